@@ -30,5 +30,6 @@
 #include <meanie3D/array/multiarray_blitz.h>
 #include <meanie3D/array/multiarray_recursive.h>
 #include <meanie3D/array/multiarray_boost.h>
+#include <meanie3D/array/multiarray_fixed.h>
 
 #endif
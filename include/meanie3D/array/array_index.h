@@ -36,84 +36,127 @@ namespace m3D {
 
     using std::vector;
 
+    /** Index of points by grid point. The indexed points are held
+     * in a list, and one flat array in row-major order (last dimension
+     * fastest) holds the position in that list (the row) for each grid
+     * point. The neighbourhood of a grid point can thus be visited
+     * through a table of precomputed offsets, and the row of a point
+     * can be used to address per-point data kept alongside the list.
+     *
+     * The index can cover the whole grid or only the box spanned by
+     * the points it was constructed with. Grid points are always those
+     * of the whole grid. Outside of the box there simply are no points.
+     *
+     * Setting points is not thread-safe. Points may be read from other
+     * threads while one thread at a time sets points at other grid
+     * points, but only if room for all of them has been reserved (see
+     * reserve). Otherwise the list of points may be reallocated under
+     * the readers.
+     */
     template<class T>
     class ArrayIndex
     {
     protected:
 
-        typedef vector<void *> array_t;
-        typedef array_t *array_t_ptr;
+        /** Offsets of the grid points in a neighbourhood of given
+         * reach, relative to the centre and in row-major order.
+         */
+        typedef struct
+        {
+            // reach in grid points
+            size_t reach;
+
+            // offset in the flat array, one per neighbour
+            vector<long> offsets;
+
+            // offset in grid points, rank() values per neighbour
+            vector<int> deltas;
+
+        } neighbourhood_t;
 
 #pragma mark -
 #pragma mark Attributes
 
     private:
 
-        vector<size_t> m_dimensions;
-        array_t *m_data;
+        vector<int> m_origin;               // first grid point covered
+        vector<size_t> m_dimensions;        // grid points covered
+        vector<size_t> m_strides;
+        bool m_covers_grid;
+        vector<int> m_rows;                 // row per grid point or NO_ROW
+        typename Point<T>::list m_points;   // indexed points by row
         bool m_make_copies;
 
-        /** Called by build_index, copy constructor
+        // neighbourhood of reach 1 (the only one used in
+        // most places) and any others, built on first use
+        neighbourhood_t m_neighbourhood;
+        vector<neighbourhood_t *> m_neighbourhoods;
+
+        /** Computes strides and the neighbourhood of reach 1.
          */
         void
-        construct_array_recursive(size_t dim_index,
-                                  array_t **array,
-                                  vector<int> &gridpoint,
-                                  ArrayIndex<T> *other = NULL);
+        initialise();
 
-        /** Called by destructor.
+        /** Checks the grid point against the covered grid points. If
+         * the index covers the whole grid, leading dimensions out of
+         * range cause an exception.
+         * @return <code>false</code> if the last dimension is out of range
          */
-        void
-        destroy_array_recursive(size_t dim_index,
-                                array_t **array,
-                                vector<int> &gridpoint);
+        template<class GridPoint>
+        bool
+        in_range(const GridPoint &gp) const;
 
-        /** Copy all points from the final dimension into the list provided
+        /** Implementation of get(), row() and set() for grid points
+         * given as vectors or as a point's view of its columns
          */
+        template<class GridPoint>
+        typename Point<T>::ptr
+        get_at(const GridPoint &gp);
+
+        template<class GridPoint>
+        int
+        row_at(const GridPoint &gp) const;
+
+        template<class GridPoint>
         void
-        add_points_to_list(typename Point<T>::list &points,
-                           vector<int> &gridpoint);
+        set_at(const GridPoint &gp, typename Point<T>::ptr p, bool copy);
 
-        /** Called by replace_points.
+        /** Fills the offset table for the given reach.
          */
         void
-        replace_points_recursive(typename Point<T>::list &points,
-                                 size_t dim_index,
-                                 vector<int> &gridpoint);
+        construct_neighbourhood(size_t reach, neighbourhood_t &neighbourhood) const;
 
-        void
-        get_points_from_index(ArrayIndex<T> *otherIndex,
-                              vector<int> &gridpoint);
+        /** @return offset table for the given reach
+         */
+        const neighbourhood_t &
+        neighbourhood(size_t reach);
 
-        void
-        copy_points_recursive(ArrayIndex<T> *otherIndex,
-                              size_t dim_index,
-                              vector<int> &gridpoint);
+        /** Collects visited points into a list.
+         */
+        class ListCollector
+        {
+            typename Point<T>::list &m_list;
 
-        void
-        count_recursive(size_t dim_index,
-                        array_t *array,
-                        vector<int> &gridpoint,
-                        size_t &count,
-                        bool originalPointsOnly = false);
+        public:
 
-        void
-        clear_recursive(size_t dim_index,
-                        array_t *array,
-                        vector<int> &gridpoint,
-                        bool delete_points);
+            ListCollector(typename Point<T>::list &list) : m_list(list) {
+            };
 
-        void
-        find_neighbours_recursive(vector<int> &gridpoint,
-                                  size_t dim_index,
-                                  typename Point<T>::list &list,
-                                  size_t reach);
+            bool operator()(typename Point<T>::ptr p) {
+                m_list.push_back(p);
+                return true;
+            };
+        };
 
 #pragma mark -
 #pragma mark Constructors/Destructors
 
     public:
 
+        /** Marks grid points without a point
+         */
+        static const int NO_ROW = -1;
+
         /** Constructs an array index for the given dimensions
          * @param dimensions
          * @param if <code>true</code>, the index makes copies of the
@@ -135,6 +178,20 @@ namespace m3D {
                    const typename Point<T>::list &points,
                    bool make_copies);
 
+        /** Constructs an array index that covers only the box of grid
+         * points spanned by the given points, and indexes them. This
+         * keeps the index small when the points occupy a part of the
+         * grid only. Points set later on must lie within the box.
+         * @param rank of the grid
+         * @param point list
+         * @param if <code>true</code>, the index makes copies of the
+         *        original points. If <code>false</code> it simply holds
+         *        references
+         */
+        ArrayIndex(size_t rank,
+                   const typename Point<T>::list &points,
+                   bool make_copies);
+
         /** Copy constructor on pointer
          * @param pointer to array index
          * @param if <code>true</code>, the index makes copies of the
@@ -151,8 +208,10 @@ namespace m3D {
 #pragma mark Indexing operation
 
         /** Indexes the point list. All points are added to the
-         * index (and are copied in the process). Existing points
-         * are overwritten (and released).
+         * index (and are copied in the process, if the index makes
+         * copies). Existing points are overwritten (and released, if
+         * the index makes copies). If the index references the points,
+         * the row of each point is its position in the given list.
          * @param point list
          */
         void
@@ -162,10 +221,63 @@ namespace m3D {
 #pragma mark Accessors
 
         typename Point<T>::ptr
-        get(const vector<int> &gp);
+        get(const vector<int> &gp) {
+            return this->get_at(gp);
+        };
+
+        /** Same, reading the grid point straight from a point's columns
+         */
+        typename Point<T>::ptr
+        get(const ColumnView<int> &gp) {
+            return this->get_at(gp);
+        };
+
+        /** @param position in the flat array (see linear_index)
+         * @return point at that position or NULL
+         */
+        inline
+        typename Point<T>::ptr
+        get(size_t linear_index) const {
+            int row = m_rows[linear_index];
+            return (row == NO_ROW) ? NULL : m_points[row];
+        };
+
+        /** @param position in the flat array (see linear_index)
+         * @return row of the point at that position or NO_ROW
+         */
+        inline
+        int
+        row(size_t linear_index) const {
+            return m_rows[linear_index];
+        };
+
+        /** @param grid point
+         * @return row of the point at the grid point or NO_ROW,
+         *         also if the grid point is not covered by the index
+         */
+        int
+        row(const vector<int> &gp) const {
+            return this->row_at(gp);
+        };
+
+        int
+        row(const ColumnView<int> &gp) const {
+            return this->row_at(gp);
+        };
+
+        /** @return indexed points by row. Rows of points that have
+         * been removed are <code>NULL</code>.
+         */
+        inline
+        const typename Point<T>::list &
+        points() const {
+            return m_points;
+        };
 
         /** Sets a point in the index at a given grid point. If a point exists
-         * at the given coordinate, it is released and replaced.
+         * at the given coordinate, it is released and replaced. A point
+         * that replaces another takes over its row. Setting <code>NULL</code>
+         * removes the point.
          *
          * @param grid point vector
          * @param pointer to the point object
@@ -175,16 +287,68 @@ namespace m3D {
         void
         set(const vector<int> &gp,
             typename Point<T>::ptr p,
-            bool copy = true);
+            bool copy = true) {
+            this->set_at(gp, p, copy);
+        };
+
+        void
+        set(const ColumnView<int> &gp,
+            typename Point<T>::ptr p,
+            bool copy = true) {
+            this->set_at(gp, p, copy);
+        };
+
+        /** Reserves room for the given number of points, so that
+         * setting up to that many points does not reallocate the
+         * list of points. Every point set takes up room, including
+         * points that are removed later. A point replacing another
+         * takes up the room of the one it replaces.
+         * @param number of points
+         */
+        void
+        reserve(size_t num_points);
 
         /** @return the rank (# of dimensions) of this array index
          */
         const size_t rank();
 
-        /** @return the dimensions of this array index
+        /** @return the number of grid points covered by this
+         * array index in each dimension
          */
         const vector<size_t> &dimensions();
 
+        /** @return the first grid point covered by this array
+         * index (all zeros, unless the index covers a box only)
+         */
+        inline
+        const vector<int> &
+        origin() const {
+            return m_origin;
+        };
+
+        /** @return row-major strides of the flat array
+         */
+        inline
+        const vector<size_t> &
+        strides() const {
+            return m_strides;
+        };
+
+        /** @param grid point (must be covered by the index), either
+         *        a vector or a point's view of its columns
+         * @return position of the grid point in the flat array
+         */
+        template<class GridPoint>
+        inline
+        size_t
+        linear_index(const GridPoint &gp) const {
+            size_t offset = 0;
+            for (size_t d = 0; d < gp.size(); d++) {
+                offset += (gp[d] - m_origin[d]) * m_strides[d];
+            }
+            return offset;
+        };
+
         /** Clear the index.
          * @param If <code>true</code> indexed points are deleted. 
          *        If <code>false</code> they are left alone.
@@ -211,9 +375,40 @@ namespace m3D {
          * @param neighborhood size (in #grid points)
          * @return list of pointers to points (no copies)
          */
+        template<class GridPoint>
         typename Point<T>::list
-        find_neighbours(const vector<int> &gridpoint, size_t reach = 1);
+        find_neighbours(const GridPoint &gridpoint, size_t reach = 1);
 
+        /** Same as above, but collects the points in the given list,
+         * which is cleared first. Re-using the list avoids allocations.
+         * @param grid point
+         * @param list of pointers to points (no copies)
+         * @param neighborhood size (in #grid points)
+         */
+        template<class GridPoint>
+        void
+        find_neighbours(const GridPoint &gridpoint,
+                        typename Point<T>::list &neighbours,
+                        size_t reach = 1);
+
+        /** Calls the visitor with each point in the neighbourhood of
+         * the given grid point, including the point at the grid point
+         * itself, in the same order as find_neighbours. The visitor
+         * is a functor <code>bool operator()(Point<T>::ptr)</code>.
+         * Returning <code>false</code> ends the visit. Nothing is
+         * allocated, except for building the offset table the first
+         * time a reach other than 1 is used.
+         *
+         * @param grid point
+         * @param visitor
+         * @param neighborhood size (in #grid points)
+         * @return <code>false</code> if the visitor ended the visit
+         */
+        template<class GridPoint, class Visitor>
+        bool
+        visit_neighbours(const GridPoint &gridpoint,
+                         Visitor &visitor,
+                         size_t reach = 1);
     };
 }
 
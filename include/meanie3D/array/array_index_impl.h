@@ -38,6 +38,9 @@
 
 namespace m3D {
 
+    template<typename T>
+    const int ArrayIndex<T>::NO_ROW;
+
     template<typename T>
     const size_t
     ArrayIndex<T>::rank() {
@@ -53,128 +56,238 @@ namespace m3D {
     template<typename T>
     ArrayIndex<T>::ArrayIndex(const vector<size_t> &dimensions,
                               bool make_copies)
-            : m_dimensions(dimensions), m_data(NULL), m_make_copies(make_copies) {
-        vector<int> gp = vector<int>(dimensions.size(), 0);
-        this->construct_array_recursive(0, &m_data, gp);
+            : m_dimensions(dimensions), m_covers_grid(true), m_make_copies(make_copies) {
+        this->initialise();
     }
 
     template<typename T>
     ArrayIndex<T>::ArrayIndex(const vector<size_t> &dimensions,
                               const typename Point<T>::list &points,
                               bool make_copies)
-            : m_dimensions(dimensions), m_data(NULL), m_make_copies(make_copies) {
-        vector<int> gp = vector<int>(dimensions.size(), 0);
-        this->construct_array_recursive(0, &m_data, gp);
+            : m_dimensions(dimensions), m_covers_grid(true), m_make_copies(make_copies) {
+        this->initialise();
+        this->index(points);
+    }
+
+    template<typename T>
+    ArrayIndex<T>::ArrayIndex(size_t rank,
+                              const typename Point<T>::list &points,
+                              bool make_copies)
+            : m_covers_grid(false), m_make_copies(make_copies) {
+        m_origin.assign(rank, 0);
+        m_dimensions.assign(rank, 0);
+        if (!points.empty()) {
+            vector<int> upper(rank, std::numeric_limits<int>::min());
+            m_origin.assign(rank, std::numeric_limits<int>::max());
+            for (size_t i = 0; i < points.size(); i++) {
+                const ColumnView<int> &gp = points[i]->gridpoint;
+                for (size_t d = 0; d < rank; d++) {
+                    m_origin[d] = std::min(m_origin[d], gp[d]);
+                    upper[d] = std::max(upper[d], gp[d]);
+                }
+            }
+            for (size_t d = 0; d < rank; d++) {
+                m_dimensions[d] = (size_t) (upper[d] - m_origin[d] + 1);
+            }
+        }
+        this->initialise();
         this->index(points);
     }
 
     template<typename T>
     ArrayIndex<T>::ArrayIndex(ArrayIndex<T> *o)
-            : m_dimensions(o->m_dimensions), m_data(NULL), m_make_copies(o->m_make_copies) {
-        vector<int> gp = vector<int>(o->m_dimensions.size(), 0);
-        this->copy_points_recursive(o, 0, gp);
+            : m_origin(o->m_origin), m_dimensions(o->m_dimensions),
+              m_covers_grid(o->m_covers_grid), m_make_copies(o->m_make_copies) {
+        this->initialise();
+        m_rows = o->m_rows;
+        m_points = o->m_points;
+        if (m_make_copies) {
+            for (size_t i = 0; i < m_points.size(); i++) {
+                if (m_points[i] != NULL) {
+                    m_points[i] = PointFactory<T>::get_instance()->copy(m_points[i]);
+                }
+            }
+        }
     }
 
     template<typename T>
     ArrayIndex<T>::~ArrayIndex() {
-        vector<int> gp = vector<int>(m_dimensions.size(), 0);
-        this->destroy_array_recursive(0, &m_data, gp);
+        if (this->m_make_copies) {
+            for (size_t i = 0; i < m_points.size(); i++) {
+                if (m_points[i] != NULL) {
+                    delete m_points[i];
+                    m_points[i] = NULL;
+                }
+            }
+        }
+        for (size_t i = 0; i < m_neighbourhoods.size(); i++) {
+            delete m_neighbourhoods[i];
+        }
     }
 
     template<typename T>
     void
-    ArrayIndex<T>::add_points_to_list(typename Point<T>::list &points,
-                                      vector<int> &gridpoint) {
-        // obtain the size of the last dimension
-
-        size_t dimSize = m_dimensions[gridpoint.size() - 1];
-
-        // copy all points over into the given point list
-        // using the point factory's copy method
+    ArrayIndex<T>::initialise() {
+        const size_t rank = m_dimensions.size();
 
-        vector<int> gIter = gridpoint;
-
-        for (size_t i = 0; i < dimSize; i++) {
-            gIter[gridpoint.size() - 1] = i;
+        if (m_origin.size() != rank) {
+            m_origin.assign(rank, 0);
+        }
 
-            typename Point<T>::ptr p = this->get(gIter);
+        // row-major, last dimension fastest
+        m_strides.assign(rank, 1);
+        for (int d = ((int) rank) - 2; d >= 0; d--) {
+            m_strides[d] = m_strides[d + 1] * m_dimensions[d + 1];
+        }
 
-            if (p != NULL) {
-                typename Point<T>::ptr copy = PointFactory<T>::get_instance()->copy(p);
+        size_t size = (rank == 0) ? 0 : m_strides[0] * m_dimensions[0];
+        m_rows.assign(size, NO_ROW);
+        m_points.clear();
 
-                points.push_back(copy);
-            }
-        }
+        this->construct_neighbourhood(1, m_neighbourhood);
     }
 
+#pragma mark -
+#pragma mark Neighbourhoods
+
     template<typename T>
     void
-    ArrayIndex<T>::get_points_from_index(ArrayIndex<T> *otherIndex,
-                                         vector<int> &gridpoint) {
-        // obtain the size of the last dimension
-
-        size_t dimSize = m_dimensions[gridpoint.size() - 1];
+    ArrayIndex<T>::construct_neighbourhood(size_t reach, neighbourhood_t &neighbourhood) const {
+        const size_t rank = m_dimensions.size();
+        const int r = (int) reach;
+
+        neighbourhood.reach = reach;
+        neighbourhood.offsets.clear();
+        neighbourhood.deltas.clear();
+        if (rank == 0) {
+            return;
+        }
 
-        vector<int> gIter = gridpoint;
+        // Count through all deltas in [-reach,reach]^rank
+        // with the last dimension running fastest
 
-        for (size_t i = 0; i < dimSize; i++) {
-            gIter[gridpoint.size() - 1] = i;
+        vector<int> delta(rank, -r);
+        while (true) {
+            long offset = 0;
+            for (size_t d = 0; d < rank; d++) {
+                offset += delta[d] * (long) m_strides[d];
+                neighbourhood.deltas.push_back(delta[d]);
+            }
+            neighbourhood.offsets.push_back(offset);
 
-            typename Point<T>::ptr p = otherIndex->get(gIter);
+            int d = ((int) rank) - 1;
+            while (d >= 0 && delta[d] == r) {
+                delta[d] = -r;
+                d--;
+            }
+            if (d < 0) {
+                break;
+            }
+            delta[d]++;
+        }
+    }
 
-            // TODO: obtain the pointer to the array directly
-            // instead of using 'set'
+    template<typename T>
+    const typename ArrayIndex<T>::neighbourhood_t &
+    ArrayIndex<T>::neighbourhood(size_t reach) {
+        if (reach == 1) {
+            return m_neighbourhood;
+        }
 
-            if (p != NULL) {
-                if (this->m_make_copies) {
-                    this->set(gIter, PointFactory<T>::get_instance()->copy(p));
-                } else {
-                    this->set(gIter, p);
+        neighbourhood_t *result = NULL;
+#if WITH_OPENMP
+#pragma omp critical (array_index_neighbourhoods)
+#endif
+        {
+            for (size_t i = 0; i < m_neighbourhoods.size() && result == NULL; i++) {
+                if (m_neighbourhoods[i]->reach == reach) {
+                    result = m_neighbourhoods[i];
                 }
             }
+            if (result == NULL) {
+                result = new neighbourhood_t();
+                this->construct_neighbourhood(reach, *result);
+                m_neighbourhoods.push_back(result);
+            }
         }
+        return *result;
     }
 
     template<typename T>
-    void
-    ArrayIndex<T>::replace_points_recursive(typename Point<T>::list &points,
-                                            size_t dim_index,
-                                            vector<int> &gridpoint) {
-        size_t dimSize = m_dimensions[dim_index];
-
-        if (m_dimensions.size() == 1) {
-            this->add_points_to_list(points, gridpoint);
-        } else if (dim_index < (m_dimensions.size() - 1)) {
-            for (size_t index = 0; index < dimSize; index++) {
-                gridpoint[dim_index] = index;
-
-                replace_points_recursive(points, dim_index + 1, gridpoint);
+    template<class GridPoint, class Visitor>
+    bool
+    ArrayIndex<T>::visit_neighbours(const GridPoint &gridpoint,
+                                    Visitor &visitor,
+                                    size_t reach) {
+        const neighbourhood_t &neighbourhood = this->neighbourhood(reach);
+        const size_t rank = m_dimensions.size();
+        const size_t count = neighbourhood.offsets.size();
+        const int r = (int) reach;
+
+        // If the neighbourhood lies inside the grid entirely,
+        // the offsets can be used without further checks
+
+        long centre = 0;
+        bool interior = true;
+        for (size_t d = 0; d < rank; d++) {
+            int g = gridpoint[d] - m_origin[d];
+            centre += g * (long) m_strides[d];
+            if (g < r || g + r >= (int) m_dimensions[d]) {
+                interior = false;
+            }
+        }
+
+        if (interior) {
+            for (size_t n = 0; n < count; n++) {
+                typename Point<T>::ptr p = this->get(centre + neighbourhood.offsets[n]);
+                if (p != NULL && !visitor(p)) {
+                    return false;
+                }
             }
         } else {
-            this->add_points_to_list(points, gridpoint);
+            for (size_t n = 0; n < count; n++) {
+                const int *delta = &neighbourhood.deltas[n * rank];
+                bool inside = true;
+                for (size_t d = 0; d < rank && inside; d++) {
+                    int g = gridpoint[d] - m_origin[d] + delta[d];
+                    inside = (g >= 0 && g < (int) m_dimensions[d]);
+                }
+                if (!inside) {
+                    continue;
+                }
+                typename Point<T>::ptr p = this->get(centre + neighbourhood.offsets[n]);
+                if (p != NULL && !visitor(p)) {
+                    return false;
+                }
+            }
         }
+
+        return true;
     }
 
     template<typename T>
+    template<class GridPoint>
     void
-    ArrayIndex<T>::copy_points_recursive(ArrayIndex<T> *otherIndex,
-                                         size_t dim_index,
-                                         vector<int> &gridpoint) {
-        size_t dimSize = m_dimensions[dim_index];
-
-        if (m_dimensions.size() == 1) {
-            this->get_points_from_index(otherIndex, gridpoint);
-        } else if (dim_index < (m_dimensions.size() - 1)) {
-            for (size_t index = 0; index < dimSize; index++) {
-                gridpoint[dim_index] = index;
-
-                copy_points_recursive(otherIndex, dim_index + 1, gridpoint);
-            }
-        } else {
-            this->get_points_from_index(otherIndex, gridpoint);
-        }
+    ArrayIndex<T>::find_neighbours(const GridPoint &gridpoint,
+                                   typename Point<T>::list &neighbours,
+                                   size_t reach) {
+        neighbours.clear();
+        ListCollector collector(neighbours);
+        this->visit_neighbours(gridpoint, collector, reach);
+    }
+
+    template<typename T>
+    template<class GridPoint>
+    typename Point<T>::list
+    ArrayIndex<T>::find_neighbours(const GridPoint &gridpoint, size_t reach) {
+        typename Point<T>::list neighbours;
+        this->find_neighbours(gridpoint, neighbours, reach);
+        return neighbours;
     }
 
+#pragma mark -
+#pragma mark Misc
+
     template<typename T>
     void
     ArrayIndex<T>::replace_points(typename Point<T>::list &points) {
@@ -191,136 +304,38 @@ namespace m3D {
 
         points.clear();
 
-        vector<int> gp = vector<int>(m_dimensions.size(), 0);
-
         // Add copies of points from this index
 
-        this->replace_points_recursive(points, 0, gp);
-    }
-
-    template<typename T>
-    void
-    ArrayIndex<T>::construct_array_recursive(size_t dim_index,
-                                             array_t **array,
-                                             vector<int> &gridpoint,
-                                             ArrayIndex<T> *other) {
-        size_t dimSize = m_dimensions[dim_index];
-
-        if (m_dimensions.size() == 1) {
-            *array = (array_t *) new vector<typename Point<T>::ptr>(dimSize, NULL);
-
-            if (other != NULL) {
-                this->get_points_from_index(other, gridpoint);
-            }
-        } else if (dim_index < (m_dimensions.size() - 1)) {
-            // create array
-
-            if (dim_index == 0) {
-                vector<void *> *new_array = new vector<void *>(dimSize, NULL);
-
-                *array = new_array;
-
-                for (size_t index = 0; index < dimSize; index++) {
-                    gridpoint[dim_index] = index;
-
-                    construct_array_recursive(dim_index + 1, array, gridpoint, other);
-                }
-            } else {
-                vector<void *> *super_array = *array;
-
-                size_t super_index = gridpoint[dim_index - 1];
-
-                vector<void *> *new_array = new vector<void *>(dimSize, NULL);
-
-                super_array->at(super_index) = new_array;
-
-                for (size_t index = 0; index < dimSize; index++) {
-                    gridpoint[dim_index] = index;
-
-                    construct_array_recursive(dim_index + 1, &new_array, gridpoint);
-                }
-            }
-        } else {
-            vector<void *> *super_array = *array;
-
-            size_t super_index = gridpoint[dim_index - 1];
-
-            vector<typename Point<T>::ptr> *new_array = new vector<typename Point<T>::ptr>(dimSize, NULL);
-
-            super_array->at(super_index) = new_array;
-
-            if (other != NULL) {
-                this->get_points_from_index(other, gridpoint);
+        for (size_t i = 0; i < m_rows.size(); i++) {
+            typename Point<T>::ptr p = this->get(i);
+            if (p != NULL) {
+                points.push_back(PointFactory<T>::get_instance()->copy(p));
             }
         }
     }
 
     template<typename T>
     void
-    ArrayIndex<T>::destroy_array_recursive(size_t dim_index, array_t **array, vector<int> &gridpoint) {
-        size_t dimSize = m_dimensions[dim_index];
-
-        if (m_dimensions.size() == 1) {
-            delete m_data;
-        } else if (dim_index < (m_dimensions.size() - 1)) {
-            if (dim_index == 0) {
-                vector<void *> *the_array = *array;
-
-                for (size_t index = 0; index < dimSize; index++) {
-                    gridpoint[dim_index] = index;
-
-                    destroy_array_recursive(dim_index + 1, array, gridpoint);
-                }
-
-                delete the_array;
-
-                *array = NULL;
-            } else {
-                size_t super_index = gridpoint[dim_index - 1];
-
-                vector<void *> *super_array = *array;
-
-                vector<void *> *the_array = (vector<void *> *) super_array->at(super_index);
-
-                for (size_t index = 0; index < dimSize; index++) {
-                    gridpoint[dim_index] = index;
-
-                    destroy_array_recursive(dim_index + 1, &the_array, gridpoint);
-                }
-
-                delete the_array;
-
-                super_array->at(super_index) = NULL;
-            }
-        } else {
-            vector<void *> *super_array = *array;
-
-            size_t super_index = gridpoint[dim_index - 1];
-
-            vector<typename Point<T>::ptr> *the_array = (vector<typename Point<T>::ptr> *) super_array->at(super_index);
-
-            if (this->m_make_copies) {
-                for (size_t i = 0; i < the_array->size(); i++) {
-                    typename Point<T>::ptr p = the_array->at(i);
+    ArrayIndex<T>::index(const typename Point<T>::list &list) {
+        if (this->m_make_copies) {
+            for (size_t i = 0; i < list.size(); i++) {
+                typename Point<T>::ptr p = list[i];
 
-                    if (p != NULL) {
-                        delete p;
-                        the_array->at(i) = NULL;
-                    }
-                }
+                this->set(p->gridpoint, p, true);
             }
-
-            super_array->at(super_index) = NULL;
+            return;
         }
-    }
 
-    template<typename T>
-    void
-    ArrayIndex<T>::index(const typename Point<T>::list &list) {
-        for (size_t i = 0; i < list.size(); i++) {
-            typename Point<T>::ptr p = list[i];
+        // Reference the points in the order of the list,
+        // so that rows are positions in the list
 
-            this->set(p->gridpoint, p, this->m_make_copies);
+        const size_t first_row = m_points.size();
+        m_points.insert(m_points.end(), list.begin(), list.end());
+        for (size_t i = 0; i < list.size(); i++) {
+            const ColumnView<int> &gp = list[i]->gridpoint;
+            if (this->in_range(gp)) {
+                m_rows[this->linear_index(gp)] = (int) (first_row + i);
+            }
         }
     }
 
@@ -328,220 +343,129 @@ namespace m3D {
 #pragma mark Accessors
 
     template<typename T>
-    typename Point<T>::ptr
-    ArrayIndex<T>::get(const vector<int> &gp) {
-        vector<void *> *array = m_data;
-
-        typename Point<T>::ptr result = NULL;
-
-        for (size_t dim_index = 0; dim_index < gp.size(); dim_index++) {
-            if (dim_index < gp.size() - 1) {
-                int index = gp[dim_index];
-
-                if (index >= 0 && index < array->size()) {
-                    array = (vector<void *> *) array->at(index);
-                } else {
-                    throw std::invalid_argument("index parameter out of range");
+    template<class GridPoint>
+    bool
+    ArrayIndex<T>::in_range(const GridPoint &gp) const {
+        const size_t last = gp.size() - 1;
+
+        for (size_t d = 0; d < last; d++) {
+            int g = gp[d] - m_origin[d];
+            if (g < 0 || g >= (int) m_dimensions[d]) {
+                if (!m_covers_grid) {
+                    return false;
                 }
-            } else {
-                vector<typename Point<T>::ptr> *points = (vector<typename Point<T>::ptr> *) array;
+                cerr << "ERROR:index parameter out of range: " << gp << endl;
+                throw std::invalid_argument("index parameter out of range");
+            }
+        }
 
-                int index = gp[dim_index];
+        int g = gp[last] - m_origin[last];
+        return g >= 0 && g < (int) m_dimensions[last];
+    }
 
-                if (index >= 0 && index < points->size()) {
-                    result = points->at(index);
-                }
-            }
+    template<typename T>
+    template<class GridPoint>
+    typename Point<T>::ptr
+    ArrayIndex<T>::get_at(const GridPoint &gp) {
+        if (!this->in_range(gp)) {
+            return NULL;
         }
 
-        return result;
+        return this->get(this->linear_index(gp));
     }
 
     template<typename T>
-    void
-    ArrayIndex<T>::set(const vector<int> &gp, typename Point<T>::ptr p, bool copy) {
-        vector<void *> *array = m_data;
-
-        for (size_t dim_index = 0; dim_index < gp.size(); dim_index++) {
-            if (dim_index < gp.size() - 1) {
-                int index = gp[dim_index];
-
-                if (index >= 0 && index < array->size()) {
-                    array = (vector<void *> *) array->at(index);
-                } else {
-                    cerr << "ERROR:index parameter out of range: " << gp << endl;
-                    throw std::invalid_argument("index parameter out of range");
-                }
-            } else {
-                vector<typename Point<T>::ptr> *points = (vector<typename Point<T>::ptr> *) array;
-
-                int index = gp[dim_index];
-
-                if (index >= 0 && index < array->size()) {
-                    typename Point<T>::ptr existingPoint = points->at(index);
-
-                    if (existingPoint != NULL) {
-                        delete existingPoint;
-                    }
-
-                    if (copy) {
-                        Point<T> *c = PointFactory<T>::get_instance()->copy(p);
-                        points->at(index) = c;
-                        if (p->isOriginalPoint != c->isOriginalPoint) {
-                            cerr << "ERROR:could not copy point" << endl;
-                        }
-                    } else {
-                        points->at(index) = p;
-                    }
-                }
+    template<class GridPoint>
+    int
+    ArrayIndex<T>::row_at(const GridPoint &gp) const {
+        for (size_t d = 0; d < gp.size(); d++) {
+            int g = gp[d] - m_origin[d];
+            if (g < 0 || g >= (int) m_dimensions[d]) {
+                return NO_ROW;
             }
         }
-    }
 
-#pragma mark -
-#pragma mark Clear Index
+        return m_rows[this->linear_index(gp)];
+    }
 
     template<typename T>
+    template<class GridPoint>
     void
-    ArrayIndex<T>::clear_recursive(size_t dim_index,
-                                   array_t *array,
-                                   vector<int> &gridpoint,
-                                   bool delete_points) {
-        size_t dimSize = m_dimensions[dim_index];
-
-        if (dim_index < (m_dimensions.size() - 1)) {
-            for (size_t index = 0; index < dimSize; index++) {
-                gridpoint[dim_index] = index;
+    ArrayIndex<T>::set_at(const GridPoint &gp, typename Point<T>::ptr p, bool copy) {
+        if (!this->in_range(gp)) {
+            return;
+        }
 
-                vector<void *> *a = (vector<void *> *) array->at(index);
+        int &row = m_rows[this->linear_index(gp)];
 
-                clear_recursive(dim_index + 1, a, gridpoint, delete_points);
-            }
-        } else {
-            vector<typename Point<T>::ptr> *points = (vector<typename Point<T>::ptr> *) array;
+        if (row != NO_ROW && m_points[row] != NULL) {
+            delete m_points[row];
+            m_points[row] = NULL;
+        }
 
-            for (size_t index = 0; index < dimSize; index++) {
-                typename Point<T>::ptr p = points->at(index);
+        if (p == NULL) {
+            row = NO_ROW;
+            return;
+        }
 
-                if (p != NULL && delete_points) {
-                    delete p;
-                }
+        typename Point<T>::ptr entry = p;
+        if (copy) {
+            entry = PointFactory<T>::get_instance()->copy(p);
+            if (p->isOriginalPoint != entry->isOriginalPoint) {
+                cerr << "ERROR:could not copy point" << endl;
             }
+        }
 
-            points->clear();
+        if (row == NO_ROW) {
+            row = (int) m_points.size();
+            m_points.push_back(entry);
+        } else {
+            m_points[row] = entry;
         }
     }
 
     template<typename T>
     void
-    ArrayIndex<T>::clear(bool delete_points) {
-        vector<int> gp = vector<int>(m_dimensions.size(), 0);
-
-        clear_recursive(0, m_data, gp, delete_points);
+    ArrayIndex<T>::reserve(size_t num_points) {
+        m_points.reserve(num_points);
     }
 
 #pragma mark -
-#pragma mark Counting
+#pragma mark Clear Index
 
     template<typename T>
     void
-    ArrayIndex<T>::count_recursive(size_t dim_index,
-                                   array_t *array,
-                                   vector<int> &gridpoint,
-                                   size_t &count,
-                                   bool originalPointsOnly) {
-        size_t dimSize = m_dimensions[dim_index];
-
-        if (dim_index < (m_dimensions.size() - 1)) {
-            for (size_t index = 0; index < dimSize; index++) {
-                gridpoint[dim_index] = index;
-
-                vector<void *> *a = (vector<void *> *) array->at(index);
-
-                count_recursive(dim_index + 1, a, gridpoint, count, originalPointsOnly);
-            }
-        } else {
-            vector<typename Point<T>::ptr> *points = (vector<typename Point<T>::ptr> *) array;
-
-            for (size_t index = 0; index < dimSize; index++) {
-                typename Point<T>::ptr p = points->at(index);
-
-                if (p != NULL) {
-                    if ((originalPointsOnly && p->isOriginalPoint) || !originalPointsOnly) {
-                        count++;
-                    }
-                }
+    ArrayIndex<T>::clear(bool delete_points) {
+        for (size_t i = 0; i < m_rows.size(); i++) {
+            typename Point<T>::ptr p = this->get(i);
+            if (p != NULL && delete_points) {
+                delete p;
             }
+            m_rows[i] = NO_ROW;
         }
+        m_points.clear();
     }
 
+#pragma mark -
+#pragma mark Counting
+
     template<typename T>
     size_t
     ArrayIndex<T>::count(bool originalPointsOnly) {
         size_t count = 0;
 
-        vector<int> gp = vector<int>(m_dimensions.size(), 0);
-
-        count_recursive(0, m_data, gp, count, originalPointsOnly);
-
-        return count;
-    }
-
-    template<typename T>
-    void
-    ArrayIndex<T>::find_neighbours_recursive(vector<int> &gridpoint,
-                                             size_t dimensionIndex,
-                                             typename Point<T>::list &list,
-                                             size_t reach) {
-        size_t dimSize = this->dimensions()[dimensionIndex];
+        for (size_t i = 0; i < m_rows.size(); i++) {
+            typename Point<T>::ptr p = this->get(i);
 
-        // iterate over dimensions
-
-        int start = gridpoint[dimensionIndex] - reach;
-
-        int end = gridpoint[dimensionIndex] + reach;
-
-        for (int index = start; index <= end; index++) {
-            gridpoint[dimensionIndex] = index;
-
-            // guard against index error
-
-            if (index < 0 || index > (dimSize - 1)) {
-                continue;
-            }
-
-            if (dimensionIndex < (gridpoint.size() - 1)) {
-                // recurse
-                find_neighbours_recursive(gridpoint, dimensionIndex + 1, list, reach);
-            } else {
-                // collect
-
-                //std::cout << gridpoint << endl;
-
-                typename Point<T>::ptr p = this->get(gridpoint);
-
-                if (p != NULL) {
-                    list.push_back(p);
+            if (p != NULL) {
+                if ((originalPointsOnly && p->isOriginalPoint) || !originalPointsOnly) {
+                    count++;
                 }
             }
         }
 
-        gridpoint[dimensionIndex] = start + reach;
-    }
-
-    template<typename T>
-    typename Point<T>::list
-    ArrayIndex<T>::find_neighbours(const vector<int> &gridpoint, size_t reach) {
-        typename Point<T>::list neighbours;
-
-        typename CoordinateSystem<T>::GridPoint gp = gridpoint;
-
-        this->find_neighbours_recursive(gp, 0, neighbours, reach);
-
-        return neighbours;
+        return count;
     }
-
-
 }
 
 #endif
@@ -28,6 +28,8 @@
 #include <meanie3D/defines.h>
 #include <meanie3D/namespaces.h>
 
+#include <boost/array.hpp>
+
 #include <vector>
 
 namespace m3D {
@@ -40,6 +42,10 @@ namespace m3D {
      */
     class LinearIndexMapping
     {
+    public:
+
+        typedef std::vector<int> GridPoint;
+
     private:
         std::vector<size_t> m_dimension_sizes;
         std::vector<size_t> m_slice_sizes;
@@ -75,7 +81,7 @@ namespace m3D {
 
         /** @return number of possible points in this mapping. 
          */
-        size_t size() {
+        size_t size() const {
             return m_size;
         }
 
@@ -104,19 +110,91 @@ namespace m3D {
             return g;
         }
 
+        /** Same as above, but writes the grid index into the
+         * given vector, which avoids allocating a new one.
+         * @param linear index
+         * @param grid index (must have the mapping's rank)
+         */
+        void
+        linear_to_grid(size_t linear_index, vector<int> &g) const {
+            size_t N = m_dimension_sizes.size();
+            for (size_t i = 0; i < N; i++) {
+                g[i] = (int) (linear_index / m_slice_sizes[i]);
+                linear_index -= g[i] * m_slice_sizes[i];
+            }
+        }
+
+        template<class GridPoint>
         size_t
-        grid_to_index(const vector<int> &g) {
+        grid_to_index(const GridPoint &g) const {
             size_t linear_index = 0;
 
             size_t N = m_dimension_sizes.size();
 
-            for (int i = (N - 1); i >= 0; i++) {
+            for (size_t i = 0; i < N; i++) {
                 linear_index += m_slice_sizes[i] * g[i];
             }
 
             return linear_index;
         }
     };
+
+    /** Version of LinearIndexMapping with the rank as template
+     * parameter. The grid indexes are fixed size arrays.
+     */
+    template<size_t N>
+    class FixedLinearIndexMapping
+    {
+    public:
+
+        typedef boost::array<int, N> GridPoint;
+
+    private:
+
+        boost::array<size_t, N> m_slice_sizes;
+        size_t m_size;
+
+    public:
+
+        /** Constructs a mapping object
+         * @param dimension sizes (N of them)
+         */
+        FixedLinearIndexMapping(const std::vector<size_t> &dimension_sizes)
+                : m_size(1) {
+            assert(dimension_sizes.size() == N);
+            for (int n = ((int) N) - 1; n >= 0; n--) {
+                m_slice_sizes[n] = m_size;
+                m_size *= dimension_sizes[n];
+            }
+        };
+
+        /** @return number of possible points in this mapping.
+         */
+        size_t size() const {
+            return m_size;
+        }
+
+        /** Maps linear index to grid index components
+         * @param linear index
+         * @param grid index
+         */
+        void
+        linear_to_grid(size_t linear_index, GridPoint &g) const {
+            for (size_t i = 0; i < N; i++) {
+                g[i] = (int) (linear_index / m_slice_sizes[i]);
+                linear_index -= g[i] * m_slice_sizes[i];
+            }
+        }
+
+        size_t
+        grid_to_index(const GridPoint &g) const {
+            size_t linear_index = 0;
+            for (size_t i = 0; i < N; i++) {
+                linear_index += m_slice_sizes[i] * g[i];
+            }
+            return linear_index;
+        }
+    };
 }
 
 #endif 
@@ -28,6 +28,7 @@
 #include <meanie3D/namespaces.h>
 
 #include <meanie3D/utils/vector_utils.h>
+#include <meanie3D/featurespace/point_columns.h>
 #include <vector>
 
 namespace m3D {
@@ -125,6 +126,25 @@ namespace m3D {
         virtual
         void set(const vector<int> &index, const T &value) = 0;
 
+        /** Gets the value at a point's grid point, read from the
+         * point's columns. The default copies the grid point, arrays
+         * looked up per point override this without copying.
+         * @param grid point
+         */
+        virtual
+        T get(const ColumnView<int> &index) const {
+            return this->get((vector<int>) index);
+        };
+
+        /** Sets the value at a point's grid point, see above.
+         * @param grid point
+         * @param value
+         */
+        virtual
+        void set(const ColumnView<int> &index, const T &value) {
+            this->set((vector<int>) index, value);
+        };
+
         /** @return const reference to the dimension vector
          * this array was build on
          */
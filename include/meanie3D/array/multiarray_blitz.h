@@ -211,6 +211,40 @@ for(int i1=0;i1<dim[0];i1++){ \
             }
         };
 
+        /** Constructs the array on an existing, contiguous buffer in
+         * row-major (C) order without copying it. The array takes over
+         * the buffer, which must have been allocated with new[].
+         * @param dimensions
+         * @param buffer
+         */
+        MultiArrayBlitz(const vector<size_t> &dims, T *data)
+                : MultiArray<T>(dims) {
+            switch (this->m_dims.size()) {
+                case 1:
+                    m_a1.reference(blitz::Array<T, 1>(data, blitz::shape(A1(this->m_dims)),
+                                                      blitz::deleteDataWhenDone));
+                    break;
+                case 2:
+                    m_a2.reference(blitz::Array<T, 2>(data, blitz::shape(A2(this->m_dims)),
+                                                      blitz::deleteDataWhenDone));
+                    break;
+                case 3:
+                    m_a3.reference(blitz::Array<T, 3>(data, blitz::shape(A3(this->m_dims)),
+                                                      blitz::deleteDataWhenDone));
+                    break;
+                case 4:
+                    m_a4.reference(blitz::Array<T, 4>(data, blitz::shape(A4(this->m_dims)),
+                                                      blitz::deleteDataWhenDone));
+                    break;
+                case 5:
+                    m_a5.reference(blitz::Array<T, 5>(data, blitz::shape(A5(this->m_dims)),
+                                                      blitz::deleteDataWhenDone));
+                    break;
+                default:
+                    throw std::out_of_range("only 5 dimensions are currently supported");
+            }
+        };
+
         /** Copy constructor
          */
         MultiArrayBlitz(const MultiArrayBlitz<T> &other) : MultiArray<T>(other) {
@@ -270,7 +304,49 @@ for(int i1=0;i1<dim[0];i1++){ \
 #pragma mark -
 #pragma mark Accessors
 
+        /** @return pointer to the first element of the array's
+         * storage. The elements are contiguous and in row-major
+         * order.
+         */
+        T *data() {
+            switch (this->m_dims.size()) {
+                case 1:
+                    return m_a1.data();
+                case 2:
+                    return m_a2.data();
+                case 3:
+                    return m_a3.data();
+                case 4:
+                    return m_a4.data();
+                case 5:
+                    return m_a5.data();
+                default:
+                    throw std::out_of_range("only 5 dimensions are currently supported");
+            }
+        }
+
         T get(const vector<int> &index) const {
+            return this->get_at(index);
+        }
+
+        void
+        set(const vector<int> &index, const T &value) {
+            this->set_at(index, value);
+        }
+
+        T get(const ColumnView<int> &index) const {
+            return this->get_at(index);
+        }
+
+        void
+        set(const ColumnView<int> &index, const T &value) {
+            this->set_at(index, value);
+        }
+
+    private:
+
+        template<class GridPoint>
+        T get_at(const GridPoint &index) const {
             T result;
             switch (this->m_dims.size()) {
                 case 1:
@@ -295,8 +371,9 @@ for(int i1=0;i1<dim[0];i1++){ \
             return result;
         }
 
+        template<class GridPoint>
         void
-        set(const vector<int> &index, const T &value) {
+        set_at(const GridPoint &index, const T &value) {
 
             switch (this->m_dims.size()) {
                 case 1:
@@ -319,6 +396,8 @@ for(int i1=0;i1<dim[0];i1++){ \
             }
         }
 
+    public:
+
 #pragma mark -
 #pragma mark Stuff
 
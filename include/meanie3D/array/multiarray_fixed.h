@@ -0,0 +1,337 @@
+/* The MIT License (MIT)
+ * 
+ * (c) Jürgen Simon 2014 (juergen.simon@uni-bonn.de)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef M3D_MULTIARRAY_FIXED_H
+#define M3D_MULTIARRAY_FIXED_H
+
+#include <meanie3D/defines.h>
+#include <meanie3D/namespaces.h>
+
+#include <meanie3D/array/multiarray.h>
+
+#include <boost/array.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace m3D {
+
+    /** Multi-dimensional array with the rank as template parameter.
+     * The values are stored contiguously in row-major order (last
+     * dimension fastest). Besides the MultiArray interface, values can
+     * be accessed through fixed size grid points or linear indexes,
+     * neither of which allocates or branches on the rank.
+     *
+     * An array can also store a box of its grid points only. It then
+     * has the dimensions of the whole grid, but grid points outside
+     * of the box read a fixed value and cannot be set. Linear indexes
+     * address the stored values.
+     */
+    template<typename T, size_t N>
+    class MultiArrayFixed : public MultiArray<T>
+    {
+    public:
+
+        typedef boost::array<int, N> GridPoint;
+
+#pragma mark -
+#pragma mark Attributes
+
+    private:
+
+        // Plain array rather than a vector, so that different
+        // elements can be written by different threads for
+        // T = bool, too
+        T *m_data;
+        size_t m_size;
+        boost::array<size_t, N> m_strides;
+
+        // stored box and the value outside of it
+        boost::array<int, N> m_origin;
+        boost::array<size_t, N> m_extent;
+        T m_outside;
+
+        /** Stores all grid points
+         */
+        void cover_grid() {
+            if (this->m_dims.size() != N) {
+                throw std::out_of_range("dimensions do not match the rank of the array");
+            }
+            for (size_t d = 0; d < N; d++) {
+                m_origin[d] = 0;
+                m_extent[d] = this->m_dims[d];
+            }
+        }
+
+        void allocate() {
+            m_size = 1;
+            for (int d = ((int) N) - 1; d >= 0; d--) {
+                m_strides[d] = m_size;
+                m_size *= m_extent[d];
+            }
+            m_data = new T[m_size];
+        }
+
+        template<class GP>
+        inline bool stores(const GP &gp) const {
+            for (size_t d = 0; d < N; d++) {
+                if ((size_t) (gp[d] - m_origin[d]) >= m_extent[d]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+#pragma mark -
+#pragma mark Constructors/Destructors
+
+    public:
+
+        MultiArrayFixed(const vector<size_t> &dims)
+                : MultiArray<T>(dims), m_data(NULL), m_size(0), m_outside(T()) {
+            this->cover_grid();
+            this->allocate();
+        };
+
+        MultiArrayFixed(const vector<size_t> &dims, T default_value)
+                : MultiArray<T>(dims), m_data(NULL), m_size(0), m_outside(default_value) {
+            this->cover_grid();
+            this->allocate();
+            this->populate_array(default_value);
+        };
+
+        /** Constructs an array over the given grid, which stores
+         * the values in the given box only.
+         * @param dimensions of the grid
+         * @param first grid point of the box
+         * @param number of grid points of the box in each dimension
+         * @param initial value, which is also the value of all grid
+         *        points outside of the box
+         */
+        MultiArrayFixed(const vector<size_t> &dims,
+                        const vector<size_t> &origin,
+                        const vector<size_t> &extent,
+                        T default_value)
+                : MultiArray<T>(dims), m_data(NULL), m_size(0), m_outside(default_value) {
+            this->cover_grid();
+            if (origin.size() != N || extent.size() != N) {
+                throw std::out_of_range("box does not match the rank of the array");
+            }
+            for (size_t d = 0; d < N; d++) {
+                if (origin[d] + extent[d] > dims[d]) {
+                    throw std::out_of_range("box exceeds the dimensions of the array");
+                }
+                m_origin[d] = (int) origin[d];
+                m_extent[d] = extent[d];
+            }
+            this->allocate();
+            std::fill(m_data, m_data + m_size, default_value);
+        };
+
+        MultiArrayFixed(const MultiArrayFixed<T, N> &other)
+                : MultiArray<T>(other.get_dimensions()), m_data(NULL), m_size(0),
+                  m_origin(other.m_origin), m_extent(other.m_extent), m_outside(other.m_outside) {
+            this->allocate();
+            std::copy(other.m_data, other.m_data + m_size, m_data);
+        };
+
+        MultiArrayFixed(const MultiArray<T> *other)
+                : MultiArray<T>(other->get_dimensions()), m_data(NULL), m_size(0), m_outside(T()) {
+            this->cover_grid();
+            this->allocate();
+            this->copy_from(other);
+        };
+
+        ~MultiArrayFixed() {
+            delete[] m_data;
+        };
+
+        /** Copy operator (copy and swap)
+         * @param other array
+         */
+        MultiArrayFixed<T, N> &
+        operator=(const MultiArrayFixed<T, N> &other) {
+            MultiArrayFixed<T, N> copy(other);
+            this->swap(copy);
+            return *this;
+        };
+
+        /** Exchanges contents with the other array
+         * @param other array
+         */
+        void swap(MultiArrayFixed<T, N> &other) {
+            std::swap(this->m_dims, other.m_dims);
+            std::swap(m_data, other.m_data);
+            std::swap(m_size, other.m_size);
+            std::swap(m_strides, other.m_strides);
+            std::swap(m_origin, other.m_origin);
+            std::swap(m_extent, other.m_extent);
+            std::swap(m_outside, other.m_outside);
+        };
+
+#pragma mark -
+#pragma mark Accessors
+
+        /** @return pointer to the first element of the array's
+         * storage. The elements are contiguous and in row-major
+         * order.
+         */
+        T *data() {
+            return m_data;
+        };
+
+        /** @return the distance between consecutive elements
+         * along each dimension
+         */
+        const boost::array<size_t, N> &strides() const {
+            return m_strides;
+        };
+
+        /** @return number of values actually stored. This is
+         * less than size() if the array stores a box only.
+         */
+        size_t stored_size() const {
+            return m_size;
+        };
+
+        /** @param grid point (must be stored)
+         * @return position of the value in the storage
+         */
+        inline size_t linear_index(const GridPoint &gp) const {
+            size_t index = 0;
+            for (size_t d = 0; d < N; d++) {
+                index += (gp[d] - m_origin[d]) * m_strides[d];
+            }
+            return index;
+        };
+
+        inline size_t linear_index(const vector<int> &gp) const {
+            size_t index = 0;
+            for (size_t d = 0; d < N; d++) {
+                index += (gp[d] - m_origin[d]) * m_strides[d];
+            }
+            return index;
+        };
+
+        inline size_t linear_index(const ColumnView<int> &gp) const {
+            size_t index = 0;
+            for (size_t d = 0; d < N; d++) {
+                index += (gp[d] - m_origin[d]) * m_strides[d];
+            }
+            return index;
+        };
+
+        inline T get(const GridPoint &gp) const {
+            return stores(gp) ? m_data[linear_index(gp)] : m_outside;
+        };
+
+        inline void set(const GridPoint &gp, const T &value) {
+            if (!stores(gp)) {
+                throw std::out_of_range("grid point is not stored in the array");
+            }
+            m_data[linear_index(gp)] = value;
+        };
+
+        inline T get(size_t linear_index) const {
+            return m_data[linear_index];
+        };
+
+        inline void set(size_t linear_index, const T &value) {
+            m_data[linear_index] = value;
+        };
+
+        T get(const vector<int> &gp) const {
+            return stores(gp) ? m_data[linear_index(gp)] : m_outside;
+        };
+
+        void set(const vector<int> &gp, const T &value) {
+            if (!stores(gp)) {
+                throw std::out_of_range("grid point is not stored in the array");
+            }
+            m_data[linear_index(gp)] = value;
+        };
+
+        T get(const ColumnView<int> &gp) const {
+            return stores(gp) ? m_data[linear_index(gp)] : m_outside;
+        };
+
+        void set(const ColumnView<int> &gp, const T &value) {
+            if (!stores(gp)) {
+                throw std::out_of_range("grid point is not stored in the array");
+            }
+            m_data[linear_index(gp)] = value;
+        };
+
+#pragma mark -
+#pragma mark Stuff
+
+        void resize(vector<size_t> dimensions) {
+            delete[] m_data;
+            m_data = NULL;
+            this->m_dims = dimensions;
+            this->cover_grid();
+            this->allocate();
+        };
+
+        void populate_array(const T &value) {
+            std::fill(m_data, m_data + m_size, value);
+            m_outside = value;
+        };
+
+        void copy_from(const MultiArray<T> *other) {
+            assert(this->m_dims == other->get_dimensions());
+
+            const MultiArrayFixed<T, N> *fixed = dynamic_cast<const MultiArrayFixed<T, N> *>(other);
+            if (fixed != NULL && fixed->m_origin == m_origin && fixed->m_extent == m_extent) {
+                std::copy(fixed->m_data, fixed->m_data + m_size, m_data);
+                m_outside = fixed->m_outside;
+                return;
+            }
+
+            // Generic path: count through the stored grid
+            // points in storage order
+            vector<int> gp(m_origin.begin(), m_origin.end());
+            for (size_t i = 0; i < m_size; i++) {
+                m_data[i] = other->get(gp);
+                for (int d = ((int) N) - 1; d >= 0; d--) {
+                    if (++gp[d] < m_origin[d] + (int) m_extent[d]) {
+                        break;
+                    }
+                    gp[d] = m_origin[d];
+                }
+            }
+        };
+
+        size_t count_value(const T &value) {
+            size_t count = (size_t) std::count(m_data, m_data + m_size, value);
+            if (value == m_outside) {
+                count += this->size() - m_size;
+            }
+            return count;
+        };
+    };
+}
+
+#endif
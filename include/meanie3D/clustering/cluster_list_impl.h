@@ -29,6 +29,7 @@
 #include <meanie3D/namespaces.h>
 #include <meanie3D/clustering/cluster.h>
 #include <meanie3D/utils/set_utils.h>
+#include <meanie3D/utils/disjoint_sets.h>
 
 #include <algorithm>
 #include <sstream>
@@ -199,9 +200,10 @@ namespace m3D {
             string source_path = file_existed ? path : source_file;
             NcFile *sourcefile = new NcFile(source_path, NcFile::read);
             if (sourcefile == NULL || sourcefile->isNull()) {
-                cerr << "FATAL:could not open file '" << source_path
-                     << "' for obtaining dimension data" << endl;
-                exit(EXIT_FAILURE);
+                std::ostringstream message;
+                message << "could not open file '" << source_path
+                        << "' for obtaining dimension data";
+                throw std::runtime_error(message.str());
             }
 
             try {
@@ -214,9 +216,10 @@ namespace m3D {
                 // the original in that way.
                 file = new NcFile(filename, NcFile::replace);
             } catch (const netCDF::exceptions::NcException &e) {
-                cerr << "FATAL:exception opening file " << filename
-                     << " for writing : " << e.what() << endl;
-                exit(EXIT_FAILURE);
+                std::ostringstream message;
+                message << "exception opening file " << filename
+                        << " for writing : " << e.what();
+                throw std::runtime_error(message.str());
             }
 
             // write version attribute
@@ -316,9 +319,10 @@ namespace m3D {
                 try {
                     cluster_dim = file->addDim(dim_name.str(), cluster->size());
                 } catch (const netCDF::exceptions::NcException &e) {
-                    cerr << "ERROR:exception creating dimension " << dim_name.str()
-                         << ":" << e.what() << endl;
-                    exit(EXIT_FAILURE);
+                    std::ostringstream message;
+                    message << "exception creating dimension " << dim_name.str()
+                            << ":" << e.what();
+                    throw std::runtime_error(message.str());
                 }
 
                 // Create variable
@@ -331,7 +335,10 @@ namespace m3D {
 
                 NcVar var;
                 try {
-                    var = file->addVar(var_name.str(), ncDouble, dims);
+                    // Values are stored in the precision they were
+                    // calculated in. Reading converts as needed.
+                    NcType value_type = (sizeof(T) <= sizeof(float)) ? ncFloat : ncDouble;
+                    var = file->addVar(var_name.str(), value_type, dims);
                     var.setCompression(false, true, 3);
                 } catch (const netCDF::exceptions::NcException &e) {
                     cerr << "ERROR:exception creating dimension " << var_name.str()
@@ -391,8 +398,7 @@ namespace m3D {
                 size_t numElements = cluster->size() * cluster->rank();
                 T *data = (T *) malloc(sizeof(T) * numElements);
                 if (data == NULL) {
-                    cerr << "FATAL:out of memory" << endl;
-                    exit(EXIT_FAILURE);
+                    throw std::runtime_error("out of memory");
                 }
 
                 for (size_t pi = 0; pi < cluster->size(); pi++) {
@@ -619,8 +625,7 @@ namespace m3D {
                 size_t numElements = cluster_size * cluster->rank();
                 T *data = (T *) malloc(sizeof(T) * numElements);
                 if (data == NULL) {
-                    cerr << "FATAL:out of memory" << endl;
-                    exit(EXIT_FAILURE);
+                    throw std::runtime_error("out of memory");
                 }
 
                 var.getVar(data);
@@ -642,10 +647,7 @@ namespace m3D {
 
                         // only when this succeeds do we have the complete
                         // set of data for the point
-                        typename Point<T>::ptr p = PointFactory<T>::get_instance()->create();
-                        p->values = values;
-                        p->coordinate = coordinate;
-                        p->gridpoint = gp;
+                        typename Point<T>::ptr p = PointFactory<T>::get_instance()->create(gp, coordinate, values);
 
                         // add to cluster
                         cluster->add_point(p);
@@ -800,12 +802,13 @@ namespace m3D {
             start_timer();
         }
 
+        typename Point<T>::list neighbours;
         for (typename pset_t::iterator pi = zeroshifts.begin(); pi != zeroshifts.end(); pi++) {
             if (show_progress) {
                 progress->operator++();
             }
             Point<T> *current_point = *pi;
-            typename Point<T>::list neighbours = index.find_neighbours(current_point->gridpoint);
+            index.find_neighbours(current_point->gridpoint, neighbours);
 
             for (size_t ni = 0; ni < neighbours.size(); ni++) {
                 Point<T> *n = neighbours.at(ni);
@@ -918,8 +921,10 @@ namespace m3D {
 
         }
 #endif
-        vector<size_t> dimensions = fs->coordinate_system->get_dimension_sizes();
-        ArrayIndex<T> index(dimensions, fs->points, false);
+        // The index only covers the box spanned by the points. On a
+        // tile that is the tile with its halo, not the whole grid
+        const size_t spatial_rank = fs->spatial_rank();
+        ArrayIndex<T> index(spatial_rank, fs->points, false);
 #if DEBUG_GRAPH_AGGREGATION
         for (size_t i = 0; i < fs->points.size(); i++) {
             Point<T> *p = fs->points[i];
@@ -962,146 +967,210 @@ namespace m3D {
             progress = new boost::progress_display(fs->points.size());
         }
 
-        //        #if WITH_OPENMP
-        //        #pragma omp parallel for schedule(dynamic)
-        //        #endif
-        for (size_t i = 0; i < fs->points.size(); i++) {
-            if (show_progress) {
-                //                #if WITH_OPENMP
-                //                #pragma omp critical
-                //                #endif
-                progress->operator++();
-            }
+        const size_t num_points = fs->points.size();
+        const size_t num_clusters = this->clusters.size();
 
-            Point<T> *current_point = fs->points[i];
-            // skip zeroshift and non-original points
-            if (vector_norm(fs->spatial_component(current_point->shift)) == 0 || !current_point->isOriginalPoint)
-                continue;
-            // Find the predecessor through gridded shift
-            vector<int> gridpoint = current_point->gridpoint + current_point->gridded_shift;
-            Point<T> *predecessor = NULL;
-            try {
-                predecessor = index.get(gridpoint);
-            } catch (std::invalid_argument &e) {
-#if DEBUG_GRAPH_AGGREGATION
-                cout << "gridpoint=" << current_point->gridpoint
-                        << " + gridded_shift = " << current_point->gridded_shift
-                        << " = " << gridpoint
-                        << " which caused exception " << e.what() << endl;
-#endif
-            }
+        // Node of the zero-shift cluster a point belongs to (-1 for none).
+        // The zero-shift clusters are the nodes after the points.
 
-            // Start testing
-            if (predecessor != NULL) {
-                // we're pointing to somebody?
-                current_point->isBoundary = true;
+        map<typename Cluster<T>::ptr, int> cluster_nodes;
+        for (size_t ci = 0; ci < num_clusters; ci++) {
+            cluster_nodes[this->clusters[ci]] = (int) (num_points + ci);
+        }
 
-                // whoever we're pointing to, he's
-                // not a boundary point.
-                predecessor->isBoundary = false;
+        // Find each point's predecessor in the graph (-1 for none) and
+        // unite the connected components of the graph, together with the
+        // zero-shift clusters, on the fly. The rows of the array index are
+        // the positions in the point list.
 
-#if DEBUG_GRAPH_AGGREGATION
-                cout << endl;
-                cout << "current point : " << current_point << " @ " << current_point->gridpoint << " (" << current_point->cluster << ")" << endl;
-                cout << "predecessor   : " << predecessor << " @ " << predecessor->gridpoint << " (" << predecessor->cluster << ")" << endl;
-                // cout << "(reverse lookup of " << x << " = " << gp << ")" << endl;
+        vector<int> predecessors(num_points, -1);
+        vector<int> point_clusters(num_points, -1);
+        utils::DisjointSets components(num_points + num_clusters);
+
+        const size_t chunk_size = 1000;
+        const size_t num_chunks = (num_points + chunk_size - 1) / chunk_size;
+
+#if WITH_OPENMP
+#pragma omp parallel
+        {
 #endif
-                if (current_point->cluster == NULL && predecessor->cluster == NULL) {
-                    // Neither point has a cluster
-                    // => create new one
-
-                    //                    #if WITH_OPENMP
-                    //                    #pragma omp critical
-                    //                    #endif
-                    {
-                        typename Cluster<T>::ptr c = new Cluster<T>(current_point->values,
-                                                                    fs->coordinate_system->rank());
-                        c->id = cluster_id++;
-                        c->add_point(current_point);
-                        c->add_point(predecessor);
-                        clusters.push_back(c);
+        vector<int> gridpoint(spatial_rank);
+
+#if WITH_OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+        for (size_t chunk = 0; chunk < num_chunks; chunk++) {
+            size_t begin = chunk * chunk_size;
+            size_t end = std::min(begin + chunk_size, num_points);
+
+            for (size_t i = begin; i < end; i++) {
+                Point<T> *current_point = fs->points[i];
+                if (current_point->cluster != NULL) {
+                    point_clusters[i] = cluster_nodes.find(current_point->cluster)->second;
+                    components.unite_concurrent((int) i, point_clusters[i]);
+                }
 
+                // skip zeroshift and non-original points
+                if (!current_point->isOriginalPoint)
+                    continue;
+                const ColumnView<T> &shift = current_point->shift;
+                bool zero_shift = true;
+                for (size_t d = 0; d < spatial_rank && zero_shift; d++) {
+                    zero_shift = (shift[d] == 0);
+                }
+                if (zero_shift)
+                    continue;
+                // Find the predecessor through gridded shift
+                const ColumnView<int> &gp = current_point->gridpoint;
+                const ColumnView<int> &gridded_shift = current_point->gridded_shift;
+                for (size_t d = 0; d < gridpoint.size(); d++) {
+                    gridpoint[d] = gp[d] + gridded_shift[d];
+                }
+                int row = index.row(gridpoint);
+                if (row != ArrayIndex<T>::NO_ROW) {
+                    predecessors[i] = row;
+                    components.unite_concurrent((int) i, row);
+                }
 #if DEBUG_GRAPH_AGGREGATION
-                        cout << "created new cluster " << c
-                                << " (" << c->size()
-                                << " points)" << endl;
+                if (predecessors[i] >= 0) {
+#if WITH_OPENMP
+#pragma omp critical
+#endif
+                    cout << "current point : " << current_point << " @ " << current_point->gridpoint
+                         << " -> predecessor " << fs->points[predecessors[i]]
+                         << " @ " << fs->points[predecessors[i]]->gridpoint << endl;
+                }
+#endif
+            }
+
+            if (show_progress) {
+#if WITH_OPENMP
+#pragma omp critical
+#endif
+                (*progress) += (end - begin);
+            }
+        }
+#if WITH_OPENMP
+        }
 #endif
-                    }
-                } else if (current_point->cluster == NULL && predecessor->cluster != NULL) {
-                    // current point has no cluster, but predecessor has one
-                    // => add current point to predecessor's cluster
 
-                    //                    #if WITH_OPENMP
-                    //                    #pragma omp critical
-                    //                    #endif
-                    predecessor->cluster->add_point(current_point);
+        // Boundary flags. Walking the points in order, every point with a
+        // predecessor was flagged as boundary point and its predecessor
+        // as inner point, the last write winning. So a point is a boundary
+        // point if it points somewhere and nobody after it points at it.
 
-#if DEBUG_GRAPH_AGGREGATION
-                    cout << "added current point to cluster "
-                            << predecessor->cluster << " ("
-                            << predecessor->cluster->size()
-                            << " points)" << endl;
+        vector<int> last_reference(num_points, -1);
+        for (size_t i = 0; i < num_points; i++) {
+            if (predecessors[i] >= 0) {
+                last_reference[predecessors[i]] = (int) i;
+            }
+        }
+
+#if WITH_OPENMP
+#pragma omp parallel for schedule(static)
 #endif
-                } else if (current_point->cluster != NULL && predecessor->cluster == NULL) {
-                    // current point has a cluster, but predecessor has none
-                    // => add predecessor to current point's cluster
+        for (size_t i = 0; i < num_points; i++) {
+            if (last_reference[i] >= (int) i) {
+                fs->points[i]->isBoundary = false;
+            } else if (predecessors[i] >= 0) {
+                fs->points[i]->isBoundary = true;
+            } else if (last_reference[i] >= 0) {
+                fs->points[i]->isBoundary = false;
+            }
+        }
 
-                    //                    #if WITH_OPENMP
-                    //                    #pragma omp critical
-                    //                    #endif
-                    current_point->cluster->add_point(predecessor);
+        // Look up the component of each point and each zero-shift
+        // cluster once, with the paths compressed
 
-#if DEBUG_GRAPH_AGGREGATION
-                    cout << "added predecessor to cluster "
-                            << current_point->cluster
-                            << " (" << current_point->cluster->size()
-                            << " points)" << endl;
+        components.compress();
+        const size_t num_nodes = components.size();
+        vector<int> roots(num_nodes);
+#if WITH_OPENMP
+#pragma omp parallel for schedule(static)
 #endif
-                } else if (current_point->cluster != predecessor->cluster) {
-                    // both points have different clusters
-                    // => merge current cluster's points to predecessor's cluster
-                    //    and delete current cluster
+        for (size_t i = 0; i < num_nodes; i++) {
+            roots[i] = components.root((int) i);
+        }
 
-                    // Save a little time by merging the smaller into the bigger cluster
+        // Each component keeps its largest zero-shift cluster (the first
+        // one on a tie). All others are merged into it.
 
-                    typename Cluster<T>::ptr merged;
-                    typename Cluster<T>::ptr mergee;
+        vector<typename Cluster<T>::ptr> component_clusters(num_points + num_clusters, NULL);
+        vector<bool> keep_cluster(num_clusters, false);
+        for (size_t ci = 0; ci < num_clusters; ci++) {
+            typename Cluster<T>::ptr c = this->clusters[ci];
+            typename Cluster<T>::ptr &kept = component_clusters[roots[num_points + ci]];
+            if (kept == NULL || c->size() > kept->size()) {
+                kept = c;
+            }
+        }
+        for (size_t ci = 0; ci < num_clusters; ci++) {
+            keep_cluster[ci] = (component_clusters[roots[num_points + ci]] == this->clusters[ci]);
+        }
 
-                    if (current_point->cluster->size() >= predecessor->cluster->size()) {
-                        merged = current_point->cluster;
-                        mergee = predecessor->cluster;
-                    } else {
-                        merged = predecessor->cluster;
-                        mergee = current_point->cluster;
-                    }
+        // Components without zero-shift cluster get a new one, with the
+        // first point that has a predecessor as mode
+
+        typename Cluster<T>::list new_clusters;
+        for (size_t i = 0; i < num_points; i++) {
+            if (predecessors[i] >= 0 && component_clusters[roots[i]] == NULL) {
+                typename Cluster<T>::ptr c = new Cluster<T>(fs->points[i]->values,
+                                                            fs->coordinate_system->rank());
+                c->id = cluster_id++;
+                component_clusters[roots[i]] = c;
+                new_clusters.push_back(c);
+            }
+        }
 
-#if DEBUG_GRAPH_AGGREGATION
-                    cout << "merging cluster " << mergee << " (" << mergee->size() << " points)"
-                            << "into " << merged << " (" << merged->size() << " points)"
-                            << endl;
-#endif
-                    //                    #if WITH_OPENMP
-                    //                    #pragma omp critical
-                    //                    #endif
-                    {
-                        // absorb predecessor
-                        merged->add_points(mergee->get_points(), false);
-
-                        // remove it
-                        typename Cluster<T>::list::iterator fi = find(clusters.begin(), clusters.end(), mergee);
-                        clusters.erase(fi);
-                        delete mergee;
-                    }
-                } else {
-                    // both points are already part of the same cluster
-                    // => do nothing
+        // Collect the points to be added to each cluster, in point order
 
-#if DEBUG_GRAPH_AGGREGATION
-                    cout << "Both points are part of the same cluster. Skip." << endl;
-#endif
-                }
+        map<typename Cluster<T>::ptr, size_t> cluster_slots;
+        typename Cluster<T>::list targets;
+        for (size_t ci = 0; ci < num_clusters; ci++) {
+            if (keep_cluster[ci]) {
+                cluster_slots[this->clusters[ci]] = targets.size();
+                targets.push_back(this->clusters[ci]);
             }
         }
+        for (size_t ci = 0; ci < new_clusters.size(); ci++) {
+            cluster_slots[new_clusters[ci]] = targets.size();
+            targets.push_back(new_clusters[ci]);
+        }
+
+        vector<typename Point<T>::list> additions(targets.size());
+        for (size_t i = 0; i < num_points; i++) {
+            bool in_graph = predecessors[i] >= 0 || last_reference[i] >= 0 || point_clusters[i] >= 0;
+            if (!in_graph) {
+                continue;
+            }
+            typename Cluster<T>::ptr c = component_clusters[roots[i]];
+            if (fs->points[i]->cluster != c) {
+                additions[cluster_slots[c]].push_back(fs->points[i]);
+            }
+        }
+
+        // Dissolve the merged zero-shift clusters. Their points are
+        // re-assigned below.
+
+        typename Cluster<T>::list remaining;
+        for (size_t ci = 0; ci < num_clusters; ci++) {
+            if (keep_cluster[ci]) {
+                remaining.push_back(this->clusters[ci]);
+            } else {
+                delete this->clusters[ci];
+            }
+        }
+        remaining.insert(remaining.end(), new_clusters.begin(), new_clusters.end());
+        this->clusters.swap(remaining);
+
+        // Label the points. Clusters are independent of each other.
+
+#if WITH_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (size_t ti = 0; ti < targets.size(); ti++) {
+            targets[ti]->add_points(additions[ti], false);
+        }
 
         if (show_progress) {
             cout << "done. (Found " << clusters.size() << " clusters in " << stop_timer() << "s)" << endl;
@@ -1115,6 +1184,7 @@ namespace m3D {
                 start_timer();
             }
 
+            typename Point<T>::list neighbours;
             for (size_t i = 0; i < clusters.size(); i++) {
                 typename Cluster<T>::ptr c = clusters.at(i);
                 T strongest_response = numeric_limits<T>::min();
@@ -1131,7 +1201,7 @@ namespace m3D {
                     }
 
                     // Find the neighbour with the strongest response
-                    typename Point<T>::list neighbours = index.find_neighbours(p->gridpoint);
+                    index.find_neighbours(p->gridpoint, neighbours);
                     for (size_t ni = 0; ni < neighbours.size(); ni++) {
                         Point<T> *n = neighbours.at(ni);
 
@@ -31,6 +31,8 @@
 #include <meanie3D/utils.h>
 #include "detection.h"
 
+#include <algorithm>
+#include <stdexcept>
 #include <vector>
 
 namespace m3D {
@@ -106,30 +108,82 @@ namespace m3D {
             return cluster_list;
         }
 
-        MeanshiftOperation <T> meanshiftOperator(this->feature_space, this->point_index);
-        meanshiftOperator.prime_index(m_context.search_params);
+        // Process the feature-space in blocks of points. Each block is
+        // sampled with a single query, and each thread re-uses
+        // its own buffers from block to block.
+
+        const size_t num_points = this->feature_space->size();
+        const size_t num_blocks = (num_points + MEANSHIFT_BATCH_SIZE - 1) / MEANSHIFT_BATCH_SIZE;
+
+        if (m_params.grid_meanshift) {
+            // Sample by walking a stencil through the grid
+            // instead of querying the index
+            if (m_context.search_params->search_type() != SearchTypeRange) {
+                throw std::runtime_error("grid meanshift requires range search parameters");
+            }
+            RangeSearchParams<T> *p = (RangeSearchParams<T> *) m_context.search_params;
+            GridMeanshiftOperation<T> gridOperator(this->feature_space, p->bandwidth);
 
 #if WITH_OPENMP
 #pragma omp parallel for schedule(dynamic)
 #endif
-        for (size_t index = 0; index < this->feature_space->size(); index++) {
-            if (m_context.show_progress) {
+            for (size_t block = 0; block < num_blocks; block++) {
+                size_t begin = block * MEANSHIFT_BATCH_SIZE;
+                size_t end = std::min(begin + MEANSHIFT_BATCH_SIZE, num_points);
+
+                gridOperator.meanshift(begin, end, m_context.kernel, m_context.weight_function);
+
+                if (m_context.show_progress) {
 #if WITH_OPENMP
 #pragma omp critical
 #endif
-                m_progress_bar->operator++();
+                    (*m_progress_bar) += (end - begin);
+                }
             }
+        } else {
+            MeanshiftOperation <T> meanshiftOperator(this->feature_space, this->point_index);
+            meanshiftOperator.prime_index(m_context.search_params);
+
+#if WITH_OPENMP
+#pragma omp parallel
+            {
+#endif
+            typename MeanshiftOperation<T>::batch_buffer_t buffer;
 
-            // Get the meanshift vector for this point
-            typename Point<T>::ptr x = this->feature_space->points[index];
-            x->shift = meanshiftOperator.meanshift(x->values,
-                                                   m_context.search_params,
-                                                   m_context.kernel,
-                                                   m_context.weight_function);
+#if WITH_OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+            for (size_t block = 0; block < num_blocks; block++) {
+                size_t begin = block * MEANSHIFT_BATCH_SIZE;
+                size_t end = std::min(begin + MEANSHIFT_BATCH_SIZE, num_points);
+
+                // Get the meanshift vectors for this block
+                meanshiftOperator.meanshift(this->feature_space->points,
+                                            begin, end,
+                                            m_context.search_params,
+                                            m_context.kernel,
+                                            m_context.weight_function,
+                                            buffer);
+
+                for (size_t index = begin; index < end; index++) {
+                    if (m_context.show_progress) {
+#if WITH_OPENMP
+#pragma omp critical
+#endif
+                        m_progress_bar->operator++();
+                    }
 
-            // Extract the spatial component and obtain the grid
-            vector<T> spatial_shift = this->feature_space->spatial_component(x->shift);
-            x->gridded_shift = this->feature_space->coordinate_system->to_gridpoints(spatial_shift);
+                    typename Point<T>::ptr x = this->feature_space->points[index];
+                    x->shift = buffer.shifts[index - begin];
+
+                    // Extract the spatial component and obtain the grid
+                    vector<T> spatial_shift = this->feature_space->spatial_component(x->shift);
+                    x->gridded_shift = this->feature_space->coordinate_system->to_gridpoints(spatial_shift);
+                }
+            }
+#if WITH_OPENMP
+            }
+#endif
         }
 
         if (m_context.show_progress) {
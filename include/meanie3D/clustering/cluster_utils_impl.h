@@ -213,12 +213,31 @@ namespace m3D {
         }
     }
 
+    /** Neighbourhood visitor, which stops at the first
+     * point in the off-limits area.
+     */
+    template<typename T>
+    class OffLimitsNeighbourVisitor
+    {
+        const MultiArray<bool> *m_off_limits;
+
+    public:
+
+        OffLimitsNeighbourVisitor(const MultiArray<bool> *off_limits)
+                : m_off_limits(off_limits) {
+        };
+
+        bool operator()(typename Point<T>::ptr n) {
+            return !m_off_limits->get(n->gridpoint);
+        };
+    };
+
     template<typename T>
     void
     ClusterUtils<T>::obtain_margin_flag(typename ClusterList<T>::ptr list,
                                         typename FeatureSpace<T>::ptr fs) {
-        vector<size_t> dims = fs->coordinate_system->get_dimension_sizes();
-        ArrayIndex<T> index(dims, fs->points, false);
+        ArrayIndex<T> index(fs->spatial_rank(), fs->points, false);
+        OffLimitsNeighbourVisitor<T> visitor(fs->off_limits());
         typename Cluster<T>::list::iterator ci;
         for (ci = list->clusters.begin(); ci != list->clusters.end(); ++ci) {
             typename Cluster<T>::ptr c = *ci;
@@ -226,15 +245,8 @@ namespace m3D {
             for (pi = c->get_points().begin(); pi != c->get_points().end() && !c->has_margin_points(); ++pi) {
                 typename Point<T>::ptr p = *pi;
                 if (!p->isOriginalPoint) continue;
-                typename Point<T>::list neighbors;
-                neighbors = index.find_neighbours(p->gridpoint, 1);
-                typename Point<T>::list::iterator ni;
-                for (ni = neighbors.begin(); ni != neighbors.end(); ++ni) {
-                    typename Point<T>::ptr n = *ni;
-                    if (fs->off_limits()->get(n->gridpoint)) {
-                        c->set_has_margin_points(true);
-                        break;
-                    }
+                if (!index.visit_neighbours(p->gridpoint, visitor, 1)) {
+                    c->set_has_margin_points(true);
                 }
             }
         }
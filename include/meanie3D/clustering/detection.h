@@ -31,6 +31,7 @@
 #include <meanie3D/filters/replacement_filter.h>
 #include <meanie3D/filters/scalespace_filter.h>
 #include <meanie3D/index/search_parameters.h>
+#include <meanie3D/utils/cluster_index.h>
 
 namespace m3D {
 
@@ -84,6 +85,16 @@ namespace m3D {
         // bandwidth from scale when present.
         vector<T> ranges;
 
+        // Convolution method of the scale-space filter. The recursive
+        // Gaussian costs the same at any scale.
+        ScaleSpaceMethod scale_space_method;
+
+        // When not empty, the detection runs once for each of these
+        // scale parameters, in ascending order, with a single data load.
+        // Each scale is smoothed from the previous one and the clusters
+        // of each scale go to a file of their own. Replaces scale.
+        vector<double> scales;
+
         // Contains a list of variables to exclude from scale-space filtering
         vector<std::string> exclude_from_scale_space_filtering;
 
@@ -142,6 +153,37 @@ namespace m3D {
         // with lower response. Use cautious, very time consuming.
         bool coalesceWithStrongestNeighbour;
 
+        // When this flag is true, the mean-shift samples are collected
+        // by walking a stencil over the grid instead of searching the
+        // point index.
+        bool grid_meanshift;
+
+        // When greater than 0, the mean-shift samples are the knn
+        // nearest neighbours of each point, and the bandwidth adapts to
+        // the distance of the farthest one. 0 means the fixed bandwidth
+        // range search is used.
+        size_t knn;
+
+        // Accuracy and speed settings of the mean-shift search index.
+        // Exact search by default.
+        index_params_t index_params;
+
+        // When true and the index is approximate, the clustering is
+        // repeated with exact search and the cluster assignments of
+        // both runs are compared.
+        bool index_accuracy_report;
+
+        // When not empty, the domain is processed in tiles of this
+        // many grid points in each spatial dimension. Each tile is
+        // extended by a halo (see DETECTION_TILE_HALO) and clustered on
+        // its own, and the clusters are stitched together across the
+        // seams afterwards. Memory then scales with the tile size.
+        vector<size_t> tile_size;
+
+        // When true, the tiles of a tiled detection are processed
+        // in parallel. Each tile is then processed single threaded.
+        bool parallel_tiles;
+
         // Verbosity of the processing chain. From 0 (silent) to 3 
         // (extremely verbose).
         Verbosity verbosity;
@@ -274,6 +316,12 @@ namespace m3D {
         // The main subject of interest
         FeatureSpace<T> *fs;
 
+        // When not empty, the feature-space is constructed from the
+        // grid points in this box only. Used for the tiles of a tiled
+        // detection run.
+        vector<size_t> region_origin;
+        vector<size_t> region_size;
+
         // Automatically calculated 
         T kernel_width;
         T filter_width; // TODO: check if this is still needed?
@@ -295,11 +343,83 @@ namespace m3D {
         // K/D tree or other quick lookup index for mean-shift
         PointIndex<T> *index;
 
+        // Index on the spatial components of the feature-space's
+        // points, shared by filters and weight functions. Filters
+        // removing points keep it up to date.
+        PointIndex<T> *spatial_index;
+
         // Resulting cluster list.
         typename ClusterList<T>::ptr clusters;
 
         // In case previous clusters are loaded, this contains those
         typename ClusterList<T>::ptr previous_clusters;
+
+        // False if the previous clusters were handed in from
+        // memory rather than read from file. They are not
+        // deleted in cleanup in that case.
+        bool owns_previous_clusters;
+    };
+
+    /**
+     * One tile of a tiled detection run. All extents are
+     * in grid points.
+     */
+    template<typename T>
+    struct detection_tile_t
+    {
+        // The part of the grid the tile is responsible for
+        vector<size_t> core_origin;
+        vector<size_t> core_size;
+
+        // Core plus halo, clipped to the grid. This is
+        // the part that is actually clustered.
+        vector<size_t> origin;
+        vector<size_t> size;
+
+        // Width of the halo in each dimension
+        vector<size_t> halo;
+
+        // Clusters found in the tile. Only the points
+        // in the core are kept.
+        typename ClusterList<T>::ptr clusters;
+
+        // (linear grid index, cluster index) of each clustered
+        // point in the halo
+        vector<std::pair<size_t, size_t> > halo_labels;
+
+        // Cluster index of each clustered core point that lies
+        // in the halo of a neighbouring tile, by linear grid index
+        map<size_t, size_t> seam_labels;
+
+        /** @return true if the grid point lies in the core */
+        template<class GridPoint>
+        bool
+        core_contains(const GridPoint &gridpoint) const {
+            for (size_t d = 0; d < core_origin.size(); d++) {
+                if (gridpoint[d] < (int) core_origin[d]
+                    || gridpoint[d] >= (int) (core_origin[d] + core_size[d])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /** @return true if the grid point (in the core) lies in
+         * the halo of a neighbouring tile
+         */
+        template<class GridPoint>
+        bool
+        seam_contains(const GridPoint &gridpoint, const vector<size_t> &dims) const {
+            for (size_t d = 0; d < core_origin.size(); d++) {
+                size_t g = (size_t) gridpoint[d];
+                size_t end = core_origin[d] + core_size[d];
+                if ((core_origin[d] > 0 && g < core_origin[d] + halo[d])
+                    || (end < dims[d] && g + halo[d] >= end)) {
+                    return true;
+                }
+            }
+            return false;
+        }
     };
 
     /** This class contains the tracking code.
@@ -340,6 +460,40 @@ namespace m3D {
         initialiseContext(const detection_params_t<T> &params,
                           detection_context_t<T> &ctx);
 
+        /**
+         * Initialize a detection context, re-using state that is
+         * kept in memory between consecutive runs on the same grid.
+         * Neither the coordinate system nor the previous clusters
+         * become property of the context.
+         *
+         * @param params
+         * @param ctx
+         * @param coordinate system to use. If NULL, one is
+         * constructed from the file.
+         * @param previous clusters for inline tracking or post-
+         * processing. If NULL, they are read from the file given
+         * in the parameters (if required).
+         */
+        static
+        void
+        initialiseContext(const detection_params_t<T> &params,
+                          detection_context_t<T> &ctx,
+                          CoordinateSystem<T> *coord_system,
+                          typename ClusterList<T>::ptr previous_clusters);
+
+        /**
+         * Calculates the mean-shift bandwidth, search parameters and
+         * kernel for the scale (or ranges) given in the parameters.
+         * Any previous search parameters and kernel are deleted.
+         *
+         * @param params
+         * @param ctx (with data store)
+         */
+        static
+        void
+        initialise_bandwidth(const detection_params_t<T> &params,
+                             detection_context_t<T> &ctx);
+
         /**
          * Frees any memory allocated as a matter of parameter
          * parsing or processing.
@@ -364,6 +518,201 @@ namespace m3D {
         run(const detection_params_t<T> &params,
             detection_context_t<T> &ctx);
 
+        /**
+         * Constructs the feature-space and applies the filters
+         * and the weight function. If the context has a region, the
+         * feature-space is constructed from that region only.
+         *
+         * @param parameters
+         * @param (initialised) context
+         */
+        static
+        void
+        prepare_featurespace(const detection_params_t<T> &params,
+                             detection_context_t<T> &ctx);
+
+        /**
+         * Constructs the feature-space and applies the replacement
+         * and convection filters. First part of prepare_featurespace.
+         *
+         * @param parameters
+         * @param (initialised) context
+         */
+        static
+        void
+        build_featurespace(const detection_params_t<T> &params,
+                           detection_context_t<T> &ctx);
+
+        /**
+         * Constructs the weight function and applies the weight
+         * threshold filter, if asked for. Last part of
+         * prepare_featurespace.
+         *
+         * @param parameters
+         * @param context (feature-space must be smoothed)
+         */
+        static
+        void
+        apply_weight_function(const detection_params_t<T> &params,
+                              detection_context_t<T> &ctx);
+
+        /**
+         * Creates the search index (if required) and clusters
+         * the context's feature-space into ctx.clusters.
+         *
+         * @param parameters
+         * @param context (feature-space must be prepared)
+         */
+        static
+        void
+        cluster(const detection_params_t<T> &params,
+                detection_context_t<T> &ctx);
+
+        /**
+         * Hands out ids and uuids to the clusters, collates them with
+         * the previous clusters (if asked for) and writes them to the
+         * output file.
+         *
+         * @param parameters
+         * @param context (with clusters)
+         */
+        static
+        void
+        finalise_clusters(const detection_params_t<T> &params,
+                          detection_context_t<T> &ctx);
+
+        /**
+         * Runs the detection for each of the scales in params.scales.
+         * The feature-space is built once, and each scale is smoothed
+         * from the previous one with the difference of the scales. The
+         * clusters of each scale are written to the output file name
+         * with the scale appended (see scale_output_filename). The
+         * context holds the clusters of the largest scale afterwards.
+         *
+         * @param parameters
+         * @param (initialised) context
+         */
+        static
+        void
+        run_multiscale(const detection_params_t<T> &params,
+                       detection_context_t<T> &ctx);
+
+        /**
+         * @param output file name
+         * @param scale
+         * @return output file name for the given scale in
+         * a multi-scale run (empty if filename is empty)
+         */
+        static
+        std::string
+        scale_output_filename(const std::string &filename, double scale);
+
+        /**
+         * Cuts the grid into tiles of the size given in the
+         * parameters. The halo is DETECTION_TILE_HALO times the
+         * spatial bandwidth, or the scale-space filter width if that
+         * is wider. Tiles are ordered with the last dimension
+         * running fastest.
+         *
+         * @param parameters
+         * @param (initialised) context
+         * @return tiles
+         */
+        static
+        vector<detection_tile_t<T> >
+        create_tiles(const detection_params_t<T> &params,
+                     const detection_context_t<T> &ctx);
+
+        /**
+         * Prepares and clusters the feature-space of each tile,
+         * then stitches the tiles' clusters into ctx.clusters. The
+         * stitched clusters' points are owned by ctx.fs. The result
+         * does not depend on the order in which the tiles were
+         * processed.
+         *
+         * @param parameters
+         * @param (initialised) context
+         */
+        static
+        void
+        cluster_tiled(const detection_params_t<T> &params,
+                      detection_context_t<T> &ctx);
+
+        /**
+         * Merges the clusters of all tiles. A cluster seen in a
+         * tile's halo is merged with the cluster of the neighbouring
+         * tile that owns the majority of its points there. Merging
+         * goes by the lowest cluster index, so that the outcome is
+         * deterministic.
+         *
+         * @param parameters
+         * @param context
+         * @param tiles (cluster lists are emptied)
+         * @return merged clusters
+         */
+        static
+        typename Cluster<T>::list
+        stitch_tiles(const detection_params_t<T> &params,
+                     const detection_context_t<T> &ctx,
+                     vector<detection_tile_t<T> > &tiles);
+
+        /**
+         * Creates an index on the spatial components of the context's
+         * feature-space points, which supports removing points in place.
+         *
+         * @param context (feature-space must be constructed)
+         * @return index. The caller takes ownership.
+         */
+        static
+        PointIndex<T> *
+        create_spatial_index(const detection_context_t<T> &ctx);
+
+        /**
+         * Clusters the context's feature-space with an exact index
+         * and returns the resulting labels, as reference for judging
+         * the accuracy of an approximate index. The feature-space is
+         * restored to its previous state afterwards.
+         *
+         * @param parameters
+         * @param context (feature-space must be constructed)
+         * @param number of clusters in the reference (result)
+         * @param number of clustered points in the reference (result)
+         * @param time taken for clustering in seconds (result)
+         * @return cluster labels. The caller takes ownership.
+         */
+        static
+        ClusterIndex<T> *
+        exact_reference(const detection_params_t<T> &params,
+                        detection_context_t<T> &ctx,
+                        size_t &num_clusters,
+                        size_t &num_points,
+                        double &time);
+
+        /**
+         * Compares the clusters of an approximate run with the exact
+         * reference and prints the differences. Each cluster is matched
+         * with the cluster of the other run it shares most points with.
+         * Points outside of the matched cluster count as differently
+         * assigned, in whichever direction has more of them.
+         *
+         * @param parameters
+         * @param context (with approximate clusters)
+         * @param exact reference labels
+         * @param number of clusters in the reference
+         * @param number of clustered points in the reference
+         * @param time of the exact run
+         * @param time of the approximate run
+         */
+        static
+        void
+        report_index_accuracy(const detection_params_t<T> &params,
+                              const detection_context_t<T> &ctx,
+                              ClusterIndex<T> &reference,
+                              size_t reference_clusters,
+                              size_t reference_points,
+                              double reference_time,
+                              double time);
+
     };
 }
 
@@ -118,6 +118,46 @@ namespace m3D {
                 ("coalesce-with-strongest-neighbour",
                  "If present, clusters are post-processed, coalescing each cluster "
                          "with their strongest neighbour")
+                ("grid-meanshift",
+                 "If present, the mean-shift samples are collected directly from "
+                         "the grid instead of a search index")
+                ("knn",
+                 program_options::value<size_t>()->default_value(params.knn),
+                 "If greater than 0, the mean-shift samples are the given number of "
+                         "nearest neighbours, and the bandwidth adapts to their distance "
+                         "(in units of --ranges or the automatic bandwidth). "
+                         "Not available with --grid-meanshift.")
+                ("approximate-index",
+                 "If present, the mean-shift samples are searched in a forest of "
+                         "randomized k-d trees. This is faster, but approximate. "
+                         "See --index-trees and --index-checks.")
+                ("index-trees",
+                 program_options::value<int>()->default_value(params.index_params.trees),
+                 "Number of randomized k-d trees with --approximate-index.")
+                ("index-checks",
+                 program_options::value<int>()->default_value(params.index_params.checks),
+                 "Number of leaves checked per search with --approximate-index. "
+                         "Higher values are slower, but closer to exact search.")
+                ("index-threads",
+                 program_options::value<int>()->default_value(params.index_params.threads),
+                 "Number of threads used for constructing the index and for "
+                         "batched searches. 0 means all available cores.")
+                ("index-single-precision",
+                 "If present, the search index keeps its copy of the feature-space "
+                         "in single precision. This halves the memory of the index, but "
+                         "points right on the edge of a search range may be found or "
+                         "missed differently.")
+                ("index-accuracy-report",
+                 "If present with --approximate-index, the clustering is repeated with "
+                         "exact search and the differences in the cluster assignments "
+                         "are reported.")
+                ("tile-size",
+                 program_options::value<string>(),
+                 "If present, the domain is processed in tiles of the given number of "
+                         "grid points per dimension (dim1,...,dimN), which limits memory "
+                         "use on large domains. Clusters are stitched across the tile seams.")
+                ("parallel-tiles",
+                 "If present with --tile-size, the tiles are processed in parallel.")
                 ("postprocess-with-previous-output",
                  "If present, the --previous-output file is used to consolidate "
                          "current results. This is time consuming and has a propensity to "
@@ -126,6 +166,18 @@ namespace m3D {
                  program_options::value<double>()->default_value(params.scale),
                  "Scale parameter to pre-smooth the data with. Filter size is "
                          "calculated from this automatically.")
+                ("scales",
+                 program_options::value<string>(),
+                 "Comma separated list of scale parameters (t1,...,tN). If present, "
+                         "the detection runs for each scale in one go, smoothing each scale "
+                         "from the previous one, and writes one cluster file per scale. "
+                         "The scale is appended to the output file name.")
+                ("scale-space-method",
+                 program_options::value<string>()->default_value("sampled"),
+                 "Convolution used by the scale-space filter. 'sampled' uses the sampled "
+                         "Gaussian, whose cost grows with the scale. 'recursive' uses a recursive "
+                         "approximation with constant cost per grid point, which pays off at large "
+                         "scales.")
                 ("filter-size,l",
                  program_options::value<double>()->default_value(0.0),
                  "Scale parameter to pre-smooth the data with. Scale parameter "
@@ -332,6 +384,30 @@ namespace m3D {
                                 + "ranges=" + vm["ranges"].as<string>();
         }
 
+        // parse tile size if there
+        if (vm.count("tile-size") > 0) {
+            tokenizer tile_tokens(vm["tile-size"].as<string>(), sep);
+            for (tokenizer::iterator tok_iter = tile_tokens.begin(); tok_iter != tile_tokens.end(); ++tok_iter) {
+                const char *ts = (*tok_iter).c_str();
+                params.tile_size.push_back((size_t) strtol(ts, (char **) NULL, 10));
+            }
+            if (params.tile_size.size() != params.dimensions.size()) {
+                cerr << "Please provide " << params.dimensions.size() << " tile size values" << endl;
+                exit(EXIT_FAILURE);
+            }
+            for (size_t i = 0; i < params.tile_size.size(); i++) {
+                if (params.tile_size[i] == 0) {
+                    cerr << "ERROR:--tile-size values must be at least 1" << endl;
+                    exit(EXIT_FAILURE);
+                }
+            }
+        }
+        params.parallel_tiles = vm.count("parallel-tiles") > 0;
+        if (params.parallel_tiles && params.tile_size.empty()) {
+            cerr << "ERROR:--parallel-tiles requires --tile-size" << endl;
+            exit(EXIT_FAILURE);
+        }
+
         // Lower Thresholds
 
         if (vm.count("lower-thresholds") > 0) {
@@ -435,6 +511,38 @@ namespace m3D {
         // Scale parameter
         params.scale = vm["scale"].as<double>();
 
+        // Multiple scales
+        if (vm.count("scales") > 0) {
+            tokenizer scale_tokens(vm["scales"].as<string>(), sep);
+            for (tokenizer::iterator tok_iter = scale_tokens.begin(); tok_iter != scale_tokens.end(); ++tok_iter) {
+                double scale = strtod((*tok_iter).c_str(), (char **) NULL);
+                if (scale <= 0) {
+                    cerr << "ERROR:--scales values must be greater than zero" << endl;
+                    exit(EXIT_FAILURE);
+                }
+                params.scales.push_back(scale);
+            }
+            if (params.scales.empty()) {
+                cerr << "ERROR:--scales requires at least one scale" << endl;
+                exit(EXIT_FAILURE);
+            }
+            if (vm.count("scale") > 0 && !vm["scale"].defaulted()) {
+                cerr << "ERROR:--scales can not be combined with --scale" << endl;
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        std::string scale_space_method = vm["scale-space-method"].as<string>();
+        if (scale_space_method == "sampled") {
+            params.scale_space_method = ScaleSpaceSampledKernel;
+        } else if (scale_space_method == "recursive") {
+            params.scale_space_method = ScaleSpaceRecursiveGaussian;
+        } else {
+            cerr << "ERROR:illegal scale-space method " << scale_space_method
+                 << ". Only 'sampled' or 'recursive' are accepted." << endl;
+            exit(EXIT_FAILURE);
+        }
+
         // Kernel
         params.kernel_name = vm["kernel-name"].as<string>();
 
@@ -464,6 +572,44 @@ namespace m3D {
         // Coalescence?
         params.coalesceWithStrongestNeighbour = vm.count("coalesce-with-strongest-neighbour") > 0;
 
+        // Grid based meanshift?
+        params.grid_meanshift = vm.count("grid-meanshift") > 0;
+
+        // Adaptive bandwidth?
+        params.knn = vm["knn"].as<size_t>();
+        if (params.knn > 0 && params.grid_meanshift) {
+            cerr << "ERROR:--knn can not be combined with --grid-meanshift" << endl;
+            exit(EXIT_FAILURE);
+        }
+
+        // Search index accuracy
+        params.index_params.approximate = vm.count("approximate-index") > 0;
+        params.index_params.trees = vm["index-trees"].as<int>();
+        params.index_params.checks = vm["index-checks"].as<int>();
+        params.index_params.threads = vm["index-threads"].as<int>();
+        params.index_params.single_precision = vm.count("index-single-precision") > 0;
+        if (params.index_params.trees < 1 || params.index_params.checks < 1) {
+            cerr << "ERROR:--index-trees and --index-checks must be at least 1" << endl;
+            exit(EXIT_FAILURE);
+        }
+        if (params.index_params.threads < 0) {
+            cerr << "ERROR:--index-threads can not be negative" << endl;
+            exit(EXIT_FAILURE);
+        }
+        params.index_accuracy_report = vm.count("index-accuracy-report") > 0;
+        if (params.index_accuracy_report && !params.index_params.approximate) {
+            cerr << "ERROR:--index-accuracy-report requires --approximate-index" << endl;
+            exit(EXIT_FAILURE);
+        }
+        if (params.index_accuracy_report && !params.tile_size.empty()) {
+            cerr << "ERROR:--index-accuracy-report can not be combined with --tile-size" << endl;
+            exit(EXIT_FAILURE);
+        }
+        if (!params.scales.empty() && (params.index_accuracy_report || !params.tile_size.empty())) {
+            cerr << "ERROR:--scales can not be combined with --index-accuracy-report or --tile-size" << endl;
+            exit(EXIT_FAILURE);
+        }
+
         // only spatial range?
         params.spatial_range_only = vm.count("spatial-range-only") > 0;
 
@@ -544,6 +690,11 @@ namespace m3D {
         // Inline tracking?
         params.inline_tracking = vm.count("inline-tracking") > 0;
 
+        if (params.inline_tracking && !params.scales.empty()) {
+            cerr << "ERROR:--inline-tracking can not be combined with --scales" << endl;
+            exit(EXIT_FAILURE);
+        }
+
         if (params.inline_tracking && params.previous_clusters_filename == NULL) {
             cerr << "FATAL:when --inline-tracking is set you must give "
                  << "--previous-output as well" << endl;
@@ -612,10 +763,16 @@ namespace m3D {
             cout << "\tusing upper thresholds " << vm["upper-thresholds"].as<string>() << endl;
         }
 
-        if (params.scale != Detection<T>::NO_SCALE) {
+        if (!params.scales.empty()) {
+            cout << "\tmulti-scale detection with scale parameters " << params.scales << " ("
+                 << (params.scale_space_method == ScaleSpaceRecursiveGaussian ? "recursive" : "sampled")
+                 << " gaussian)" << endl;
+        } else if (params.scale != Detection<T>::NO_SCALE) {
             cout << "\tpre-smoothing data with scale parameter "
                  << params.scale << " (kernel width = "
-                 << ctx.kernel_width << ")" << endl;
+                 << ctx.kernel_width << ", "
+                 << (params.scale_space_method == ScaleSpaceRecursiveGaussian ? "recursive" : "sampled")
+                 << " gaussian)" << endl;
         } else {
             cout << "\tno scale-space smoothing" << endl;
         }
@@ -677,6 +834,29 @@ namespace m3D {
              << (params.coalesceWithStrongestNeighbour ? "yes" : "no") <<
              endl;
 
+        cout << "\tmean-shift samples taken from the grid: "
+             << (params.grid_meanshift ? "yes" : "no") << endl;
+
+        if (params.knn > 0) {
+            cout << "\tadaptive bandwidth from " << params.knn << " nearest neighbours" << endl;
+        }
+
+        if (params.index_params.approximate) {
+            cout << "\tapproximate search index: trees=" << params.index_params.trees
+                 << " checks=" << params.index_params.checks
+                 << " threads=" << params.index_params.threads
+                 << (params.index_accuracy_report ? " (with accuracy report)" : "") << endl;
+        }
+
+        if (params.index_params.single_precision) {
+            cout << "\tsearch index in single precision" << endl;
+        }
+
+        if (!params.tile_size.empty()) {
+            cout << "\tprocessed in tiles of " << params.tile_size << " grid points"
+                 << (params.parallel_tiles ? " (in parallel)" : "") << endl;
+        }
+
         cout << "\toutput written to file: " << params.output_filename << endl;
 
 #if WITH_VTK
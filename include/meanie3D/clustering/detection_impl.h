@@ -23,6 +23,7 @@
 #ifndef M3D_DETECTION_IMPL_H
 #define    M3D_DETECTION_IMPL_H
 
+#include <algorithm>
 #include <exception>
 #include <fstream>
 #include <limits>
@@ -31,10 +32,12 @@
 #include <netcdf>
 #include <stdlib.h>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
 #include <boost/cast.hpp>
+#include <boost/lexical_cast.hpp>
 
 #include <meanie3D/utils/verbosity.h>
 #include <meanie3D/filters/convection_filter.h>
@@ -88,8 +91,13 @@ namespace m3D {
         p.cluster_coverage_threshold = 0.66;
         p.convection_filter_index = -1;
         p.coalesceWithStrongestNeighbour = false;
+        p.grid_meanshift = false;
+        p.knn = 0;
+        p.index_accuracy_report = false;
+        p.parallel_tiles = false;
         p.spatial_range_only = false;
         p.scale = Detection<T>::NO_SCALE;
+        p.scale_space_method = ScaleSpaceSampledKernel;
         p.verbosity = VerbosityNormal;
         p.inline_tracking = false;
         return p;
@@ -101,6 +109,7 @@ namespace m3D {
         ctx.file = NULL;
         ctx.clusters = NULL;
         ctx.previous_clusters = NULL;
+        ctx.owns_previous_clusters = true;
         ctx.search_params = NULL;
         ctx.kernel = NULL;
         ctx.kernel_width = 0.0;
@@ -112,6 +121,7 @@ namespace m3D {
         ctx.coord_system = NULL;
         ctx.data_store = NULL;
         ctx.index = NULL;
+        ctx.spatial_index = NULL;
         ctx.initialised = false;
         ctx.sf = NULL;
         ctx.weight_function = NULL;
@@ -122,26 +132,72 @@ namespace m3D {
     void
     Detection<T>::initialiseContext(const detection_params_t<T> &params,
                                     detection_context_t<T> &ctx) {
+        Detection<T>::initialiseContext(params, ctx, NULL, NULL);
+    }
+
+    template<typename T>
+    void
+    Detection<T>::initialiseContext(const detection_params_t<T> &params,
+                                    detection_context_t<T> &ctx,
+                                    CoordinateSystem<T> *coord_system,
+                                    typename ClusterList<T>::ptr previous_clusters) {
         Detection<T>::initialiseContext(ctx);
         try {
             ctx.file = new NcFile(params.filename, NcFile::read);
         } catch (const netCDF::exceptions::NcException &e) {
-            cerr << "ERROR: could not open file '" << params.filename
-                 << "' for reading: " << e.what() << endl;
-            exit(EXIT_FAILURE);
+            std::ostringstream message;
+            message << "could not open file '" << params.filename
+                    << "' for reading: " << e.what();
+            throw std::runtime_error(message.str());
         }
 
         ctx.data_store = new NetCDFDataStore<T>(params.filename,
                                                 params.variables,
                                                 params.dimensions,
                                                 params.dimension_variables,
-                                                params.time_index);
+                                                params.time_index,
+                                                coord_system);
 
         ctx.show_progress = (params.verbosity > VerbositySilent);
 
         // Get timestamp
         ctx.timestamp = netcdf::get_time_checked<timestamp_t>(params.filename, params.time_index);
 
+        // Construct a coordinate system object from the dimensions
+        // and dimension variables given
+        ctx.coord_system = ctx.data_store->coordinate_system();
+
+        Detection<T>::initialise_bandwidth(params, ctx);
+
+        ctx.wwf_apply = (params.wwf_lower_threshold != 0
+                         || params.wwf_upper_threshold != std::numeric_limits<T>::max());
+
+        if (previous_clusters != NULL) {
+            ctx.previous_clusters = previous_clusters;
+            ctx.owns_previous_clusters = false;
+        } else if (params.inline_tracking || params.postprocess_with_previous_output) {
+            if (params.previous_clusters_filename == NULL) {
+                std::ostringstream message;
+                message << "inline tracking or postprocessing with previous output"
+                        << " wanted but previous output is missing";
+                throw std::runtime_error(message.str());
+            }
+            ctx.previous_clusters = ClusterList<T>::read(*params.previous_clusters_filename);
+        }
+
+        ctx.initialised = true;
+    };
+
+#define delete_and_clear(X) if (X != NULL) {delete X; X = NULL;}
+
+    template<typename T>
+    void
+    Detection<T>::initialise_bandwidth(const detection_params_t<T> &params,
+                                       detection_context_t<T> &ctx) {
+        ctx.bandwidth.clear();
+        delete_and_clear(ctx.search_params);
+        delete_and_clear(ctx.kernel);
+
         // Calculate mean-shift bandwidth if necessary
         if (!params.ranges.empty()) {
             // calculate kernel width as average of ranges
@@ -164,7 +220,18 @@ namespace m3D {
                 ctx.bandwidth.push_back(range);
             }
         }
-        ctx.search_params = new RangeSearchParams<T>(ctx.bandwidth);
+        if (params.knn > 0) {
+            // The bandwidth becomes the unit of the neighbourhood
+            // metric, which is scaled per point. The resolution used
+            // for cluster boundaries is the same as for range search
+            vector<T> resolution = ((T) 4.0) * ctx.data_store->coordinate_system()->resolution();
+            for (size_t i = resolution.size(); i < ctx.bandwidth.size(); i++) {
+                resolution.push_back(ctx.bandwidth[i]);
+            }
+            ctx.search_params = new KNNSearchParams<T>(params.knn, resolution, ctx.bandwidth);
+        } else {
+            ctx.search_params = new RangeSearchParams<T>(ctx.bandwidth);
+        }
 
         // Calculate kernel width if necessary
         if (params.scale != Detection<T>::NO_SCALE) {
@@ -175,13 +242,6 @@ namespace m3D {
             }
         }
 
-        // Construct a coordinate system object from the dimensions
-        // and dimension variables given
-        ctx.coord_system = ctx.data_store->coordinate_system();
-
-        ctx.wwf_apply = (params.wwf_lower_threshold != 0
-                         || params.wwf_upper_threshold != std::numeric_limits<T>::max());
-
         // Construct the kernel
         if (params.kernel_name == "uniform") {
             ctx.kernel = new UniformKernel<T>(ctx.kernel_width);
@@ -190,37 +250,33 @@ namespace m3D {
         } else if (params.kernel_name == "epanechnikov") {
             ctx.kernel = new EpanechnikovKernel<T>(ctx.kernel_width);
         }
-
-        if (params.inline_tracking || params.postprocess_with_previous_output) {
-            if (params.previous_clusters_filename == NULL) {
-                cerr << "inline tracking or postprocessing with previous output"
-                     << " wanted but previous output is missing" << endl;
-                exit(EXIT_FAILURE);
-            }
-            ctx.previous_clusters = ClusterList<T>::read(*params.previous_clusters_filename);
-        }
-
-        ctx.initialised = true;
-    };
-
-#define delete_and_clear(X) if (X != NULL) {delete X; X = NULL;}
+    }
 
     template<typename T>
     void
     Detection<T>::cleanup(detection_params_t<T> &params,
                           detection_context_t<T> &ctx) {
         // context
-        ctx.clusters->clear();
-        ctx.fs->clear();
+        if (ctx.clusters != NULL) {
+            ctx.clusters->clear();
+        }
+        if (ctx.fs != NULL) {
+            ctx.fs->clear();
+        }
         delete_and_clear(ctx.search_params)
         delete_and_clear(ctx.data_store);
+        delete_and_clear(ctx.spatial_index);
         delete_and_clear(ctx.fs);
         delete_and_clear(ctx.weight_function);
         delete_and_clear(ctx.sf);
         delete_and_clear(ctx.kernel);
         delete_and_clear(ctx.index);
         delete_and_clear(ctx.clusters);
-        delete_and_clear(ctx.previous_clusters);
+        if (ctx.owns_previous_clusters) {
+            delete_and_clear(ctx.previous_clusters);
+        } else {
+            ctx.previous_clusters = NULL;
+        }
         delete_and_clear(ctx.file);
 
         // params
@@ -237,146 +293,72 @@ namespace m3D {
             Detection<T>::initialiseContext(params, ctx);
         }
 
-        // used in writing out debug data
-        boost::filesystem::path path(params.filename);
-
-        // Construct Featurespace from data
-        ctx.fs = new FeatureSpace<T>(
-                ctx.coord_system,
-                ctx.data_store,
-                params.lower_thresholds,
-                params.upper_thresholds,
-                params.replacement_values,
-                ctx.show_progress);
-
-        // Run replacement filters
-        if (!params.replacementFilterVariableIndex.empty()) {
-            size_t rfvi_length = params.replacementFilterVariableIndex.size();
-            for (size_t i = 0; i < rfvi_length; i++) {
-                int rvi = params.replacementFilterVariableIndex[i];
-                typename ReplacementFilter<T>::ReplacementMode mode = params.replacementFilterModes.at(rvi);
-                float percent = params.replacementFilterPercentages.at(rvi);
-                if (params.verbosity >= VerbosityNormal) {
-                    start_timer("Applying replacement filter for " + params.variables[rvi]);
-                }
-                ReplacementFilter<T> rf(mode, rvi, ctx.bandwidth, percent);
-                rf.apply(ctx.fs);
-                if (params.verbosity >= VerbosityNormal) {
-                    stop_timer("done.");
-                }
-            }
-        }
-
-#if WRITE_FEATURESPACE
-        static size_t fs_index = 0;
-        std::string fn = path.stem().string() + "_featurespace_" + boost::lexical_cast<string>(fs_index++) + ".vtk";
-        VisitUtils<T>::write_featurespace_vtk(fn, ctx.fs);
-#endif
-
-#if WRITE_OFF_LIMITS_MASK
-        std::string ol_fname = path.filename().stem().string() + "-off_limits.vtk";
-        VisitUtils<T>::write_multiarray_vtk(ol_fname, "off_limits", ctx.coord_system, ctx.fs->off_limits());
-#endif
-
-        // Convection Filter?
-        if (params.convection_filter_index >= 0) {
-            if (params.verbosity >= VerbosityNormal) {
-                start_timer("Applying convection filter");
-            }
-            ConvectionFilter<T> convection_filter(ctx.bandwidth,
-                                                  params.convection_filter_index, ctx.show_progress);
-            convection_filter.apply(ctx.fs);
-            if (params.verbosity >= VerbosityNormal) {
-                stop_timer("done.");
-            }
-        }
-
-        // Scale-Space smoothing
-        if (params.scale != NO_SCALE) {
-
-            vector<T> resolution = ctx.fs->coordinate_system->resolution();
-            ctx.sf = new ScaleSpaceFilter<T>(params.scale,
-                                             resolution,
-                                             params.exclude_from_scale_space_filtering,
-                                             ctx.decay,
-                                             ctx.show_progress);
-            ctx.sf->apply(ctx.fs);
-
-#if WRITE_FEATURESPACE
-            std::string fn = path.stem().string() + "_scale_" + boost::lexical_cast<string>(scale) + ".vtk";
-            VisitUtils<T>::write_featurespace_vtk(fn, ctx.fs);
-#endif
+        if (!params.scales.empty()) {
+            Detection<T>::run_multiscale(params, ctx);
+            return;
         }
 
-        // Construct the weight function
-        if (params.verbosity > VerbositySilent) {
-            start_timer("Constructing weight function: " + params.weight_function_name);
-        }
-        ctx.weight_function = WeightFunctionFactory<T>::create(params, ctx);
-        if (params.verbosity > VerbositySilent) {
-            stop_timer("done");
-        }
+        // used in writing out debug data
+        boost::filesystem::path path(params.filename);
 
-        // Apply weight function filtering
-        if (ctx.wwf_apply) {
-            if (params.verbosity > VerbositySilent) {
-                start_timer("Applying weight function filter ...");
-            }
+        ClusterIndex<T> *reference = NULL;
+        size_t reference_clusters = 0;
+        size_t reference_points = 0;
+        double reference_time = 0.0;
+        double cluster_time = 0.0;
 
-            // Apply weight function filter
-            WeightThresholdFilter<T> wtf(ctx.weight_function,
-                                         params.wwf_lower_threshold,
-                                         params.wwf_upper_threshold,
-                                         ctx.show_progress);
-            wtf.apply(ctx.fs);
+        if (!params.tile_size.empty()) {
+            Detection<T>::cluster_tiled(params, ctx);
+        } else {
+            Detection<T>::prepare_featurespace(params, ctx);
 
-            if (params.verbosity > VerbositySilent) {
+#if WITH_VTK
+            if (params.write_weight_function) {
+                std::string wfname = "weights-" + path.filename().stem().string();
+                start_timer("Writing weight function");
+                VisitUtils<T>::write_weight_function_response(wfname, ctx.fs, ctx.weight_function);
                 stop_timer("done");
-                cout << "Filtered featurespace contains "
-                     << ctx.fs->count_original_points() << " original points "
-                     << endl;
             }
-        }
-
-#if WITH_VTK
-        if (params.write_weight_function) {
-            std::string wfname = "weights-" + path.filename().stem().string();
-            start_timer("Writing weight function");
-            VisitUtils<T>::write_weight_function_response(wfname, ctx.fs, ctx.weight_function);
-            stop_timer("done");
-        }
 
-        if (!params.vtk_variables.empty()) {
+            if (!params.vtk_variables.empty()) {
 
-            string filename_only = path.filename().string();
-            boost::filesystem::path destination_path = boost::filesystem::path(".");
-            destination_path /= filename_only;
-            destination_path.replace_extension();
-            string dest_path = destination_path.generic_string();
+                string filename_only = path.filename().string();
+                boost::filesystem::path destination_path = boost::filesystem::path(".");
+                destination_path /= filename_only;
+                destination_path.replace_extension();
+                string dest_path = destination_path.generic_string();
 
-            if (params.verbosity > VerbositySilent) {
-                cout << "Writing featurespace-variables ...";
-            }
+                if (params.verbosity > VerbositySilent) {
+                    cout << "Writing featurespace-variables ...";
+                }
 
-            VisitUtils<T>::write_featurespace_variables_vtk(dest_path,
-                                                            ctx.fs,
-                                                            ctx.data_store->variables(),
-                                                            params.vtk_variables,
-                                                            false);
+                VisitUtils<T>::write_featurespace_variables_vtk(dest_path,
+                                                                ctx.fs,
+                                                                ctx.data_store->variables(),
+                                                                params.vtk_variables,
+                                                                false);
 
-            if (params.verbosity > VerbositySilent) {
-                cout << " done." << endl;
+                if (params.verbosity > VerbositySilent) {
+                    cout << " done." << endl;
+                }
             }
-        }
 #endif
 
-        // Create the quick lookup index to speed up mean-shift
-        // clustering. By default this is FLANN K/D-tree implementation.
-        ctx.index = PointIndex<T>::create(ctx.fs->get_points(), ctx.fs->rank());
+            // When asked to judge an approximate index, cluster
+            // with exact search first as reference
+            if (params.index_accuracy_report && params.index_params.approximate && !params.grid_meanshift) {
+                reference = Detection<T>::exact_reference(params, ctx,
+                                                          reference_clusters,
+                                                          reference_points,
+                                                          reference_time);
+            }
 
-        // Perform the actual clustering
-        ClusterOperation<T> cop(params, ctx);
-        ctx.clusters = cop.cluster();
+            // Perform the actual clustering
+            timeval cluster_start;
+            gettimeofday(&cluster_start, NULL);
+            Detection<T>::cluster(params, ctx);
+            cluster_time = seconds_since(cluster_start);
+        }
 
 #if WITH_VTK
         if (params.write_meanshift_vectors) {
@@ -388,6 +370,25 @@ namespace m3D {
         // Axe weenies
         ctx.clusters->apply_size_threshold(params.min_cluster_size);
 
+        if (reference != NULL) {
+            Detection<T>::report_index_accuracy(params, ctx, *reference,
+                                                reference_clusters,
+                                                reference_points,
+                                                reference_time,
+                                                cluster_time);
+            delete reference;
+        }
+
+        Detection<T>::finalise_clusters(params, ctx);
+    }
+
+    template<typename T>
+    void
+    Detection<T>::finalise_clusters(const detection_params_t<T> &params,
+                                    detection_context_t<T> &ctx) {
+        // used in writing out debug data
+        boost::filesystem::path path(params.filename);
+
         // The survivors are now eligible for an actual id
         // TODO: we need to move away from doing this as part
         // of the detection process. The id is something only
@@ -407,7 +408,7 @@ namespace m3D {
         ctx.clusters->highest_uuid = uuid;
 
         // Collate with previous clusters, if provided
-        if (params.previous_clusters_filename != NULL
+        if (ctx.previous_clusters != NULL
             && params.postprocess_with_previous_output) {
             cout << endl << "Collating with previous results:" << endl;
             if (params.verbosity >= VerbosityDetails)
@@ -435,8 +436,9 @@ namespace m3D {
                         params.verbosity);
 
             } catch (const std::exception &e) {
-                cerr << "FATAL:exception reading previous cluster file: " << e.what() << endl;
-                exit(EXIT_FAILURE);
+                std::ostringstream message;
+                message << "exception reading previous cluster file: " << e.what();
+                throw std::runtime_error(message.str());
             }
             cout << endl << "Done. Have " << ctx.clusters->size() << " clusters:" << endl;
 
@@ -503,6 +505,759 @@ namespace m3D {
             }
         }
     }
+
+    template<typename T>
+    void
+    Detection<T>::prepare_featurespace(const detection_params_t<T> &params,
+                                       detection_context_t<T> &ctx) {
+        // used in writing out debug data
+        boost::filesystem::path path(params.filename);
+
+        Detection<T>::build_featurespace(params, ctx);
+
+        // Scale-Space smoothing
+        if (params.scale != NO_SCALE) {
+
+            vector<T> resolution = ctx.fs->coordinate_system->resolution();
+            ctx.sf = new ScaleSpaceFilter<T>(params.scale,
+                                             resolution,
+                                             params.exclude_from_scale_space_filtering,
+                                             ctx.decay,
+                                             ctx.show_progress,
+                                             params.scale_space_method);
+            ctx.sf->apply(ctx.fs);
+
+            // The filter replaces the points
+            delete ctx.spatial_index;
+            ctx.spatial_index = Detection<T>::create_spatial_index(ctx);
+
+#if WRITE_FEATURESPACE
+            std::string fn = path.stem().string() + "_scale_" + boost::lexical_cast<string>(scale) + ".vtk";
+            VisitUtils<T>::write_featurespace_vtk(fn, ctx.fs);
+#endif
+        }
+
+        Detection<T>::apply_weight_function(params, ctx);
+    }
+
+    template<typename T>
+    void
+    Detection<T>::build_featurespace(const detection_params_t<T> &params,
+                                     detection_context_t<T> &ctx) {
+        // used in writing out debug data
+        boost::filesystem::path path(params.filename);
+
+        // Construct Featurespace from data
+        if (ctx.region_size.empty()) {
+            ctx.fs = new FeatureSpace<T>(
+                    ctx.coord_system,
+                    ctx.data_store,
+                    params.lower_thresholds,
+                    params.upper_thresholds,
+                    params.replacement_values,
+                    ctx.show_progress);
+        } else {
+            ctx.fs = new FeatureSpace<T>(
+                    ctx.coord_system,
+                    ctx.data_store,
+                    params.lower_thresholds,
+                    params.upper_thresholds,
+                    params.replacement_values,
+                    ctx.region_origin,
+                    ctx.region_size,
+                    ctx.show_progress);
+        }
+
+        // Filters that search the neighbourhood of each point share
+        // one spatial index, which is built once and then changed in
+        // place. The grid versions of the replacement and convection
+        // filters search none, and all later users create their own
+        // index if there is no shared one.
+        bool filters_search_index = false;
+#if !REPLACEMENT_FILTER_USES_GRID_STENCIL
+        filters_search_index |= !params.replacementFilterVariableIndex.empty();
+#endif
+#if !CONVECTION_FILTER_USES_GRID_STENCIL
+        filters_search_index |= (params.convection_filter_index >= 0);
+#endif
+        if (filters_search_index) {
+            ctx.spatial_index = Detection<T>::create_spatial_index(ctx);
+        }
+
+        // Run replacement filters
+        if (!params.replacementFilterVariableIndex.empty()) {
+            size_t rfvi_length = params.replacementFilterVariableIndex.size();
+            for (size_t i = 0; i < rfvi_length; i++) {
+                int rvi = params.replacementFilterVariableIndex[i];
+                typename ReplacementFilter<T>::ReplacementMode mode = params.replacementFilterModes.at(rvi);
+                float percent = params.replacementFilterPercentages.at(rvi);
+                if (params.verbosity >= VerbosityNormal) {
+                    start_timer("Applying replacement filter for " + params.variables[rvi]);
+                }
+                ReplacementFilter<T> rf(mode, rvi, ctx.bandwidth, percent);
+                rf.set_spatial_index(ctx.spatial_index);
+                rf.apply(ctx.fs);
+                if (params.verbosity >= VerbosityNormal) {
+                    stop_timer("done.");
+                }
+            }
+        }
+
+#if WRITE_FEATURESPACE
+        static size_t fs_index = 0;
+        std::string fn = path.stem().string() + "_featurespace_" + boost::lexical_cast<string>(fs_index++) + ".vtk";
+        VisitUtils<T>::write_featurespace_vtk(fn, ctx.fs);
+#endif
+
+#if WRITE_OFF_LIMITS_MASK
+        std::string ol_fname = path.filename().stem().string() + "-off_limits.vtk";
+        VisitUtils<T>::write_multiarray_vtk(ol_fname, "off_limits", ctx.coord_system, ctx.fs->off_limits());
+#endif
+
+        // Convection Filter?
+        if (params.convection_filter_index >= 0) {
+            if (params.verbosity >= VerbosityNormal) {
+                start_timer("Applying convection filter");
+            }
+            ConvectionFilter<T> convection_filter(ctx.bandwidth,
+                                                  params.convection_filter_index, ctx.show_progress);
+            convection_filter.set_spatial_index(ctx.spatial_index);
+            convection_filter.apply(ctx.fs);
+            if (params.verbosity >= VerbosityNormal) {
+                stop_timer("done.");
+            }
+        }
+    }
+
+    template<typename T>
+    void
+    Detection<T>::apply_weight_function(const detection_params_t<T> &params,
+                                        detection_context_t<T> &ctx) {
+        // Construct the weight function
+        if (params.verbosity > VerbositySilent) {
+            start_timer("Constructing weight function: " + params.weight_function_name);
+        }
+        ctx.weight_function = WeightFunctionFactory<T>::create(params, ctx);
+        if (params.verbosity > VerbositySilent) {
+            stop_timer("done");
+        }
+
+        // Apply weight function filtering
+        if (ctx.wwf_apply) {
+            if (params.verbosity > VerbositySilent) {
+                start_timer("Applying weight function filter ...");
+            }
+
+            // Apply weight function filter
+            WeightThresholdFilter<T> wtf(ctx.weight_function,
+                                         params.wwf_lower_threshold,
+                                         params.wwf_upper_threshold,
+                                         ctx.show_progress);
+            wtf.set_spatial_index(ctx.spatial_index);
+            wtf.apply(ctx.fs);
+
+            if (params.verbosity > VerbositySilent) {
+                stop_timer("done");
+                cout << "Filtered featurespace contains "
+                     << ctx.fs->count_original_points() << " original points "
+                     << endl;
+            }
+        }
+    }
+
+    template<typename T>
+    void
+    Detection<T>::cluster(const detection_params_t<T> &params,
+                          detection_context_t<T> &ctx) {
+        // Create the quick lookup index to speed up mean-shift
+        // clustering. By default this is FLANN K/D-tree implementation.
+        // The grid meanshift does not need one.
+        if (!params.grid_meanshift) {
+            ctx.index = PointIndex<T>::create(ctx.fs->get_points(),
+                                              ctx.fs->rank(),
+                                              PointIndex<T>::DefaultIndexType,
+                                              params.index_params);
+        }
+
+        ClusterOperation<T> cop(params, ctx);
+        ctx.clusters = cop.cluster();
+    }
+
+#pragma mark -
+#pragma mark Multi-scale detection
+
+    template<typename T>
+    std::string
+    Detection<T>::scale_output_filename(const std::string &filename, double scale) {
+        if (filename.empty()) {
+            return filename;
+        }
+        boost::filesystem::path path(filename);
+        boost::filesystem::path result = path.parent_path();
+        result /= path.stem().string() + "-scale-" + boost::lexical_cast<string>(scale)
+                  + path.extension().string();
+        return result.string();
+    }
+
+    template<typename T>
+    void
+    Detection<T>::run_multiscale(const detection_params_t<T> &params,
+                                 detection_context_t<T> &ctx) {
+        vector<double> scales = params.scales;
+        std::sort(scales.begin(), scales.end());
+        scales.erase(std::unique(scales.begin(), scales.end()), scales.end());
+
+        // The feature-space is built only once. Replacement and
+        // convection filter see the bandwidth of the smallest scale.
+        detection_params_t<T> scale_params = params;
+        scale_params.scales.clear();
+        scale_params.scale = scales[0];
+        Detection<T>::initialise_bandwidth(scale_params, ctx);
+        Detection<T>::build_featurespace(scale_params, ctx);
+
+        const vector<T> resolution = ctx.coord_system->resolution();
+        typename Point<T>::list smoothed;
+        T previous_gain = 1.0;
+
+        for (size_t si = 0; si < scales.size(); si++) {
+            const double scale = scales[si];
+            const double previous_scale = (si == 0) ? 0.0 : scales[si - 1];
+
+            scale_params.scale = scale;
+            scale_params.output_filename = Detection<T>::scale_output_filename(params.output_filename, scale);
+
+            if (params.verbosity > VerbositySilent) {
+                cout << endl << "----------------------------------------------------" << endl;
+                cout << "Scale t=" << scale << " (" << (si + 1) << " of " << scales.size() << ")" << endl;
+                cout << "----------------------------------------------------" << endl;
+            }
+
+            if (si > 0) {
+                Detection<T>::initialise_bandwidth(scale_params, ctx);
+
+                // Continue from the smoothed points of the previous scale
+                ctx.fs->clear();
+                ctx.fs->points.swap(smoothed);
+            }
+
+            // Gaussians form a semigroup: smoothing the field at scale t0
+            // with scale t - t0 yields the field at scale t. The filter
+            // with the smaller scale is also the cheaper one.
+            ctx.sf = new ScaleSpaceFilter<T>(scale - previous_scale,
+                                             resolution,
+                                             params.exclude_from_scale_space_filtering,
+                                             ctx.decay,
+                                             ctx.show_progress,
+                                             params.scale_space_method);
+            if (ctx.sf->gain() <= 0) {
+                std::ostringstream message;
+                message << "the difference between scales " << previous_scale << " and " << scale
+                        << " is too small for the grid resolution";
+                throw std::runtime_error(message.str());
+            }
+            ctx.sf->apply(ctx.fs);
+
+            // The sampled kernels are not normalized. Bring the values
+            // to the level a single filter with scale t would produce.
+            ScaleSpaceFilter<T> direct(scale, resolution, params.exclude_from_scale_space_filtering, ctx.decay);
+            if (si > 0) {
+                ctx.sf->scale_values(ctx.fs, direct.gain() / (previous_gain * ctx.sf->gain()));
+            }
+            previous_gain = direct.gain();
+
+            // Keep the smoothed points. Weight function filtering
+            // and clustering change the feature-space.
+            if (si + 1 < scales.size()) {
+                smoothed.reserve(ctx.fs->points.size());
+                for (size_t i = 0; i < ctx.fs->points.size(); i++) {
+                    smoothed.push_back(PointFactory<T>::get_instance()->copy(ctx.fs->points[i]));
+                }
+            }
+
+            delete_and_clear(ctx.spatial_index);
+            ctx.spatial_index = Detection<T>::create_spatial_index(ctx);
+
+            Detection<T>::apply_weight_function(scale_params, ctx);
+            Detection<T>::cluster(scale_params, ctx);
+            ctx.clusters->apply_size_threshold(params.min_cluster_size);
+            Detection<T>::finalise_clusters(scale_params, ctx);
+
+            // The results of the last scale remain in the
+            // context, as they would after a single run
+            if (si + 1 < scales.size()) {
+                ctx.clusters->clear();
+                delete_and_clear(ctx.clusters);
+                delete_and_clear(ctx.index);
+                delete_and_clear(ctx.weight_function);
+                delete_and_clear(ctx.sf);
+            }
+        }
+    }
+
+#pragma mark -
+#pragma mark Tiled detection
+
+    template<typename T>
+    vector<detection_tile_t<T> >
+    Detection<T>::create_tiles(const detection_params_t<T> &params,
+                               const detection_context_t<T> &ctx) {
+        const vector<size_t> &dims = ctx.coord_system->get_dimension_sizes();
+        const size_t rank = dims.size();
+        if (params.tile_size.size() != rank) {
+            std::ostringstream message;
+            message << "tiled detection requires a tile size for each of the "
+                    << rank << " dimensions";
+            throw std::runtime_error(message.str());
+        }
+
+        // The halo must cover the reach of the scale-space filter
+        // and of the mean-shift, so that points in the core see the
+        // same neighbourhood as they would without tiling
+        vector<T> resolution = ctx.coord_system->resolution();
+        T filter_width = 0.0;
+        if (params.scale != Detection<T>::NO_SCALE) {
+            filter_width = ScaleSpaceFilter<T>::scale_to_filter_width(params.scale);
+        }
+
+        vector<size_t> halo(rank);
+        vector<size_t> counts(rank);
+        size_t num_tiles = 1;
+        for (size_t d = 0; d < rank; d++) {
+            if (params.tile_size[d] == 0) {
+                throw std::runtime_error("tile size must be at least 1 grid point");
+            }
+            T reach = std::max(ctx.bandwidth[d], filter_width);
+            halo[d] = (size_t) ceil(DETECTION_TILE_HALO * reach / resolution[d]);
+            counts[d] = (dims[d] + params.tile_size[d] - 1) / params.tile_size[d];
+            num_tiles *= counts[d];
+        }
+
+        vector<detection_tile_t<T> > tiles(num_tiles);
+        for (size_t ti = 0; ti < num_tiles; ti++) {
+            detection_tile_t<T> &tile = tiles[ti];
+            tile.core_origin.resize(rank);
+            tile.core_size.resize(rank);
+            tile.origin.resize(rank);
+            tile.size.resize(rank);
+            tile.halo = halo;
+            tile.clusters = NULL;
+
+            size_t rest = ti;
+            for (int d = ((int) rank) - 1; d >= 0; d--) {
+                size_t index = rest % counts[d];
+                rest /= counts[d];
+
+                size_t begin = index * params.tile_size[d];
+                size_t end = std::min(begin + params.tile_size[d], dims[d]);
+                tile.core_origin[d] = begin;
+                tile.core_size[d] = end - begin;
+
+                size_t lower = (begin > halo[d]) ? begin - halo[d] : 0;
+                size_t upper = std::min(end + halo[d], dims[d]);
+                tile.origin[d] = lower;
+                tile.size[d] = upper - lower;
+            }
+        }
+
+        return tiles;
+    }
+
+    template<typename T>
+    void
+    Detection<T>::cluster_tiled(const detection_params_t<T> &params,
+                                detection_context_t<T> &ctx) {
+        vector<detection_tile_t<T> > tiles = Detection<T>::create_tiles(params, ctx);
+        const vector<size_t> &dims = ctx.coord_system->get_dimension_sizes();
+        const size_t rank = dims.size();
+        LinearIndexMapping grid(dims);
+
+        if (params.verbosity > VerbositySilent) {
+            cout << endl << "Tiled detection: " << tiles.size() << " tiles of "
+                 << params.tile_size << " grid points, halo " << tiles[0].halo
+                 << (params.parallel_tiles ? " (in parallel)" : "") << endl;
+        }
+
+        // Tiles processed in parallel must not report progress,
+        // the console output would be garbled
+        detection_params_t<T> tile_params = params;
+        if (params.parallel_tiles) {
+            tile_params.verbosity = VerbositySilent;
+        }
+
+#if WITH_OPENMP
+#pragma omp parallel for schedule(dynamic) if (params.parallel_tiles)
+#endif
+        for (size_t ti = 0; ti < tiles.size(); ti++) {
+            detection_tile_t<T> &tile = tiles[ti];
+
+            if (tile_params.verbosity > VerbositySilent) {
+                cout << endl << "Tile " << (ti + 1) << "/" << tiles.size()
+                     << ": origin " << tile.origin << " size " << tile.size << endl;
+            }
+
+            // The tile shares the read-only parts of the context
+            detection_context_t<T> tile_ctx = ctx;
+            tile_ctx.show_progress = ctx.show_progress && !params.parallel_tiles;
+            tile_ctx.fs = NULL;
+            tile_ctx.spatial_index = NULL;
+            tile_ctx.sf = NULL;
+            tile_ctx.weight_function = NULL;
+            tile_ctx.index = NULL;
+            tile_ctx.clusters = NULL;
+            tile_ctx.region_origin = tile.origin;
+            tile_ctx.region_size = tile.size;
+
+            Detection<T>::prepare_featurespace(tile_params, tile_ctx);
+            Detection<T>::cluster(tile_params, tile_ctx);
+
+            // Keep the clustered points in the core and note the
+            // cluster labels needed for stitching
+            tile.clusters = tile_ctx.clusters;
+            for (size_t ci = 0; ci < tile.clusters->size(); ci++) {
+                typename Cluster<T>::ptr c = tile.clusters->clusters[ci];
+                typename Point<T>::list core;
+                typename Point<T>::list::const_iterator pi;
+                for (pi = c->get_points().begin(); pi != c->get_points().end(); ++pi) {
+                    typename Point<T>::ptr p = *pi;
+                    size_t linear_index = grid.grid_to_index(p->gridpoint);
+                    if (tile.core_contains(p->gridpoint)) {
+                        core.push_back(p);
+                        if (tile.seam_contains(p->gridpoint, dims)) {
+                            tile.seam_labels[linear_index] = ci;
+                        }
+                    } else {
+                        tile.halo_labels.push_back(std::make_pair(linear_index, ci));
+                    }
+                }
+                c->get_points().swap(core);
+                c->clear_center_caches();
+                c->clear_index();
+            }
+
+            // Let go of everything else
+            for (size_t i = 0; i < tile_ctx.fs->points.size(); i++) {
+                typename Point<T>::ptr p = tile_ctx.fs->points[i];
+                if (p->cluster != NULL && tile.core_contains(p->gridpoint)) {
+                    tile_ctx.fs->points[i] = NULL;
+                }
+            }
+            tile_ctx.fs->clear();
+            delete_and_clear(tile_ctx.spatial_index);
+            delete_and_clear(tile_ctx.fs);
+            delete_and_clear(tile_ctx.weight_function);
+            delete_and_clear(tile_ctx.sf);
+            delete_and_clear(tile_ctx.index);
+        }
+
+        if (params.verbosity > VerbositySilent) {
+            start_timer("Stitching tiles");
+        }
+
+        typename Cluster<T>::list clusters = Detection<T>::stitch_tiles(params, ctx, tiles);
+
+        // The stitched clusters' points are handed
+        // to an empty feature-space, which owns them
+        ctx.fs = new FeatureSpace<T>(
+                ctx.coord_system,
+                ctx.data_store,
+                params.lower_thresholds,
+                params.upper_thresholds,
+                params.replacement_values,
+                vector<size_t>(rank, 0),
+                vector<size_t>(rank, 0),
+                false);
+        for (size_t ci = 0; ci < clusters.size(); ci++) {
+            typename Point<T>::list &points = clusters[ci]->get_points();
+            ctx.fs->points.insert(ctx.fs->points.end(), points.begin(), points.end());
+        }
+
+        ctx.clusters = new ClusterList<T>(clusters,
+                                          params.filename,
+                                          params.variables,
+                                          params.dimensions,
+                                          params.dimension_variables,
+                                          ctx.timestamp,
+                                          params.time_index);
+
+        if (params.verbosity > VerbositySilent) {
+            stop_timer("done");
+        }
+
+        // Post-processing and output need the weight
+        // function on the stitched result
+        ctx.weight_function = WeightFunctionFactory<T>::create(params, ctx);
+    }
+
+    template<typename T>
+    typename Cluster<T>::list
+    Detection<T>::stitch_tiles(const detection_params_t<T> &params,
+                               const detection_context_t<T> &ctx,
+                               vector<detection_tile_t<T> > &tiles) {
+        const vector<size_t> &dims = ctx.coord_system->get_dimension_sizes();
+        const size_t rank = dims.size();
+        LinearIndexMapping grid(dims);
+
+        // Cluster ci of tile ti is labelled offsets[ti] + ci
+        vector<size_t> offsets(tiles.size() + 1, 0);
+        typename Cluster<T>::list labelled;
+        for (size_t ti = 0; ti < tiles.size(); ti++) {
+            offsets[ti + 1] = offsets[ti] + tiles[ti].clusters->size();
+            labelled.insert(labelled.end(),
+                            tiles[ti].clusters->clusters.begin(),
+                            tiles[ti].clusters->clusters.end());
+        }
+        const size_t num_labels = offsets[tiles.size()];
+
+        // Number of tiles along each dimension, to find
+        // the tile owning a grid point
+        vector<size_t> counts(rank);
+        for (size_t d = 0; d < rank; d++) {
+            counts[d] = (dims[d] + params.tile_size[d] - 1) / params.tile_size[d];
+        }
+
+        // For each cluster seen in a halo and each tile owning part
+        // of that halo: the labels the owner gave to those points.
+        // Points the owner did not cluster count as num_labels.
+        typedef map<size_t, size_t> label_count_t;
+        map<std::pair<size_t, size_t>, label_count_t> votes;
+        vector<int> gridpoint(rank);
+        for (size_t ti = 0; ti < tiles.size(); ti++) {
+            for (size_t i = 0; i < tiles[ti].halo_labels.size(); i++) {
+                size_t linear_index = tiles[ti].halo_labels[i].first;
+                size_t label = offsets[ti] + tiles[ti].halo_labels[i].second;
+
+                grid.linear_to_grid(linear_index, gridpoint);
+                size_t owner = 0;
+                for (size_t d = 0; d < rank; d++) {
+                    owner = owner * counts[d] + gridpoint[d] / params.tile_size[d];
+                }
+
+                map<size_t, size_t>::const_iterator si = tiles[owner].seam_labels.find(linear_index);
+                size_t owner_label = (si == tiles[owner].seam_labels.end())
+                                     ? num_labels
+                                     : offsets[owner] + si->second;
+                votes[std::make_pair(label, owner)][owner_label]++;
+            }
+        }
+
+        // Merge with the majority label. The component's root is
+        // always its lowest label, independent of the merge order.
+        vector<size_t> parent(num_labels);
+        for (size_t l = 0; l < num_labels; l++) {
+            parent[l] = l;
+        }
+
+        typename map<std::pair<size_t, size_t>, label_count_t>::const_iterator vi;
+        for (vi = votes.begin(); vi != votes.end(); ++vi) {
+            size_t total = 0;
+            size_t best_label = num_labels;
+            size_t best_count = 0;
+            label_count_t::const_iterator ci;
+            for (ci = vi->second.begin(); ci != vi->second.end(); ++ci) {
+                total += ci->second;
+                if (ci->second > best_count) {
+                    best_count = ci->second;
+                    best_label = ci->first;
+                }
+            }
+            if (best_label == num_labels || 2 * best_count <= total) {
+                continue;
+            }
+
+            size_t a = vi->first.first;
+            while (parent[a] != a) {
+                a = parent[a];
+            }
+            size_t b = best_label;
+            while (parent[b] != b) {
+                b = parent[b];
+            }
+            if (a < b) {
+                parent[b] = a;
+            } else if (b < a) {
+                parent[a] = b;
+            }
+        }
+
+        for (size_t l = 0; l < num_labels; l++) {
+            size_t root = l;
+            while (parent[root] != root) {
+                root = parent[root];
+            }
+            parent[l] = root;
+        }
+
+        // Each component is collected in its biggest
+        // cluster, which keeps its mode
+        vector<size_t> keeper(num_labels, num_labels);
+        for (size_t l = 0; l < num_labels; l++) {
+            size_t &k = keeper[parent[l]];
+            if (k == num_labels || labelled[l]->size() > labelled[k]->size()) {
+                k = l;
+            }
+        }
+
+        typename Cluster<T>::list result;
+        for (size_t l = 0; l < num_labels; l++) {
+            typename Cluster<T>::ptr c = labelled[l];
+            size_t k = keeper[parent[l]];
+            if (k != l) {
+                typename Cluster<T>::ptr target = labelled[k];
+                typename Point<T>::list::const_iterator pi;
+                for (pi = c->get_points().begin(); pi != c->get_points().end(); ++pi) {
+                    target->add_point(*pi);
+                }
+                if (c->has_margin_points()) {
+                    target->set_has_margin_points(true);
+                }
+                target->clear_center_caches();
+                target->clear_histogram_cache();
+                target->clear_index();
+                c->clear();
+                delete c;
+            }
+        }
+        for (size_t l = 0; l < num_labels; l++) {
+            if (keeper[parent[l]] == l) {
+                if (labelled[l]->size() > 0) {
+                    result.push_back(labelled[l]);
+                } else {
+                    delete labelled[l];
+                }
+            }
+        }
+
+        for (size_t ti = 0; ti < tiles.size(); ti++) {
+            tiles[ti].clusters->clusters.clear();
+            delete_and_clear(tiles[ti].clusters);
+        }
+
+        return result;
+    }
+
+    template<typename T>
+    PointIndex<T> *
+    Detection<T>::create_spatial_index(const detection_context_t<T> &ctx) {
+        index_params_t index_params;
+        index_params.incremental = true;
+        return PointIndex<T>::create(ctx.fs->get_points(),
+                                     ctx.fs->spatial_rank(),
+                                     PointIndex<T>::DefaultIndexType,
+                                     index_params);
+    }
+
+#pragma mark -
+#pragma mark Index accuracy
+
+    template<typename T>
+    ClusterIndex<T> *
+    Detection<T>::exact_reference(const detection_params_t<T> &params,
+                                  detection_context_t<T> &ctx,
+                                  size_t &num_clusters,
+                                  size_t &num_points,
+                                  double &time) {
+        if (params.verbosity > VerbositySilent) {
+            cout << endl << "Clustering with exact search for reference ..." << endl;
+        }
+
+        // Clustering replaces the values of clustered points
+        // with the original data and links points to clusters.
+        // Keep what is needed to undo this.
+        vector<vector<T> > values(ctx.fs->points.size());
+        for (size_t i = 0; i < ctx.fs->points.size(); i++) {
+            values[i] = ctx.fs->points[i]->values;
+        }
+
+        ctx.index = PointIndex<T>::create(ctx.fs->get_points(), ctx.fs->rank());
+
+        timeval start;
+        gettimeofday(&start, NULL);
+        ClusterOperation<T> cop(params, ctx);
+        ClusterList<T> *clusters = cop.cluster();
+        time = seconds_since(start);
+
+        clusters->apply_size_threshold(params.min_cluster_size);
+
+        num_clusters = clusters->size();
+        num_points = 0;
+        for (size_t ci = 0; ci < clusters->size(); ci++) {
+            num_points += clusters->clusters[ci]->size();
+        }
+
+        ClusterIndex<T> *reference = new ClusterIndex<T>(clusters->clusters,
+                                                         ctx.coord_system->get_dimension_sizes());
+
+        // Restore the feature-space
+        clusters->clear();
+        delete clusters;
+        for (size_t i = 0; i < ctx.fs->points.size(); i++) {
+            typename Point<T>::ptr p = ctx.fs->points[i];
+            p->values = values[i];
+            p->cluster = NULL;
+        }
+        delete ctx.index;
+        ctx.index = NULL;
+
+        return reference;
+    }
+
+    template<typename T>
+    void
+    Detection<T>::report_index_accuracy(const detection_params_t<T> &params,
+                                        const detection_context_t<T> &ctx,
+                                        ClusterIndex<T> &reference,
+                                        size_t reference_clusters,
+                                        size_t reference_points,
+                                        double reference_time,
+                                        double time) {
+        ClusterIndex<T> labels(ctx.clusters->clusters, ctx.coord_system->get_dimension_sizes());
+
+        size_t num_points = 0;
+        for (size_t ci = 0; ci < ctx.clusters->size(); ci++) {
+            num_points += ctx.clusters->clusters[ci]->size();
+        }
+
+        typename ClusterIndex<T>::intersection_table_t overlaps;
+        ClusterIndex<T>::intersection_counts(labels, reference, overlaps);
+
+        // Best match of each approximate cluster in the reference,
+        // and of each reference cluster among the approximate ones
+        size_t matched = 0;
+        map<m3D::id_t, size_t> best_reference_match;
+        typename ClusterIndex<T>::intersection_table_t::const_iterator ri;
+        for (ri = overlaps.begin(); ri != overlaps.end(); ++ri) {
+            size_t best = 0;
+            typename ClusterIndex<T>::id_count_t::const_iterator ci;
+            for (ci = ri->second.begin(); ci != ri->second.end(); ++ci) {
+                best = std::max(best, ci->second);
+                size_t &best_reference = best_reference_match[ci->first];
+                best_reference = std::max(best_reference, ci->second);
+            }
+            matched += best;
+        }
+        size_t reference_matched = 0;
+        map<m3D::id_t, size_t>::const_iterator bi;
+        for (bi = best_reference_match.begin(); bi != best_reference_match.end(); ++bi) {
+            reference_matched += bi->second;
+        }
+
+        size_t differing = std::max(num_points - matched, reference_points - reference_matched);
+        size_t total = std::max(num_points, reference_points);
+        double agreement = (total == 0) ? 1.0 : 1.0 - ((double) differing) / ((double) total);
+
+        cout << endl << "Index accuracy (approximate vs. exact search):" << endl;
+        cout << "\ttrees=" << params.index_params.trees
+             << " checks=" << params.index_params.checks << endl;
+        cout << "\tclusters: " << ctx.clusters->size()
+             << " (exact: " << reference_clusters << ")" << endl;
+        cout << "\tclustered points: " << num_points
+             << " (exact: " << reference_points << ")" << endl;
+        cout << "\tdifferently assigned points: " << differing
+             << " (" << (100.0 * agreement) << "% agreement)" << endl;
+        cout << "\tclustering time: " << time << "s"
+             << " (exact: " << reference_time << "s, speedup "
+             << ((time > 0) ? reference_time / time : 0.0) << ")" << endl;
+    }
 }
 
 #endif	/* M3D_DETECTION_IMPL_H */
@@ -50,6 +50,46 @@
 // 'off limits' in feature-space construction
 #define SCALE_SPACE_SKIPS_NON_ORIGINAL_POINTS 0
 
+// If enabled, the scale-space filter convolves dense
+// per-variable arrays and creates the filtered points
+// only once, after all dimensions are done
+#define SCALE_SPACE_USES_DENSE_ARRAYS 1
+
+// Number of neighbouring grid lines convolved
+// together by the dense scale-space filter
+#define SCALE_SPACE_BLOCK_SIZE 256
+
+// Number of points processed with a single index
+// query when calculating the meanshift vector graph
+#define MEANSHIFT_BATCH_SIZE 256
+
+// If enabled, the convection filter works on the grid:
+// background averages and convective radius come from
+// per-line prefix sums instead of index searches
+#define CONVECTION_FILTER_USES_GRID_STENCIL 1
+
+// If enabled, the replacement filter works on the grid:
+// averages come from per-line prefix sums, order statistics
+// from a histogram sliding along the grid lines
+#define REPLACEMENT_FILTER_USES_GRID_STENCIL 1
+
+// Width of the halo around each tile in tiled detection,
+// in multiples of the spatial bandwidth (or of the scale-space
+// filter width, if that is wider)
+#define DETECTION_TILE_HALO 2
+
+// If enabled, NetCDF variables are read straight into
+// the storage of the data store's arrays. Otherwise they
+// are read into a buffer and copied element by element
+#define NETCDF_READS_INTO_ARRAY 1
+
+// If enabled, the executables use single precision for the
+// feature-space, the search index and the cluster files.
+// Switch on with cmake -DWITH_SINGLE_PRECISION=ON
+#ifndef WITH_SINGLE_PRECISION
+#define WITH_SINGLE_PRECISION 0
+#endif
+
 // Method for rounding vectors to grid resolution
 
 #define GRID_ROUNDING_METHOD_FLOOR 0
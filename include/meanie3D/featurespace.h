@@ -29,6 +29,7 @@
 #include <meanie3D/featurespace/featurespace.h>
 #include <meanie3D/featurespace/netcdf_data_store.h>
 #include <meanie3D/featurespace/point.h>
+#include <meanie3D/featurespace/point_columns.h>
 #include <meanie3D/featurespace/point_default_factory.h>
 #include <meanie3D/featurespace/point_factory.h>
 #include <meanie3D/featurespace/timestamp.h>
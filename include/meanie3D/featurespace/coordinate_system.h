@@ -28,6 +28,8 @@
 #include <meanie3D/defines.h>
 #include <meanie3D/namespaces.h>
 
+#include <boost/array.hpp>
+
 #include <vector>
 #include <map>
 #include <netcdf>
@@ -150,6 +152,17 @@ namespace m3D {
          */
         void lookup(const GridPoint &gridpoint, Coordinate &coordinate) const;
 
+        /** Lookup for grid points of fixed rank N.
+         * @param grid point
+         * @param coordinate (must have N components)
+         */
+        template<size_t N>
+        void lookup(const boost::array<int, N> &gridpoint, Coordinate &coordinate) const {
+            for (size_t index = 0; index < N; index++) {
+                coordinate[index] = m_dimension_data[index][gridpoint[index]];
+            }
+        };
+
         /** Reverse Lookup.
          * @throws std::out_of_range
          */
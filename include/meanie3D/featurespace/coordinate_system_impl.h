@@ -30,6 +30,7 @@
 
 #include <algorithm>
 #include <exception>
+#include <sstream>
 #include <stdexcept>
 #include <string.h>
 
@@ -51,9 +52,10 @@ namespace m3D {
 
             this->construct();
         } catch (const exceptions::NcException &e) {
-            cerr << "FATAL:could not create coordinate system from file "
-                 << file->getName() << " :" << e.what() << endl;
-            exit(EXIT_FAILURE);
+            std::ostringstream message;
+            message << "could not create coordinate system from file "
+                    << file->getName() << " :" << e.what();
+            throw std::runtime_error(message.str());
         }
     }
 
@@ -77,9 +79,10 @@ namespace m3D {
             this->construct();
 
         } catch (const exceptions::NcException &e) {
-            cerr << "FATAL:could not create coordinate system from file "
-                 << file->getName() << " :" << e.what() << endl;
-            exit(EXIT_FAILURE);
+            std::ostringstream message;
+            message << "could not create coordinate system from file "
+                    << file->getName() << " :" << e.what();
+            throw std::runtime_error(message.str());
         }
     }
 
@@ -194,9 +197,10 @@ namespace m3D {
 
             m_resolution_norm = utils::vectors::vector_norm<T>(m_resolution);
         } catch (const exceptions::NcException &e) {
-            cerr << "FATAL:could not construct coordinate system:"
-                 << e.what() << endl;
-            exit(EXIT_FAILURE);
+            std::ostringstream message;
+            message << "could not construct coordinate system:"
+                    << e.what();
+            throw std::runtime_error(message.str());
         }
     }
 
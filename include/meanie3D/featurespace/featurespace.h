@@ -29,10 +29,13 @@
 #include <meanie3D/namespaces.h>
 
 #include <meanie3D/array/multiarray.h>
+#include <meanie3D/array/multiarray_fixed.h>
+#include <meanie3D/array/linear_index_mapping.h>
 #include <meanie3D/featurespace/coordinate_system.h>
 #include <meanie3D/featurespace/point.h>
 #include <meanie3D/featurespace/data_store.h>
 
+#include <boost/array.hpp>
 #include <boost/progress.hpp>
 
 #include <map>
@@ -93,6 +96,28 @@ namespace m3D {
          */
         void build();
 
+        /** Builds the feature space from the grid points of the
+         * region, using the given linear index mappings. The mappings'
+         * grid point type determines the grid point type used throughout.
+         * @param linear index mapping of the region
+         * @param linear index mapping of the whole grid
+         * @param off-limits array to fill in
+         */
+        template<class Mapping, class OffLimits>
+        void build(const Mapping &region, const Mapping &grid, OffLimits *off_limits);
+
+        /** Sizes variable rank grid points. Fixed rank grid
+         * points need no initialisation.
+         */
+        static void init_gridpoint(vector<int> &gridpoint, size_t rank) {
+            gridpoint.resize(rank, 0);
+        }
+
+        template<size_t N>
+        static void init_gridpoint(boost::array<int, N> &gridpoint, size_t rank) {
+            gridpoint.fill(0);
+        }
+
 #pragma mark -
 #pragma mark Protected
 
@@ -130,6 +155,13 @@ namespace m3D {
          */
         map<int, double> m_replacement_values;
 
+        /** If not empty, only the grid points in the box from
+         * m_region_origin with extent m_region_size are used
+         * in construction.
+         */
+        vector<size_t> m_region_origin;
+        vector<size_t> m_region_size;
+
         // bool flag array, indicating where the original data sets
         // had '_fillValue' or values outside of valid_range.
         // Note: only applicaple for gridded data!
@@ -190,6 +222,29 @@ namespace m3D {
                      const map<int, double> &replacement_values,
                      const bool &show_progress = true);
 
+        /** Constructs a feature-space from the variables in the
+         * given data store, using only the grid points within the
+         * given box. Grid points and coordinates of the points
+         * refer to the whole grid.
+         *
+         * @param coordinate_system
+         * @param dataStore
+         * @param lower_thresholds
+         * @param upper_thresholds
+         * @param replacement_values
+         * @param grid point at the origin of the box
+         * @param number of grid points of the box in each dimension
+         * @param show_progress
+         */
+        FeatureSpace(const CoordinateSystem <T> *coordinate_system,
+                     const DataStore <T> *dataStore,
+                     const map<int, double> &lower_thresholds,
+                     const map<int, double> &upper_thresholds,
+                     const map<int, double> &replacement_values,
+                     const vector<size_t> &region_origin,
+                     const vector<size_t> &region_size,
+                     const bool &show_progress = true);
+
         // Making copies
 
         /** Copy constructor
@@ -340,6 +395,15 @@ namespace m3D {
         typename CoordinateSystem<T>::Coordinate
         spatial_component(const vector<T> &value) const;
 
+        /** Returns the spatial range component of a point's
+         * value column (shift or values).
+         *
+         * @param column of a point
+         * @return it's spatial component
+         */
+        typename CoordinateSystem<T>::Coordinate
+        spatial_component(const ColumnView<T> &value) const;
+
         /**  
          * @param p
          * @param index
@@ -64,6 +64,27 @@ namespace m3D {
         this->construct_featurespace(show_progress);
     }
 
+    template<typename T>
+    FeatureSpace<T>::FeatureSpace(const CoordinateSystem <T> *coordinate_system,
+                                  const DataStore <T> *data_store,
+                                  const map<int, double> &lower_thresholds,
+                                  const map<int, double> &upper_thresholds,
+                                  const map<int, double> &replacement_values,
+                                  const vector<size_t> &region_origin,
+                                  const vector<size_t> &region_size,
+                                  const bool &show_progress)
+            : m_data_store(data_store), m_progress_bar(NULL), m_lower_thresholds(lower_thresholds),
+              m_upper_thresholds(upper_thresholds), m_replacement_values(replacement_values),
+              m_region_origin(region_origin), m_region_size(region_size), m_off_limits(NULL),
+              coordinate_system(coordinate_system) {
+        assert(region_origin.size() == coordinate_system->rank());
+        assert(region_size.size() == coordinate_system->rank());
+        dimension = coordinate_system->rank() + data_store->rank();
+
+        // construct feature space
+        this->construct_featurespace(show_progress);
+    }
+
     /** Destructor
      */
     template<typename T>
@@ -136,8 +157,12 @@ namespace m3D {
             size_t number_of_points = 1;
 
             for (size_t di = 0; di < coordinate_system->rank(); di++) {
-                NcDim dim = coordinate_system->dimensions()[di];
-                number_of_points *= dim.getSize();
+                if (m_region_size.empty()) {
+                    NcDim dim = coordinate_system->dimensions()[di];
+                    number_of_points *= dim.getSize();
+                } else {
+                    number_of_points *= m_region_size[di];
+                }
             }
 
             m_progress_bar = new progress_display(number_of_points);
@@ -163,120 +188,215 @@ namespace m3D {
 
     template<typename T>
     void FeatureSpace<T>::build() {
-        m_off_limits = new MultiArrayBlitz<bool>(this->coordinate_system->get_dimension_sizes(), false);
-
-        size_t size = this->m_data_store->size();
+        const vector<size_t> &dims = this->coordinate_system->get_dimension_sizes();
+        const vector<size_t> &region = m_region_size.empty() ? dims : m_region_size;
+        const vector<size_t> origin = m_region_origin.empty() ? vector<size_t>(dims.size(), 0) : m_region_origin;
+
+        // Grids of rank 2 and 3 are by far the most common. Those are
+        // dispatched once to versions with the rank fixed at compile time,
+        // which work on fixed size grid points and flat arrays. Their
+        // off-limits mask only stores the region, which keeps it small
+        // when the feature-space is built for a tile.
+
+        switch (this->coordinate_system->rank()) {
+            case 2: {
+                MultiArrayFixed<bool, 2> *off_limits = new MultiArrayFixed<bool, 2>(dims, origin, region, false);
+                m_off_limits = off_limits;
+                this->build(FixedLinearIndexMapping<2>(region), FixedLinearIndexMapping<2>(dims), off_limits);
+                break;
+            }
+            case 3: {
+                MultiArrayFixed<bool, 3> *off_limits = new MultiArrayFixed<bool, 3>(dims, origin, region, false);
+                m_off_limits = off_limits;
+                this->build(FixedLinearIndexMapping<3>(region), FixedLinearIndexMapping<3>(dims), off_limits);
+                break;
+            }
+            default:
+                m_off_limits = new MultiArrayBlitz<bool>(dims, false);
+                this->build(LinearIndexMapping(region), LinearIndexMapping(dims), m_off_limits);
+        }
+    }
 
-        LinearIndexMapping mapping(m_data_store->coordinate_system()->get_dimension_sizes());
+    template<typename T>
+    template<class Mapping, class OffLimits>
+    void FeatureSpace<T>::build(const Mapping &region, const Mapping &grid, OffLimits *off_limits) {
+        const size_t size = region.size();
+        const size_t value_rank = this->data_store()->rank();
+        const size_t spatial_rank = this->coordinate_system->rank();
+
+        // The grid is cut into contiguous chunks of linear indexes. Each
+        // chunk collects its points and value ranges on its own, without
+        // any locking. The chunks are then placed into the point list at
+        // offsets obtained by a prefix sum over their sizes. That way the
+        // points are always in linear grid order, independent of the
+        // number of threads and of the scheduling.
 
 #if WITH_OPENMP
-#pragma omp parallel for schedule(dynamic,10) 
-#endif
-        for (size_t linear_index = 0; linear_index < size; linear_index++) {
-            // Get the variables together and construct the cartesian coordinate
-            if (m_progress_bar != NULL) {
-#if WITH_OPENMP
-#pragma omp critical
+        size_t num_chunks = 4 * omp_get_max_threads();
+#else
+        size_t num_chunks = 1;
 #endif
-                m_progress_bar->operator++();
-            }
+        num_chunks = std::max((size_t) 1, std::min(num_chunks, size));
+        const size_t chunk_size = (size + num_chunks - 1) / num_chunks;
 
-            vector<int> gridpoint = mapping.linear_to_grid(linear_index);
+        vector<typename Point<T>::list> chunk_points(num_chunks);
+        vector<vector<T> > chunk_min(num_chunks, vector<T>(value_rank, std::numeric_limits<T>::max()));
+        vector<vector<T> > chunk_max(num_chunks, vector<T>(value_rank, -std::numeric_limits<T>::max()));
 
-            typename CoordinateSystem<T>::Coordinate coordinate(gridpoint.size());
+#if WITH_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (size_t chunk = 0; chunk < num_chunks; chunk++) {
+            const size_t chunk_begin = chunk * chunk_size;
+            const size_t chunk_end = std::min(chunk_begin + chunk_size, size);
+
+            typename Point<T>::list &local_points = chunk_points[chunk];
+            vector<T> &local_min = chunk_min[chunk];
+            vector<T> &local_max = chunk_max[chunk];
+
+            // The chunk's points take their rows from blocks of their
+            // own, which needs no locking and keeps the columns of
+            // neighbouring points together
+            PointStorage<T> storage;
+
+            typename Mapping::GridPoint gridpoint;
+            init_gridpoint(gridpoint, spatial_rank);
+            typename CoordinateSystem<T>::Coordinate coordinate(spatial_rank);
+
+            for (size_t region_index = chunk_begin; region_index < chunk_end; region_index++) {
+                // Get the variables together and construct the cartesian coordinate
+                region.linear_to_grid(region_index, gridpoint);
+                size_t linear_index = region_index;
+                if (!m_region_origin.empty()) {
+                    for (size_t d = 0; d < spatial_rank; d++) {
+                        gridpoint[d] += (int) m_region_origin[d];
+                    }
+                    linear_index = grid.grid_to_index(gridpoint);
+                }
 
-            coordinate_system->lookup(gridpoint, coordinate);
+                coordinate_system->lookup(gridpoint, coordinate);
 
-            // Iterate over the variables
+                // Iterate over the variables
 
-            bool isPointValid = true;
-            bool isPointInRange = true;
+                bool isPointValid = true;
+                bool isPointInRange = true;
 
-            // start the entry by copying the dimension variables
+                // start the entry by copying the dimension variables
 
-            vector<T> values = coordinate;
+                vector<T> values = coordinate;
 
-            // iterate over the variables
+                // iterate over the variables
 
-            for (size_t var_index = 0; var_index < this->m_data_store->rank() && isPointValid; var_index++) {
-                typename std::map<int, double>::const_iterator replacement;
-                replacement = this->m_replacement_values.find(var_index);
+                for (size_t var_index = 0; var_index < this->m_data_store->rank() && isPointValid; var_index++) {
+                    typename std::map<int, double>::const_iterator replacement;
+                    replacement = this->m_replacement_values.find(var_index);
 
-                // is this contribution valid?
+                    // is this contribution valid?
 
-                T value = data_store()->get(var_index, gridpoint, isPointInRange, isPointValid);
+                    T value = data_store()->get(var_index, linear_index, isPointInRange, isPointValid);
 
-                if (!isPointValid) {
-                    // Reading routine marked this point 'off limits'
-#if WITH_OPENMP
-#pragma omp critical
-#endif
-                    this->m_off_limits->set(gridpoint, true);
-                }
+                    if (!isPointValid) {
+                        // Reading routine marked this point 'off limits'.
+                        // Each grid point is visited exactly once, so no
+                        // two threads write the same element
+                        off_limits->set(gridpoint, true);
+                    }
 
-                if (isPointValid && isPointInRange) {
-                    values.push_back(value);
+                    if (isPointValid && isPointInRange) {
+                        values.push_back(value);
 
-                    // apply upper/lower thresholding to the value, if asked
+                        // apply upper/lower thresholding to the value, if asked
 
-                    map<int, double>::const_iterator fi;
-                    fi = m_lower_thresholds.find(var_index);
-                    if (fi != m_lower_thresholds.end()) {
-                        if (value < fi->second) {
-                            if (replacement != this->m_replacement_values.end()) {
-                                value = replacement->second;
-                            } else {
-                                isPointValid = false;
+                        map<int, double>::const_iterator fi;
+                        fi = m_lower_thresholds.find(var_index);
+                        if (fi != m_lower_thresholds.end()) {
+                            if (value < fi->second) {
+                                if (replacement != this->m_replacement_values.end()) {
+                                    value = replacement->second;
+                                } else {
+                                    isPointValid = false;
+                                }
                             }
                         }
-                    }
 
-                    fi = m_upper_thresholds.find(var_index);
-                    if (fi != m_upper_thresholds.end()) {
-                        if (value > fi->second) {
-                            if (replacement != this->m_replacement_values.end()) {
-                                value = replacement->second;
-                            } else {
-                                isPointValid = false;
+                        fi = m_upper_thresholds.find(var_index);
+                        if (fi != m_upper_thresholds.end()) {
+                            if (value > fi->second) {
+                                if (replacement != this->m_replacement_values.end()) {
+                                    value = replacement->second;
+                                } else {
+                                    isPointValid = false;
+                                }
                             }
                         }
+                    } else if (replacement != this->m_replacement_values.end()) {
+                        // check for replacement value and use after all
+                        value = replacement->second;
+                        isPointValid = true;
                     }
-                } else if (replacement != this->m_replacement_values.end()) {
-                    // check for replacement value and use after all
-                    value = replacement->second;
-                    isPointValid = true;
                 }
-            }
 
-            // if the point is still valid (all variables measured up to criteria)
-            // add it to the feature-space
+                // if the point is still valid (all variables measured up to criteria)
+                // add it to the chunk
 
-            if (isPointValid) {
-                typename Point<T>::ptr p = NULL;
-
-#if WITH_OPENMP
-#pragma omp critical
-#endif
-                {
-                    p = PointFactory<T>::get_instance()->create(gridpoint, coordinate, values);
+                if (isPointValid) {
+                    vector<int> gp(gridpoint.begin(), gridpoint.end());
+                    typename Point<T>::ptr p = PointFactory<T>::get_instance()->create(storage, gp, coordinate, values);
                     p->isOriginalPoint = true;
-                    this->points.push_back(p);
+                    local_points.push_back(p);
+
+                    for (size_t vi = 0; vi < value_rank; vi++) {
+                        T v = p->values[spatial_rank + vi];
+                        if (v < local_min[vi]) {
+                            local_min[vi] = v;
+                        }
+                        if (v > local_max[vi]) {
+                            local_max[vi] = v;
+                        }
+                    }
                 }
+            }
 
-                for (size_t vi = 0; vi < data_store()->rank(); vi++) {
-                    if (p->values[coordinate.size() + vi] < m_min[vi]) {
+            if (m_progress_bar != NULL) {
 #if WITH_OPENMP
 #pragma omp critical
 #endif
-                        m_min[vi] = p->values[coordinate.size() + vi];
-                    }
+                (*m_progress_bar) += (chunk_end - chunk_begin);
+            }
+        }
+
+        // Prefix sum over the chunk sizes gives each
+        // chunk's position in the point list
+
+        vector<size_t> chunk_offsets(num_chunks + 1, 0);
+        for (size_t chunk = 0; chunk < num_chunks; chunk++) {
+            chunk_offsets[chunk + 1] = chunk_offsets[chunk] + chunk_points[chunk].size();
+        }
+
+        const size_t existing = this->points.size();
+        this->points.resize(existing + chunk_offsets[num_chunks]);
 
-                    if (p->values[coordinate.size() + vi] > m_max[vi]) {
 #if WITH_OPENMP
-#pragma omp critical
+#pragma omp parallel for schedule(static)
 #endif
-                        m_max[vi] = p->values[coordinate.size() + vi];
-                    }
+        for (size_t chunk = 0; chunk < num_chunks; chunk++) {
+            std::copy(chunk_points[chunk].begin(),
+                      chunk_points[chunk].end(),
+                      this->points.begin() + existing + chunk_offsets[chunk]);
+        }
+
+        // Reduce the value ranges in chunk order
+
+        for (size_t chunk = 0; chunk < num_chunks; chunk++) {
+            if (chunk_points[chunk].empty()) {
+                continue;
+            }
+            for (size_t vi = 0; vi < value_rank; vi++) {
+                if (chunk_min[chunk][vi] < m_min[vi]) {
+                    m_min[vi] = chunk_min[chunk][vi];
+                }
+                if (chunk_max[chunk][vi] > m_max[vi]) {
+                    m_max[vi] = chunk_max[chunk][vi];
                 }
             }
         }
@@ -295,6 +415,17 @@ namespace m3D {
         return coordinate;
     }
 
+    template<typename T>
+    typename CoordinateSystem<T>::Coordinate
+    FeatureSpace<T>::spatial_component(const ColumnView<T> &value) const {
+        assert(value.size() >= this->coordinate_system->rank());
+
+        typename CoordinateSystem<T>::Coordinate coordinate(value.begin(),
+                                                            value.begin() + this->coordinate_system->rank());
+
+        return coordinate;
+    }
+
     template<typename T>
     T
     FeatureSpace<T>::get_spatial_component_at(typename Point<T>::ptr p, size_t index) const {
@@ -30,6 +30,7 @@
 
 #include <meanie3D/parallel.h>
 
+#include <meanie3D/array/linear_index_mapping.h>
 #include <meanie3D/array/multiarray_blitz.h>
 #include <meanie3D/featurespace/data_store.h>
 
@@ -38,6 +39,10 @@
 #include <algorithm>
 #include <limits>
 #include <fstream>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
 
 namespace m3D {
 
@@ -84,6 +89,11 @@ namespace m3D {
          */
         CoordinateSystem <T> *m_coordinate_system;
 
+        /** If the coordinate system was handed in from outside,
+         * it is not deleted with the data store.
+         */
+        bool m_owns_coordinate_system;
+
         /** Index of the time(time) variable to use. If -1, it is assumed
          * that there is no time variable and it is omitted.
          */
@@ -105,6 +115,12 @@ namespace m3D {
 
         multiarray_map_t m_buffered_data;
 
+        // Contiguous row-major storage of the buffered arrays
+        // per variable, if available (NULL otherwise). Allows
+        // access by linear index.
+
+        vector<T *> m_raw_data;
+
     public:
 
 #pragma mark -
@@ -118,67 +134,104 @@ namespace m3D {
          * @param dimensions
          * @param dimension_variables
          * @param time_index
+         * @param coordinate_system (optional) coordinate system to use
+         * instead of constructing one from the file. Useful when processing
+         * a series of files on the same grid. The data store does not take
+         * ownership of it.
          */
         NetCDFDataStore(const std::string filename,
                         const std::vector<std::string> &variables,
                         const std::vector<std::string> &dimensions,
                         const std::vector<std::string> &dimension_variables,
-                        const int time_index = -1)
+                        const int time_index = -1,
+                        CoordinateSystem <T> *coordinate_system = NULL)
                 : DataStore<T>(variables, dimensions, dimension_variables), m_filename(filename),
-                  m_time_index(time_index) {
+                  m_coordinate_system(coordinate_system),
+                  m_owns_coordinate_system(coordinate_system == NULL),
+                  m_time_index(time_index), m_raw_data(variables.size(), (T *) NULL) {
             m_file = NULL;
             try {
                 m_file = new NcFile(filename.c_str(), NcFile::read);
             } catch (const netCDF::exceptions::NcException &e) {
-                cerr << "FATAL:could not open file '" << m_filename
-                     << "' for reading" << endl;
-                exit(EXIT_FAILURE);
+                std::ostringstream message;
+                message << "could not open file '" << m_filename
+                        << "' for reading";
+                throw std::runtime_error(message.str());
             }
 
-            m_coordinate_system = new CoordinateSystem<T>(m_file,
-                                                          dimensions, dimension_variables);
-
-            m_scale_factor = new T[variables.size()];
-            m_offset = new T[variables.size()];
-            m_valid_min = new T[variables.size()];
-            m_valid_max = new T[variables.size()];
-            m_min = new T[variables.size()];
-            m_max = new T[variables.size()];
-            m_fill_value = new T[variables.size()];
-
-            // Check if the variables exist
-            for (int i = 0; i < variables.size(); i++) {
-                try {
-                    NcVar var = m_file->getVar(variables[i]);
-                    if (var.isNull()) {
-                        cerr << "FATAL: no variable " << variables[i]
-                             << " found in file " << m_filename << endl;
-                        exit(EXIT_FAILURE);
-                    }
-                } catch (netCDF::exceptions::NcException &e) {
-                    cerr << "FATAL: can't access variable "
-                         << variables[i] << " in file "
-                         << m_filename << endl;
-                    exit(EXIT_FAILURE);
+            // Nothing is allocated yet, in case the following fails
+            m_scale_factor = m_offset = m_valid_min = m_valid_max = NULL;
+            m_min = m_max = m_fill_value = NULL;
+            if (m_owns_coordinate_system) {
+                m_coordinate_system = NULL;
+            }
+
+            // Without a destructor call on failure, release what has
+            // been allocated so far before passing the exception on
+            try {
+                if (m_owns_coordinate_system) {
+                    m_coordinate_system = new CoordinateSystem<T>(m_file,
+                                                                  dimensions, dimension_variables);
                 }
 
-                m_scale_factor[i] = 1.0;
-                m_offset[i] = 0.0;
-                m_fill_value[i] = NO_VALUE;
+                m_scale_factor = new T[variables.size()];
+                m_offset = new T[variables.size()];
+                m_valid_min = new T[variables.size()];
+                m_valid_max = new T[variables.size()];
+                m_min = new T[variables.size()];
+                m_max = new T[variables.size()];
+                m_fill_value = new T[variables.size()];
+
+                // Check if the variables exist
+                for (int i = 0; i < variables.size(); i++) {
+                    try {
+                        NcVar var = m_file->getVar(variables[i]);
+                        if (var.isNull()) {
+                            std::ostringstream message;
+                            message << "no variable " << variables[i]
+                                    << " found in file " << m_filename;
+                            throw std::runtime_error(message.str());
+                        }
+                    } catch (netCDF::exceptions::NcException &e) {
+                        std::ostringstream message;
+                        message << "can't access variable "
+                                << variables[i] << " in file "
+                                << m_filename;
+                        throw std::runtime_error(message.str());
+                    }
 
-                m_valid_min[i] = std::numeric_limits<T>::min();
-                m_min[i] = std::numeric_limits<T>::min();
+                    m_scale_factor[i] = 1.0;
+                    m_offset[i] = 0.0;
+                    m_fill_value[i] = NO_VALUE;
 
-                m_valid_max[i] = std::numeric_limits<T>::max();
-                m_max[i] = std::numeric_limits<T>::max();
-            }
+                    m_valid_min[i] = std::numeric_limits<T>::min();
+                    m_min[i] = std::numeric_limits<T>::min();
 
-            this->read();
+                    m_valid_max[i] = std::numeric_limits<T>::max();
+                    m_max[i] = std::numeric_limits<T>::max();
+                }
+
+                this->read();
+            } catch (...) {
+                release();
+                delete m_file;
+                m_file = NULL;
+                throw;
+            }
         }
 
         /** Destructor
          */
         ~NetCDFDataStore() {
+            release();
+        }
+
+    private:
+
+        /** Frees the buffers, the arrays of variable attributes
+         * and the coordinate system, if owned.
+         */
+        void release() {
             this->discard_buffer();
             delete[] m_offset;
             delete[] m_scale_factor;
@@ -187,9 +240,13 @@ namespace m3D {
             delete[] m_valid_max;
             delete[] m_min;
             delete[] m_max;
-            delete m_coordinate_system;
+            if (m_owns_coordinate_system) {
+                delete m_coordinate_system;
+            }
         }
 
+    public:
+
 #pragma mark -
 #pragma mark Accessors
 
@@ -243,6 +300,64 @@ namespace m3D {
 
     private:
 
+        /** Reads the variable's hyperslab for the current time index
+         * directly into the storage of the multiarray that holds it,
+         * in one call. The values are kept packed, unpacking happens
+         * on access.
+         * @param variable index
+         */
+        void
+        read_into_array(size_t variable_index) {
+            bool time_is_an_issue = this->m_time_index >= 0;
+
+            NcFile file(this->m_filename, NcFile::read);
+            NcVar variable = file.getVar(this->m_variables[variable_index]);
+
+            int spatial_dims = time_is_an_issue
+                               ? variable.getDimCount() - 1
+                               : variable.getDimCount();
+
+            if (spatial_dims < 1 || spatial_dims > 5) {
+                std::ostringstream message;
+                message << "Variables with " << spatial_dims << " spatial dimensions are not currently handled";
+                throw std::runtime_error(message.str());
+            }
+
+            // where to start reading and how much to read?
+            vector<size_t> start(variable.getDimCount(), 0);
+            vector<size_t> count;
+            if (time_is_an_issue) {
+                start[0] = this->m_time_index;
+                count.push_back(1);
+            }
+
+            vector<size_t> dims(spatial_dims);
+            size_t N = 1;
+            for (size_t i = 0; i < spatial_dims; i++) {
+                dims[i] = coordinate_system()->get_dimension_sizes()[i];
+                size_t dim_size = variable.getDim(time_is_an_issue ? i + 1 : i).getSize();
+                if (dim_size != dims[i]) {
+                    std::ostringstream message;
+                    message << "dimension " << i << " of variable " << this->m_variables[variable_index]
+                            << " does not match the coordinate system";
+                    throw std::runtime_error(message.str());
+                }
+                count.push_back(dim_size);
+                N *= dim_size;
+            }
+
+            T *values = new(std::nothrow) T[N];
+            if (values == NULL) {
+                throw std::runtime_error("out of memory");
+            }
+
+            // read the chunk
+            variable.getVar(start, count, values);
+
+            // The array takes over the buffer
+            this->set_data(variable_index, new MultiArrayBlitz<T>(dims, values));
+        }
+
         void
         read_buffer(size_t variable_index) {
             bool time_is_an_issue = this->m_time_index >= 0;
@@ -312,8 +427,7 @@ namespace m3D {
                 // Create buffer to hold data
                 T *values = (T *) calloc(N * M, sizeof(T));
                 if (values == NULL) {
-                    cerr << "FATAL:out of memory" << endl;
-                    exit(EXIT_FAILURE);
+                    throw std::runtime_error("out of memory");
                 }
 
                 // where to start reading?
@@ -363,8 +477,7 @@ namespace m3D {
                 // Allocate buffer for 2D slices
                 T *values = (T *) calloc(N * M * K, sizeof(T));
                 if (values == NULL) {
-                    cerr << "FATAL:out of memory" << endl;
-                    exit(EXIT_FAILURE);
+                    throw std::runtime_error("out of memory");
                 }
 
                 // where to start reading?
@@ -405,13 +518,13 @@ namespace m3D {
                 delete values;
 
             } else {
-                cerr << "FATAL: Variables with " << spatial_dims << " spatial dimensions are not currently handled" <<
-                     endl;
-                exit(EXIT_FAILURE);
+                std::ostringstream message;
+                message << "Variables with " << spatial_dims << " spatial dimensions are not currently handled";
+                throw std::runtime_error(message.str());
             }
 
             // Store result in map
-            this->m_buffered_data[variable_index] = index;
+            this->set_data(variable_index, index);
         }
 
         void
@@ -456,8 +569,7 @@ namespace m3D {
                 // copy the data into the buffer
                 T *values = (T *) calloc(N, sizeof(T));
                 if (values == NULL) {
-                    cerr << "FATAL:out of memory" << endl;
-                    exit(EXIT_FAILURE);
+                    throw std::runtime_error("out of memory");
                 }
 
                 for (int i = 0; i < N; i++) {
@@ -485,8 +597,7 @@ namespace m3D {
                 // Create buffer to hold data
                 T *values = (T *) calloc(N * M, sizeof(T));
                 if (values == NULL) {
-                    cerr << "FATAL:out of memory" << endl;
-                    exit(EXIT_FAILURE);
+                    throw std::runtime_error("out of memory");
                 }
 
                 // where to start reading?
@@ -537,8 +648,7 @@ namespace m3D {
                 // Allocate buffer for 2D slices
                 T *values = (T *) calloc(N * M * K, sizeof(T));
                 if (values == NULL) {
-                    cerr << "FATAL:out of memory" << endl;
-                    exit(EXIT_FAILURE);
+                    throw std::runtime_error("out of memory");
                 }
 
                 // where to start reading?
@@ -579,9 +689,9 @@ namespace m3D {
                 delete[] values;
 
             } else {
-                cerr << "FATAL: Variables with " << spatial_dims << " spatial dimensions are not currently handled" <<
-                     endl;
-                exit(EXIT_FAILURE);
+                std::ostringstream message;
+                message << "Variables with " << spatial_dims << " spatial dimensions are not currently handled";
+                throw std::runtime_error(message.str());
             }
         }
 
@@ -594,6 +704,7 @@ namespace m3D {
                 i->second = NULL;
                 delete indexPtr;
             }
+            std::fill(m_raw_data.begin(), m_raw_data.end(), (T *) NULL);
         }
 
         void
@@ -649,7 +760,11 @@ namespace m3D {
         read() {
             for (size_t var_index = 0; var_index < this->rank(); var_index++) {
                 this->get_limits(var_index);
+#if NETCDF_READS_INTO_ARRAY
+                this->read_into_array(var_index);
+#else
                 this->read_buffer(var_index);
+#endif
             }
         }
 
@@ -711,7 +826,6 @@ namespace m3D {
          */
         T get(size_t variable_index, const vector<int> &gridpoint, bool &is_in_range, bool &is_valid) const {
             T value = 0.0;
-            T unpacked_value = 0.0;
             typename multiarray_map_t::const_iterator i;
             i = m_buffered_data.find(variable_index);
 
@@ -720,10 +834,53 @@ namespace m3D {
 
                 value = indexPtr->get(gridpoint);
             } else {
-                cerr << "FATAL: no buffered data for variable with index " << variable_index << endl;
-                exit(EXIT_FAILURE);
+                std::ostringstream message;
+                message << "no buffered data for variable with index " << variable_index;
+                throw std::runtime_error(message.str());
             }
 
+            return this->unpack(variable_index, value, is_in_range, is_valid);
+        }
+
+        /** Gets a point by it's linear index. The index may run
+         * from 0 ... (N-1) where N is the total number of points
+         * in the grid.
+         */
+        virtual
+        T get(size_t variable_index,
+              size_t index,
+              bool &is_in_range,
+              bool &is_valid) const {
+            T value = 0.0;
+            const T *raw = m_raw_data[variable_index];
+            if (raw != NULL) {
+                value = raw[index];
+            } else {
+                LinearIndexMapping mapping(this->get_dimension_sizes());
+                typename multiarray_map_t::const_iterator i = m_buffered_data.find(variable_index);
+                if (i == m_buffered_data.end() || i->second == NULL) {
+                    std::ostringstream message;
+                    message << "no buffered data for variable with index " << variable_index;
+                    throw std::runtime_error(message.str());
+                }
+                value = i->second->get(mapping.linear_to_grid(index));
+            }
+
+            return this->unpack(variable_index, value, is_in_range, is_valid);
+        }
+
+    private:
+
+        /** Checks a packed value against fill value and valid range
+         * and unpacks it.
+         * @param variable index
+         * @param packed value
+         * @param is the value in the valid range?
+         * @param is the value valid (not the fill value)?
+         * @return unpacked value
+         */
+        inline
+        T unpack(size_t variable_index, T value, bool &is_in_range, bool &is_valid) const {
             if (m_fill_value[variable_index] != NO_VALUE) {
                 is_valid = (value != m_fill_value[variable_index]);
                 // If it's invalid, it's automatically out of range
@@ -736,24 +893,10 @@ namespace m3D {
             }
 
             // scale first, then offset
-            unpacked_value = m_scale_factor[variable_index]
-                             * value + m_offset[variable_index];
-
-            return unpacked_value;
+            return m_scale_factor[variable_index] * value + m_offset[variable_index];
         }
 
-        /** Gets a point by it's linear index. The index may run
-         * from 0 ... (N-1) where N is the total number of points
-         * in the grid.
-         */
-        virtual
-        T get(size_t variable_index,
-              size_t index,
-              bool &is_in_range,
-              bool &is_valid) const {
-
-            return 0;
-        }
+    public:
 
         /** Values in memory buffer are 'packed'. When retrieving values
          * through get(..) they are unpacked. In order to get the packed
@@ -781,8 +924,9 @@ namespace m3D {
             if (i != m_buffered_data.end()) {
                 indexPtr = i->second;
             } else {
-                cerr << "FATAL: no buffered data for variable with index " << variable_index << endl;
-                exit(EXIT_FAILURE);
+                std::ostringstream message;
+                message << "no buffered data for variable with index " << variable_index;
+                throw std::runtime_error(message.str());
             }
 
             // scale first, then offset
@@ -827,8 +971,9 @@ namespace m3D {
             if (i != m_buffered_data.end()) {
                 return i->second;
             } else {
-                cerr << "FATAL: no buffered data for variable with index " << index << endl;
-                exit(EXIT_FAILURE);
+                std::ostringstream message;
+                message << "no buffered data for variable with index " << index;
+                throw std::runtime_error(message.str());
             }
         }
 
@@ -843,6 +988,10 @@ namespace m3D {
                 delete ptr;
             }
 
+            // Blitz arrays are stored contiguously and in
+            // row-major order, other arrays are not known
+            MultiArrayBlitz<T> *blitz_data = dynamic_cast<MultiArrayBlitz<T> *>(data);
+            m_raw_data[index] = (blitz_data != NULL) ? blitz_data->data() : NULL;
             m_buffered_data[index] = data;
         }
 
@@ -27,6 +27,7 @@
 
 #include <meanie3D/defines.h>
 #include <meanie3D/namespaces.h>
+#include <meanie3D/featurespace/point_columns.h>
 
 #include <vector>
 
@@ -38,13 +39,32 @@ namespace m3D {
     template<typename T>
     class Cluster;
 
-    /** This represents one point f in feature space F.
+    /** This represents one point f in feature space F. The point
+     * is a row in a block of columns (see PointColumns). Its vector
+     * properties are views into that row.
      */
     template<class T>
     struct Point
     {
     private:
 
+        PointColumns<T> *m_columns;
+
+        size_t m_row;
+
+        /** Allocates the row from the given storage and binds
+         * the views to it.
+         */
+        void bind(PointStorage<T> &storage, size_t grid_rank, size_t coord_rank, size_t value_rank);
+
+        /** Same from the shared storage
+         */
+        void bind(size_t grid_rank, size_t coord_rank, size_t value_rank);
+
+        /** Binds the views to the row
+         */
+        void bind_views();
+
     public:
 
 #pragma mark -
@@ -58,22 +78,22 @@ namespace m3D {
 #pragma mark public properties
 
         /** spatial coordinate */
-        vector<T> coordinate;
+        ColumnView<T> coordinate;
 
         /** added for quicker array indexing */
-        vector<int> gridpoint;
+        ColumnView<int> gridpoint;
 
         /** actual point in feature space */
-        vector<T> values;
+        ColumnView<T> values;
 
         /** @deprecated */
         size_t trajectory_length;
 
         /** meanshift vector (rounded to resolution) */
-        vector<T> shift;
+        ColumnView<T> shift;
 
         /** meanshift vector in grid points */
-        vector<int> gridded_shift;
+        ColumnView<int> gridded_shift;
 
         /** Remembers if this point was part of the original
          * feature-space construction
@@ -105,7 +125,8 @@ namespace m3D {
         Point<T>
         operator=(const Point &o);
 
-        /** Default constructor
+        /** Default constructor. The point has no row and
+         * all its vector properties are empty.
          */
         Point();
 
@@ -118,6 +139,19 @@ namespace m3D {
               vector<T> &coordinate,
               vector<T> &values);
 
+        /** Constructor for bulk construction. The row is taken from
+         * the given storage, which must not be used by other threads
+         * at the same time.
+         * @param storage
+         * @param gridpoint
+         * @param coordinate
+         * @param values
+         */
+        Point(PointStorage<T> &storage,
+              const vector<int> &gridpoint,
+              const vector<T> &coordinate,
+              const vector<T> &values);
+
         /** Constructor.
          * @param coordinate
          * @param values
@@ -126,10 +160,9 @@ namespace m3D {
         Point(vector<T> &coordinate,
               vector<T> &values);
 
-        /** Destructor 
+        /** Destructor. Lets go of the row.
          */
-        virtual ~Point() {
-        }
+        virtual ~Point();
 
 #pragma mark -
 #pragma mark Operators
@@ -142,6 +175,21 @@ namespace m3D {
         bool
         operator==(const Point<T> &o);
 
+#pragma mark -
+#pragma mark Columns
+
+        /** @return block of columns holding the point or NULL
+         */
+        inline PointColumns<T> *columns() const {
+            return m_columns;
+        };
+
+        /** @return row of the point in its block of columns
+         */
+        inline size_t row() const {
+            return m_row;
+        };
+
 #pragma mark -
 #pragma mark Misc
 
@@ -0,0 +1,503 @@
+/* The MIT License (MIT)
+ *
+ * (c) Jürgen Simon 2014 (juergen.simon@uni-bonn.de)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef M3D_POINT_COLUMNS_H
+#define M3D_POINT_COLUMNS_H
+
+#include <meanie3D/defines.h>
+#include <meanie3D/namespaces.h>
+
+#include <assert.h>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+namespace m3D {
+
+    using namespace std;
+
+    /** Strided iterator over the elements of a ColumnView.
+     */
+    template<typename V>
+    class ColumnIterator
+    {
+    private:
+
+        V *m_element;
+        ptrdiff_t m_stride;
+
+    public:
+
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef V value_type;
+        typedef ptrdiff_t difference_type;
+        typedef V *pointer;
+        typedef V &reference;
+
+        ColumnIterator() : m_element(NULL), m_stride(0) {};
+
+        ColumnIterator(V *element, ptrdiff_t stride) : m_element(element), m_stride(stride) {};
+
+        V &operator*() const {
+            return *m_element;
+        };
+
+        V &operator[](ptrdiff_t n) const {
+            return m_element[n * m_stride];
+        };
+
+        ColumnIterator &operator++() {
+            m_element += m_stride;
+            return *this;
+        };
+
+        ColumnIterator operator++(int) {
+            ColumnIterator it(*this);
+            m_element += m_stride;
+            return it;
+        };
+
+        ColumnIterator &operator--() {
+            m_element -= m_stride;
+            return *this;
+        };
+
+        ColumnIterator operator--(int) {
+            ColumnIterator it(*this);
+            m_element -= m_stride;
+            return it;
+        };
+
+        ColumnIterator &operator+=(ptrdiff_t n) {
+            m_element += n * m_stride;
+            return *this;
+        };
+
+        ColumnIterator &operator-=(ptrdiff_t n) {
+            m_element -= n * m_stride;
+            return *this;
+        };
+
+        ColumnIterator operator+(ptrdiff_t n) const {
+            return ColumnIterator(m_element + n * m_stride, m_stride);
+        };
+
+        ColumnIterator operator-(ptrdiff_t n) const {
+            return ColumnIterator(m_element - n * m_stride, m_stride);
+        };
+
+        ptrdiff_t operator-(const ColumnIterator &o) const {
+            return (m_stride == 0) ? 0 : (m_element - o.m_element) / m_stride;
+        };
+
+        bool operator==(const ColumnIterator &o) const {
+            return m_element == o.m_element;
+        };
+
+        bool operator!=(const ColumnIterator &o) const {
+            return m_element != o.m_element;
+        };
+
+        bool operator<(const ColumnIterator &o) const {
+            return m_element < o.m_element;
+        };
+    };
+
+    /** The components of one point in its block of columns. Element i
+     * is found one column further along, at i times the block capacity.
+     * A view does not own the elements and behaves like a pointer:
+     * assigning to a view copies into the columns, it never re-binds
+     * the view, and a const view still allows changing the elements.
+     * Views convert to vectors, which copies the components.
+     */
+    template<typename V>
+    class ColumnView
+    {
+    private:
+
+        V *m_first;
+        unsigned int m_stride;
+        unsigned int m_size;
+
+    public:
+
+        typedef V value_type;
+        typedef size_t size_type;
+        typedef ColumnIterator<V> iterator;
+        typedef ColumnIterator<V> const_iterator;
+
+        ColumnView() : m_first(NULL), m_stride(0), m_size(0) {};
+
+        ColumnView(V *first, size_t stride, size_t size)
+                : m_first(first), m_stride((unsigned int) stride), m_size((unsigned int) size) {};
+
+        /** Copies the elements of the other view. The sizes must match.
+         */
+        ColumnView &operator=(const ColumnView &o) {
+            assert(o.size() == size());
+            for (size_t i = 0; i < m_size; i++) {
+                m_first[i * m_stride] = o[i];
+            }
+            return *this;
+        };
+
+        /** Copies the elements of the vector. The sizes must match.
+         */
+        template<typename W>
+        ColumnView &operator=(const vector<W> &v) {
+            assert(v.size() == size());
+            for (size_t i = 0; i < m_size; i++) {
+                m_first[i * m_stride] = (V) v[i];
+            }
+            return *this;
+        };
+
+        /** Points the view at other elements.
+         */
+        void rebind(V *first, size_t stride, size_t size) {
+            m_first = first;
+            m_stride = (unsigned int) stride;
+            m_size = (unsigned int) size;
+        };
+
+        /** Copies the elements into a vector, for code which
+         * still takes vectors.
+         */
+        operator vector<V>() const {
+            return vector<V>(begin(), end());
+        };
+
+        inline size_t size() const {
+            return m_size;
+        };
+
+        inline bool empty() const {
+            return m_size == 0;
+        };
+
+        /** @return distance of consecutive elements in the columns
+         */
+        inline size_t stride() const {
+            return m_stride;
+        };
+
+        inline V &operator[](size_t i) const {
+            return m_first[i * m_stride];
+        };
+
+        V &at(size_t i) const {
+            if (i >= m_size) {
+                throw std::out_of_range("ColumnView::at");
+            }
+            return m_first[i * m_stride];
+        };
+
+        inline V &front() const {
+            return m_first[0];
+        };
+
+        inline V &back() const {
+            return m_first[(m_size - 1) * m_stride];
+        };
+
+        inline iterator begin() const {
+            return iterator(m_first, m_stride);
+        };
+
+        inline iterator end() const {
+            return iterator(m_first + m_size * m_stride, m_stride);
+        };
+
+        void fill(const V &value) const {
+            for (size_t i = 0; i < m_size; i++) {
+                m_first[i * m_stride] = value;
+            }
+        };
+    };
+
+    template<typename V>
+    bool operator==(const ColumnView<V> &a, const ColumnView<V> &b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); i++) {
+            if (a[i] != b[i]) return false;
+        }
+        return true;
+    }
+
+    template<typename V>
+    bool operator==(const ColumnView<V> &a, const vector<V> &b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); i++) {
+            if (a[i] != b[i]) return false;
+        }
+        return true;
+    }
+
+    template<typename V>
+    bool operator==(const vector<V> &a, const ColumnView<V> &b) {
+        return b == a;
+    }
+
+    template<typename V>
+    bool operator!=(const ColumnView<V> &a, const ColumnView<V> &b) {
+        return !(a == b);
+    }
+
+    template<typename V>
+    bool operator!=(const ColumnView<V> &a, const vector<V> &b) {
+        return !(a == b);
+    }
+
+    template<typename V>
+    bool operator!=(const vector<V> &a, const ColumnView<V> &b) {
+        return !(b == a);
+    }
+
+    /** Same format as vectors
+     */
+    template<typename V>
+    std::ostream &operator<<(std::ostream &os, const ColumnView<V> &v) {
+        os << "(";
+        for (size_t i = 0; i < v.size(); i++) {
+            os << v[i];
+            if (i + 1 < v.size()) {
+                os << ",";
+            }
+        }
+        os << ")";
+        return os;
+    }
+
+#pragma mark -
+#pragma mark Arithmetic
+
+    // Same as the vector operators in utils::vectors
+
+    template<typename V>
+    void operator+=(vector<V> &v, const ColumnView<V> &o) {
+        for (size_t i = 0; i < v.size(); i++) {
+            v[i] += o[i];
+        }
+    }
+
+    template<typename V>
+    void operator+=(const ColumnView<V> &v, const vector<V> &o) {
+        for (size_t i = 0; i < v.size(); i++) {
+            v[i] += o[i];
+        }
+    }
+
+    template<typename V>
+    vector<V> operator+(const ColumnView<V> &v, const vector<V> &o) {
+        vector<V> result(v.size());
+        for (size_t i = 0; i < v.size(); i++) {
+            result[i] = v[i] + o[i];
+        }
+        return result;
+    }
+
+    template<typename V>
+    vector<V> operator-(const ColumnView<V> &v, const ColumnView<V> &o) {
+        vector<V> result(v.size());
+        for (size_t i = 0; i < v.size(); i++) {
+            result[i] = v[i] - o[i];
+        }
+        return result;
+    }
+
+    template<typename V>
+    vector<V> operator*(const ColumnView<V> &v, const V s) {
+        vector<V> result(v.size());
+        for (size_t i = 0; i < v.size(); i++) {
+            result[i] = v[i] * s;
+        }
+        return result;
+    }
+
+#pragma mark -
+#pragma mark Blocks of columns
+
+    /** A block of rows of the feature-space, one row per point. Each
+     * component has its own contiguous column, which keeps the values
+     * of one variable together for the passes over many points and
+     * replaces the separate heap vectors of each point.
+     *
+     * Rows are handed out once and never re-used. The block counts
+     * its points plus the storage that is filling it, and deletes
+     * itself when the last of them lets go. Points therefore remain
+     * valid as they are moved between feature-spaces, indexes and
+     * clusters.
+     */
+    template<typename T>
+    class PointColumns
+    {
+    private:
+
+        size_t m_grid_rank;
+        size_t m_coord_rank;
+        size_t m_value_rank;
+        size_t m_capacity;
+        size_t m_size;
+
+        // coordinate, values and shift columns
+        vector<T> m_reals;
+
+        // gridpoint and gridded_shift columns
+        vector<int> m_ints;
+
+        long m_references;
+
+        ~PointColumns() {};
+
+    public:
+
+        /** Creates an empty block, which is referenced once
+         * by the caller.
+         * @param rank of the grid points
+         * @param rank of the coordinates
+         * @param rank of the values
+         * @param number of rows
+         */
+        PointColumns(size_t grid_rank, size_t coord_rank, size_t value_rank, size_t capacity);
+
+        /** Whether the block holds rows of the given ranks.
+         */
+        inline bool matches(size_t grid_rank, size_t coord_rank, size_t value_rank) const {
+            return grid_rank == m_grid_rank
+                   && coord_rank == m_coord_rank
+                   && value_rank == m_value_rank;
+        };
+
+        inline bool full() const {
+            return m_size == m_capacity;
+        };
+
+        /** Hands out the next row. Not thread safe, each block is
+         * filled by one storage only.
+         * @return row
+         */
+        inline size_t append() {
+            assert(m_size < m_capacity);
+            return m_size++;
+        };
+
+        void retain();
+
+        void release();
+
+        inline size_t size() const {
+            return m_size;
+        };
+
+        inline size_t capacity() const {
+            return m_capacity;
+        };
+
+        inline size_t grid_rank() const {
+            return m_grid_rank;
+        };
+
+        inline size_t coord_rank() const {
+            return m_coord_rank;
+        };
+
+        inline size_t value_rank() const {
+            return m_value_rank;
+        };
+
+#pragma mark -
+#pragma mark Columns
+
+        inline T *coordinate(size_t d) {
+            return &m_reals[0] + d * m_capacity;
+        };
+
+        inline T *values(size_t d) {
+            return &m_reals[0] + (m_coord_rank + d) * m_capacity;
+        };
+
+        inline T *shift(size_t d) {
+            return &m_reals[0] + (m_coord_rank + m_value_rank + d) * m_capacity;
+        };
+
+        inline int *gridpoint(size_t d) {
+            return &m_ints[0] + d * m_capacity;
+        };
+
+        inline int *gridded_shift(size_t d) {
+            return &m_ints[0] + (m_grid_rank + d) * m_capacity;
+        };
+    };
+
+    /** Hands out rows to new points, filling one block per combination
+     * of ranks at a time. A storage is not thread safe. Bulk construction
+     * uses one storage per thread or chunk of work, everything else goes
+     * through the shared storage.
+     */
+    template<typename T>
+    class PointStorage
+    {
+    private:
+
+        size_t m_block_size;
+
+        // block being filled, one per combination of ranks
+        vector<PointColumns<T> *> m_current;
+
+        PointStorage(const PointStorage<T> &o);
+
+        PointStorage<T> &operator=(const PointStorage<T> &o);
+
+    public:
+
+        static const size_t DEFAULT_BLOCK_SIZE = 4096;
+
+        /** @param number of rows per block
+         */
+        PointStorage(size_t block_size = DEFAULT_BLOCK_SIZE);
+
+        /** Lets go of the current blocks. Blocks stay alive as long
+         * as they have points.
+         */
+        ~PointStorage();
+
+        /** Allocates a row for a point of the given ranks. The block
+         * is referenced once more on behalf of the point.
+         * @param grid_rank
+         * @param coord_rank
+         * @param value_rank
+         * @param row (out)
+         * @return block
+         */
+        PointColumns<T> *allocate(size_t grid_rank, size_t coord_rank, size_t value_rank, size_t &row);
+
+        /** Storage used by points constructed without one. Access
+         * must be serialised with the critical section 'point_storage'.
+         */
+        static PointStorage<T> &shared();
+    };
+}
+
+#endif
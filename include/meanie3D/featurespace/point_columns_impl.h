@@ -0,0 +1,111 @@
+/* The MIT License (MIT)
+ *
+ * (c) Jürgen Simon 2014 (juergen.simon@uni-bonn.de)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef M3D_POINT_COLUMNS_IMPL_H
+#define M3D_POINT_COLUMNS_IMPL_H
+
+#include <meanie3D/defines.h>
+#include <meanie3D/namespaces.h>
+
+#include "point_columns.h"
+
+namespace m3D {
+
+#pragma mark -
+#pragma mark PointColumns
+
+    template<typename T>
+    PointColumns<T>::PointColumns(size_t grid_rank, size_t coord_rank, size_t value_rank, size_t capacity)
+            : m_grid_rank(grid_rank), m_coord_rank(coord_rank), m_value_rank(value_rank), m_capacity(capacity),
+              m_size(0), m_reals((coord_rank + 2 * value_rank) * capacity + 1, 0.0),
+              m_ints(2 * grid_rank * capacity + 1, 0), m_references(1) {
+    }
+
+    template<typename T>
+    void
+    PointColumns<T>::retain() {
+#if WITH_OPENMP
+#pragma omp atomic
+#endif
+        m_references++;
+    }
+
+    template<typename T>
+    void
+    PointColumns<T>::release() {
+        long references;
+#if WITH_OPENMP
+#pragma omp atomic capture
+#endif
+        references = --m_references;
+
+        if (references == 0) {
+            delete this;
+        }
+    }
+
+#pragma mark -
+#pragma mark PointStorage
+
+    template<typename T>
+    PointStorage<T>::PointStorage(size_t block_size)
+            : m_block_size(block_size) {
+    }
+
+    template<typename T>
+    PointStorage<T>::~PointStorage() {
+        for (size_t i = 0; i < m_current.size(); i++) {
+            m_current[i]->release();
+        }
+    }
+
+    template<typename T>
+    PointColumns<T> *
+    PointStorage<T>::allocate(size_t grid_rank, size_t coord_rank, size_t value_rank, size_t &row) {
+        size_t i = 0;
+        while (i < m_current.size() && !m_current[i]->matches(grid_rank, coord_rank, value_rank)) {
+            i++;
+        }
+        if (i == m_current.size()) {
+            m_current.push_back(new PointColumns<T>(grid_rank, coord_rank, value_rank, m_block_size));
+        } else if (m_current[i]->full()) {
+            m_current[i]->release();
+            m_current[i] = new PointColumns<T>(grid_rank, coord_rank, value_rank, m_block_size);
+        }
+
+        PointColumns<T> *block = m_current[i];
+        row = block->append();
+        block->retain();
+        return block;
+    }
+
+    template<typename T>
+    PointStorage<T> &
+    PointStorage<T>::shared() {
+        static PointStorage<T> storage;
+        return storage;
+    }
+}
+
+#endif
@@ -50,6 +50,13 @@ namespace m3D {
             return new Point<T>(gridpoint, coord, value);
         }
 
+        virtual Point <T> *create(PointStorage <T> &storage,
+                                  const vector<int> &gridpoint,
+                                  const vector <T> &coord,
+                                  const vector <T> &value) {
+            return new Point<T>(storage, gridpoint, coord, value);
+        }
+
         virtual Point <T> *create(vector <T> &coord, vector <T> &value) {
             return new Point<T>(coord, value);
         }
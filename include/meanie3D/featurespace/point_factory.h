@@ -81,6 +81,21 @@ namespace m3D {
         Point <T> *
         create(vector<int> &gridpoint, vector <T> &coord, vector <T> &value) = 0;
 
+        /** This is an abstract method used to create new instances of Point
+         * in bulk. The row is taken from the given storage, which must not
+         * be used by other threads at the same time.
+         * @param storage
+         * @param gridpoint
+         * @param coordinates
+         * @param value
+         */
+        virtual
+        Point <T> *
+        create(PointStorage <T> &storage,
+               const vector<int> &gridpoint,
+               const vector <T> &coord,
+               const vector <T> &value) = 0;
+
         /** This is an abstract method used to create new instances of Point.
          * @param coordinates
          * @param value
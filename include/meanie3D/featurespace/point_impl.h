@@ -32,39 +32,112 @@
 #include <math.h>
 
 #include "point.h"
+#include "point_columns_impl.h"
 
 namespace m3D {
 
+#pragma mark -
+#pragma mark Columns
+
+    template<class T>
+    void
+    Point<T>::bind(PointStorage<T> &storage, size_t grid_rank, size_t coord_rank, size_t value_rank) {
+        m_columns = storage.allocate(grid_rank, coord_rank, value_rank, m_row);
+        bind_views();
+    }
+
+    template<class T>
+    void
+    Point<T>::bind(size_t grid_rank, size_t coord_rank, size_t value_rank) {
+#if WITH_OPENMP
+#pragma omp critical (point_storage)
+#endif
+        m_columns = PointStorage<T>::shared().allocate(grid_rank, coord_rank, value_rank, m_row);
+        bind_views();
+    }
+
+    template<class T>
+    void
+    Point<T>::bind_views() {
+        size_t stride = m_columns->capacity();
+        coordinate.rebind(m_columns->coordinate(0) + m_row, stride, m_columns->coord_rank());
+        values.rebind(m_columns->values(0) + m_row, stride, m_columns->value_rank());
+        shift.rebind(m_columns->shift(0) + m_row, stride, m_columns->value_rank());
+        gridpoint.rebind(m_columns->gridpoint(0) + m_row, stride, m_columns->grid_rank());
+        gridded_shift.rebind(m_columns->gridded_shift(0) + m_row, stride, m_columns->grid_rank());
+    }
+
+#pragma mark -
+#pragma mark Constructor/Destructor
+
     template<class T>
     Point<T>::Point()
-            : trajectory_length(0), isOriginalPoint(false) {
+            : m_columns(NULL), m_row(0), trajectory_length(0), isOriginalPoint(false), cluster(NULL),
+              isBoundary(false) {
     }
 
     template<class T>
     Point<T>::Point(vector<int> &gp, vector <T> &coord, vector <T> &value)
-            : coordinate(coord), gridpoint(gp), values(value), isOriginalPoint(false), cluster(NULL),
-              isBoundary(false) {
-        trajectory_length = 0;
+            : trajectory_length(0), isOriginalPoint(false), cluster(NULL), isBoundary(false) {
+        bind(gp.size(), coord.size(), value.size());
+        gridpoint = gp;
+        coordinate = coord;
+        values = value;
+    }
+
+    template<class T>
+    Point<T>::Point(PointStorage<T> &storage,
+                    const vector<int> &gp,
+                    const vector <T> &coord,
+                    const vector <T> &value)
+            : trajectory_length(0), isOriginalPoint(false), cluster(NULL), isBoundary(false) {
+        bind(storage, gp.size(), coord.size(), value.size());
+        gridpoint = gp;
+        coordinate = coord;
+        values = value;
     }
 
     template<class T>
     Point<T>::Point(vector <T> &coord, vector <T> &value)
-            : coordinate(coord), values(value), isOriginalPoint(false), cluster(NULL), isBoundary(false) {
-        trajectory_length = 0;
+            : trajectory_length(0), isOriginalPoint(false), cluster(NULL), isBoundary(false) {
+        bind(0, coord.size(), value.size());
+        coordinate = coord;
+        values = value;
     }
 
     template<class T>
     Point<T>::Point(const Point <T> &o)
-            : coordinate(o.coordinate), values(o.values), trajectory_length(o.trajectory_length), shift(o.shift),
-              gridded_shift(o.gridded_shift), gridpoint(o.gridpoint), isOriginalPoint(o.isOriginalPoint),
+            : m_columns(NULL), m_row(0), trajectory_length(o.trajectory_length), isOriginalPoint(o.isOriginalPoint),
               cluster(o.cluster), isBoundary(o.isBoundary) {
+        if (o.m_columns != NULL) {
+            bind(o.gridpoint.size(), o.coordinate.size(), o.values.size());
+            coordinate = o.coordinate;
+            gridpoint = o.gridpoint;
+            values = o.values;
+            shift = o.shift;
+            gridded_shift = o.gridded_shift;
+        }
     }
 
     template<class T>
     Point<T>::Point(const Point <T> *o)
-            : coordinate(o->coordinate), gridpoint(o->gridpoint), values(o->values),
-              trajectory_length(o->trajectory_length), shift(o->shift), gridded_shift(o->gridded_shift),
-              isOriginalPoint(o->isOriginalPoint), cluster(o->cluster), isBoundary(o->isBoundary) {
+            : m_columns(NULL), m_row(0), trajectory_length(o->trajectory_length), isOriginalPoint(o->isOriginalPoint),
+              cluster(o->cluster), isBoundary(o->isBoundary) {
+        if (o->m_columns != NULL) {
+            bind(o->gridpoint.size(), o->coordinate.size(), o->values.size());
+            coordinate = o->coordinate;
+            gridpoint = o->gridpoint;
+            values = o->values;
+            shift = o->shift;
+            gridded_shift = o->gridded_shift;
+        }
+    }
+
+    template<class T>
+    Point<T>::~Point() {
+        if (m_columns != NULL) {
+            m_columns->release();
+        }
     }
 
     template<class T>
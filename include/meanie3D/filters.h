@@ -25,7 +25,9 @@
 #define M3D_FILTER_INCLUDES_H
 
 #include <meanie3D/filters/filter.h>
+#include <meanie3D/filters/grid_stencil.h>
 #include <meanie3D/filters/convection_filter.h>
+#include <meanie3D/filters/recursive_gaussian.h>
 #include <meanie3D/filters/replacement_filter.h>
 #include <meanie3D/filters/scalespace_kernel.h>
 #include <meanie3D/filters/scalespace_filter.h>
@@ -82,7 +82,34 @@ namespace m3D {
 #pragma mark -
 #pragma mark Abstract filter method
 
+        /** Applies the filter on the grid if CONVECTION_FILTER_USES_GRID_STENCIL
+         * is set and the grid points are evenly spaced, and with range
+         * searches otherwise.
+         * @param feature-space
+         */
         virtual void apply(FeatureSpace <T> *fs);
+
+#pragma mark -
+#pragma mark Implementations
+
+        /** Original implementation. Finds the background and the
+         * convective radius of each point with range searches on
+         * the point coordinates.
+         * @param feature-space
+         */
+        void
+        apply_with_index(FeatureSpace<T> *fs);
+
+        /** Same result as apply_with_index, but the neighbourhoods are
+         * taken from prefix sums along the grid lines, summed over the
+         * rows of grid stencils. All loops run in parallel. The stencils
+         * are measured in multiples of the grid resolution, so the
+         * result matches apply_with_index only if the grid points are
+         * evenly spaced (see GridStencil::matches_grid).
+         * @param feature-space
+         */
+        void
+        apply_on_grid(FeatureSpace<T> *fs);
     };
 }
 
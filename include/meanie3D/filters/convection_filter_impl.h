@@ -30,6 +30,7 @@
 #include <boost/progress.hpp>
 
 #include "convection_filter.h"
+#include "grid_stencil.h"
 
 namespace m3D {
 
@@ -56,6 +57,20 @@ namespace m3D {
     template<typename T>
     void
     ConvectionFilter<T>::apply(FeatureSpace <T> *fs) {
+#if CONVECTION_FILTER_USES_GRID_STENCIL
+        if (GridStencil<T>::matches_grid(fs->coordinate_system)) {
+            this->apply_on_grid(fs);
+        } else {
+            this->apply_with_index(fs);
+        }
+#else
+        this->apply_with_index(fs);
+#endif
+    }
+
+    template<typename T>
+    void
+    ConvectionFilter<T>::apply_with_index(FeatureSpace <T> *fs) {
         using namespace std;
         using namespace m3D::utils::vectors;
 
@@ -69,19 +84,26 @@ namespace m3D {
             start_timer();
         }
 
-        // Create a point index with spatial components only
+        // Use the shared spatial index or create one
+
+        PointIndex<T> *index = this->spatial_index();
 
-        PointIndex<T> *index = PointIndex<T>::create(fs->get_points(), fs->rank());
+        if (index == NULL) {
+            index = PointIndex<T>::create(fs->get_points(), fs->spatial_rank());
+        }
 
-        PointIndex<T> *convective_radius_index = PointIndex<T>::create(fs->get_points(), fs->rank());
+        // Prepared searches for the background and the convective
+        // 'radius'. The latter is a multiple of the former, which
+        // allows both to search the same index.
 
-        // params for index search
+        vector<T> bandwidth = fs->spatial_component(this->m_bandwidth);
 
-        RangeSearchParams<T> params(this->m_bandwidth);
+        PreparedRangeSearch<T> *search = index->prepare_range_search(bandwidth);
 
-        // convective 'radius'
+        PreparedRangeSearch<T> *convective_radius_search
+                = index->prepare_range_search(m_convective_radius_factor * bandwidth);
 
-        RangeSearchParams<T> convective_radius_params(m_convective_radius_factor *m_bandwidth);
+        typename Point<T>::list sample;
 
         // Create a field to hold the convection mask
 
@@ -98,9 +120,7 @@ namespace m3D {
 
             Point<T> *p = fs->points.at(k);
 
-            typename Point<T>::list *sample = NULL;
-
-            sample = index->search(p->coordinate, &params, NULL);
+            search->search(p->coordinate, sample);
 
             // Check if the convective threshold is met
 
@@ -115,8 +135,8 @@ namespace m3D {
 
                 T z_background = 0.0;
 
-                for (size_t i = 0; i < sample->size(); i++) {
-                    Point<T> *p = sample->at(i);
+                for (size_t i = 0; i < sample.size(); i++) {
+                    Point<T> *p = sample[i];
 
                     T z = p->values.at(m_index_of_z);
 
@@ -125,7 +145,7 @@ namespace m3D {
 
                 // linear average
 
-                z_background = z_background / boost::numeric_cast<T>(sample->size());
+                z_background = z_background / boost::numeric_cast<T>(sample.size());
 
                 // Now figure if this point classifies as 'convective' according to
                 // the scheme
@@ -144,29 +164,27 @@ namespace m3D {
                 }
             }
 
-            delete sample;
-
             if (is_convective) {
                 // Mark all points within convective radius
 
-                typename Point<T>::list *sample = NULL;
-
-                sample = convective_radius_index->search(p->coordinate, &convective_radius_params, NULL);
+                convective_radius_search->search(p->coordinate, sample);
 
-                for (size_t i = 0; i < sample->size(); i++) {
-                    Point<T> *sp = sample->at(i);
+                for (size_t i = 0; i < sample.size(); i++) {
+                    Point<T> *sp = sample[i];
 
                     convective_mask.set(sp->gridpoint, true);
                 }
-
-                delete sample;
             }
         }
 
         // Don't need the index anymore
 
-        delete index;
-        delete convective_radius_index;
+        delete search;
+        delete convective_radius_search;
+
+        if (index != this->spatial_index()) {
+            delete index;
+        }
 
         // Now iterate over the feature-space again and set
         // reflectivity to zero for all non-convective points
@@ -196,7 +214,12 @@ namespace m3D {
             // replace feature-space points with those accepted
             // only and delete the rest
 
-            fs->points = accepted;
+            if (this->spatial_index() != NULL) {
+                // removes them from fs->points, too
+                this->spatial_index()->remove_points(erased);
+            } else {
+                fs->points = accepted;
+            }
 
             for (size_t i = 0; i < erased.size(); i++) {
                 Point<T> *p = erased[i];
@@ -209,6 +232,231 @@ namespace m3D {
             cout << "done. (" << stop_timer() << "s)" << std::endl;
         }
     }
+
+#pragma mark -
+#pragma mark Grid stencil version
+
+    template<typename T>
+    void
+    ConvectionFilter<T>::apply_on_grid(FeatureSpace <T> *fs) {
+        using namespace std;
+        using namespace m3D::utils::vectors;
+
+        if (this->show_progress()) {
+            cout << endl << "Applying convection filter ...";
+            start_timer();
+        }
+
+        typename Point<T>::list &points = fs->points;
+        const size_t num_points = points.size();
+
+        if (num_points == 0) {
+            if (this->show_progress()) {
+                cout << "done. (" << stop_timer() << "s)" << std::endl;
+            }
+            return;
+        }
+
+        // Work on the bounding box of the points, seen as
+        // a set of lines along the last dimension
+
+        GridLines<T> grid(points, fs->spatial_rank());
+
+        // Prefix sums of reflectivity and point counts along each line.
+        // Entry i of a line holds the sum over positions 0..i-1.
+
+        const size_t prefix_length = grid.line_length() + 1;
+        vector<double> z_sum(grid.num_lines() * prefix_length, 0.0);
+        vector<int> count_sum(grid.num_lines() * prefix_length, 0);
+
+#if WITH_OPENMP
+#pragma omp parallel for
+#endif
+        for (size_t k = 0; k < num_points; k++) {
+            size_t i = grid.line(k) * prefix_length + grid.position(k) + 1;
+            z_sum[i] = points[k]->values.at(m_index_of_z);
+            count_sum[i] = 1;
+        }
+
+#if WITH_OPENMP
+#pragma omp parallel for
+#endif
+        for (size_t line = 0; line < grid.num_lines(); line++) {
+            double *z = &z_sum[line * prefix_length];
+            int *c = &count_sum[line * prefix_length];
+            for (size_t i = 1; i < prefix_length; i++) {
+                z[i] += z[i - 1];
+                c[i] += c[i - 1];
+            }
+        }
+
+        // Stencils for the background and the convective radius. They
+        // are measured in multiples of the resolution, which equals
+        // the distances between the point coordinates on an evenly
+        // spaced grid only (see apply)
+
+        const vector<T> &resolution = fs->coordinate_system->resolution();
+        vector<T> bandwidth = fs->spatial_component(this->m_bandwidth);
+        GridStencil<T> background(resolution, bandwidth);
+        GridStencil<T> convective_radius(resolution, m_convective_radius_factor * bandwidth);
+
+        // Decide for each point if it is convective
+
+        vector<unsigned char> is_convective(num_points, 0);
+
+#if WITH_OPENMP
+#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+        for (size_t k = 0; k < num_points; k++) {
+            T z_p = points[k]->values.at(m_index_of_z);
+
+            if (z_p >= m_convective_threshold) {
+                is_convective[k] = 1;
+                continue;
+            }
+
+            // Obtain the background reflectivity for this point
+
+            double sum = 0.0;
+            int count = 0;
+
+            for (size_t r = 0; r < background.size(); r++) {
+                size_t line;
+                int first, last;
+                if (grid.row_span(k, background.rows()[r], line, first, last)) {
+                    size_t begin = line * prefix_length + first;
+                    size_t end = line * prefix_length + last + 1;
+                    sum += z_sum[end] - z_sum[begin];
+                    count += count_sum[end] - count_sum[begin];
+                }
+            }
+
+            // linear average
+
+            T z_background = (T) (sum / count);
+
+            // Now figure if this point classifies as 'convective' according to
+            // the scheme
+
+            T deltaZ = 10.0;
+
+            if (z_background >= 0 && z_background <= m_convective_threshold) {
+                deltaZ = 10.0 - (z_background * z_background) / 180.0;
+            }
+
+            if (deltaZ > m_critical_delta_z) {
+                is_convective[k] = 1;
+            }
+        }
+
+        // Mark all points within the convective radius of a convective
+        // point. The stencil is symmetric, so a point is marked if a
+        // convective point lies within its own convective radius.
+        // Count the convective points along the lines first.
+
+        std::fill(count_sum.begin(), count_sum.end(), 0);
+
+#if WITH_OPENMP
+#pragma omp parallel for
+#endif
+        for (size_t k = 0; k < num_points; k++) {
+            if (is_convective[k]) {
+                count_sum[grid.line(k) * prefix_length + grid.position(k) + 1] = 1;
+            }
+        }
+
+#if WITH_OPENMP
+#pragma omp parallel for
+#endif
+        for (size_t line = 0; line < grid.num_lines(); line++) {
+            int *c = &count_sum[line * prefix_length];
+            for (size_t i = 1; i < prefix_length; i++) {
+                c[i] += c[i - 1];
+            }
+        }
+
+        vector<unsigned char> convective_mask(num_points, 0);
+
+#if WITH_OPENMP
+#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+        for (size_t k = 0; k < num_points; k++) {
+            for (size_t r = 0; r < convective_radius.size() && !convective_mask[k]; r++) {
+                size_t line;
+                int first, last;
+                if (grid.row_span(k, convective_radius.rows()[r], line, first, last)
+                    && count_sum[line * prefix_length + last + 1] > count_sum[line * prefix_length + first]) {
+                    convective_mask[k] = 1;
+                }
+            }
+        }
+
+        if (!m_erase_non_convective) {
+#if WITH_OPENMP
+#pragma omp parallel for
+#endif
+            for (size_t k = 0; k < num_points; k++) {
+                points[k]->values.at(m_index_of_z) = 0.0;
+            }
+        } else {
+            // Compact the point list. As in FeatureSpace::build(), the
+            // list is cut into chunks, which are compacted in parallel
+            // and then concatenated in their original order.
+
+#if WITH_OPENMP
+            size_t num_chunks = 4 * omp_get_max_threads();
+#else
+            size_t num_chunks = 1;
+#endif
+            num_chunks = std::max((size_t) 1, std::min(num_chunks, num_points));
+            const size_t chunk_size = (num_points + num_chunks - 1) / num_chunks;
+
+            vector<typename Point<T>::list> chunk_accepted(num_chunks);
+            vector<typename Point<T>::list> chunk_erased(num_chunks);
+
+#if WITH_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+            for (size_t chunk = 0; chunk < num_chunks; chunk++) {
+                const size_t chunk_end = std::min((chunk + 1) * chunk_size, num_points);
+                for (size_t k = chunk * chunk_size; k < chunk_end; k++) {
+                    if (convective_mask[k]) {
+                        chunk_accepted[chunk].push_back(points[k]);
+                    } else {
+                        chunk_erased[chunk].push_back(points[k]);
+                    }
+                }
+            }
+
+            vector<Point<T> *> erased;
+            for (size_t chunk = 0; chunk < num_chunks; chunk++) {
+                erased.insert(erased.end(), chunk_erased[chunk].begin(), chunk_erased[chunk].end());
+            }
+
+            if (this->spatial_index() != NULL) {
+                // removes them from fs->points, too
+                this->spatial_index()->remove_points(erased);
+            } else {
+                vector<Point<T> *> accepted;
+                accepted.reserve(num_points - erased.size());
+                for (size_t chunk = 0; chunk < num_chunks; chunk++) {
+                    accepted.insert(accepted.end(), chunk_accepted[chunk].begin(), chunk_accepted[chunk].end());
+                }
+                fs->points.swap(accepted);
+            }
+
+#if WITH_OPENMP
+#pragma omp parallel for
+#endif
+            for (size_t i = 0; i < erased.size(); i++) {
+                delete erased[i];
+            }
+        }
+
+        if (this->show_progress()) {
+            cout << "done. (" << stop_timer() << "s)" << std::endl;
+        }
+    }
 }
 
 #endif
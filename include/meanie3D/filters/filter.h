@@ -29,6 +29,9 @@
 
 namespace m3D {
 
+    template<typename T>
+    class PointIndex;
+
     /** Abstract base class for feature-space filters.
      */
     template<class T>
@@ -38,6 +41,8 @@ namespace m3D {
 
         bool m_show_progress;
 
+        PointIndex<T> *m_spatial_index;
+
     public:
 
 #pragma mark -
@@ -45,7 +50,7 @@ namespace m3D {
 
         /** Default constructor
          */
-        FeatureSpaceFilter(bool show_progress) : m_show_progress(show_progress) {
+        FeatureSpaceFilter(bool show_progress) : m_show_progress(show_progress), m_spatial_index(NULL) {
         };
 
         /** Destructor 
@@ -60,6 +65,23 @@ namespace m3D {
             return m_show_progress;
         };
 
+        /** @return spatial index on the feature-space's points
+         * shared with other filters, or NULL if there is none.
+         */
+        PointIndex<T> *spatial_index() {
+            return m_spatial_index;
+        };
+
+        /** Filters that need a spatial index on the feature-space's
+         * points use the given one instead of building their own.
+         * Filters removing points do so through the index, which
+         * keeps it up to date. The filter does not take ownership.
+         * @param index over the spatial components of fs->points
+         */
+        void set_spatial_index(PointIndex<T> *index) {
+            m_spatial_index = index;
+        };
+
 #pragma mark -
 #pragma mark Abstract filter method
 
@@ -0,0 +1,212 @@
+/* The MIT License (MIT)
+ * 
+ * (c) Jürgen Simon 2014 (juergen.simon@uni-bonn.de)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef M3D_GRIDSTENCIL_H
+#define M3D_GRIDSTENCIL_H
+
+#include <meanie3D/defines.h>
+#include <meanie3D/namespaces.h>
+
+#include <vector>
+
+namespace m3D {
+
+    /** Covers all grid offsets within the ellipsoid given by the
+     * radii (x1^2/a1^2 + ... + xn^2/an^2 <= 1), which is the shape
+     * of a range search on a point index. The stencil is stored as
+     * rows along the last dimension. Together with prefix sums along
+     * the lines of a GridLines layout, sums over the ellipsoid cost
+     * one difference per row instead of one addition per grid point.
+     */
+    template<typename T>
+    class GridStencil
+    {
+    public:
+
+        /** One row of the stencil: the offset in all but the last
+         * dimension, and the half width of the row in the last
+         * dimension.
+         */
+        typedef struct
+        {
+            vector<int> offset;
+            int half_width;
+        } row_t;
+
+    private:
+
+        vector<row_t> m_rows;
+
+    public:
+
+#pragma mark -
+#pragma mark Constructor/Destructor
+
+        /** Constructor
+         * @param grid resolution
+         * @param radii (spatial, same units as the resolution)
+         */
+        GridStencil(const vector<T> &resolution, const vector<T> &radii);
+
+#pragma mark -
+#pragma mark Accessors
+
+        /** @return rows of the stencil
+         */
+        const vector<row_t> &rows() const {
+            return m_rows;
+        };
+
+        /** @return number of rows
+         */
+        size_t size() const {
+            return m_rows.size();
+        };
+
+#pragma mark -
+#pragma mark Grid check
+
+        /** Stencils place the grid points at multiples of the resolution,
+         * while a range search on a point index uses the coordinates of
+         * the points. Both select the same neighbours only if the grid
+         * points are evenly spaced at the resolution.
+         * @param coordinate system
+         * @return <code>true</code> if the coordinates in each dimension
+         *         are spaced at the resolution (up to rounding)
+         */
+        static bool
+        matches_grid(const CoordinateSystem<T> *cs);
+    };
+
+    /** Lays out the bounding box of a list of points as lines along
+     * the last dimension and keeps the position of each point in it.
+     * Cells are numbered line * line_length() + position.
+     */
+    template<typename T>
+    class GridLines
+    {
+    private:
+
+        vector<int> m_origin;
+        vector<int> m_size;
+        vector<size_t> m_line_stride;
+        size_t m_num_lines;
+        vector<size_t> m_point_line;
+        vector<int> m_point_position;
+
+    public:
+
+#pragma mark -
+#pragma mark Constructor/Destructor
+
+        /** Constructor. The positions of the points are calculated
+         * in parallel.
+         * @param points (must not be empty)
+         * @param spatial rank
+         */
+        GridLines(const typename Point<T>::list &points, size_t rank);
+
+#pragma mark -
+#pragma mark Accessors
+
+        /** @return number of lines in the bounding box
+         */
+        size_t num_lines() const {
+            return m_num_lines;
+        };
+
+        /** @return length of each line
+         */
+        size_t line_length() const {
+            return m_size.back();
+        };
+
+        /** @return number of cells in the bounding box
+         */
+        size_t num_cells() const {
+            return m_num_lines * line_length();
+        };
+
+        /** @param index of the point
+         * @return line the point lies on
+         */
+        size_t line(size_t k) const {
+            return m_point_line[k];
+        };
+
+        /** @param index of the point
+         * @return position of the point on its line
+         */
+        int position(size_t k) const {
+            return m_point_position[k];
+        };
+
+        /** @param index of the point
+         * @return cell of the point
+         */
+        size_t cell(size_t k) const {
+            return m_point_line[k] * line_length() + m_point_position[k];
+        };
+
+#pragma mark -
+#pragma mark Stencils
+
+        /** Finds the part of a stencil row that lies within the
+         * bounding box, with the stencil centered on the given cell.
+         * @param line of the center
+         * @param position of the center on its line
+         * @param stencil row
+         * @param line the row falls on (out)
+         * @param first position on that line (out)
+         * @param last position on that line (out)
+         * @return false if the row lies outside of the bounding box
+         */
+        bool
+        row_span(size_t line,
+                 int position,
+                 const typename GridStencil<T>::row_t &row,
+                 size_t &row_line,
+                 int &first,
+                 int &last) const;
+
+        /** Same as above, with the stencil centered on a point.
+         * @param index of the point
+         * @param stencil row
+         * @param line the row falls on (out)
+         * @param first position on that line (out)
+         * @param last position on that line (out)
+         * @return false if the row lies outside of the bounding box
+         */
+        bool
+        row_span(size_t k,
+                 const typename GridStencil<T>::row_t &row,
+                 size_t &row_line,
+                 int &first,
+                 int &last) const {
+            return row_span(m_point_line[k], m_point_position[k], row, row_line, first, last);
+        };
+    };
+}
+
+#endif
@@ -0,0 +1,195 @@
+/* The MIT License (MIT)
+ * 
+ * (c) Jürgen Simon 2014 (juergen.simon@uni-bonn.de)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef M3D_GRIDSTENCIL_IMPL_H
+#define M3D_GRIDSTENCIL_IMPL_H
+
+#include <meanie3D/defines.h>
+#include <meanie3D/namespaces.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "grid_stencil.h"
+
+namespace m3D {
+
+#pragma mark -
+#pragma mark GridStencil
+
+    template<typename T>
+    GridStencil<T>::GridStencil(const vector<T> &resolution, const vector<T> &radii) {
+        const size_t rank = radii.size();
+        const size_t last = rank - 1;
+
+        // maximum offsets in each dimension
+        vector<int> reach(rank);
+        for (size_t d = 0; d < rank; d++) {
+            reach[d] = (int) floor(radii[d] / resolution[d]);
+        }
+
+        // Enumerate all offsets in the leading dimensions and find the
+        // widest extent in the last dimension that stays inside
+        vector<int> offset(last);
+        for (size_t d = 0; d < last; d++) {
+            offset[d] = -reach[d];
+        }
+
+        bool done = false;
+        while (!done) {
+            T r = 0.0;
+            for (size_t d = 0; d < last; d++) {
+                T x = offset[d] * resolution[d] / radii[d];
+                r += x * x;
+            }
+
+            if (r <= 1.0) {
+                int w = (int) floor(sqrt(1.0 - r) * radii[last] / resolution[last]);
+                // guard against rounding either way
+                while (true) {
+                    T x = (w + 1) * resolution[last] / radii[last];
+                    if (r + x * x > 1.0) break;
+                    w++;
+                }
+                while (w > 0) {
+                    T x = w * resolution[last] / radii[last];
+                    if (r + x * x <= 1.0) break;
+                    w--;
+                }
+
+                row_t row;
+                row.offset = offset;
+                row.half_width = w;
+                m_rows.push_back(row);
+            }
+
+            // next offset, last leading dimension running fastest
+            done = true;
+            for (int d = ((int) last) - 1; d >= 0; d--) {
+                if (offset[d] < reach[d]) {
+                    offset[d]++;
+                    done = false;
+                    break;
+                }
+                offset[d] = -reach[d];
+            }
+        }
+    }
+
+    template<typename T>
+    bool
+    GridStencil<T>::matches_grid(const CoordinateSystem<T> *cs) {
+        const vector<size_t> dims = cs->get_dimension_sizes();
+        const vector<T> &resolution = cs->resolution();
+
+        for (size_t d = 0; d < cs->rank(); d++) {
+            const T *data = cs->get_dimension_data_ptr((int) d);
+            const T tolerance = 1.0e-3 * fabs(resolution[d]);
+            for (size_t i = 1; i < dims[d]; i++) {
+                if (fabs((data[i] - data[i - 1]) - resolution[d]) > tolerance) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+#pragma mark -
+#pragma mark GridLines
+
+    template<typename T>
+    GridLines<T>::GridLines(const typename Point<T>::list &points, size_t rank)
+            : m_origin(rank, std::numeric_limits<int>::max()),
+              m_size(rank, 0),
+              m_line_stride(rank, 1),
+              m_num_lines(1),
+              m_point_line(points.size()),
+              m_point_position(points.size()) {
+        const size_t num_points = points.size();
+        const size_t last = rank - 1;
+
+        // bounding box
+        vector<int> upper(rank, std::numeric_limits<int>::min());
+        for (size_t k = 0; k < num_points; k++) {
+            const ColumnView<int> &gp = points[k]->gridpoint;
+            for (size_t d = 0; d < rank; d++) {
+                m_origin[d] = std::min(m_origin[d], gp[d]);
+                upper[d] = std::max(upper[d], gp[d]);
+            }
+        }
+
+        for (size_t d = 0; d < rank; d++) {
+            m_size[d] = upper[d] - m_origin[d] + 1;
+        }
+
+        for (int d = ((int) last) - 1; d >= 0; d--) {
+            m_line_stride[d] = m_num_lines;
+            m_num_lines *= m_size[d];
+        }
+
+        // position of each point
+
+#if WITH_OPENMP
+#pragma omp parallel for
+#endif
+        for (size_t k = 0; k < num_points; k++) {
+            const ColumnView<int> &gp = points[k]->gridpoint;
+            size_t line = 0;
+            for (size_t d = 0; d < last; d++) {
+                line += (gp[d] - m_origin[d]) * m_line_stride[d];
+            }
+            m_point_line[k] = line;
+            m_point_position[k] = gp[last] - m_origin[last];
+        }
+    }
+
+    template<typename T>
+    bool
+    GridLines<T>::row_span(size_t line,
+                           int position,
+                           const typename GridStencil<T>::row_t &row,
+                           size_t &row_line,
+                           int &first,
+                           int &last) const {
+        const size_t leading = m_size.size() - 1;
+
+        row_line = 0;
+        for (size_t d = 0; d < leading; d++) {
+            int g = (int) ((line / m_line_stride[d]) % m_size[d]) + row.offset[d];
+            if (g < 0 || g >= m_size[d]) {
+                return false;
+            }
+            row_line += g * m_line_stride[d];
+        }
+
+        first = std::max(position - row.half_width, 0);
+        last = std::min(position + row.half_width, m_size[leading] - 1);
+
+        return true;
+    }
+}
+
+#endif
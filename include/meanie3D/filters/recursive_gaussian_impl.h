@@ -0,0 +1,190 @@
+/* The MIT License (MIT)
+ * 
+ * (c) Jürgen Simon 2014 (juergen.simon@uni-bonn.de)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef M3D_RECURSIVEGAUSSIAN_IMPL_H
+#define M3D_RECURSIVEGAUSSIAN_IMPL_H
+
+#include <meanie3D/defines.h>
+#include <meanie3D/namespaces.h>
+
+#include <cmath>
+#include <complex>
+
+#include "recursive_gaussian.h"
+
+namespace m3D {
+
+    using namespace std;
+
+#pragma mark -
+#pragma mark Constructor/Destructor
+
+    template<typename T>
+    RecursiveGaussian<T>::RecursiveGaussian(T sigma, T gain)
+            : m_sigma(sigma) {
+        for (size_t k = 0; k < 4; k++) {
+            m_causal[k] = m_anticausal[k] = m_feedback[k] = 0.0;
+        }
+
+        if (!is_valid()) {
+            return;
+        }
+
+        // Deriche's fit of the causal half of a Gaussian with
+        // sigma = 1 by two damped cosine/sine pairs:
+        //
+        //   h(x) = (a0 cos(w0 x) + a1 sin(w0 x)) exp(-b0 x)
+        //        + (c0 cos(w1 x) + c1 sin(w1 x)) exp(-b1 x)
+        //
+        // Written as a sum of four complex exponentials, each term
+        // is a first order recursion with the pole z_i.
+
+        const double a0 = 1.680, a1 = 3.735, b0 = 1.783, w0 = 0.6318;
+        const double c0 = -0.6803, c1 = -0.2598, b1 = 1.723, w1 = 1.997;
+
+        typedef std::complex<double> complex_t;
+
+        complex_t alpha[4] = {
+                complex_t(a0, -a1) / 2.0, complex_t(a0, a1) / 2.0,
+                complex_t(c0, -c1) / 2.0, complex_t(c0, c1) / 2.0
+        };
+
+        complex_t pole[4] = {
+                std::exp(complex_t(-b0, w0) / (double) sigma),
+                std::exp(complex_t(-b0, -w0) / (double) sigma),
+                std::exp(complex_t(-b1, w1) / (double) sigma),
+                std::exp(complex_t(-b1, -w1) / (double) sigma)
+        };
+
+        // Denominator: product of (1 - z_i q^-1)
+
+        complex_t denominator[5] = {1.0, 0.0, 0.0, 0.0, 0.0};
+        for (size_t i = 0; i < 4; i++) {
+            for (size_t k = i + 1; k > 0; k--) {
+                denominator[k] -= pole[i] * denominator[k - 1];
+            }
+        }
+
+        // Numerator: sum over alpha_i times the product
+        // of (1 - z_j q^-1) for all j != i
+
+        complex_t numerator[4] = {0.0, 0.0, 0.0, 0.0};
+        for (size_t i = 0; i < 4; i++) {
+            complex_t product[4] = {1.0, 0.0, 0.0, 0.0};
+            size_t order = 0;
+            for (size_t j = 0; j < 4; j++) {
+                if (j == i) continue;
+                order++;
+                for (size_t k = order; k > 0; k--) {
+                    product[k] -= pole[j] * product[k - 1];
+                }
+            }
+            for (size_t k = 0; k < 4; k++) {
+                numerator[k] += alpha[i] * product[k];
+            }
+        }
+
+        // The anti-causal filter implements h(-x) for x < 0, which
+        // leaves out the centre sample
+
+        double causal[4], anticausal[4], feedback[4];
+        for (size_t k = 0; k < 4; k++) {
+            causal[k] = numerator[k].real();
+            feedback[k] = denominator[k + 1].real();
+        }
+        for (size_t k = 0; k < 3; k++) {
+            anticausal[k] = causal[k + 1] - feedback[k] * causal[0];
+        }
+        anticausal[3] = -feedback[3] * causal[0];
+
+        // Normalize to the requested gain
+
+        double sum = 0.0, feedback_sum = 1.0;
+        for (size_t k = 0; k < 4; k++) {
+            sum += causal[k] + anticausal[k];
+            feedback_sum += feedback[k];
+        }
+        double factor = gain * feedback_sum / sum;
+
+        for (size_t k = 0; k < 4; k++) {
+            m_causal[k] = (T) (factor * causal[k]);
+            m_anticausal[k] = (T) (factor * anticausal[k]);
+            m_feedback[k] = (T) feedback[k];
+        }
+    }
+
+#pragma mark -
+#pragma mark Filtering
+
+    template<typename T>
+    void
+    RecursiveGaussian<T>::apply(const T *in, T *out, T *scratch, size_t n, size_t stride, size_t len) const {
+        // Causal pass, straight into the output:
+        // y+[k] = sum_i n_i x[k-i] - sum_i d_i y+[k-i]
+
+        for (size_t k = 0; k < n; k++) {
+            T *y = &out[k * stride];
+            const T *x = &in[k * stride];
+            for (size_t j = 0; j < len; j++) {
+                y[j] = m_causal[0] * x[j];
+            }
+            for (size_t i = 1; i <= 3 && i <= k; i++) {
+                const T *xi = &in[(k - i) * stride];
+                for (size_t j = 0; j < len; j++) {
+                    y[j] += m_causal[i] * xi[j];
+                }
+            }
+            for (size_t i = 1; i <= 4 && i <= k; i++) {
+                const T *yi = &out[(k - i) * stride];
+                for (size_t j = 0; j < len; j++) {
+                    y[j] -= m_feedback[i - 1] * yi[j];
+                }
+            }
+        }
+
+        // Anti-causal pass into the scratch buffer, then added up:
+        // y-[k] = sum_i m_i x[k+i] - sum_i d_i y-[k+i]
+
+        for (size_t kk = n; kk > 0; kk--) {
+            const size_t k = kk - 1;
+            T *y = &scratch[k * len];
+            for (size_t j = 0; j < len; j++) {
+                y[j] = 0.0;
+            }
+            for (size_t i = 1; i <= 4 && k + i < n; i++) {
+                const T *xi = &in[(k + i) * stride];
+                const T *yi = &scratch[(k + i) * len];
+                for (size_t j = 0; j < len; j++) {
+                    y[j] += m_anticausal[i - 1] * xi[j] - m_feedback[i - 1] * yi[j];
+                }
+            }
+            T *o = &out[k * stride];
+            for (size_t j = 0; j < len; j++) {
+                o[j] += y[j];
+            }
+        }
+    }
+}
+
+#endif
@@ -30,6 +30,7 @@
 #include <vector>
 
 #include "filter.h"
+#include "grid_stencil.h"
 
 namespace m3D {
 
@@ -71,6 +72,47 @@ namespace m3D {
         float m_percentage;
         std::vector<T> m_bandwidth;
 
+        /** @return the percentage, or 1.0 (all neighbours) if it
+         * is not within (0,1]
+         */
+        float
+        effective_percentage() const {
+            return (m_percentage > 0.0 && m_percentage <= 1.0) ? m_percentage : 1.0f;
+        };
+
+        /** Averages over all neighbours (lowest or highest 100%)
+         * from prefix sums along the grid lines, summed over the
+         * rows of the stencil.
+         * @param grid layout of the points
+         * @param neighbourhood stencil
+         * @param index of the variable in the points' values
+         * @param filtered values (out)
+         */
+        void
+        average_on_grid(FeatureSpace<T> *fs,
+                        const GridLines<T> &grid,
+                        const GridStencil<T> &stencil,
+                        size_t value_index,
+                        vector<T> &filtered);
+
+        /** Median and partial averages from a histogram over the
+         * ranks of the values, which slides along each grid line.
+         * Moving the stencil by one position only adds and removes
+         * the cells at the ends of its rows, and the histogram is
+         * read through a second level of bins with sqrt(#values)
+         * ranks each.
+         * @param grid layout of the points
+         * @param neighbourhood stencil
+         * @param index of the variable in the points' values
+         * @param filtered values (out)
+         */
+        void
+        order_statistics_on_grid(FeatureSpace<T> *fs,
+                                 const GridLines<T> &grid,
+                                 const GridStencil<T> &stencil,
+                                 size_t value_index,
+                                 vector<T> &filtered);
+
     public:
 
         ReplacementFilter(const ReplacementMode mode,
@@ -87,7 +129,31 @@ namespace m3D {
 #pragma mark -
 #pragma mark Abstract filter method
 
+        /** Applies the filter on the grid if REPLACEMENT_FILTER_USES_GRID_STENCIL
+         * is set and the grid points are evenly spaced, and with range
+         * searches otherwise.
+         * @param feature-space
+         */
         virtual void apply(FeatureSpace<T> *fs);
+
+#pragma mark -
+#pragma mark Implementations
+
+        /** Original implementation. Collects and sorts the neighbours
+         * of each point with range searches on the spatial index.
+         * @param feature-space
+         */
+        void
+        apply_with_index(FeatureSpace<T> *fs);
+
+        /** Same result as apply_with_index, but the neighbourhoods are
+         * taken from the grid. Runs fully parallel, see below. As with
+         * the convection filter, the stencil is measured in multiples
+         * of the grid resolution (see GridStencil::matches_grid).
+         * @param feature-space
+         */
+        void
+        apply_on_grid(FeatureSpace<T> *fs);
     };
 }
 
@@ -27,7 +27,11 @@
 #include <meanie3D/utils.h>
 #include <meanie3D/index.h>
 #include "replacement_filter.h"
+#include "grid_stencil.h"
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
 #include <vector>
 
 namespace m3D {
@@ -48,71 +52,95 @@ namespace m3D {
 
     template<typename T>
     void ReplacementFilter<T>::apply(FeatureSpace <T> *fs) {
+#if REPLACEMENT_FILTER_USES_GRID_STENCIL
+        if (GridStencil<T>::matches_grid(fs->coordinate_system)) {
+            this->apply_on_grid(fs);
+        } else {
+            this->apply_with_index(fs);
+        }
+#else
+        this->apply_with_index(fs);
+#endif
+    }
 
-        // Create a spatial index for the copied feature space
-        PointIndex<T> *index = PointIndex<T>::create(fs->get_points(), fs->rank());
-        SearchParameters *params = new RangeSearchParams<T>(m_bandwidth);
+    template<typename T>
+    void ReplacementFilter<T>::apply_with_index(FeatureSpace <T> *fs) {
+
+        // Use the shared spatial index or create one
+        PointIndex<T> *index = this->spatial_index();
+        if (index == NULL) {
+            index = PointIndex<T>::create(fs->get_points(), fs->spatial_rank());
+        }
         size_t value_index = fs->spatial_rank() + m_variable_index;
+        const float percentage = this->effective_percentage();
 
         vector<T> filteredValues;
         filteredValues.resize(fs->size());
 
-        typename Point<T>::list points;
-
 #if WITH_OPENMP
-#pragma omp parallel for schedule(dynamic)
+#pragma omp parallel
 #endif
-        for (size_t i = 0; i < fs->size(); i++) {
-
-            // Get the values around the point (original index)
-            T result = fs->points[i]->values[value_index];
-
-            typename Point<T>::list *neighbours = NULL;
-
+        {
+            // Each thread searches through its own prepared handle,
+            // which allows concurrent searches on the index
+            PreparedRangeSearch<T> *search = NULL;
 #if WITH_OPENMP
 #pragma omp critical
-            {
 #endif
-            neighbours = index->search(fs->points[i]->coordinate, params);
+            search = index->prepare_range_search(fs->spatial_component(m_bandwidth));
+
+            typename Point<T>::list neighbours;
+            vector<T> values;
+
 #if WITH_OPENMP
-            }
+#pragma omp for schedule(dynamic)
 #endif
-            if (!(neighbours == NULL || neighbours->size() == 0)) {
+            for (size_t i = 0; i < fs->size(); i++) {
 
-                vector<T> values;
-                for (size_t n = 0; n < neighbours->size(); n++) {
-                    values.push_back(neighbours->at(n)->values[value_index]);
-                }
+                // Get the values around the point (original index)
+                T result = fs->points[i]->values[value_index];
 
-                switch (m_replacement_mode) {
+                search->search(fs->points[i]->coordinate, neighbours);
 
-                    case ReplaceWithLowest:
-                    case ReplaceWithMedian:
-                        // sort the data in ascending order
-                        std::sort(values.begin(), values.end());
-                        break;
+                if (!neighbours.empty()) {
 
-                    case ReplaceWithHighest:
-                        // sort the data in descending order
-                        std::sort(values.begin(), values.end(), std::greater<int>());
-                        break;
-                }
+                    values.clear();
+                    for (size_t n = 0; n < neighbours.size(); n++) {
+                        values.push_back(neighbours[n]->values[value_index]);
+                    }
+
+                    switch (m_replacement_mode) {
+
+                        case ReplaceWithLowest:
+                        case ReplaceWithMedian:
+                            // sort the data in ascending order
+                            std::sort(values.begin(), values.end());
+                            break;
+
+                        case ReplaceWithHighest:
+                            // sort the data in descending order
+                            std::sort(values.begin(), values.end(), std::greater<T>());
+                            break;
+                    }
 
-                // calculate the number of values that make up
-                // the required percentage
-                int num_values = round(values.size() * m_percentage);
-                if (m_replacement_mode == ReplaceWithMedian) {
-                    result = values[num_values / 2];
-                } else {
-                    // obtain the average of the last num_values values
-                    T sum = 0.0;
-                    for (int i = 0; i < num_values; i++)
-                        sum += values[i];
-                    result = sum / ((T) num_values);
+                    // calculate the number of values that make up
+                    // the required percentage
+                    int num_values = round(values.size() * percentage);
+                    if (m_replacement_mode == ReplaceWithMedian) {
+                        result = values[num_values / 2];
+                    } else {
+                        // obtain the average of the last num_values values
+                        T sum = 0.0;
+                        for (int i = 0; i < num_values; i++)
+                            sum += values[i];
+                        result = sum / ((T) num_values);
+                    }
                 }
+
+                filteredValues[i] = result;
             }
 
-            filteredValues[i] = result;
+            delete search;
         }
 
         // Replace the values in the featurespace's points
@@ -120,8 +148,276 @@ namespace m3D {
             fs->points[i]->values[value_index] = filteredValues[i];
         }
 
-        delete index;
-        delete params;
+        if (index != this->spatial_index()) {
+            delete index;
+        }
+    }
+
+#pragma mark -
+#pragma mark Grid stencil version
+
+    template<typename T>
+    void ReplacementFilter<T>::apply_on_grid(FeatureSpace <T> *fs) {
+        if (fs->points.empty()) {
+            return;
+        }
+
+        size_t value_index = fs->spatial_rank() + m_variable_index;
+
+        GridLines<T> grid(fs->points, fs->spatial_rank());
+        GridStencil<T> stencil(fs->coordinate_system->resolution(), fs->spatial_component(m_bandwidth));
+
+        vector<T> filteredValues(fs->size());
+
+        if (m_replacement_mode != ReplaceWithMedian && this->effective_percentage() == 1.0) {
+            this->average_on_grid(fs, grid, stencil, value_index, filteredValues);
+        } else {
+            this->order_statistics_on_grid(fs, grid, stencil, value_index, filteredValues);
+        }
+
+        // Replace the values in the featurespace's points
+#if WITH_OPENMP
+#pragma omp parallel for
+#endif
+        for (size_t i = 0; i < fs->size(); i++) {
+            fs->points[i]->values[value_index] = filteredValues[i];
+        }
+    }
+
+    template<typename T>
+    void ReplacementFilter<T>::average_on_grid(FeatureSpace <T> *fs,
+                                               const GridLines<T> &grid,
+                                               const GridStencil<T> &stencil,
+                                               size_t value_index,
+                                               vector<T> &filtered) {
+        const typename Point<T>::list &points = fs->points;
+
+        // Prefix sums of the values and point counts along each line.
+        // Entry i of a line holds the sum over positions 0..i-1.
+
+        const size_t prefix_length = grid.line_length() + 1;
+        vector<double> value_sum(grid.num_lines() * prefix_length, 0.0);
+        vector<int> count_sum(grid.num_lines() * prefix_length, 0);
+
+#if WITH_OPENMP
+#pragma omp parallel for
+#endif
+        for (size_t k = 0; k < points.size(); k++) {
+            size_t i = grid.line(k) * prefix_length + grid.position(k) + 1;
+            value_sum[i] = points[k]->values[value_index];
+            count_sum[i] = 1;
+        }
+
+#if WITH_OPENMP
+#pragma omp parallel for
+#endif
+        for (size_t line = 0; line < grid.num_lines(); line++) {
+            double *v = &value_sum[line * prefix_length];
+            int *c = &count_sum[line * prefix_length];
+            for (size_t i = 1; i < prefix_length; i++) {
+                v[i] += v[i - 1];
+                c[i] += c[i - 1];
+            }
+        }
+
+#if WITH_OPENMP
+#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+        for (size_t k = 0; k < points.size(); k++) {
+            double sum = 0.0;
+            int count = 0;
+            for (size_t r = 0; r < stencil.size(); r++) {
+                size_t line;
+                int first, last;
+                if (grid.row_span(k, stencil.rows()[r], line, first, last)) {
+                    size_t begin = line * prefix_length + first;
+                    size_t end = line * prefix_length + last + 1;
+                    sum += value_sum[end] - value_sum[begin];
+                    count += count_sum[end] - count_sum[begin];
+                }
+            }
+            filtered[k] = (T) (sum / count);
+        }
+    }
+
+    template<typename T>
+    void ReplacementFilter<T>::order_statistics_on_grid(FeatureSpace <T> *fs,
+                                                        const GridLines<T> &grid,
+                                                        const GridStencil<T> &stencil,
+                                                        size_t value_index,
+                                                        vector<T> &filtered) {
+        const typename Point<T>::list &points = fs->points;
+        const bool descending = (m_replacement_mode == ReplaceWithHighest);
+
+        // The histogram runs over the distinct values, so the median
+        // is exactly the value the sorted neighbours would give. The
+        // averages are taken from running block sums, which pick up
+        // rounding errors as values enter and leave the window along
+        // a line. Ranks follow the order the neighbours would be sorted
+        // in (descending for ReplaceWithHighest).
+
+        vector<T> table(points.size());
+        for (size_t k = 0; k < points.size(); k++) {
+            table[k] = points[k]->values[value_index];
+        }
+        std::sort(table.begin(), table.end());
+        table.erase(std::unique(table.begin(), table.end()), table.end());
+        if (descending) {
+            std::reverse(table.begin(), table.end());
+        }
+
+        const size_t num_ranks = table.size();
+        const size_t block_size = std::max((size_t) 1, (size_t) ceil(sqrt((double) num_ranks)));
+        const size_t num_blocks = (num_ranks + block_size - 1) / block_size;
+
+        // Rank and point of each cell (-1 if there is no point)
+
+        vector<int> cell_rank(grid.num_cells(), -1);
+        vector<int> cell_point(grid.num_cells(), -1);
+
+#if WITH_OPENMP
+#pragma omp parallel for
+#endif
+        for (size_t k = 0; k < points.size(); k++) {
+            T value = points[k]->values[value_index];
+            typename vector<T>::iterator it = descending
+                                              ? std::lower_bound(table.begin(), table.end(), value,
+                                                                 std::greater<T>())
+                                              : std::lower_bound(table.begin(), table.end(), value);
+            cell_rank[grid.cell(k)] = (int) (it - table.begin());
+            cell_point[grid.cell(k)] = (int) k;
+        }
+
+        // The median is picked from the given percentage of the
+        // lowest values, like the averages
+
+        const float percentage = this->effective_percentage();
+
+        const int line_length = (int) grid.line_length();
+        const vector<typename GridStencil<T>::row_t> &rows = stencil.rows();
+
+#if WITH_OPENMP
+#pragma omp parallel
+#endif
+        {
+            vector<int> bin_count(num_ranks, 0);
+            vector<int> block_count(num_blocks, 0);
+            vector<double> block_sum(num_blocks, 0.0);
+            int total = 0;
+
+            vector<char> row_inside(rows.size());
+            vector<size_t> row_line(rows.size());
+            vector<int> row_first(rows.size());
+            vector<int> row_last(rows.size());
+
+#if WITH_OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+            for (size_t line = 0; line < grid.num_lines(); line++) {
+                const int *line_point = &cell_point[line * line_length];
+                bool active = false;
+
+                for (int x = 0; x < line_length; x++) {
+                    int k = line_point[x];
+                    if (k < 0) continue;
+
+                    // Move the stencil to x, updating the histogram
+                    // only at the ends of each row
+
+                    for (size_t r = 0; r < rows.size(); r++) {
+                        int first, last;
+                        if (!active) {
+                            row_inside[r] = grid.row_span(line, x, rows[r], row_line[r], first, last);
+                            if (!row_inside[r]) continue;
+                        } else {
+                            if (!row_inside[r]) continue;
+                            first = std::max(x - rows[r].half_width, 0);
+                            last = std::min(x + rows[r].half_width, line_length - 1);
+                        }
+
+                        const int *rank = &cell_rank[row_line[r] * line_length];
+
+                        int add_from = first;
+                        if (active) {
+                            int remove_to = std::min(row_last[r], first - 1);
+                            for (int i = row_first[r]; i <= remove_to; i++) {
+                                if (rank[i] < 0) continue;
+                                size_t b = rank[i] / block_size;
+                                bin_count[rank[i]]--;
+                                block_sum[b] -= table[rank[i]];
+                                if (--block_count[b] == 0) block_sum[b] = 0.0;
+                                total--;
+                            }
+                            add_from = std::max(first, row_last[r] + 1);
+                        }
+
+                        for (int i = add_from; i <= last; i++) {
+                            if (rank[i] < 0) continue;
+                            size_t b = rank[i] / block_size;
+                            bin_count[rank[i]]++;
+                            block_count[b]++;
+                            block_sum[b] += table[rank[i]];
+                            total++;
+                        }
+
+                        row_first[r] = first;
+                        row_last[r] = last;
+                    }
+                    active = true;
+
+                    // calculate the number of values that make up
+                    // the required percentage
+                    int num_values = (int) round(total * percentage);
+
+                    if (m_replacement_mode == ReplaceWithMedian) {
+                        // find the value at position num_values/2
+                        int position = num_values / 2;
+                        int seen = 0;
+                        size_t b = 0;
+                        while (seen + block_count[b] <= position) {
+                            seen += block_count[b++];
+                        }
+                        size_t i = b * block_size;
+                        while (seen + bin_count[i] <= position) {
+                            seen += bin_count[i++];
+                        }
+                        filtered[k] = table[i];
+                    } else {
+                        // obtain the average of the first num_values values
+                        double sum = 0.0;
+                        int remaining = num_values;
+                        size_t b = 0;
+                        while (remaining > 0 && block_count[b] <= remaining) {
+                            sum += block_sum[b];
+                            remaining -= block_count[b++];
+                        }
+                        for (size_t i = b * block_size; remaining > 0; i++) {
+                            int used = std::min(bin_count[i], remaining);
+                            sum += used * (double) table[i];
+                            remaining -= used;
+                        }
+                        filtered[k] = (T) (sum / num_values);
+                    }
+                }
+
+                // Empty the histogram for the next line
+
+                if (active) {
+                    for (size_t r = 0; r < rows.size(); r++) {
+                        if (!row_inside[r]) continue;
+                        const int *rank = &cell_rank[row_line[r] * line_length];
+                        for (int i = row_first[r]; i <= row_last[r]; i++) {
+                            if (rank[i] < 0) continue;
+                            size_t b = rank[i] / block_size;
+                            bin_count[rank[i]] = 0;
+                            block_count[b] = 0;
+                            block_sum[b] = 0.0;
+                        }
+                    }
+                    total = 0;
+                }
+            }
+        }
     }
 }
 
@@ -28,6 +28,7 @@
 #include <meanie3D/namespaces.h>
 #include <meanie3D/array/array_index.h>
 #include <meanie3D/filters/filter.h>
+#include <meanie3D/filters/recursive_gaussian.h>
 #include <meanie3D/filters/scalespace_kernel.h>
 
 #include <boost/progress.hpp>
@@ -37,6 +38,22 @@ namespace m3D {
     template<class T>
     class ArrayIndex;
 
+    /** Ways of convolving the data with the Gaussian
+     */
+    typedef enum
+    {
+        /** Convolution with the sampled Gaussian, truncated where it
+         * drops below the decay. Cost grows with the filter width.
+         */
+                ScaleSpaceSampledKernel,
+
+        /** Recursive approximation of the Gaussian. Constant cost
+         * per grid point, independent of the scale.
+         */
+                ScaleSpaceRecursiveGaussian
+
+    } ScaleSpaceMethod;
+
     /** Smoothes the data with a scale-space filter. This filter does NOT create
      * new points. Only the existing points are smoothed out.
      */
@@ -48,6 +65,8 @@ namespace m3D {
         T m_scale; /// Scale
         T m_decay; /// Decay
         vector<ScaleSpaceKernel<T> > m_kernels; /// Scale-Space kernel
+        ScaleSpaceMethod m_method; /// Convolution method
+        vector<RecursiveGaussian<T> > m_recursive_kernels; /// Recursive filters (if used)
 
         map<size_t, T> m_unfiltered_min; /// unfiltered minimum
         map<size_t, T> m_unfiltered_max; /// unfiltered maximum
@@ -75,6 +94,11 @@ namespace m3D {
         void
         applyWithArrayIndex(FeatureSpace<T> *fs);
 
+        /** @return sum of the sampled kernel values over the window
+         * [-width,width) used in the convolution
+         */
+        static T window_sum(const vector<T> &g);
+
 #pragma mark -
 #pragma mark Paralellized versions
 
@@ -84,8 +108,42 @@ namespace m3D {
                                          ArrayIndex<T> *filteredPoints,
                                          size_t fixedDimensionIndex);
 
+#pragma mark -
+#pragma mark Dense array version
+
+        /** State of a grid point in the dense arrays
+         */
+        enum {
+            DensePointPresent = 1,
+            DensePointOriginal = 2
+        };
+
+        /** Convolves the dense arrays along one dimension. The arrays
+         * cover a box of the grid, starting at the given origin. Values
+         * are stored variable by variable, each in the linear order of
+         * the box. Neighbouring grid lines are convolved in blocks, so
+         * that the innermost loops run over contiguous memory.
+         *
+         * @param origin of the box in the grid
+         * @param size of the box
+         * @param size of the grid in the filtered dimension
+         * @param number of variables
+         * @param filtered dimension
+         * @param values before the pass
+         * @param point states before the pass
+         * @param values after the pass
+         * @param point states after the pass
+         */
         void
-        apply_parallellized(FeatureSpace<T> *fs);
+        apply_dense_on_dimension(const vector<int> &origin,
+                                 const vector<size_t> &box,
+                                 size_t dim_size,
+                                 size_t value_rank,
+                                 size_t fixedDimension,
+                                 const vector<T> &values,
+                                 const vector<unsigned char> &state,
+                                 vector<T> &filtered,
+                                 vector<unsigned char> &filtered_state);
 
     public:
 
@@ -97,13 +155,15 @@ namespace m3D {
          * @param resolution vector
          * @param decay in percent of value at 0
          * @param show progress indicator while filtering (default no)
+         * @param convolution method (default sampled kernel)
          * @throws logic_error if scale < 0 or decay < 0 or > 1.
          */
         ScaleSpaceFilter(const T scale,
                          const vector<T> &resolution,
                          const vector<string> &exclude_from_scale_space_filtering,
                          const T decay = 0.01,
-                         const bool show_progress = false);
+                         const bool show_progress = false,
+                         const ScaleSpaceMethod method = ScaleSpaceSampledKernel);
 
         /** Destructor
          */
@@ -119,6 +179,27 @@ namespace m3D {
          */
         virtual void apply(FeatureSpace<T> *fs);
 
+#pragma mark -
+#pragma mark Implementations
+
+        /** Original implementation. Convolves the points dimension by
+         * dimension, collecting the filtered points of each pass in an
+         * array index. Supports ScaleSpaceSampledKernel only.
+         * @param feature-space
+         */
+        void
+        apply_parallellized(FeatureSpace<T> *fs);
+
+        /** Same result as apply_parallellized, but the points are copied
+         * into dense arrays covering their bounding box (widened by the
+         * filter width) and filtered there. The feature-space points are
+         * only created once, after all dimensions have been processed.
+         * This is the only version supporting ScaleSpaceRecursiveGaussian.
+         * @param feature-space
+         */
+        void
+        apply_dense(FeatureSpace<T> *fs);
+
 #pragma mark -
 #pragma mark After the processing 
 
@@ -146,6 +227,21 @@ namespace m3D {
         map<size_t, T>
         getRangeFactors();
 
+        /** The sampled kernels are not normalized. This is the factor
+         * by which the filter multiplies a constant field (away from
+         * the boundaries).
+         * @return gain
+         */
+        T gain();
+
+        /** Multiplies the filtered values in the feature-space and the
+         * filtered value ranges by the given factor.
+         * @param feature-space (filtered)
+         * @param factor
+         */
+        void
+        scale_values(FeatureSpace<T> *fs, T factor);
+
 #pragma mark -
 #pragma mark Utility methods
 
@@ -66,9 +66,10 @@ namespace m3D {
                                           const vector<T> &resolution,
                                           const vector<string> &excluded_vars,
                                           T decay,
-                                          bool show_progress)
-            : FeatureSpaceFilter<T>(show_progress), m_scale(scale), m_decay(decay), m_progress_bar(NULL),
-              m_excluded_vars(excluded_vars) {
+                                          bool show_progress,
+                                          ScaleSpaceMethod method)
+            : FeatureSpaceFilter<T>(show_progress), m_scale(scale), m_decay(decay), m_method(method),
+              m_progress_bar(NULL), m_excluded_vars(excluded_vars) {
         if (scale < 0) {
             throw logic_error("scale can not be less than zero");
         }
@@ -97,6 +98,16 @@ namespace m3D {
             ScaleSpaceKernel<T> kernel(scale, distances);
 
             m_kernels.push_back(kernel);
+
+            if (method == ScaleSpaceRecursiveGaussian) {
+                // Give the recursive filter the same gain as the sampled
+                // kernel's window [-width,width) in apply_parallellized,
+                // so that both methods produce the same value ranges
+
+                T gain = window_sum(kernel.values());
+                RecursiveGaussian<T> recursive(sqrt(scale) / resolution[i], gain);
+                m_recursive_kernels.push_back(recursive);
+            }
         }
     }
 
@@ -564,7 +575,11 @@ namespace m3D {
         }
 
         ArrayIndex<T> *originalIndex = new ArrayIndex<T>(cs->get_dimension_sizes(), fs->points, true);
+
+        // The filtered points are set in a critical section while
+        // other threads read. There is at most one per grid point.
         ArrayIndex<T> *filteredIndex = new ArrayIndex<T>(cs->get_dimension_sizes(), false);
+        filteredIndex->reserve(N);
 
         if (this->show_progress()) {
             cout << "done. (" << stop_timer() << "s)" << endl;
@@ -600,6 +615,7 @@ namespace m3D {
                 originalIndex = filteredIndex;
 
                 filteredIndex = new ArrayIndex<T>(cs->get_dimension_sizes(), false);
+                filteredIndex->reserve(N);
             }
         }
 
@@ -627,6 +643,343 @@ namespace m3D {
         delete filteredIndex;
     }
 
+#pragma mark -
+#pragma mark Dense array version
+
+    template<typename T>
+    void
+    ScaleSpaceFilter<T>::apply_dense_on_dimension(const vector<int> &origin,
+                                                  const vector<size_t> &box,
+                                                  size_t dim_size,
+                                                  size_t value_rank,
+                                                  size_t fixedDimension,
+                                                  const vector<T> &values,
+                                                  const vector<unsigned char> &state,
+                                                  vector<T> &filtered,
+                                                  vector<unsigned char> &filtered_state) {
+        const size_t size = state.size();
+
+        // The box is stored in row-major order. Seen from the filtered
+        // dimension, it consists of 'outer' slabs of n lines, and each
+        // line position holds 'inner' contiguous values. Blocks of those
+        // contiguous values are convolved together.
+
+        const size_t n = box[fixedDimension];
+        size_t inner = 1;
+        for (size_t i = fixedDimension + 1; i < box.size(); i++) {
+            inner *= box[i];
+        }
+        const size_t outer = size / (n * inner);
+        const size_t block_size = SCALE_SPACE_BLOCK_SIZE;
+        const size_t num_blocks = (inner + block_size - 1) / block_size;
+        const size_t num_jobs = outer * num_blocks;
+
+        const vector<T> &g = this->m_kernels[fixedDimension].values();
+        const int width = (int) g.size() - 1;
+        const int first = origin[fixedDimension];
+        const int last = (int) dim_size - 1;
+
+        // Scales too small for the recursive filter are
+        // convolved with the sampled kernel instead
+
+        const bool recursive = (m_method == ScaleSpaceRecursiveGaussian)
+                               && m_recursive_kernels[fixedDimension].is_valid();
+
+#if WITH_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (size_t job = 0; job < num_jobs; job++) {
+            const size_t block_begin = (job % num_blocks) * block_size;
+            const size_t len = std::min(block_size, inner - block_begin);
+            const size_t base = (job / num_blocks) * n * inner + block_begin;
+
+            // The window of the sampled kernel also decides which
+            // points exist after the pass with the recursive filter,
+            // so that both methods produce the same points
+
+            for (size_t k = 0; k < n; k++) {
+                // Same window as in apply_parallellized_on_dimension (the
+                // upper bound is exclusive), clipped to the box. There are
+                // no points outside of the box.
+
+                const int gpIndex = first + (int) k;
+                int minIndex = std::max(gpIndex - width, 0) - first;
+                int maxIndex = std::min(gpIndex + width, last) - first;
+                minIndex = std::max(minIndex, 0);
+                maxIndex = std::min(maxIndex, (int) n);
+
+                const size_t out = base + k * inner;
+
+                // A point exists after the pass if any point was
+                // found in the window. It remains an original point
+                // if it was one before.
+
+                unsigned char *out_state = &filtered_state[out];
+                const unsigned char *own_state = &state[out];
+
+                for (size_t j = 0; j < len; j++) {
+                    out_state[j] = 0;
+                }
+
+                for (int i = minIndex; i < maxIndex; i++) {
+                    const unsigned char *in_state = &state[base + i * inner];
+                    for (size_t j = 0; j < len; j++) {
+                        out_state[j] |= in_state[j];
+                    }
+                }
+
+                for (size_t j = 0; j < len; j++) {
+                    out_state[j] = (out_state[j] == 0) ? 0
+                                                       : (DensePointPresent | (own_state[j] & DensePointOriginal));
+                }
+
+                if (recursive) continue;
+
+                // Absent points are zero in the arrays, so they
+                // don't contribute to the sums
+
+                for (size_t varIndex = 0; varIndex < value_rank; varIndex++) {
+                    T *out_values = &filtered[varIndex * size + out];
+
+                    for (size_t j = 0; j < len; j++) {
+                        out_values[j] = 0.0;
+                    }
+
+                    for (int i = minIndex; i < maxIndex; i++) {
+                        const T weight = g[(i <= (int) k) ? (k - i) : (i - k)];
+                        const T *in_values = &values[varIndex * size + base + i * inner];
+                        for (size_t j = 0; j < len; j++) {
+                            out_values[j] += weight * in_values[j];
+                        }
+                    }
+                }
+            }
+
+            if (recursive) {
+                const RecursiveGaussian<T> &rg = m_recursive_kernels[fixedDimension];
+                vector<T> scratch(n * len);
+
+                for (size_t varIndex = 0; varIndex < value_rank; varIndex++) {
+                    const size_t offset = varIndex * size + base;
+                    rg.apply(&values[offset], &filtered[offset], &scratch[0], n, inner, len);
+
+                    // The recursive filter has infinite support. Points
+                    // that don't exist must remain zero.
+
+                    for (size_t k = 0; k < n; k++) {
+                        const unsigned char *out_state = &filtered_state[base + k * inner];
+                        T *out_values = &filtered[offset + k * inner];
+                        for (size_t j = 0; j < len; j++) {
+                            if (out_state[j] == 0) out_values[j] = 0.0;
+                        }
+                    }
+                }
+            }
+
+            if (this->show_progress()) {
+#if WITH_OPENMP
+#pragma omp critical
+#endif
+                m_progress_bar->operator+=(n * len);
+            }
+        }
+    }
+
+    template<typename T>
+    void
+    ScaleSpaceFilter<T>::apply_dense(FeatureSpace<T> *fs) {
+        using namespace std;
+
+        const CoordinateSystem<T> *cs = fs->coordinate_system;
+        const vector<size_t> &dim_sizes = cs->get_dimension_sizes();
+        const size_t spatial_rank = cs->rank();
+        const size_t value_rank = fs->value_rank();
+
+        // initialize min/max and re-set counts
+        for (size_t varIndex = 0; varIndex < value_rank; varIndex++) {
+            m_min[varIndex] = std::numeric_limits<T>::max();
+            m_max[varIndex] = std::numeric_limits<T>::min();
+        }
+
+        if (fs->points.empty()) {
+            return;
+        }
+
+        if (this->show_progress()) {
+            cout << endl << "Constructing dense arrays ...";
+            start_timer();
+        }
+
+        // Find the bounding box of the points and widen it by the
+        // filter width. Each pass can only spread the points that
+        // far in the filtered dimension.
+
+        vector<int> origin(spatial_rank, std::numeric_limits<int>::max());
+        vector<int> upper(spatial_rank, 0);
+
+        for (size_t pi = 0; pi < fs->points.size(); pi++) {
+            const ColumnView<int> &gp = fs->points[pi]->gridpoint;
+            for (size_t d = 0; d < spatial_rank; d++) {
+                origin[d] = std::min(origin[d], gp[d]);
+                upper[d] = std::max(upper[d], gp[d]);
+            }
+        }
+
+        vector<size_t> box(spatial_rank);
+        for (size_t d = 0; d < spatial_rank; d++) {
+            int width = std::max((int) m_kernels[d].values().size() - 1, 0);
+            origin[d] = std::max(origin[d] - width, 0);
+            upper[d] = std::min(upper[d] + width, (int) dim_sizes[d] - 1);
+            box[d] = upper[d] - origin[d] + 1;
+        }
+
+        LinearIndexMapping mapping(box);
+        const size_t N = mapping.size();
+
+        // Copy the point values into the arrays. The values are taken
+        // from the points rather than the data store, since thresholds
+        // and replacements have been applied to them already.
+
+        vector<T> values(value_rank * N, 0.0);
+        vector<T> filtered(value_rank * N, 0.0);
+        vector<unsigned char> state(N, 0);
+        vector<unsigned char> filtered_state(N, 0);
+
+        vector<int> local(spatial_rank);
+        for (size_t pi = 0; pi < fs->points.size(); pi++) {
+            typename Point<T>::ptr p = fs->points[pi];
+            for (size_t d = 0; d < spatial_rank; d++) {
+                local[d] = p->gridpoint[d] - origin[d];
+            }
+            size_t index = mapping.grid_to_index(local);
+            state[index] = p->isOriginalPoint ? (DensePointPresent | DensePointOriginal) : DensePointPresent;
+            for (size_t varIndex = 0; varIndex < value_rank; varIndex++) {
+                values[varIndex * N + index] = p->values[spatial_rank + varIndex];
+            }
+        }
+
+#if SCALE_SPACE_SKIPS_NON_ORIGINAL_POINTS
+        vector<bool> skip(N, false);
+        vector<int> gridpoint(spatial_rank);
+        for (size_t index = 0; index < N; index++) {
+            mapping.linear_to_grid(index, gridpoint);
+            for (size_t d = 0; d < spatial_rank; d++) {
+                gridpoint[d] += origin[d];
+            }
+            skip[index] = fs->off_limits()->get(gridpoint);
+        }
+#endif
+
+        if (this->show_progress()) {
+            cout << "done. (" << stop_timer() << "s)" << endl;
+            cout << endl << "Applying scale filter t=" << m_scale << " decay=" << m_decay << " ... " << endl;
+            m_progress_bar = new boost::progress_display(spatial_rank * N);
+            start_timer();
+        }
+
+        //
+        // Apply dimension by dimension (exploiting separability)
+        //
+
+        for (size_t dimIndex = 0; dimIndex < spatial_rank; dimIndex++) {
+            apply_dense_on_dimension(origin, box, dim_sizes[dimIndex], value_rank, dimIndex,
+                                     values, state, filtered, filtered_state);
+
+            values.swap(filtered);
+            state.swap(filtered_state);
+
+#if SCALE_SPACE_SKIPS_NON_ORIGINAL_POINTS
+            for (size_t index = 0; index < N; index++) {
+                if (skip[index]) {
+                    state[index] = 0;
+                    for (size_t varIndex = 0; varIndex < value_rank; varIndex++) {
+                        values[varIndex * N + index] = 0.0;
+                    }
+                }
+            }
+#endif
+            // track limits
+
+            for (size_t varIndex = 0; varIndex < value_rank; varIndex++) {
+                const T *var_values = &values[varIndex * N];
+                T min = m_min[varIndex];
+                T max = m_max[varIndex];
+                for (size_t index = 0; index < N; index++) {
+                    if (state[index] != 0) {
+                        if (var_values[index] < min) min = var_values[index];
+                        if (var_values[index] > max) max = var_values[index];
+                    }
+                }
+                m_min[varIndex] = min;
+                m_max[varIndex] = max;
+            }
+        }
+
+        // Create the filtered points. As in FeatureSpace::build(),
+        // the box is cut into chunks, which are filled in parallel
+        // and then concatenated in linear grid order.
+
+        fs->clear();
+
+#if WITH_OPENMP
+        size_t num_chunks = 4 * omp_get_max_threads();
+#else
+        size_t num_chunks = 1;
+#endif
+        num_chunks = std::max((size_t) 1, std::min(num_chunks, N));
+        const size_t chunk_size = (N + num_chunks - 1) / num_chunks;
+
+        vector<typename Point<T>::list> chunk_points(num_chunks);
+
+#if WITH_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (size_t chunk = 0; chunk < num_chunks; chunk++) {
+            const size_t chunk_begin = chunk * chunk_size;
+            const size_t chunk_end = std::min(chunk_begin + chunk_size, N);
+
+            // Rows from the chunk's own blocks (see FeatureSpace::build())
+            PointStorage<T> storage;
+
+            vector<int> gridpoint(spatial_rank);
+            typename CoordinateSystem<T>::Coordinate coordinate = cs->newCoordinate();
+
+            for (size_t index = chunk_begin; index < chunk_end; index++) {
+                if (state[index] == 0) continue;
+
+                mapping.linear_to_grid(index, gridpoint);
+                for (size_t d = 0; d < spatial_rank; d++) {
+                    gridpoint[d] += origin[d];
+                }
+                cs->lookup(gridpoint, coordinate);
+
+                vector<T> point_values = coordinate;
+                point_values.resize(spatial_rank + value_rank);
+                for (size_t varIndex = 0; varIndex < value_rank; varIndex++) {
+                    point_values[spatial_rank + varIndex] = values[varIndex * N + index];
+                }
+
+                typename Point<T>::ptr p = PointFactory<T>::get_instance()->create(storage, gridpoint, coordinate, point_values);
+                p->isOriginalPoint = (state[index] & DensePointOriginal) != 0;
+                chunk_points[chunk].push_back(p);
+            }
+        }
+
+        for (size_t chunk = 0; chunk < num_chunks; chunk++) {
+            fs->points.insert(fs->points.end(), chunk_points[chunk].begin(), chunk_points[chunk].end());
+        }
+
+        if (this->show_progress()) {
+            size_t originalPoints = fs->count_original_points();
+            cout << "done. (" << stop_timer() << "s)" << endl;
+            cout << "Filtered featurespace contains " << fs->size() << " points (" << originalPoints
+                 << " original points, "
+                 << "(" << (fs->size() - originalPoints) << " new points))" << endl;
+            delete m_progress_bar;
+            m_progress_bar = NULL;
+        }
+    }
+
     template<typename T>
     void
     ScaleSpaceFilter<T>::apply(FeatureSpace <T> *fs) {
@@ -634,7 +987,15 @@ namespace m3D {
         this->m_unfiltered_max = fs->max();
         //this->applyWithArrayIndex(fs);
 
-        this->apply_parallellized(fs);
+#if SCALE_SPACE_USES_DENSE_ARRAYS
+        this->apply_dense(fs);
+#else
+        if (m_method == ScaleSpaceRecursiveGaussian) {
+            this->apply_dense(fs);
+        } else {
+            this->apply_parallellized(fs);
+        }
+#endif
     }
 
 #pragma mark -
@@ -654,6 +1015,56 @@ namespace m3D {
         return factors;
     }
 
+    template<typename T>
+    T
+    ScaleSpaceFilter<T>::window_sum(const vector<T> &g) {
+        // The window covers distance 0 once, distances 1 to width-1
+        // on both sides and distance width on one side only
+        T sum = 0.0;
+        for (size_t j = 0; j < g.size(); j++) {
+            sum += (j == 0) ? g[j] : 2 * g[j];
+        }
+        if (!g.empty()) {
+            sum -= g.back();
+        }
+        return sum;
+    }
+
+    template<typename T>
+    T
+    ScaleSpaceFilter<T>::gain() {
+        T gain = 1.0;
+        for (size_t i = 0; i < m_kernels.size(); i++) {
+            gain *= window_sum(m_kernels[i].values());
+        }
+        return gain;
+    }
+
+    template<typename T>
+    void
+    ScaleSpaceFilter<T>::scale_values(FeatureSpace<T> *fs, T factor) {
+        const size_t spatial_rank = fs->spatial_rank();
+        const size_t value_rank = fs->value_rank();
+
+#if WITH_OPENMP
+#pragma omp parallel for
+#endif
+        for (size_t i = 0; i < fs->points.size(); i++) {
+            typename Point<T>::ptr p = fs->points[i];
+            for (size_t varIndex = 0; varIndex < value_rank; varIndex++) {
+                p->values[spatial_rank + varIndex] *= factor;
+            }
+        }
+
+        typename map<size_t, T>::iterator mi;
+        for (mi = m_min.begin(); mi != m_min.end(); mi++) {
+            mi->second *= factor;
+        }
+        for (mi = m_max.begin(); mi != m_max.end(); mi++) {
+            mi->second *= factor;
+        }
+    }
+
     template<typename T>
     const map<size_t, T> &
     ScaleSpaceFilter<T>::get_filtered_min() {
@@ -84,7 +84,12 @@ namespace m3D {
             }
         }
 
-        fs->points = accepted;
+        if (this->spatial_index() != NULL) {
+            // removes them from fs->points, too
+            this->spatial_index()->remove_points(erased);
+        } else {
+            fs->points = accepted;
+        }
 
         for (size_t i = 0; i < erased.size(); i++) {
             Point<T> *p = erased[i];
@@ -34,13 +34,17 @@
 #include<meanie3D/featurespace/coordinate_system_impl.h>
 #include<meanie3D/featurespace/featurespace_impl.h>
 #include<meanie3D/featurespace/point_impl.h>
+#include<meanie3D/featurespace/point_columns_impl.h>
 #include<meanie3D/filters/convection_filter_impl.h>
+#include<meanie3D/filters/grid_stencil_impl.h>
+#include<meanie3D/filters/recursive_gaussian_impl.h>
 #include<meanie3D/filters/scalespace_filter_impl.h>
 #include<meanie3D/filters/scalespace_kernel_impl.h>
 #include<meanie3D/filters/replacement_filter_impl.h>
 #include<meanie3D/filters/threshold_filter_impl.h>
 #include<meanie3D/filters/weight_filter_impl.h>
 #include<meanie3D/index/index_impl.h>
+#include<meanie3D/operations/grid_meanshift_op_impl.h>
 #include<meanie3D/operations/iterate_op_impl.h>
 #include<meanie3D/operations/kernels_impl.h>
 #include<meanie3D/operations/meanshift_op_impl.h>
@@ -29,7 +29,9 @@
 #include <meanie3D/index/indexed_flann.h>
 #include <meanie3D/index/indexed_kdtree.h>
 #include <meanie3D/index/linear.h>
+#include <meanie3D/index/prepared_search.h>
 #include <meanie3D/index/rectilinear_grid_index.h>
 #include <meanie3D/index/search_parameters.h>
+#include <meanie3D/index/search_visitor.h>
 
 #endif
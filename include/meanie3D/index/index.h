@@ -29,6 +29,7 @@
 
 #include <meanie3D/featurespace/point.h>
 #include <meanie3D/index/search_parameters.h>
+#include <meanie3D/index/search_visitor.h>
 
 #include <vector>
 
@@ -37,6 +38,9 @@ namespace m3D {
     template<typename T>
     class FeatureSpace;
 
+    template<typename T>
+    class PreparedRangeSearch;
+
     /** Abstract base class. This interface abstracts the various implementations
      * used for indexing the points, such as kdtree.c, flann etc.
      * 
@@ -47,6 +51,8 @@ namespace m3D {
     template<typename T>
     class PointIndex
     {
+        friend class PreparedRangeSearch<T>;
+
     protected:
 
         // Member Variables
@@ -62,6 +68,10 @@ namespace m3D {
          */
         vector<size_t> m_index_variable_indexes;
 
+        /** Accuracy and speed settings
+         */
+        index_params_t m_index_params;
+
         /** Debugging method. Writes out the search window and found points to files.
          */
         void
@@ -124,6 +134,51 @@ namespace m3D {
         typename Point<T>::list *
         search(const vector<T> &x, const SearchParameters *params, vector<T> *distances = NULL) = 0;
 
+        /** Searches the index according to the given search parameters
+         * and hands each point found to the visitor, in the same order
+         * as the list returned by the other search method. No result list
+         * is allocated.
+         * @abstract
+         * @param x
+         * @param search parameters
+         * @param visitor
+         */
+        virtual
+        void
+        search(const vector<T> &x, const SearchParameters *params, SearchVisitor<T> &visitor) = 0;
+
+        /** Searches the index for a whole block of query vectors at once. The
+         * result of query i is placed in results[i]. Result lists are cleared
+         * but not de-allocated, so callers re-using the same results vector
+         * across blocks avoid allocating a new list for each query. The default
+         * implementation simply calls search() for each query. Indexes that
+         * are able to process multiple queries in one go override this.
+         *
+         * @param query vectors
+         * @param search parameters
+         * @param results (resized to the number of queries)
+         */
+        virtual
+        void
+        batch_search(const vector<vector<T> > &queries,
+                     const SearchParameters *params,
+                     vector<typename Point<T>::list> &results);
+
+        /** Prepares repeated range searches with the given bandwidth.
+         * Any index building is done here, so that the searches on the
+         * returned handle need no further checks as long as the index
+         * is not rebuilt. If searching with another bandwidth rebuilds
+         * the index, the handle's next search rebuilds it again for the
+         * handle's bandwidth where needed. The caller takes ownership
+         * of the handle.
+         *
+         * @param bandwidth
+         * @return search handle
+         */
+        virtual
+        PreparedRangeSearch<T> *
+        prepare_range_search(const vector<T> &bandwidth);
+
         /** Add a new point to the index. If the point already exists, it is
          * replaced with the new point
          * @param feature-space point
@@ -139,6 +194,16 @@ namespace m3D {
         void
         remove_point(typename Point<T>::ptr p) = 0;
 
+        /** Remove a number of points from the index at once. Indexes
+         * that maintain the point list remove them from the list, too,
+         * keeping the order of the remaining points. The default
+         * implementation calls remove_point() for each.
+         * @param feature-space points
+         */
+        virtual
+        void
+        remove_points(const typename Point<T>::list &points);
+
 
 #pragma mark -
 #pragma mark Public Methods
@@ -199,6 +264,22 @@ namespace m3D {
             return this->m_points->size();
         }
 
+        /** @return accuracy and speed settings
+         */
+        inline
+        const index_params_t &index_params() const {
+            return m_index_params;
+        }
+
+        /** Changes the accuracy and speed settings. Only takes
+         * effect with the next (re-)construction of the index.
+         * @param settings
+         */
+        inline
+        void set_index_params(const index_params_t &params) {
+            m_index_params = params;
+        }
+
 #pragma mark -
 #pragma mark Destructor
 
@@ -218,22 +299,26 @@ namespace m3D {
          * @param point list
          * @param point dimension
          * @param index type
+         * @param accuracy and speed settings (defaults to exact)
          */
         static PointIndex<T> *
         create(typename Point<T>::list *points,
                size_t dimension,
-               IndexType index_type = DefaultIndexType);
+               IndexType index_type = DefaultIndexType,
+               const index_params_t &index_params = index_params_t());
 
         /** Creates an index for the given points by using a subset of variables
          * as indicated by their indices in the point->values vector.
          * @param point list
          * @param indices
          * @param index type
+         * @param accuracy and speed settings (defaults to exact)
          */
         static PointIndex<T> *
         create(typename Point<T>::list *points,
                const vector<size_t> &indexes,
-               IndexType index_type = DefaultIndexType);
+               IndexType index_type = DefaultIndexType,
+               const index_params_t &index_params = index_params_t());
 
 
 #pragma mark -
@@ -277,7 +362,8 @@ namespace m3D {
         /** Copy constructor
          */
         PointIndex(const PointIndex<T> &o)
-                : m_points(o.m_points), m_fs(o.m_fs), m_index_variable_indexes(o.index_variable_indexes()) {
+                : m_points(o.m_points), m_fs(o.m_fs), m_index_variable_indexes(o.index_variable_indexes()),
+                  m_index_params(o.m_index_params) {
         };
 
         /** This method turns the given list of variables into a list of indexes to be used
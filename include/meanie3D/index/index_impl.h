@@ -45,7 +45,10 @@ namespace m3D {
 
     template<typename T>
     PointIndex<T> *
-    PointIndex<T>::create(typename Point<T>::list *points, size_t dimension, IndexType index_type) {
+    PointIndex<T>::create(typename Point<T>::list *points,
+                          size_t dimension,
+                          IndexType index_type,
+                          const index_params_t &index_params) {
         PointIndex<T> *instance = NULL;
 
         switch (index_type) {
@@ -54,7 +57,11 @@ namespace m3D {
                 break;
 
             case IndexTypeFLANN:
-                instance = new FLANNIndex<T>(points, dimension);
+                if (index_params.single_precision) {
+                    instance = new FLANNIndex<T, float>(points, dimension);
+                } else {
+                    instance = new FLANNIndex<T>(points, dimension);
+                }
                 break;
 
             case IndexTypeKDTree:
@@ -66,6 +73,8 @@ namespace m3D {
                 break;
         }
 
+        instance->set_index_params(index_params);
+
         return instance;
     }
 
@@ -73,7 +82,8 @@ namespace m3D {
     PointIndex<T> *
     PointIndex<T>::create(typename Point<T>::list *points,
                           const vector<size_t> &indexes,
-                          IndexType index_type) {
+                          IndexType index_type,
+                          const index_params_t &index_params) {
         PointIndex<T> *instance = NULL;
 
         switch (index_type) {
@@ -82,7 +92,11 @@ namespace m3D {
                 break;
 
             case IndexTypeFLANN:
-                instance = new FLANNIndex<T>(points, indexes);
+                if (index_params.single_precision) {
+                    instance = new FLANNIndex<T, float>(points, indexes);
+                } else {
+                    instance = new FLANNIndex<T>(points, indexes);
+                }
                 break;
 
             case IndexTypeKDTree:
@@ -94,9 +108,38 @@ namespace m3D {
                 break;
         }
 
+        instance->set_index_params(index_params);
+
         return instance;
     }
 
+    template<typename T>
+    void
+    PointIndex<T>::batch_search(const vector<vector<T> > &queries,
+                                const SearchParameters *params,
+                                vector<typename Point<T>::list> &results) {
+        results.resize(queries.size());
+        for (size_t i = 0; i < queries.size(); i++) {
+            results[i].clear();
+            PointListCollector<T> collector(results[i]);
+            this->search(queries[i], params, collector);
+        }
+    }
+
+    template<typename T>
+    void
+    PointIndex<T>::remove_points(const typename Point<T>::list &points) {
+        for (size_t i = 0; i < points.size(); i++) {
+            this->remove_point(points[i]);
+        }
+    }
+
+    template<typename T>
+    PreparedRangeSearch<T> *
+    PointIndex<T>::prepare_range_search(const vector<T> &bandwidth) {
+        return new PreparedRangeSearch<T>(this, bandwidth);
+    }
+
     template<typename T>
     void
     PointIndex<T>::write_search(const vector<T> &x, const vector<T> &ranges, typename Point<T>::list *result) {
@@ -163,10 +206,14 @@ namespace m3D {
 
         vector<T> x = this->indexed_components(p);
 
-        typename Point<T>::list *result = this->search(x, &knn);
+        typename Point<T>::list result;
+
+        PointListCollector<T> collector(result);
+
+        this->search(x, &knn, collector);
 
-        if (result->size() > 0) {
-            have_point = (result->front() == p);
+        if (result.size() > 0) {
+            have_point = (result.front() == p);
         }
 
         return have_point;
@@ -179,10 +226,14 @@ namespace m3D {
 
         KNNSearchParams<T> knn(1);
 
-        typename Point<T>::list *result = this->search(x, &knn);
+        typename Point<T>::list result;
+
+        PointListCollector<T> collector(result);
+
+        this->search(x, &knn, collector);
 
-        if (result->size() > 0) {
-            vector<T> xr = this->indexed_components(result->front());
+        if (result.size() > 0) {
+            vector<T> xr = this->indexed_components(result.front());
 
             have_point = (xr == x);
         }
@@ -176,22 +176,46 @@ namespace m3D {
                 }
             }
 
+            update_whitening(ranges);
+
+            // multiply the original featurespace matrix with
+            // this transformation matrix
+            white_point_matrix = boost::numeric::ublas::prod(point_matrix, omega);
+        };
+
+        /** Calculates the transformation omega from the given ranges,
+         * without transforming the feature-space. Implementations that
+         * whiten the points themselves use this to avoid holding the
+         * feature-space in matrix form.
+         * @param ranges
+         */
+        void update_whitening(const vector<T> &ranges) {
             white_range = ranges;
 
             // construct a diagonal matrix with the whitening factors
-            // from the bandwidth vector
+            // from the bandwidth vector. Components with zero bandwidth
+            // get a zero factor and do not contribute to distances
 
             omega = boost::numeric::ublas::matrix<T>(this->dimension(), this->dimension());
 
             for (size_t i = 0; i < this->dimension(); i++) {
                 for (size_t j = 0; j < this->dimension(); j++) {
-                    omega(i, j) = (i == j) ? (white_radius / white_range[i]) : 0.0;
+                    omega(i, j) = (i == j && white_range[i] > 0) ? (white_radius / white_range[i]) : 0.0;
                 }
             }
+        };
 
-            // multiply the original featurespace matrix with
-            // this transformation matrix
-            white_point_matrix = boost::numeric::ublas::prod(point_matrix, omega);
+        /** Writes the whitened indexed components of the given point
+         * into the given buffer, converting to the buffer's precision.
+         * @param point
+         * @param buffer with room for dimension() values
+         */
+        template<typename F>
+        void whiten_point(typename Point<T>::ptr p, F *buffer) const {
+            for (size_t col = 0; col < this->dimension(); col++) {
+                size_t actual_index = this->m_index_variable_indexes[col];
+                buffer[col] = (F) (omega(col, col) * p->values[actual_index]);
+            }
         };
 
         /** Transform the given coordinate using the current omega
@@ -28,31 +28,191 @@
 #include <meanie3D/namespaces.h>
 #include <meanie3D/parallel.h>
 #include <meanie3D/index.h>
+#include <meanie3D/index/prepared_search.h>
 
 #include <flann/flann.hpp>
 #include <flann/io/hdf5.h>
 
+#include <algorithm>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
 namespace m3D {
 
     using flann::Matrix;
     using flann::Index;
     using flann::L2;
 
+    template<typename T, typename F>
+    class FLANNIndex;
+
+    /** Prepared range search on a FLANN index. The whitening factors
+     * are taken from the index once, and the query and result buffers
+     * are re-used between searches.
+     *
+     * The handle goes through the owning index for every search, since
+     * the index may be rebuilt after the handle was prepared (for
+     * instance by searches with other bandwidths). In that case the
+     * search radius and whitening are looked up again, and the index
+     * is rebuilt for the handle's own bandwidth if that is no multiple
+     * of the new one. Vectors whitened with whiten() before the rebuild
+     * remain valid.
+     *
+     * @param T feature-space data type
+     * @param F data type of the FLANN index
+     */
+    template<typename T, typename F>
+    class FLANNPreparedRangeSearch : public PreparedRangeSearch<T>
+    {
+        friend class FLANNIndex<T, F>;
+
+    private:
+
+        FLANNIndex<T, F> *m_owner;
+        size_t m_build_count; // build of the owner the values below belong to
+        vector<T> m_factors; // whitening of whiten(), fixed at preparation
+        vector<T> m_index_factors; // whitening of the owner's current build
+        vector<T> m_conversion; // from m_factors to m_index_factors
+        T m_radius;
+        vector<F> m_query;
+        flann::SearchParams m_flann_params;
+        vector<vector<int> > m_indices;
+        vector<vector<F> > m_dists;
+
+    protected:
+
+        /** Constructor
+         * @param owner flann index
+         * @param bandwidth
+         * @param whitening factors of the flann index
+         * @param search radius in the whitened space (the bandwidth
+         *        may be a multiple of the one the index was built for)
+         * @param flann search parameters
+         */
+        FLANNPreparedRangeSearch(FLANNIndex<T, F> *owner,
+                                 const vector<T> &bandwidth,
+                                 const vector<T> &factors,
+                                 T radius,
+                                 const flann::SearchParams &flann_params)
+                : PreparedRangeSearch<T>(owner, bandwidth),
+                  m_owner(owner),
+                  m_build_count(owner->m_build_count),
+                  m_factors(factors),
+                  m_index_factors(factors),
+                  m_conversion(factors.size(), 1.0),
+                  m_radius(radius),
+                  m_query(factors.size()),
+                  m_flann_params(flann_params),
+                  m_indices(1),
+                  m_dists(1) {
+            // Same parameters as FLANNIndex::search, except that
+            // nothing is kept in GPU memory
+            m_flann_params.matrices_in_gpu_ram = flann::FLANN_False;
+        };
+
+        /** Called when the owner was rebuilt since the values of the
+         * handle were looked up.
+         */
+        void
+        refresh() {
+            T scale = 1.0;
+            if (m_owner->m_index == NULL
+                    || !m_owner->bandwidth_scale(this->m_params.bandwidth, scale)) {
+                m_owner->build_index(this->m_params.bandwidth);
+                scale = 1.0;
+            }
+            for (size_t i = 0; i < m_factors.size(); i++) {
+                m_index_factors[i] = m_owner->omega(i, i);
+                m_conversion[i] = m_index_factors[i] / m_factors[i];
+            }
+            m_radius = scale * m_owner->white_radius;
+            m_build_count = m_owner->m_build_count;
+        };
+
+    public:
+
+        void
+        whiten(const vector<T> &x, vector<T> &result) const {
+            result.resize(m_factors.size());
+            for (size_t i = 0; i < m_factors.size(); i++) {
+                result[i] = m_factors[i] * x[i];
+            }
+        };
+
+        void
+        search(const vector<T> &x,
+               typename Point<T>::list &result,
+               vector<T> *distances = NULL,
+               bool whitened = false) {
+            if (m_build_count != m_owner->m_build_count) {
+                refresh();
+            }
+            const size_t dim = m_factors.size();
+            for (size_t i = 0; i < dim; i++) {
+                m_query[i] = (F) (whitened ? m_conversion[i] * x[i] : m_index_factors[i] * x[i]);
+            }
+            flann::Matrix<F> query(&m_query[0], 1, dim);
+
+            // FLANN resizes the inner vectors, which keeps their
+            // capacity between calls
+            // FLANN's L2 distance is squared, hence the radius
+            m_owner->m_index->radiusSearch(query, m_indices, m_dists,
+                                           m_radius * m_radius,
+                                           m_flann_params);
+
+            const vector<int> &indices = m_indices[0];
+            result.resize(indices.size());
+            for (size_t n = 0; n < indices.size(); n++) {
+                result[n] = m_owner->m_id_points.at(indices[n]);
+            }
+            if (distances != NULL) {
+                const vector<F> &dists = m_dists[0];
+                distances->resize(dists.size());
+                for (size_t n = 0; n < dists.size(); n++) {
+                    (*distances)[n] = dists[n] / (m_radius * m_radius);
+                }
+            }
+        };
+    };
+
     /** Implementation of FeatureSpace which simply searches the feature-space vector
      * brute-force style when sampling around points.
+     *
+     * The whitened points are written straight into FLANN's dataset,
+     * without going through the feature-space matrices of WhiteningIndex.
+     * The dataset may be kept in a lower precision than the feature-space
+     * to save memory.
+     *
+     * @param T feature-space data type
+     * @param F data type of the FLANN index (defaults to T)
      */
-    template<typename T>
+    template<typename T, typename F = T>
     class FLANNIndex : public WhiteningIndex<T>
     {
         friend class PointIndex<T>;
+        friend class FLANNPreparedRangeSearch<T, F>;
 
     private:
 
 #pragma mark -
 #pragma mark Member variables
 
-        Index<L2<T> > *m_index;
-        Matrix<T> m_dataset;
+        Index<L2<F> > *m_index;
+        Matrix<F> m_dataset;
+
+        // FLANN identifies points by the order in which they were
+        // inserted. After a full build, these are the positions in
+        // the point list. Adding and removing points in place breaks
+        // this, and the tables below translate between the two.
+
+        vector<typename Point<T>::ptr> m_id_points; // point by id (NULL if removed)
+        map<typename Point<T>::ptr, size_t> m_point_ids; // id by point (filled on demand)
+        vector<F *> m_added_data; // whitened data of added points (FLANN keeps pointers into it)
+        size_t m_size_at_build; // number of points at the last (re)build
+        size_t m_removed_since_build; // points removed since the last (re)build
+        size_t m_build_count; // number of full builds, prepared searches check it
 
     protected:
 
@@ -61,26 +221,38 @@ namespace m3D {
 
         inline
         FLANNIndex(typename Point<T>::list *points, size_t dimension) : WhiteningIndex<T>(points, dimension),
-                                                                        m_index(NULL) {
+                                                                        m_index(NULL),
+                                                                        m_size_at_build(0),
+                                                                        m_removed_since_build(0),
+                                                                        m_build_count(0) {
         };
 
         inline
         FLANNIndex(typename Point<T>::list *points, const vector<size_t> &indexes) : WhiteningIndex<T>(points, indexes),
-                                                                                     m_index(NULL) {
+                                                                                     m_index(NULL),
+                                                                                     m_size_at_build(0),
+                                                                                     m_removed_since_build(0),
+                                                                                     m_build_count(0) {
         };
 
         inline
-        FLANNIndex(FeatureSpace<T> *fs) : WhiteningIndex<T>(fs), m_index(NULL) {
+        FLANNIndex(FeatureSpace<T> *fs) : WhiteningIndex<T>(fs), m_index(NULL),
+                                          m_size_at_build(0), m_removed_since_build(0),
+                                          m_build_count(0) {
         };
 
         inline
         FLANNIndex(FeatureSpace<T> *fs, const vector<netCDF::NcVar> &index_variables) : WhiteningIndex<T>(fs,
                                                                                                           index_variables),
-                                                                                        m_index(NULL) {
+                                                                                        m_index(NULL),
+                                                                                        m_size_at_build(0),
+                                                                                        m_removed_since_build(0),
+                                                                                        m_build_count(0) {
         };
 
         inline
-        FLANNIndex(const FLANNIndex<T> &o) : WhiteningIndex<T>(o), m_dataset(dynamic_cast<FLANNIndex> (o).dataset()) {
+        FLANNIndex(const FLANNIndex<T, F> &o) : WhiteningIndex<T>(o), m_dataset(dynamic_cast<FLANNIndex> (o).dataset()),
+                                                m_build_count(0) {
             build_index_from_dataset();
         };
 
@@ -97,8 +269,10 @@ namespace m3D {
             }
 
             if (m_dataset.ptr()) {
-                delete[] m_dataset.ptr();
+                free(m_dataset.ptr());
             }
+
+            free_added_data();
         };
 
 #pragma mark -
@@ -106,8 +280,8 @@ namespace m3D {
 
         /** Copy operator
          */
-        FLANNIndex<T> operator=(const FLANNIndex<T> &other) {
-            return FLANNIndex<T>(other);
+        FLANNIndex<T, F> operator=(const FLANNIndex<T, F> &other) {
+            return FLANNIndex<T, F>(other);
         }
 
 #pragma mark -
@@ -117,7 +291,7 @@ namespace m3D {
 
         void
         build_index(const vector<T> &ranges) {
-            this->transform_featurespace(ranges);
+            this->update_whitening(ranges);
 
             if (m_index != NULL) {
                 delete m_index;
@@ -125,11 +299,20 @@ namespace m3D {
                 m_index = NULL;
             }
 
+            // Release the old dataset before allocating the new one
+            if (m_dataset.ptr()) {
+                free(m_dataset.ptr());
+                m_dataset = Matrix<F>();
+            }
+
             // Re-package data for FLANN
             construct_dataset();
 
             build_index_from_dataset();
 
+            reset_ids();
+
+            m_build_count++;
         }
 
     public:
@@ -137,102 +320,116 @@ namespace m3D {
 #pragma mark -
 #pragma mark Overwritten Public Methods
 
+        /** Removes the point from the index and the point list. In
+         * the index, the point is only marked as removed until enough
+         * points have been removed to warrant rebalancing.
+         * @param point
+         */
         void
         remove_point(typename Point<T>::ptr p) {
-            throw "FLANN does not support removing individual points";
-        }
-
-        void
-        add_point(typename Point<T>::ptr p) {
-            // construct the coordinate for indexing
-
-            vector<T> coordinate(this->size());
+            remove_from_index(p);
 
-            for (size_t i = 0; i < this->dimension(); i++) {
-                size_t j = this->m_index_variable_indexes[i];
-
-                coordinate[i] = p->coordinate[j];
+            typename Point<T>::list::iterator f = find(this->m_points->begin(), this->m_points->end(), p);
+            if (f != this->m_points->end()) {
+                this->m_points->erase(f);
             }
 
-            // transform it into the whitened space
-
-            vector<T> t = this->transform_vector(coordinate);
-
-            // add it to the index
-
-            T data[t.size()][1];
+            rebalance();
+        }
 
-            for (size_t i = 0; i < this->dimension(); i++) {
-                data[i][0] = t[i];
+        /** Removes the points from the index and compacts the point
+         * list in one pass.
+         * @param points
+         */
+        void
+        remove_points(const typename Point<T>::list &points) {
+            std::set<typename Point<T>::ptr> removed;
+            for (size_t i = 0; i < points.size(); i++) {
+                remove_from_index(points[i]);
+                removed.insert(points[i]);
             }
 
-            Matrix<T> dataset(&data[0][0], 1, t.size());
-
-            m_index->addPoints(dataset);
-
-            // add to the points list
+            typename Point<T>::list &list = *(this->m_points);
+            size_t kept = 0;
+            for (size_t i = 0; i < list.size(); i++) {
+                if (removed.find(list[i]) == removed.end()) {
+                    list[kept++] = list[i];
+                }
+            }
+            list.resize(kept);
 
-            this->m_points->push_back(p);
+            rebalance();
         }
 
-        typename Point<T>::list *
-        search(const vector<T> &x, const SearchParameters *params, vector<T> *distances = NULL) {
-            // Check if the index needs re-building
-
-            vector<T> h;
-
-            if (params->search_type() == SearchTypeRange) {
-                RangeSearchParams<T> *p = (RangeSearchParams<T> *) params;
+        /** Appends the point to the point list and inserts it into
+         * the index. If the index has not been built yet, the point
+         * will be part of the build.
+         * @param point
+         */
+        void
+        add_point(typename Point<T>::ptr p) {
+            this->m_points->push_back(p);
 
-                h = p->bandwidth;
-            } else {
-                h = vector<T>(x.size(), 1.0);
+            if (m_index != NULL) {
+                // FLANN does not copy the data, so it has to be
+                // kept until the next full build
+                const size_t dim = this->dimension();
+                F *data = (F *) malloc(dim * sizeof(F));
+                this->whiten_point(p, data);
+                m_added_data.push_back(data);
+
+                // FLANN takes care of rebalancing after growth
+                Matrix<F> row(data, 1, dim);
+                m_index->addPoints(row, this->index_params().rebuild_threshold);
+
+                lookup_point_ids();
+                m_point_ids[p] = m_id_points.size();
+                m_id_points.push_back(p);
             }
+        }
 
-            if (this->white_range != h || m_index == NULL) {
-                build_index(h);
+        /** Prepares range searches. If the index was built for a
+         * bandwidth that the given bandwidth is a multiple of, the index
+         * is re-used with a larger search radius, so that handles for
+         * different multiples of the same bandwidth can be used side
+         * by side.
+         * @param bandwidth
+         * @return search handle
+         */
+        PreparedRangeSearch<T> *
+        prepare_range_search(const vector<T> &bandwidth) {
+            T scale = 1.0;
+            if (m_index == NULL || !bandwidth_scale(bandwidth, scale)) {
+                build_index(bandwidth);
+                scale = 1.0;
             }
-
-            // FLANN Search Parameters
-
-            flann::SearchParams flann_params(32, 0, false);
-            flann_params.use_heap = flann::FLANN_True;
-            flann_params.matrices_in_gpu_ram = flann::FLANN_True;
-
-            // Build query
-
-            vector<T> x_t = (params->search_type() == SearchTypeRange) ? this->transform_vector(x) : x;
-
-            T query_point[x_t.size()];
-
-            for (size_t i = 0; i < x_t.size(); i++) {
-                query_point[i] = x_t[i];
+            vector<T> factors(this->dimension());
+            for (size_t i = 0; i < this->dimension(); i++) {
+                factors[i] = this->omega(i, i);
             }
+            return new FLANNPreparedRangeSearch<T, F>(this, bandwidth, factors,
+                                                   scale * this->white_radius, flann_search_params(1));
+        }
 
-            flann::Matrix<T> query = flann::Matrix<T>(&query_point[0], 1, this->dimension());
+        typename Point<T>::list *
+        search(const vector<T> &x, const SearchParameters *params, vector<T> *distances = NULL) {
             vector<vector<int> > indices;
-            vector<vector<T> > dists;
-            if (params->search_type() == SearchTypeKNN) {
-                const KNNSearchParams<T> *p = dynamic_cast<const KNNSearchParams<T> *> (params);
-                flann_params.sorted = flann::FLANN_True;
-                m_index->knnSearch(query, indices, dists, p->k, flann_params);
-            } else {
-                m_index->radiusSearch(query, indices, dists, this->white_radius, flann_params);
-            }
+            vector<vector<F> > dists;
+            flann_search(x, params, indices, dists);
 
             // re-wrap results
             typename Point<T>::list *result = new typename Point<T>::list();
             for (size_t row = 0; row < indices.size(); row++) {
-                vector<int> _indices = indices[row];
+                const vector<int> &_indices = indices[row];
                 for (size_t col = 0; col < _indices.size(); col++) {
-                    typename Point<T>::ptr p = this->m_points->at(_indices[col]);
+                    typename Point<T>::ptr p = m_id_points[_indices[col]];
                     result->push_back(p);
                 }
             }
 
             if (distances) {
                 for (size_t row = 0; row < dists.size(); row++) {
-                    vector<T> _dists = dists[row];
+                    const vector<F> &_dists = dists[row];
                     for (size_t col = 0; col < _dists.size(); col++) {
                         distances->push_back((T) _dists[col]);
                     }
@@ -244,6 +441,7 @@ namespace m3D {
                     RangeSearchParams<T> *p = (RangeSearchParams<T> *) params;
                     this->write_search(x, p->bandwidth, result);
                 } else {
+                    vector<T> x_t = this->transform_vector(x);
                     vector<T> white_ranges(x_t.size(), this->white_radius);
                     this->write_search(x_t, white_ranges, result);
                 }
@@ -252,6 +450,74 @@ namespace m3D {
             return result;
         }
 
+        void
+        search(const vector<T> &x, const SearchParameters *params, SearchVisitor<T> &visitor) {
+            vector<vector<int> > indices;
+            vector<vector<F> > dists;
+            flann_search(x, params, indices, dists);
+
+            for (size_t row = 0; row < indices.size(); row++) {
+                const vector<int> &_indices = indices[row];
+                for (size_t col = 0; col < _indices.size(); col++) {
+                    visitor.visit(m_id_points[_indices[col]]);
+                }
+            }
+        }
+
+        void
+        batch_search(const vector<vector<T> > &queries,
+                     const SearchParameters *params,
+                     vector<typename Point<T>::list> &results) {
+            // Only range searches are batched for now
+            if (params->search_type() != SearchTypeRange) {
+                PointIndex<T>::batch_search(queries, params, results);
+                return;
+            }
+
+            RangeSearchParams<T> *p = (RangeSearchParams<T> *) params;
+            if (this->white_range != p->bandwidth || m_index == NULL) {
+                build_index(p->bandwidth);
+            }
+
+            results.resize(queries.size());
+            if (queries.empty()) {
+                return;
+            }
+
+            // Pack the whitened query vectors into one row-major
+            // block, so that FLANN can process them in a single call
+
+            size_t dim = this->dimension();
+            vector<F> query_data(queries.size() * dim);
+            for (size_t row = 0; row < queries.size(); row++) {
+                for (size_t col = 0; col < dim; col++) {
+                    query_data[row * dim + col] = (F) (this->omega(col, col) * queries[row][col]);
+                }
+            }
+            flann::Matrix<F> query = flann::Matrix<F>(&query_data[0], queries.size(), dim);
+
+            // Same parameters as the single query search, which
+            // guarantees identical results per row
+            flann::SearchParams flann_params = flann_search_params(queries.size());
+
+            vector<vector<int> > indices;
+            vector<vector<F> > dists;
+            m_index->radiusSearch(query, indices, dists, this->white_radius, flann_params);
+
+            // re-wrap results
+            for (size_t row = 0; row < indices.size(); row++) {
+                typename Point<T>::list &result = results[row];
+                result.clear();
+                const vector<int> &_indices = indices[row];
+                for (size_t col = 0; col < _indices.size(); col++) {
+                    result.push_back(m_id_points[_indices[col]]);
+                }
+                if (PointIndex<T>::write_index_searches) {
+                    this->write_search(queries[row], p->bandwidth, &result);
+                }
+            }
+        }
+
 #pragma mark
 #pragma mark Protected specific methods
 
@@ -260,39 +526,226 @@ namespace m3D {
         /** Protected accessor. Required for copy constructor
          * @return pointer to the index
          */
-        Index<L2<T> > *index() {
+        Index<L2<F> > *index() {
             return m_index;
         };
 
         /** Protected accessor. Required for copy constructor
          * @return dataset
          */
-        Matrix<T> dataset() {
+        Matrix<F> dataset() {
             return m_dataset;
         };
 
+        /** Single query search, shared by both search methods. The
+         * results are FLANN ids.
+         * @param x
+         * @param search parameters
+         * @param ids (output)
+         * @param distances (output)
+         */
+        void flann_search(const vector<T> &x,
+                          const SearchParameters *params,
+                          vector<vector<int> > &indices,
+                          vector<vector<F> > &dists) {
+            // Check if the index needs re-building
+
+            vector<T> h;
+
+            if (params->search_type() == SearchTypeRange) {
+                RangeSearchParams<T> *p = (RangeSearchParams<T> *) params;
+
+                h = p->bandwidth;
+            } else {
+                // Neighbours are ranked in the space whitened
+                // by the given bandwidth, if there is one
+                KNNSearchParams<T> *p = (KNNSearchParams<T> *) params;
+
+                h = p->bandwidth.empty() ? vector<T>(x.size(), 1.0) : p->bandwidth;
+            }
+
+            if (this->white_range != h || m_index == NULL) {
+                build_index(h);
+            }
+
+            // FLANN Search Parameters
+
+            flann::SearchParams flann_params = flann_search_params(1);
+
+            // Build query
+
+            const size_t dim = this->dimension();
+
+            F query_point[dim];
+
+            for (size_t i = 0; i < dim; i++) {
+                query_point[i] = (F) (this->omega(i, i) * x[i]);
+            }
+
+            flann::Matrix<F> query = flann::Matrix<F>(&query_point[0], 1, dim);
+            if (params->search_type() == SearchTypeKNN) {
+                const KNNSearchParams<T> *p = dynamic_cast<const KNNSearchParams<T> *> (params);
+                flann_params.sorted = flann::FLANN_True;
+                m_index->knnSearch(query, indices, dists, std::min(p->k, this->size()), flann_params);
+            } else {
+                m_index->radiusSearch(query, indices, dists, this->white_radius, flann_params);
+            }
+        }
+
+        /** FLANN search parameters according to the index settings.
+         * The number of checks only limits the search in the randomized
+         * forest, otherwise the search is exact.
+         *
+         * @param number of queries searched in one go. Multiple
+         * threads are only used for more than one query.
+         * @return search parameters
+         */
+        flann::SearchParams flann_search_params(size_t num_queries) const {
+            const index_params_t &p = this->index_params();
+            int checks = p.approximate ? p.checks : (int) flann::FLANN_CHECKS_UNLIMITED;
+            flann::SearchParams flann_params(checks, 0, false);
+            flann_params.use_heap = flann::FLANN_True;
+            flann_params.matrices_in_gpu_ram = flann::FLANN_True;
+            flann_params.cores = (num_queries > 1) ? p.threads : 1;
+            return flann_params;
+        }
+
         /** Create dataset from the feature-space, as prescribed
-         * by the index variables
+         * by the index variables. The points are whitened straight
+         * into the dataset, so that no other copy of the feature-space
+         * is held while the index is built.
          */
         void construct_dataset() {
-            // re-package data for FLANN
-            size_t count = this->size() * this->dimension();
-            T *data = (T *) malloc(count * sizeof(T));
-            for (size_t row = 0; row < this->white_point_matrix.size1(); row++) {
-                for (size_t col = 0; col < this->white_point_matrix.size2(); col++) {
-                    data[row * this->white_point_matrix.size2() + col] = this->white_point_matrix(row, col);
-                }
+            const size_t dim = this->dimension();
+            const size_t count = this->size();
+            F *data = (F *) malloc(count * dim * sizeof(F));
+            if (data == NULL && count > 0) {
+                std::ostringstream message;
+                message << "could not allocate " << (count * dim * sizeof(F))
+                        << " bytes for the search index";
+                throw std::runtime_error(message.str());
             }
-            m_dataset = flann::Matrix<T>(data, this->size(), this->dimension());
+#if WITH_OPENMP
+            int num_threads = this->index_params().threads;
+            if (num_threads <= 0) {
+                num_threads = omp_get_max_threads();
+            }
+#pragma omp parallel for schedule(static) num_threads(num_threads)
+#endif
+            for (size_t row = 0; row < count; row++) {
+                this->whiten_point(this->m_points->at(row), &data[row * dim]);
+            }
+            m_dataset = flann::Matrix<F>(data, count, dim);
         }
 
         void build_index_from_dataset() {
-            // Set up Index options
+            // Set up Index options. The randomized forest trades
+            // accuracy for speed, the single tree is exact. Only the
+            // former can take new points without being rebuilt, so
+            // incremental indexes use a forest of one tree, which is
+            // exact when searched without limit on the checks.
             flann::IndexParams params;
-            params = flann::KDTreeSingleIndexParams();
-            m_index = new flann::Index<flann::L2<T> >(m_dataset, params);
+            if (this->index_params().approximate) {
+                params = flann::KDTreeIndexParams(this->index_params().trees);
+            } else if (this->index_params().incremental) {
+                params = flann::KDTreeIndexParams(1);
+            } else {
+                params = flann::KDTreeSingleIndexParams();
+            }
+            m_index = new flann::Index<flann::L2<F> >(m_dataset, params);
             m_index->buildIndex();
         }
+
+#pragma mark -
+#pragma mark Incremental changes
+
+        /** After a full build, FLANN's ids are the positions in
+         * the point list again.
+         */
+        void reset_ids() {
+            free_added_data();
+            m_id_points = *(this->m_points);
+            m_point_ids.clear();
+            m_size_at_build = this->size();
+            m_removed_since_build = 0;
+        }
+
+        void free_added_data() {
+            for (size_t i = 0; i < m_added_data.size(); i++) {
+                free(m_added_data[i]);
+            }
+            m_added_data.clear();
+        }
+
+        /** The reverse lookup is only needed when points are
+         * removed or added, so it is filled on first use.
+         */
+        void lookup_point_ids() {
+            if (m_point_ids.empty()) {
+                for (size_t id = 0; id < m_id_points.size(); id++) {
+                    if (m_id_points[id] != NULL) {
+                        m_point_ids[m_id_points[id]] = id;
+                    }
+                }
+            }
+        }
+
+        /** Marks the point as removed in the FLANN index.
+         * @param point
+         */
+        void remove_from_index(typename Point<T>::ptr p) {
+            if (m_index == NULL) {
+                return;
+            }
+            lookup_point_ids();
+            typename map<typename Point<T>::ptr, size_t>::iterator f = m_point_ids.find(p);
+            if (f == m_point_ids.end()) {
+                return;
+            }
+            m_index->removePoint(f->second);
+            m_id_points[f->second] = NULL;
+            m_point_ids.erase(f);
+            m_removed_since_build++;
+        }
+
+        /** Removed points are still in the trees and slow down
+         * searches. Once the index has shrunk by the rebuild threshold,
+         * the trees are rebuilt without them. The ids are kept.
+         */
+        void rebalance() {
+            if (m_index == NULL || m_removed_since_build == 0) {
+                return;
+            }
+            float threshold = this->index_params().rebuild_threshold;
+            if (threshold <= 1.0f) {
+                return;
+            }
+            if (m_removed_since_build > m_size_at_build * (1.0f - 1.0f / threshold)) {
+                m_index->buildIndex();
+                m_size_at_build = this->size();
+                m_removed_since_build = 0;
+            }
+        }
+
+        /** Checks if the given bandwidth is a uniform multiple of
+         * the bandwidth the index was built for.
+         * @param bandwidth
+         * @param multiple (output)
+         * @return true if it is
+         */
+        bool bandwidth_scale(const vector<T> &bandwidth, T &scale) const {
+            if (this->white_range.size() != bandwidth.size() || bandwidth.empty()) {
+                return false;
+            }
+            scale = bandwidth[0] / this->white_range[0];
+            for (size_t i = 1; i < bandwidth.size(); i++) {
+                T expected = scale * this->white_range[i];
+                if (fabs(bandwidth[i] - expected) > 1e-6 * fabs(expected)) {
+                    return false;
+                }
+            }
+            return true;
+        }
     };
 }
 
@@ -96,7 +96,7 @@ namespace m3D {
         build_index(const vector<T> &ranges) {
             // TODO: build index from index variables
 
-            this->transform_featurespace(ranges);
+            this->update_whitening(ranges);
 
             if (m_index == NULL) {
                 // allocate kd tree, if necessary
@@ -106,23 +106,17 @@ namespace m3D {
                 kd_clear(m_index);
             }
 
-            typename Point<T>::list::iterator it;
+            // Whiten each point straight into the insertion buffer
 
-            // Allocate 
+            double query_point[this->dimension()];
 
-            for (size_t row = 0; row < this->white_point_matrix.size1(); row++) {
-                // re-package data for kd-tree
-
-                double query_point[this->white_point_matrix.size2()];
+            for (size_t row = 0; row < this->size(); row++) {
+                typename Point<T>::ptr p = this->m_points->at(row);
 
-                for (size_t col = 0; col < this->dimension(); col++) {
-                    query_point[col] = this->white_point_matrix(row, col);
-                }
+                this->whiten_point(p, query_point);
 
                 // Insert
 
-                typename Point<T>::ptr p = this->m_points->at(row);
-
                 kd_insert(m_index, query_point, static_cast<void *> (p));
             }
         }
@@ -165,6 +159,31 @@ namespace m3D {
 
         typename Point<T>::list *
         search(const vector<T> &x, const SearchParameters *params, vector<T> *distances = NULL) {
+            // Compile the sample
+
+            typename Point<T>::list *result = new typename Point<T>::list();
+
+            PointListCollector<T> collector(*result);
+
+            this->search(x, params, collector);
+
+            // calculate distances
+//            if (distances != NULL) {
+//                typename Point<T>::list::iterator li;
+//                for (li = result->begin(); li != result->end(); li++) {
+//                    vector<T> dx = vector_subtract(<#vector<T> &v1#>, <#vector<T> &v2#>);
+//                }
+//            }
+
+            if (PointIndex<T>::write_index_searches) {
+                RangeSearchParams<T> *p = (RangeSearchParams<T> *) params;
+                this->write_search(x, p->bandwidth, result);
+            }
+            return result;
+        }
+
+        void
+        search(const vector<T> &x, const SearchParameters *params, SearchVisitor<T> &visitor) {
             if (params->search_type() == SearchTypeKNN) {
                 std::cerr << "FATAL:KNN not supported by KDTree yet" << std::endl;
                 exit(EXIT_FAILURE);
@@ -173,56 +192,31 @@ namespace m3D {
             // Check if the index needs re-building
 
             if (params->search_type() == SearchTypeRange) {
-                RangeSearchParams<T> *p = (RangeSearchParams<T> *) &params;
+                const RangeSearchParams<T> *p = (const RangeSearchParams<T> *) params;
 
                 if (this->white_range != p->bandwidth || m_index == NULL) {
                     build_index(p->bandwidth);
                 }
             }
 
-            // Compile the sample
-
-            typename Point<T>::list *result = new typename Point<T>::list();
             struct kdres *presults;
 
-            // tranform coordinate
-            vector<T> xt = this->transform_vector(x);
-
-            // re-package data for KD-Tree
+            // re-package the transformed coordinate for KD-Tree
             double pos[this->dimension()];
             for (size_t index = 0; index < this->dimension(); index++) {
-                pos[index] = xt[index];
+                pos[index] = this->omega(index, index) * x[index];
             }
 
             presults = kd_nearest_range(m_index, pos, this->white_radius);
 
-            // Re-package results
+            // Hand out the results
             while (!kd_res_end(presults)) {
                 typename Point<T>::ptr ptr = (typename Point<T>::ptr) kd_res_item(presults, &pos[0]);
-                result->push_back(ptr);
+                visitor.visit(ptr);
                 kd_res_next(presults);
             }
 
-            // calculate distances
-//            if (distances != NULL) {
-//                typename Point<T>::list::iterator li;
-//                for (li = result->begin(); li != result->end(); li++) {
-//                    vector<T> dx = vector_subtract(<#vector<T> &v1#>, <#vector<T> &v2#>);
-//                }
-//            }
-
             kd_res_free(presults);
-
-            if (PointIndex<T>::write_index_searches) {
-                if (params->search_type() == SearchTypeRange) {
-                    RangeSearchParams<T> *p = (RangeSearchParams<T> *) params;
-                    this->write_search(x, p->bandwidth, result);
-                } else {
-                    vector<T> white_ranges(xt.size(), this->white_radius);
-                    this->write_search(xt, white_ranges, result);
-                }
-            }
-            return result;
         }
     };
 }
@@ -100,11 +100,20 @@ namespace m3D {
 
         typename Point<T>::list *
         search(const vector<T> &x, const SearchParameters *params, vector<T> *distances = NULL) {
+            typename Point<T>::list *result = new typename Point<T>::list();
+
+            PointListCollector<T> collector(*result);
+
+            this->search(x, params, collector);
+
+            return result;
+        };
+
+        void
+        search(const vector<T> &x, const SearchParameters *params, SearchVisitor<T> &visitor) {
             using std::cerr;
             using std::endl;
 
-            typename Point<T>::list *result = new typename Point<T>::list();
-
             // Test if a point is within the given ellipsoid
 
             // x1^2/a1^2 + .... + xn^2/an^2 <= 1
@@ -118,7 +127,7 @@ namespace m3D {
                 exit(EXIT_FAILURE);
             }
 
-            RangeSearchParams<T> *p = (RangeSearchParams<T> *) &params;
+            const RangeSearchParams<T> *p = (const RangeSearchParams<T> *) params;
 
             vector<T> coefficients(p->bandwidth);
 
@@ -135,7 +144,7 @@ namespace m3D {
 
                 float r = 0.0;
 
-                vector<T> coordinate = p->coordinate;
+                const ColumnView<T> &coordinate = p->coordinate;
 
                 for (size_t index = 0; index < coordinate.size(); index++) {
                     float dist = coordinate[index] - x[index];
@@ -144,13 +153,11 @@ namespace m3D {
                 }
 
                 if (r <= 1.0) {
-                    result->push_back(p);
+                    visitor.visit(p);
                 }
 
                 it++;
             }
-
-            return result;
         };
 
         void
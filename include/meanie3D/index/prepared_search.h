@@ -0,0 +1,132 @@
+/* The MIT License (MIT)
+ * 
+ * (c) Jürgen Simon 2014 (juergen.simon@uni-bonn.de)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef M3D_FEATURESPACE_PREPAREDSEARCH_H
+#define M3D_FEATURESPACE_PREPAREDSEARCH_H
+
+#include <meanie3D/defines.h>
+#include <meanie3D/namespaces.h>
+#include <meanie3D/featurespace/point.h>
+#include <meanie3D/index/index.h>
+#include <meanie3D/index/search_parameters.h>
+
+#include <vector>
+
+namespace m3D {
+
+    /** Handle for repeated range searches with a fixed bandwidth,
+     * obtained from PointIndex::prepare_range_search(). Results are
+     * written into caller-owned lists, which keep their capacity
+     * between calls. This base implementation simply forwards to
+     * PointIndex::search(). Indexes with a cheaper way of doing
+     * repeated searches provide their own subclass.
+     *
+     * A handle is not thread-safe, use one per thread. It must be
+     * deleted before the index it was obtained from.
+     */
+    template<typename T>
+    class PreparedRangeSearch
+    {
+    protected:
+
+        PointIndex<T> *m_index;
+
+        typename Point<T>::list *m_points;
+
+        vector<size_t> m_index_variable_indexes;
+
+        RangeSearchParams<T> m_params;
+
+    public:
+
+        /** Constructor
+         * @param index
+         * @param bandwidth
+         */
+        PreparedRangeSearch(PointIndex<T> *index, const vector<T> &bandwidth)
+                : m_index(index),
+                  m_points(index->m_points),
+                  m_index_variable_indexes(index->m_index_variable_indexes),
+                  m_params(bandwidth) {
+        };
+
+        virtual ~PreparedRangeSearch() {
+        };
+
+        /** @return bandwidth the handle was prepared with
+         */
+        const vector<T> &bandwidth() const {
+            return m_params.bandwidth;
+        };
+
+        /** Transforms a query vector into the space the index is
+         * searched in. Callers that issue the same query more than
+         * once can transform it once and use search() with the
+         * whitened flag. The base implementation is the identity.
+         *
+         * @param x query vector
+         * @param result transformed vector
+         */
+        virtual
+        void
+        whiten(const vector<T> &x, vector<T> &result) const {
+            result = x;
+        };
+
+        /** Searches the range around x.
+         *
+         * @param x query vector
+         * @param result found points (cleared first)
+         * @param distances (optional) squared distances of the found
+         * points to x, in units of the bandwidth.
+         * @param whitened if true, x has been transformed with whiten()
+         * already
+         */
+        virtual
+        void
+        search(const vector<T> &x,
+               typename Point<T>::list &result,
+               vector<T> *distances = NULL,
+               bool whitened = false) {
+            result.clear();
+            PointListCollector<T> collector(result);
+            m_index->search(x, &m_params, collector);
+
+            if (distances != NULL) {
+                const vector<T> &h = m_params.bandwidth;
+                distances->resize(result.size());
+                for (size_t n = 0; n < result.size(); n++) {
+                    T dist = 0.0;
+                    for (size_t k = 0; k < m_index_variable_indexes.size(); k++) {
+                        T d = (x[k] - result[n]->values[m_index_variable_indexes[k]]) / h[k];
+                        dist += d * d;
+                    }
+                    distances->at(n) = dist;
+                }
+            }
+        };
+    };
+}
+
+#endif
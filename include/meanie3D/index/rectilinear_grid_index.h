@@ -136,7 +136,7 @@ namespace m3D {
 
                 h = p->bandwidth;
             } else {
-                throw "RectilinearGridIndex does not support knn search at this time";
+                return this->knn_search(x, (KNNSearchParams<T> *) params, distances);
             }
 
             // spatial realm
@@ -158,6 +158,34 @@ namespace m3D {
             return result;
         }
 
+        void
+        search(const vector<T> &x, const SearchParameters *params, SearchVisitor<T> &visitor) {
+            if (params->search_type() != SearchTypeRange) {
+                // The neighbours need ranking first
+                typename Point<T>::list *result = this->knn_search(x, (KNNSearchParams<T> *) params, NULL);
+
+                for (size_t i = 0; i < result->size(); i++) {
+                    visitor.visit(result->at(i));
+                }
+
+                delete result;
+
+                return;
+            }
+
+            typename CoordinateSystem<T>::GridPoint gp = this->m_fs->coordinate_system->newGridPoint();
+
+            vector<T> x_spatial = this->m_fs->spatial_component(x);
+
+            try {
+                this->m_fs->coordinate_system->reverse_lookup(x_spatial, gp);
+
+                this->search(x, gp, ((RangeSearchParams<T> *) params)->bandwidth, visitor);
+            } catch (std::out_of_range &e) {
+                cerr << "ERROR:reverse coordinate transformation failed for coordinate=" << x_spatial << endl;
+            }
+        }
+
 #pragma mark -
 #pragma mark Public Methods (new)
 
@@ -166,14 +194,39 @@ namespace m3D {
                const typename CoordinateSystem<T>::GridPoint &gp,
                const vector<T> &h,
                vector<T> *distances = NULL) {
+            typename Point<T>::list *result = new typename Point<T>::list();
+
+            PointListCollector<T> collector(*result);
+
+            this->search(x, gp, h, collector, distances);
+
+            if (PointIndex<T>::write_index_searches) {
+                this->write_search(x, h, result);
+            }
+
+            return result;
+        }
+
+        /** Searches the box of size h around the given grid point and
+         * hands each point within range to the visitor.
+         * @param x
+         * @param grid point of x
+         * @param bandwidth
+         * @param visitor
+         * @param distances (optional)
+         */
+        void
+        search(const vector<T> &x,
+               const typename CoordinateSystem<T>::GridPoint &gp,
+               const vector<T> &h,
+               SearchVisitor<T> &visitor,
+               vector<T> *distances = NULL) {
             if (m_index == NULL) {
                 this->build_index(h);
             }
 
             // Calculate the grid points
 
-            typename Point<T>::list *result = new typename Point<T>::list();
-
             vector<size_t> lower_index_bounds(h.size(), 0);
 
             vector<size_t> upper_index_bounds(h.size(), 0);
@@ -183,34 +236,28 @@ namespace m3D {
             vector<T> resolution = cs->resolution();
 
             for (size_t i = 0; i < resolution.size(); i++) {
-                size_t num_gridpoints = h[i] / resolution[i];
+                long num_gridpoints = (long) (h[i] / resolution[i]);
 
                 // bound against underrun
 
                 lower_index_bounds[i] = ((gp[i] - num_gridpoints) <= 0)
                                         ? 0
-                                        : lower_index_bounds[i] = gp[i] - num_gridpoints;
+                                        : gp[i] - num_gridpoints;
 
                 // bound against overrun
 
-                size_t max_index = cs->dimensions()[i].getSize() - 1;
+                long max_index = cs->dimensions()[i].getSize() - 1;
 
                 upper_index_bounds[i] = ((gp[i] + num_gridpoints) >= max_index)
                                         ? max_index
-                                        : upper_index_bounds[i] = gp[i] + num_gridpoints;
+                                        : gp[i] + num_gridpoints;
             }
 
             // Start the recursion
 
             typename CoordinateSystem<T>::GridPoint gridpoint = cs->newGridPoint();
 
-            search_recursive(0, x, gridpoint, h, lower_index_bounds, upper_index_bounds, result, distances);
-
-            if (PointIndex<T>::write_index_searches) {
-                this->write_search(x, h, result);
-            }
-
-            return result;
+            search_recursive(0, x, gridpoint, h, lower_index_bounds, upper_index_bounds, visitor, distances);
         }
 
 #pragma mark
@@ -218,6 +265,96 @@ namespace m3D {
 
     protected:
 
+        /** K nearest neighbours by repeated box searches. The box
+         * starts at about one grid cell and doubles in size until the
+         * k-th closest point found lies within the radius inscribed
+         * into the box, at which point no closer points can lie outside
+         * of it. The distances returned are the squared distances in
+         * units of the search bandwidth, in ascending order.
+         *
+         * @param origin
+         * @param search parameters
+         * @param distances (optional)
+         * @return the k nearest points
+         */
+        typename Point<T>::list *
+        knn_search(const vector<T> &x, const KNNSearchParams<T> *params, vector<T> *distances) {
+            using utils::vectors::mahalabonis_distance_sqr;
+
+            typename Point<T>::list *result = new typename Point<T>::list();
+
+            const CoordinateSystem<T> *cs = this->m_fs->coordinate_system;
+
+            typename CoordinateSystem<T>::GridPoint gp = cs->newGridPoint();
+
+            try {
+                cs->reverse_lookup(this->m_fs->spatial_component(x), gp);
+            } catch (std::out_of_range &e) {
+                cerr << "ERROR:reverse coordinate transformation failed for coordinate=" << x << endl;
+                return result;
+            }
+
+            vector<T> unit = params->bandwidth.empty() ? vector<T>(x.size(), 1.0) : params->bandwidth;
+
+            vector<T> resolution = cs->resolution();
+
+            T radius = 0.0;
+
+            for (size_t i = 0; i < resolution.size(); i++) {
+                radius = std::max(radius, resolution[i] / unit[i]);
+            }
+
+            const size_t k = std::min(params->k, this->size());
+
+            vector<std::pair<T, typename Point<T>::ptr> > ranked;
+
+            typename Point<T>::list box;
+
+            while (k > 0) {
+                vector<T> h(unit.size());
+
+                for (size_t i = 0; i < h.size(); i++) {
+                    h[i] = radius * unit[i];
+                }
+
+                box.clear();
+
+                PointListCollector<T> collector(box);
+
+                this->search(x, gp, h, collector);
+
+                ranked.resize(box.size());
+
+                for (size_t i = 0; i < box.size(); i++) {
+                    typename Point<T>::ptr p = box.at(i);
+
+                    ranked[i] = std::make_pair(mahalabonis_distance_sqr(x, p->values, unit), p);
+                }
+
+                size_t found = box.size();
+
+                if (found >= k) {
+                    std::partial_sort(ranked.begin(), ranked.begin() + k, ranked.end());
+
+                    if (ranked[k - 1].first <= radius * radius || found == this->size()) {
+                        break;
+                    }
+                }
+
+                radius *= 2.0;
+            }
+
+            for (size_t i = 0; i < k; i++) {
+                result->push_back(ranked[i].second);
+
+                if (distances != NULL) {
+                    distances->push_back(ranked[i].first);
+                }
+            }
+
+            return result;
+        }
+
         void
         search_recursive(size_t dim_index,
                          const vector<T> &x,
@@ -225,13 +362,13 @@ namespace m3D {
                          const vector<T> &h,
                          const vector<size_t> &lower_index_bounds,
                          const vector<size_t> &upper_index_bounds,
-                         typename Point<T>::list *result,
+                         SearchVisitor<T> &visitor,
                          vector<T> *distances = NULL) {
             if (dim_index < (gridpoint.size() - 1)) {
                 for (size_t index = lower_index_bounds[dim_index]; index <= upper_index_bounds[dim_index]; index++) {
                     gridpoint[dim_index] = index;
 
-                    search_recursive(dim_index + 1, x, gridpoint, h, lower_index_bounds, upper_index_bounds, result,
+                    search_recursive(dim_index + 1, x, gridpoint, h, lower_index_bounds, upper_index_bounds, visitor,
                                      distances);
                 }
             } else {
@@ -259,7 +396,7 @@ namespace m3D {
                         }
 
                         if (within_range) {
-                            result->push_back(p);
+                            visitor.visit(p);
 
                             if (distances != NULL) {
                                 // fill out the spatial realm part of the dists vector
@@ -37,6 +37,50 @@ namespace m3D {
         SearchTypeRange
     } SearchType;
 
+    /** Settings controlling the trade-off between accuracy and
+     * speed of an index. The defaults give exact search results.
+     * Only the FLANN index implements approximate search, other
+     * index types ignore these settings.
+     */
+    struct index_params_t
+    {
+        // If true, the index is a forest of randomized k-d trees
+        // and searches stop after a fixed number of leaf checks.
+        // Otherwise a single k-d tree is searched exhaustively.
+        bool approximate;
+
+        // Number of randomized trees in the forest (approximate only)
+        int trees;
+
+        // Number of leaves checked per search (approximate only).
+        // Higher values are slower but closer to exact search.
+        int checks;
+
+        // Number of threads used when constructing the index and
+        // in batched searches. 0 means all available cores.
+        int threads;
+
+        // If true, the index is built such that points can be added
+        // and removed in place. Otherwise each insertion rebuilds it.
+        bool incremental;
+
+        // Incremental indexes are only rebalanced once they have grown
+        // by this factor since the last build, or lost the equivalent
+        // share of their points.
+        float rebuild_threshold;
+
+        // If true, the FLANN index keeps its copy of the points in
+        // single precision, which halves its memory for T=double.
+        // Search results may differ for points on the boundary of
+        // the search range.
+        bool single_precision;
+
+        index_params_t()
+                : approximate(false), trees(4), checks(32), threads(0),
+                  incremental(false), rebuild_threshold(2.0), single_precision(false) {
+        };
+    };
+
     class SearchParameters
     {
     private:
@@ -78,6 +122,13 @@ namespace m3D {
         size_t k;
         vector <T> resolution;
 
+        /** Per-dimension unit of the distance metric the neighbours
+         * are ranked by. Each component is divided by the respective
+         * value before the euclidean distance is taken. If empty, the
+         * components are used as they are.
+         */
+        vector <T> bandwidth;
+
         KNNSearchParams(const size_t _k)
                 : SearchParameters(SearchTypeKNN), k(_k) {
         };
@@ -86,11 +137,17 @@ namespace m3D {
                 : SearchParameters(SearchTypeKNN), k(_k), resolution(_resolution) {
         };
 
+        KNNSearchParams(const size_t _k, const vector <T> &_resolution, const vector <T> &_bandwidth)
+                : SearchParameters(SearchTypeKNN), k(_k), resolution(_resolution), bandwidth(_bandwidth) {
+        };
+
         KNNSearchParams(const KNNSearchParams &other)
                 : SearchParameters(other.search_type()) {
             k = other.k;
 
             resolution = other.resolution;
+
+            bandwidth = other.bandwidth;
         }
 
         KNNSearchParams operator=(const KNNSearchParams &other) {
@@ -0,0 +1,79 @@
+/* The MIT License (MIT)
+ * 
+ * (c) Jürgen Simon 2014 (juergen.simon@uni-bonn.de)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef M3D_SEARCH_VISITOR_H
+#define M3D_SEARCH_VISITOR_H
+
+#include <meanie3D/defines.h>
+#include <meanie3D/namespaces.h>
+#include <meanie3D/featurespace/point.h>
+
+namespace m3D {
+
+    /** Receives the results of a PointIndex search one point at a
+     * time, so that they can be consumed in place rather than being
+     * collected into a newly allocated list first.
+     *
+     * @abstract
+     */
+    template<typename T>
+    class SearchVisitor
+    {
+    public:
+
+        virtual ~SearchVisitor() {
+        };
+
+        /** Called once for each point found. The order of the points
+         * is the same as in the list returned by PointIndex::search().
+         * @param point
+         */
+        virtual
+        void
+        visit(typename Point<T>::ptr p) = 0;
+    };
+
+    /** Appends all found points to the given list. The list is
+     * not cleared.
+     */
+    template<typename T>
+    class PointListCollector : public SearchVisitor<T>
+    {
+    private:
+
+        typename Point<T>::list &m_list;
+
+    public:
+
+        PointListCollector(typename Point<T>::list &list) : m_list(list) {
+        };
+
+        void
+        visit(typename Point<T>::ptr p) {
+            m_list.push_back(p);
+        };
+    };
+}
+
+#endif
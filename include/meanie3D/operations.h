@@ -24,6 +24,7 @@
 #ifndef M3D_OPERATION_INCLUDES_H
 #define M3D_OPERATION_INCLUDES_H
 
+#include <meanie3D/operations/grid_meanshift_op.h>
 #include <meanie3D/operations/iterate_op.h>
 #include <meanie3D/operations/kernels.h>
 #include <meanie3D/operations/meanshift_op.h>
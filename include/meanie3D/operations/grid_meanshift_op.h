@@ -0,0 +1,110 @@
+/* The MIT License (MIT)
+ * 
+ * (c) Jürgen Simon 2014 (juergen.simon@uni-bonn.de)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef M3D_OPERATION_GRIDMEANSHIFTOPERATION_H
+#define M3D_OPERATION_GRIDMEANSHIFTOPERATION_H
+
+#include <meanie3D/defines.h>
+#include <meanie3D/namespaces.h>
+#include <meanie3D/operations/operation.h>
+#include <meanie3D/operations/kernels.h>
+#include <meanie3D/operations/meanshift_op.h>
+#include <meanie3D/featurespace.h>
+#include <meanie3D/array.h>
+
+#include <vector>
+
+namespace m3D {
+
+    /** Mean-shift on the regular grid without any search tree. The
+     * spatial part of the bandwidth is turned into a stencil of lattice
+     * offsets once. The sample at a point is then found by walking the
+     * stencil through an array index of the feature-space and filtering
+     * the candidates with the full (spatial and value range) bandwidth.
+     * The sample is the same as that of a range search with the same
+     * bandwidth, only the order of the sample points (and thus the order
+     * of summation) differs.
+     */
+    template<typename T>
+    class GridMeanshiftOperation : public Operation<T>
+    {
+    private:
+
+        vector<T> m_bandwidth;
+        ArrayIndex<T> *m_index;         // lattice lookup of the feature-space points
+        vector<int> m_stencil;          // offsets per spatial dimension, one row per stencil point
+        vector<long> m_stencil_offsets; // linear lattice offsets of the stencil points
+
+        /** Calculates the stencil from the spatial bandwidth
+         * and grid resolution.
+         */
+        void build_stencil();
+
+    public:
+
+#pragma mark -
+#pragma mark Constructor/Destructor
+
+        /** Constructor. Indexes the points of the feature-space
+         * by gridpoint (without copying them) and builds the stencil.
+         * @param feature-space
+         * @param bandwidth (spatial and value range)
+         */
+        GridMeanshiftOperation(FeatureSpace<T> *fs,
+                               const vector<T> &bandwidth);
+
+        virtual ~GridMeanshiftOperation();
+
+#pragma mark -
+#pragma mark Accessors
+
+        /** @return number of lattice points in the stencil
+         */
+        size_t stencil_size() const {
+            return m_stencil_offsets.size();
+        };
+
+#pragma mark -
+#pragma mark Meanshift
+
+        /** Calculates the meanshift for the points [begin,end) of the
+         * feature-space and stores shift and gridded shift in the points.
+         * Different ranges may be processed concurrently.
+         *
+         * @param index of the first point
+         * @param index one past the last point
+         * @param kernel (may be <code>NULL</code>)
+         * @param weight function (may be <code>NULL</code>)
+         * @param flag, indicating if the shift should be rounded
+         *        to the coordinate system's resolution
+         */
+        void meanshift(size_t begin,
+                       size_t end,
+                       const Kernel<T> *kernel,
+                       const WeightFunction<T> *w,
+                       const bool normalize_shift = true);
+    };
+}
+
+#endif
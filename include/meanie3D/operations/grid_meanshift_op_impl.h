@@ -0,0 +1,206 @@
+/* The MIT License (MIT)
+ * 
+ * (c) Jürgen Simon 2014 (juergen.simon@uni-bonn.de)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef M3D_OPERATION_GRIDMEANSHIFTOPERATION_IMPL_H
+#define M3D_OPERATION_GRIDMEANSHIFTOPERATION_IMPL_H
+
+#include <algorithm>
+#include <cmath>
+
+#include "grid_meanshift_op.h"
+
+namespace m3D {
+
+#pragma mark -
+#pragma mark Constructor/Destructor
+
+    template<typename T>
+    GridMeanshiftOperation<T>::GridMeanshiftOperation(FeatureSpace<T> *fs,
+                                                      const vector<T> &bandwidth)
+            : Operation<T>(fs, NULL), m_bandwidth(bandwidth), m_index(NULL) {
+        m_index = new ArrayIndex<T>(fs->spatial_rank(), fs->points, false);
+        this->build_stencil();
+    }
+
+    template<typename T>
+    GridMeanshiftOperation<T>::~GridMeanshiftOperation() {
+        if (m_index != NULL) {
+            delete m_index;
+            m_index = NULL;
+        }
+    }
+
+#pragma mark -
+#pragma mark Stencil
+
+    template<typename T>
+    void
+    GridMeanshiftOperation<T>::build_stencil() {
+        const size_t spatial_rank = this->feature_space->spatial_rank();
+        const vector<T> &resolution = this->feature_space->coordinate_system->resolution();
+        const vector<size_t> &strides = m_index->strides();
+
+        // Half width of the stencil box in grid points. One extra grid
+        // point on each side tolerates slightly irregular coordinates,
+        // the exact test is done on the coordinates later.
+        vector<int> half_width(spatial_rank, 0);
+        for (size_t d = 0; d < spatial_rank; d++) {
+            if (m_bandwidth[d] > 0) {
+                half_width[d] = ((int) floor(m_bandwidth[d] / fabs(resolution[d]))) + 1;
+            }
+        }
+
+        m_stencil.clear();
+        m_stencil_offsets.clear();
+
+        vector<int> delta(spatial_rank);
+        for (size_t d = 0; d < spatial_rank; d++) {
+            delta[d] = -half_width[d];
+        }
+
+        while (true) {
+            // Keep the box point if it can possibly be within the
+            // bandwidth ellipsoid (measured to the nearest corner
+            // of the tolerance margin)
+            T dist = 0.0;
+            for (size_t d = 0; d < spatial_rank; d++) {
+                if (m_bandwidth[d] > 0) {
+                    T r = std::max(abs(delta[d]) - 1, 0) * fabs(resolution[d]) / m_bandwidth[d];
+                    dist += r * r;
+                }
+            }
+            if (dist <= 1.0) {
+                long offset = 0;
+                for (size_t d = 0; d < spatial_rank; d++) {
+                    m_stencil.push_back(delta[d]);
+                    offset += delta[d] * ((long) strides[d]);
+                }
+                m_stencil_offsets.push_back(offset);
+            }
+
+            // next box point (last dimension runs fastest)
+            int d = ((int) spatial_rank) - 1;
+            while (d >= 0 && delta[d] == half_width[d]) {
+                delta[d] = -half_width[d];
+                d--;
+            }
+            if (d < 0) {
+                break;
+            }
+            delta[d]++;
+        }
+    }
+
+#pragma mark -
+#pragma mark Meanshift
+
+    template<typename T>
+    void
+    GridMeanshiftOperation<T>::meanshift(size_t begin,
+                                         size_t end,
+                                         const Kernel<T> *kernel,
+                                         const WeightFunction<T> *w,
+                                         const bool normalize_shift) {
+        const CoordinateSystem<T> *cs = this->feature_space->coordinate_system;
+        const size_t dim = this->feature_space->rank();
+        const size_t spatial_dim = this->feature_space->spatial_rank();
+        const vector<size_t> &dims = m_index->dimensions();
+        const vector<int> &origin = m_index->origin();
+        const vector<T> &h = m_bandwidth;
+        const size_t stencil_size = m_stencil_offsets.size();
+
+        vector<T> x(dim);
+        vector<T> shift(dim);
+        typename Point<T>::list sample;
+        typename MeanshiftOperation<T>::batch_buffer_t buffer;
+
+        for (size_t pi = begin; pi < end; pi++) {
+            typename Point<T>::ptr p = this->feature_space->points[pi];
+            const ColumnView<int> &gp = p->gridpoint;
+            const size_t center = m_index->linear_index(gp);
+            x.assign(p->values.begin(), p->values.end());
+
+            std::fill(shift.begin(), shift.end(), 0.0);
+            sample.clear();
+
+            for (size_t s = 0; s < stencil_size; s++) {
+                // stay inside the box covered by the index
+                const int *delta = &m_stencil[s * spatial_dim];
+                bool inside = true;
+                for (size_t d = 0; d < spatial_dim && inside; d++) {
+                    int g = gp[d] - origin[d] + delta[d];
+                    inside = (g >= 0 && g < (int) dims[d]);
+                }
+                if (!inside) {
+                    continue;
+                }
+
+                typename Point<T>::ptr n = m_index->get(center + m_stencil_offsets[s]);
+                if (n == NULL) {
+                    continue;
+                }
+
+                // Filter with the full bandwidth. This is the range
+                // criterion of the whitened index search
+                T dist = 0.0;
+                for (size_t k = 0; k < dim; k++) {
+                    if (h[k] > 0) {
+                        T d = x[k] - n->values[k];
+                        dist += d * d / (h[k] * h[k]);
+                    }
+                }
+                if (dist <= 1.0) {
+                    sample.push_back(n);
+                }
+            }
+
+            if (!sample.empty()) {
+                const size_t size = sample.size();
+                buffer.lanes.resize(dim * size);
+                buffer.weights.resize(size);
+                for (size_t j = 0; j < size; j++) {
+                    const ColumnView<T> &values = sample[j]->values;
+                    for (size_t i = 0; i < dim; i++) {
+                        buffer.lanes[i * size + j] = values[i];
+                    }
+                    buffer.weights[j] = (w == NULL) ? 1.0 : w->operator()(sample[j]);
+                }
+
+                T denominator = MeanshiftOperation<T>::accumulate(kernel, x, h, size, buffer);
+                const vector<T> &numerator = buffer.numerator;
+                for (size_t i = 0; i < dim; i++) {
+                    shift[i] = numerator[i] / denominator - x[i];
+                }
+                if (normalize_shift) {
+                    shift = cs->round_to_grid(shift);
+                }
+            }
+
+            p->shift = shift;
+            p->gridded_shift = cs->to_gridpoints(this->feature_space->spatial_component(shift));
+        }
+    }
+}
+
+#endif
@@ -27,6 +27,7 @@
 #include <meanie3D/defines.h>
 #include <meanie3D/namespaces.h>
 
+#include <cmath>
 #include <vector>
 
 namespace m3D {
@@ -70,6 +71,14 @@ namespace m3D {
          * the kernel shape around an arbitrary point.
          */
         virtual T apply(const T dist) const = 0;
+
+        /** Non-virtual form of apply(dist). The concrete kernels
+         * hide this with an inline version, so that code templated
+         * on the kernel type does not pay for virtual dispatch.
+         */
+        inline T profile(const T dist) const {
+            return this->apply(dist);
+        }
     };
 
     /** Gaussian normal kernel 
@@ -92,6 +101,10 @@ namespace m3D {
 
         T apply(const T dist) const;
 
+        inline T profile(const T dist) const {
+            return 0.5 * exp(-0.5 * dist);
+        }
+
     };
 
     /** Epanechniov Kernel 
@@ -114,6 +127,10 @@ namespace m3D {
 
         T apply(const T dist) const;
 
+        inline T profile(const T dist) const {
+            return (dist <= this->m_kernelSize ? this->m_kernelSize - dist : 0);
+        }
+
     };
 
     /** Uniform Kernel 
@@ -132,6 +149,10 @@ namespace m3D {
         T apply(const vector <T> &c) const;
 
         T apply(const T dist) const;
+
+        inline T profile(const T dist) const {
+            return (fabs(dist) <= this->m_kernelSize) ? 1.0f / this->m_kernelSize : 0;
+        }
     };
 }
 
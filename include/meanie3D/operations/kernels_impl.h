@@ -41,7 +41,7 @@ namespace m3D {
 
     template<class T>
     T GaussianNormalKernel<T>::apply(const T dist) const {
-        return 0.5 * exp(-0.5 * dist);
+        return this->profile(dist);
     }
 
     template<class T>
@@ -53,7 +53,7 @@ namespace m3D {
 
     template<class T>
     T EpanechnikovKernel<T>::apply(const T dist) const {
-        return (dist <= this->m_kernelSize ? this->m_kernelSize - dist : 0);
+        return this->profile(dist);
     }
 
     template<class T>
@@ -65,7 +65,7 @@ namespace m3D {
 
     template<class T>
     T UniformKernel<T>::apply(const T dist) const {
-        return (fabs(dist) <= this->m_kernelSize) ? 1.0f / this->m_kernelSize : 0;
+        return this->profile(dist);
     }
 
     template<class T>
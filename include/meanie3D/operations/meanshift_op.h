@@ -29,6 +29,7 @@
 #include <meanie3D/operations.h>
 #include <meanie3D/featurespace.h>
 #include <meanie3D/index.h>
+#include <meanie3D/utils/compensated_sum.h>
 
 #include <vector>
 
@@ -39,6 +40,22 @@ namespace m3D {
     {
     public:
 
+        /** Re-usable storage for batched meanshift calculations. Each
+         * thread should own one instance and hand it to every call of
+         * the batched meanshift method, so that sample lists, accumulator
+         * and result vectors are allocated only once.
+         */
+        typedef struct
+        {
+            vector<vector<T> > queries;                 // query vectors of the current block
+            vector<typename Point<T>::list> samples;    // search results per query
+            vector<vector<T> > shifts;                  // resulting meanshift vectors
+            vector<T> numerator;                        // accumulator
+            vector<T> lanes;                            // gathered sample values, one lane per dimension
+            vector<T> weights;                          // per sample weights
+            vector<T> distances;                        // per sample kernel distances
+        } batch_buffer_t;
+
         //static const int NO_WEIGHT;
 
         MeanshiftOperation(FeatureSpace<T> *fs,
@@ -49,12 +66,42 @@ namespace m3D {
         }
 
 
+        /** Accumulates numerator and denominator of the meanshift
+         * from a sample that has been gathered into the buffer: the
+         * value of dimension i of sample n at lanes[i * size + n] and
+         * the weight function response of sample n at weights[n]
+         * (1 if there is none). The kernel type is resolved once per
+         * call, and each step is a flat loop over the lanes without
+         * virtual calls or temporaries, which the compiler can
+         * vectorize. Results are identical to the per-sample loop.
+         *
+         * @param kernel (may be <code>NULL</code>)
+         * @param origin x
+         * @param bandwidth
+         * @param number of samples
+         * @param buffer (numerator is written here)
+         * @return denominator
+         */
+        static T
+        accumulate(const Kernel<T> *kernel,
+                   const vector<T> &x,
+                   const vector<T> &h,
+                   size_t size,
+                   batch_buffer_t &buffer);
+
         /** Call this up-front to preempt lazy index construction.
          * @param search parameters
          */
         void prime_index(const SearchParameters *params);
 
-        /** Meanshift calculation at point x. Sample is done by range search. 
+        /** Meanshift calculation at point x. The sample is obtained by
+         * range search, using the fixed bandwidth of the parameters, or by
+         * k nearest neighbours search. In the latter case the bandwidth
+         * varies from point to point: the parameters' bandwidth (or 1 in
+         * every dimension, if there is none) is stretched such that the
+         * farthest of the k neighbours of x lies on the kernel's rim.
+         * Dense regions are thus sampled with a narrow kernel, sparse
+         * regions with a wide one.
          * {@see SampleOperation::sample_range}
          * 
          * @param feature space coordinate x (origin)
@@ -71,6 +118,85 @@ namespace m3D {
                   const Kernel<T> *kernel = new GaussianNormalKernel<T>(),
                   const WeightFunction<T> *w = NULL,
                   const bool normalize_shift = true);
+
+        /** Batched meanshift calculation for the points [begin,end) of
+         * the given list. The samples for the whole block are obtained
+         * with a single index query. The result for each point is identical
+         * to calling meanshift() on the point's values. After the call,
+         * buffer.shifts[i] contains the meanshift vector for points[begin+i].
+         *
+         * @param point list
+         * @param index of the first point in the block
+         * @param index one past the last point in the block
+         * @param search parameters (range or knn search)
+         * @param kernel
+         * @param weight function
+         * @param per-thread buffer
+         * @param flag, indicating if the returned vectors should be rounded
+         *        to the coordinate system's resolution
+         */
+        void
+        meanshift(const typename Point<T>::list &points,
+                  size_t begin,
+                  size_t end,
+                  const SearchParameters *params,
+                  const Kernel<T> *kernel,
+                  const WeightFunction<T> *w,
+                  batch_buffer_t &buffer,
+                  const bool normalize_shift = true);
+
+    private:
+
+        /** Accumulates numerator and denominator of the meanshift
+         * while the index search visits the sample, so that the
+         * sample need not be collected into a list first.
+         */
+        class SampleAccumulator : public SearchVisitor<T>
+        {
+        public:
+
+            const vector<T> &x;
+            const vector<T> *h;
+            const Kernel<T> *kernel;
+            const WeightFunction<T> *w;
+
+            vector<utils::CompensatedSum<T> > numerator;
+            utils::CompensatedSum<T> denominator;
+            size_t count;
+
+            SampleAccumulator(const vector<T> &origin,
+                              const Kernel<T> *k,
+                              const WeightFunction<T> *weight_function)
+                    : x(origin), h(NULL), kernel(k), w(weight_function),
+                      numerator(origin.size()), count(0) {
+            };
+
+            void
+            visit(typename Point<T>::ptr p);
+        };
+
+        /** Calculates the adaptive bandwidth for a k nearest neighbours
+         * sample, that has been gathered into the buffer's lanes.
+         *
+         * @param origin x
+         * @param search parameters
+         * @param number of samples
+         * @param buffer (distances are used as scratch space)
+         * @param bandwidth (result)
+         */
+        static void
+        adaptive_bandwidth(const vector<T> &x,
+                           const KNNSearchParams<T> *params,
+                           size_t size,
+                           batch_buffer_t &buffer,
+                           vector<T> &h);
+
+        /** Multiplies the weights with the kernel profile at
+         * the sample distances.
+         */
+        template<class K>
+        static void
+        apply_profile(const K *kernel, size_t size, batch_buffer_t &buffer);
     };
 }
 
@@ -24,20 +24,164 @@
 #ifndef M3D_OPERATION_MEANSHIFTOPERATION_IMPL_H
 #define M3D_OPERATION_MEANSHIFTOPERATION_IMPL_H
 
+#include <algorithm>
 #include <stdexcept>
 #include <cmath>
 #include <netcdf>
 
+#include <meanie3D/utils/compensated_sum.h>
+
 #include "meanshift_op.h"
 
 namespace m3D {
 
+#pragma mark -
+#pragma mark Accumulation
+
+    template<typename T>
+    template<class K>
+    void
+    MeanshiftOperation<T>::apply_profile(const K *kernel, size_t size, batch_buffer_t &buffer) {
+        T *weights = &buffer.weights[0];
+        const T *distances = &buffer.distances[0];
+        for (size_t n = 0; n < size; n++) {
+            weights[n] = kernel->K::profile(distances[n]) * weights[n];
+        }
+    }
+
+    template<typename T>
+    T
+    MeanshiftOperation<T>::accumulate(const Kernel<T> *kernel,
+                                      const vector<T> &x,
+                                      const vector<T> &h,
+                                      size_t size,
+                                      batch_buffer_t &buffer) {
+        const size_t dim = x.size();
+        buffer.numerator.resize(dim);
+        if (size == 0) {
+            std::fill(buffer.numerator.begin(), buffer.numerator.end(), 0.0);
+            return 0.0;
+        }
+
+        if (kernel != NULL) {
+            // Squared mahalanobis distances, one dimension at a time
+            buffer.distances.assign(size, 0.0);
+            T *distances = &buffer.distances[0];
+            for (size_t k = 0; k < dim; k++) {
+                if (h[k] > 0) {
+                    const T xk = x[k];
+                    const T hk = h[k] * h[k];
+                    const T *lane = &buffer.lanes[k * size];
+                    for (size_t n = 0; n < size; n++) {
+                        distances[n] += (xk - lane[n]) * (xk - lane[n]) / hk;
+                    }
+                }
+            }
+
+            // Resolve the kernel type once for the whole sample
+            if (const GaussianNormalKernel<T> *g = dynamic_cast<const GaussianNormalKernel<T> *>(kernel)) {
+                apply_profile(g, size, buffer);
+            } else if (const EpanechnikovKernel<T> *e = dynamic_cast<const EpanechnikovKernel<T> *>(kernel)) {
+                apply_profile(e, size, buffer);
+            } else if (const UniformKernel<T> *u = dynamic_cast<const UniformKernel<T> *>(kernel)) {
+                apply_profile(u, size, buffer);
+            } else {
+                apply_profile(kernel, size, buffer);
+            }
+        }
+
+        // The sums run in sample order, as in the per-sample loop.
+        // In single precision they are compensated, which keeps the
+        // results close to double precision ones for large samples.
+        // Double precision sums are plain and unchanged.
+        const T *weights = &buffer.weights[0];
+        utils::CompensatedSum<T> denominator;
+        for (size_t n = 0; n < size; n++) {
+            denominator += weights[n];
+        }
+        for (size_t i = 0; i < dim; i++) {
+            const T *lane = &buffer.lanes[i * size];
+            utils::CompensatedSum<T> sum;
+            for (size_t n = 0; n < size; n++) {
+                sum += weights[n] * lane[n];
+            }
+            buffer.numerator[i] = sum.value();
+        }
+        return denominator.value();
+    }
+
+    template<typename T>
+    void
+    MeanshiftOperation<T>::adaptive_bandwidth(const vector<T> &x,
+                                              const KNNSearchParams<T> *params,
+                                              size_t size,
+                                              batch_buffer_t &buffer,
+                                              vector<T> &h) {
+        const size_t dim = x.size();
+        h.assign(dim, 1.0);
+        if (!params->bandwidth.empty()) {
+            h = params->bandwidth;
+        }
+
+        // Squared distances in units of the bandwidth. Components
+        // with zero bandwidth are ignored, as in accumulate()
+        buffer.distances.assign(size, 0.0);
+        T *distances = &buffer.distances[0];
+        for (size_t k = 0; k < dim; k++) {
+            if (h[k] > 0) {
+                const T xk = x[k];
+                const T hk = h[k] * h[k];
+                const T *lane = &buffer.lanes[k * size];
+                for (size_t n = 0; n < size; n++) {
+                    distances[n] += (xk - lane[n]) * (xk - lane[n]) / hk;
+                }
+            }
+        }
+
+        T radius_sqr = 0.0;
+        for (size_t n = 0; n < size; n++) {
+            radius_sqr = std::max(radius_sqr, distances[n]);
+        }
+
+        // All neighbours on top of x: any bandwidth will do
+        if (radius_sqr > 0) {
+            const T radius = sqrt(radius_sqr);
+            for (size_t k = 0; k < dim; k++) {
+                h[k] *= radius;
+            }
+        }
+    }
+
+#pragma mark -
+#pragma mark Meanshift
+
+    template<typename T>
+    void
+    MeanshiftOperation<T>::SampleAccumulator::visit(typename Point<T>::ptr p) {
+        using namespace utils::vectors;
+
+        T weight = 1.0;
+        if (kernel != NULL) {
+            weight = kernel->apply(mahalabonis_distance_sqr(x, p->values, *h));
+        }
+        if (w != NULL) {
+            weight *= w->operator()(p);
+        }
+        const ColumnView<T> &values = p->values;
+        denominator += weight;
+        for (size_t i = 0; i < numerator.size(); i++) {
+            numerator[i] += weight * values[i];
+        }
+        count++;
+    }
+
     template<typename T>
     void
     MeanshiftOperation<T>::prime_index(const SearchParameters *params) {
         vector<T> x(this->feature_space->rank());
-        typename Point<T>::list *sample = this->point_index->search(x, params, NULL);
-        delete sample;
+        typename Point<T>::list sample;
+        PointListCollector<T> collector(sample);
+        this->point_index->search(x, params, collector);
     }
 
     template<typename T>
@@ -49,76 +193,131 @@ namespace m3D {
                                      const bool normalize_shift) {
         using namespace utils::vectors;
 
-        // Distances are only used in the KNN case.
-        vector<T> distances;
-        typename Point<T>::list *sample = NULL;
+        const size_t dim = this->feature_space->dimension;
+        vector<T> shift(dim, 0.0);
+        SampleAccumulator sample(x, kernel, w);
+
+        vector<T> h;
         if (params->search_type() == SearchTypeRange) {
-            sample = this->point_index->search(x, params, NULL);
+            // The bandwidth is known up-front, accumulate
+            // while the index visits the sample
+            h = ((RangeSearchParams<T> *) params)->bandwidth;
+            sample.h = &h;
+            this->point_index->search(x, params, sample);
         } else {
-            sample = this->point_index->search(x, params, &distances);
+            // KNN: the bandwidth at x is stretched until the
+            // farthest of the k neighbours lies on its rim,
+            // which requires the whole sample first
+            typename Point<T>::list neighbours;
+            PointListCollector<T> collector(neighbours);
+            this->point_index->search(x, params, collector);
+
+            const KNNSearchParams<T> *p = (const KNNSearchParams<T> *) params;
+            h = p->bandwidth.empty() ? vector<T>(x.size(), 1.0) : p->bandwidth;
+            T radius_sqr = 0.0;
+            for (size_t index = 0; index < neighbours.size(); index++) {
+                radius_sqr = std::max(radius_sqr, mahalabonis_distance_sqr(x, neighbours[index]->values, h));
+            }
+            if (radius_sqr > 0) {
+                h = ((T) sqrt(radius_sqr)) * h;
+            }
+
+            sample.h = &h;
+            for (size_t index = 0; index < neighbours.size(); index++) {
+                sample.visit(neighbours[index]);
+            }
         }
-        vector<T> shift(this->feature_space->dimension, 0.0);
 
         // If the sample is empty, no shift can be calculated.
         // Returns a shift of 0
-        if (sample->size() == 0) {
+        if (sample.count == 0) {
             return shift;
         }
 
-        vector<T> numerator(this->feature_space->dimension);
-        T denominator = 0.0;
-        size_t size = sample->size();
-
-        // Range Search
-        if (params->search_type() == SearchTypeRange) {
-            vector<T> h = ((RangeSearchParams<T> *) params)->bandwidth;
-            if (w == NULL && kernel != NULL) {
-                // No weight function
-                for (size_t index = 0; index < size; index++) {
-                    T weight = kernel->apply(mahalabonis_distance_sqr(x, sample->at(index)->values, h));
-                    denominator += weight;
-                    numerator += weight * sample->at(index)->values;
-                }
-            } else if (w != NULL && kernel == NULL) {
-                // no kernel
-                for (size_t index = 0; index < size; index++) {
-                    T weight = w->operator()(sample->at(index));
-                    denominator += weight;
-                    numerator += weight * sample->at(index)->values;
-                }
-            } else if (kernel == NULL && w == NULL) {
-                // no weight function AND no kernel
-                for (size_t index = 0; index < size; index++) {
-                    denominator += 1.0;
-                    numerator += sample->at(index)->values;
-                }
-            } else {
-                // Both weight function and kernel
-                vector<T> mult(x.size(), 0.0);
-                for (size_t index = 0; index < size; index++) {
-                    T var_weight = w->operator()(sample->at(index));
-                    T kernel_weight = kernel->apply(mahalabonis_distance_sqr(x, sample->at(index)->values, h));
-                    T weight = kernel_weight * var_weight;
-                    denominator += weight;
-                    for (int i = 0; i < x.size(); i++) {
-                        numerator[i] += (weight * sample->at(index)->values[i]);
-                    }
-                }
-            }
-        }            // KNN
-        else {
-            throw "Not Implemented";
+        for (size_t i = 0; i < dim; i++) {
+            shift[i] = sample.numerator[i].value() / sample.denominator.value() - x[i];
         }
-
-        vector<T> dx = numerator / denominator;
-        shift = dx - x;
-        delete sample;
         if (normalize_shift) {
             shift = this->feature_space->coordinate_system->round_to_grid(shift);
         }
 
         return shift;
     }
+
+    template<typename T>
+    void
+    MeanshiftOperation<T>::meanshift(const typename Point<T>::list &points,
+                                     size_t begin,
+                                     size_t end,
+                                     const SearchParameters *params,
+                                     const Kernel<T> *kernel,
+                                     const WeightFunction<T> *w,
+                                     batch_buffer_t &buffer,
+                                     const bool normalize_shift) {
+        using namespace utils::vectors;
+
+        const size_t count = end - begin;
+        const size_t dim = this->feature_space->dimension;
+        const bool is_knn = (params->search_type() == SearchTypeKNN);
+        vector<T> h;
+        if (!is_knn) {
+            h = ((RangeSearchParams<T> *) params)->bandwidth;
+        }
+
+        // Collect the query vectors from the value columns.
+        // Assignment re-uses the capacity of the buffer's vectors
+
+        buffer.queries.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            const ColumnView<T> &values = points[begin + i]->values;
+            buffer.queries[i].assign(values.begin(), values.end());
+        }
+
+        // One index query for the whole block
+
+        this->point_index->batch_search(buffer.queries, params, buffer.samples);
+
+        buffer.shifts.resize(count);
+
+        for (size_t qi = 0; qi < count; qi++) {
+            const vector<T> &x = buffer.queries[qi];
+            const typename Point<T>::list &sample = buffer.samples[qi];
+            vector<T> &shift = buffer.shifts[qi];
+            shift.assign(dim, 0.0);
+
+            // If the sample is empty, no shift can be calculated.
+            if (sample.empty()) {
+                continue;
+            }
+
+            // Gather the sample into lanes
+            const size_t size = sample.size();
+            buffer.lanes.resize(dim * size);
+            buffer.weights.resize(size);
+            for (size_t n = 0; n < size; n++) {
+                const ColumnView<T> &values = sample[n]->values;
+                for (size_t i = 0; i < dim; i++) {
+                    buffer.lanes[i * size + n] = values[i];
+                }
+                buffer.weights[n] = (w == NULL) ? 1.0 : w->operator()(sample[n]);
+            }
+
+            if (is_knn) {
+                adaptive_bandwidth(x, (const KNNSearchParams<T> *) params, size, buffer, h);
+            }
+
+            T denominator = accumulate(kernel, x, h, size, buffer);
+            const vector<T> &numerator = buffer.numerator;
+
+            for (size_t i = 0; i < dim; i++) {
+                shift[i] = numerator[i] / denominator - x[i];
+            }
+
+            if (normalize_shift) {
+                shift = this->feature_space->coordinate_system->round_to_grid(shift);
+            }
+        }
+    }
 }
 
 #endif
@@ -129,20 +129,19 @@ namespace m3D {
             std::string line;
             while (getline(f, line)) {
                 // values
-                typename Point<T>::ptr p = PointFactory<T>::get_instance()->create();
-                p->values = from_string<T>(line);
+                vector<T> values = from_string<T>(line);
 
                 // grid point
                 if (!getline(f, line)) {
                     cerr << "FATAL:failed to read line from " << m_filename << endl;
                     exit(EXIT_FAILURE);
                 }
-                p->gridpoint = from_string<int>(line);
+                vector<int> gridpoint = from_string<int>(line);
 
                 // reconstruct coordinate from spatial range
-                p->coordinate = std::vector<T>(p->values.begin(),
-                                               p->values.begin() + p->gridpoint.size());
+                vector<T> coordinate(values.begin(), values.begin() + gridpoint.size());
 
+                typename Point<T>::ptr p = PointFactory<T>::get_instance()->create(gridpoint, coordinate, values);
                 this->add_point(p);
             }
         }
@@ -96,6 +96,7 @@ namespace m3D {
             typename ClusterList<T>::ptr previous; // current cluster list
             size_t N, M;                     // Shortcuts for lenghts of previous and current lists.
             const CoordinateSystem<T> *cs;  // Coordinate system (for transformations)
+            bool owns_cs;                   // Indicates if cs was created by the run
             LinearIndexMapping mapping;     // maps i <-> (n,m)
 
             m3D::id_t highestId;        // Stores the highest used ID
@@ -154,13 +155,19 @@ namespace m3D {
          */
         Tracking(tracking_param_t params) : m_params(params) {};
 
+        virtual ~Tracking() {};
+
         /**
          * Runs the meanie3D tracking algorithm.
          * @param current
          * @param previous
+         * @param coordinate system (optional). If omitted, the coordinate
+         * system is constructed from the cluster files. Passing one in
+         * allows tracking cluster lists that were never written to disk.
          */
         void track(typename ClusterList<T>::ptr previous,
-                   typename ClusterList<T>::ptr current);
+                   typename ClusterList<T>::ptr current,
+                   const CoordinateSystem<T> *cs = NULL);
 
     protected:
 
@@ -181,6 +188,20 @@ namespace m3D {
          */
         bool initialise(typename Tracking<T>::tracking_run_t &run);
 
+        /**
+         * Finds the pairs of current and previous clusters, whose
+         * geometrical centers are within the maximum displacement
+         * of each other, by hashing the previous centers into a grid.
+         * Virtual, so that the pruning can be compared with scoring
+         * all pairs.
+         * @param run
+         * @param candidates flag matrix (N x M), set to 1 for each pair
+         * within range
+         */
+        virtual
+        void findCandidates(typename Tracking<T>::tracking_run_t &run,
+                            typename SimpleMatrix<T>::flag_matrix_t &candidates);
+
         /**
          * Calculates data to base match probabilities on.
          * @param run
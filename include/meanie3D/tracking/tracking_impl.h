@@ -33,9 +33,13 @@
 
 #include <algorithm>
 #include <boost/bind.hpp>
+#include <cmath>
 #include <math.h>
 #include <netcdf>
+#include <map>
 #include <set>
+#include <sstream>
+#include <stdexcept>
 #include <utility>
 #include <vector>
 
@@ -105,7 +109,6 @@ namespace m3D {
     Tracking<T>::initialise(typename Tracking<T>::tracking_run_t &run) {
         bool skip_tracking = false;
         bool logDetails = m_params.verbosity >= VerbosityDetails;
-        run.cs = NULL;
 
         if (logDetails) {
             cout << endl;
@@ -120,11 +123,11 @@ namespace m3D {
 
         // Check if the feature variables match
         if (run.previous->variables != run.current->variables) {
-            cerr << "FATAL:Incompatible feature variables in the cluster files:"
-                 << " previous:" << run.previous->variables
-                 << " current:" << run.current->variables
-                 << endl;
-            exit(EXIT_FAILURE);
+            std::ostringstream message;
+            message << "Incompatible feature variables in the cluster files:"
+                    << " previous:" << run.previous->variables
+                    << " current:" << run.current->variables;
+            throw std::runtime_error(message.str());
         }
 
         run.N = run.current->clusters.size();
@@ -164,9 +167,12 @@ namespace m3D {
 
         if (!skip_tracking) {
 
-            run.cs = new CoordinateSystem<T>(infoFile,
-                                             run.current->dimensions,
-                                             run.current->dimension_variables);
+            if (run.cs == NULL) {
+                run.cs = new CoordinateSystem<T>(infoFile,
+                                                 run.current->dimensions,
+                                                 run.current->dimension_variables);
+                run.owns_cs = true;
+            }
 
             // Check cluster sizes
             for (size_t i = 0; i < run.M; i++) {
@@ -203,9 +209,10 @@ namespace m3D {
                     }
                 }
                 if (!found_tracking_var) {
-                    cerr << "FATAL:tracking variable " << m_params.tracking_variable
-                         << " is not part of the feature variables" << endl;
-                    exit(EXIT_FAILURE);
+                    std::ostringstream message;
+                    message << "tracking variable " << m_params.tracking_variable
+                            << " is not part of the feature variables";
+                    throw std::runtime_error(message.str());
                 }
             }
 
@@ -275,6 +282,101 @@ namespace m3D {
 #pragma mark -
 #pragma mark Matching
 
+    template<typename T>
+    void
+    Tracking<T>::findCandidates(typename Tracking<T>::tracking_run_t &run,
+                                typename SimpleMatrix<T>::flag_matrix_t &candidates) {
+        candidates = SimpleMatrix<T>::create_flag_matrix(run.N, run.M, 0);
+
+        // Geometrical centers are cached by the clusters on first
+        // use. Each cluster is touched by one thread only.
+#if WITH_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (size_t n = 0; n < run.N; n++) {
+            run.current->clusters[n]->geometrical_center();
+        }
+#if WITH_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (size_t m = 0; m < run.M; m++) {
+            run.previous->clusters[m]->geometrical_center();
+        }
+
+        // Allow for some rounding, the exact displacement is checked
+        // on the candidates later
+        T radius = run.maxDisplacement.get() * (1.0 + 1.0e-6);
+        if (!(radius > 0) || !std::isfinite(radius)) {
+            candidates = SimpleMatrix<T>::create_flag_matrix(run.N, run.M, 1);
+            return;
+        }
+
+        // Hash the previous centers into a grid with cells of the
+        // search radius. All centers within range of a point are
+        // then found in the adjacent cells.
+        typedef vector<long> cell_t;
+        typedef map<cell_t, vector<size_t> > grid_t;
+        grid_t grid;
+        size_t rank = run.cs->rank();
+        vector<vector<T> > previous_centers(run.M);
+        for (size_t m = 0; m < run.M; m++) {
+            previous_centers[m] = run.cs->to_meters(run.previous->clusters[m]->geometrical_center());
+            cell_t cell(rank);
+            for (size_t d = 0; d < rank; d++) {
+                cell[d] = (long) floor(previous_centers[m][d] / radius);
+            }
+            grid[cell].push_back(m);
+        }
+
+        T radius_squared = radius * radius;
+
+#if WITH_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (size_t n = 0; n < run.N; n++) {
+            vector<T> center = run.cs->to_meters(run.current->clusters[n]->geometrical_center());
+            cell_t origin(rank), cell(rank);
+            for (size_t d = 0; d < rank; d++) {
+                origin[d] = (long) floor(center[d] / radius);
+            }
+
+            // visit the 3^rank neighbouring cells
+            vector<int> offset(rank, -1);
+            bool done = false;
+            while (!done) {
+                for (size_t d = 0; d < rank; d++) {
+                    cell[d] = origin[d] + offset[d];
+                }
+                typename grid_t::const_iterator gi = grid.find(cell);
+                if (gi != grid.end()) {
+                    const vector<size_t> &members = gi->second;
+                    for (size_t k = 0; k < members.size(); k++) {
+                        size_t m = members[k];
+                        T dist_squared = 0;
+                        for (size_t d = 0; d < rank; d++) {
+                            T dx = center[d] - previous_centers[m][d];
+                            dist_squared += dx * dx;
+                        }
+                        if (dist_squared <= radius_squared) {
+                            candidates[n][m] = 1;
+                        }
+                    }
+                }
+
+                size_t d = 0;
+                while (d < rank && offset[d] == 1) {
+                    offset[d] = -1;
+                    d++;
+                }
+                if (d == rank) {
+                    done = true;
+                } else {
+                    offset[d]++;
+                }
+            }
+        }
+    }
+
     template<typename T>
     void
     Tracking<T>::calculateCorrelationData(typename Tracking<T>::tracking_run_t &run) {
@@ -295,6 +397,12 @@ namespace m3D {
         run.maxSizeDifference = numeric_limits<int>::min();
         run.maxMidDisplacement = ::units::values::m(numeric_limits<T>::min());
 
+        // Only pairs, which are within reach at maximum velocity
+        // are scored. Everything else violates the max velocity
+        // constraint anyway.
+        typename SimpleMatrix<T>::flag_matrix_t candidates;
+        findCandidates(run, candidates);
+
         // Index the cluster lists for quick overlap calculations
 
         // need to label the clusters with a unique id before we
@@ -305,133 +413,265 @@ namespace m3D {
         ClusterIndex<T> index_c(run.current->clusters, run.cs->get_dimension_sizes());
         ClusterIndex<T> index_p(run.previous->clusters, run.cs->get_dimension_sizes());
 
-        // Employ a mapping to parallelize
+        // Count the shared gridpoints of all pairs in one pass over
+        // the label grids. Only overlapping pairs show up in the table,
+        // all others keep their coverage of 0.
+        typename ClusterIndex<T>::intersection_table_t overlaps;
+        ClusterIndex<T>::intersection_counts(index_c, index_p, overlaps);
 
-        for (size_t idx = 0; idx < run.mapping.size(); idx++) {
-            vector<int> index_pair = run.mapping.linear_to_grid(idx);
+        // the previous clusters are labeled by their original ids
+        map<m3D::id_t, vector<size_t> > previous_by_id;
+        for (size_t m = 0; m < run.M; m++) {
+            previous_by_id[run.previous->clusters[m]->id].push_back(m);
+        }
 
-            int n = index_pair[0];
-            int m = index_pair[1];
+        typename ClusterIndex<T>::intersection_table_t::const_iterator ri;
+        for (ri = overlaps.begin(); ri != overlaps.end(); ++ri) {
+            size_t n = ri->first;
+            typename Cluster<T>::ptr c = run.current->clusters[n];
+            typename ClusterIndex<T>::id_count_t::const_iterator ci;
+            for (ci = ri->second.begin(); ci != ri->second.end(); ++ci) {
+                const vector<size_t> &ms = previous_by_id[ci->first];
+                for (size_t k = 0; k < ms.size(); k++) {
+                    size_t m = ms[k];
+                    typename Cluster<T>::ptr p = run.previous->clusters[m];
+                    T common = (T) ci->second;
+
+                    // How many percent of old cluster's points are shared by
+                    // the new cluster?
+                    run.coverOldByNew[n][m] = common / ((T) p->size());
+
+                    // How many percent of the new cluster's points are shared
+                    // by the old cluster
+                    run.coverNewByOld[n][m] = common / ((T) c->size());
+
+                    // Overlapping pairs are always looked at, since
+                    // merges and splits depend on them
+                    candidates[n][m] = 1;
+                }
+            }
+        }
 
-            // set all constraint flags to false to start with
-            run.matchPossible[n][m] = false;
+        // Radii and histograms are cached by the clusters, too.
+        // Fill the caches before the pairs are scored concurrently.
+        bool useHistograms = run.haveHistogramInfo && m_params.correlation_weight != 0.0;
+        // Collect the candidate pairs, so that pruned pairs are not
+        // visited again when scoring.
+        vector<int> isCandidateC(run.N, 0);
+        vector<int> isCandidateP(run.M, 0);
+        vector<size_t> candidatePairs;
+        vector<int> index_pair(2);
+        for (size_t n = 0; n < run.N; n++) {
+            for (size_t m = 0; m < run.M; m++) {
+                if (candidates[n][m]) {
+                    isCandidateC[n] = 1;
+                    isCandidateP[m] = 1;
+                    index_pair[0] = (int) n;
+                    index_pair[1] = (int) m;
+                    candidatePairs.push_back(run.mapping.grid_to_index(index_pair));
+                }
+            }
+        }
 
-            typename Cluster<T>::ptr c = run.current->clusters[n];
+        vector<int> requiresOverlap(run.M, 0);
+#if WITH_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (size_t m = 0; m < run.M; m++) {
             typename Cluster<T>::ptr p = run.previous->clusters[m];
-            if (logDetails) {
-                cout << "\tmatch uuid:" << p->uuid
-                     << " id:" << p->id
-                     << " with uuid:" << c->uuid << " ";
+            if (m_params.useOverlapConstraint) {
+                ::units::values::m radius = p->radius(run.cs);
+                requiresOverlap[m] = (radius >= run.overlap_constraint_radius) ? 1 : 0;
+            }
+            if (useHistograms && isCandidateP[m]) {
+                p->histogram(run.tracking_var_index, run.valid_min, run.valid_max);
+            }
+        }
+        if (useHistograms) {
+#if WITH_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+            for (size_t n = 0; n < run.N; n++) {
+                if (isCandidateC[n]) {
+                    run.current->clusters[n]->histogram(run.tracking_var_index, run.valid_min, run.valid_max);
+                }
             }
+        }
 
-            // How many percent of old cluster's points are shared by
-            // the new cluster?
-            run.coverOldByNew[n][m] = index_c.occupation_ratio(p, c);
+        // The maximum size difference is taken over all pairs passing
+        // the overlap constraint, including those that are out of reach.
+        // For a given current cluster, the largest difference to a set
+        // of previous clusters is found at the smallest or the largest
+        // of them, so the pruned pairs need not be visited.
+        int maxSizeDifference = numeric_limits<int>::min();
+        if (m_params.size_weight != 0.0) {
+            bool haveUnconstrained = false;
+            size_t minUnconstrained = numeric_limits<size_t>::max();
+            size_t maxUnconstrained = 0;
+            for (size_t m = 0; m < run.M; m++) {
+                if (!requiresOverlap[m]) {
+                    size_t s = run.previous->clusters[m]->size();
+                    minUnconstrained = min(minUnconstrained, s);
+                    maxUnconstrained = max(maxUnconstrained, s);
+                    haveUnconstrained = true;
+                }
+            }
+            if (haveUnconstrained) {
+                for (size_t n = 0; n < run.N; n++) {
+                    size_t s = run.current->clusters[n]->size();
+                    size_t extremes[2] = {minUnconstrained, maxUnconstrained};
+                    for (size_t k = 0; k < 2; k++) {
+                        T maxSize = (T) max(s, extremes[k]);
+                        T minSize = (T) min(s, extremes[k]);
+                        T sizeDiff = (maxSize == 0) ? 1.0 : (maxSize - minSize);
+                        if (sizeDiff > maxSizeDifference) {
+                            maxSizeDifference = sizeDiff;
+                        }
+                    }
+                }
+            }
+        }
+        ::units::values::m maxMidDisplacement = run.maxMidDisplacement;
+
+        // Score the candidate pairs in parallel. All other pairs keep
+        // the constraint flag false they were allocated with. Detailed
+        // output is only readable if written by one thread.
 
-            // How many percent of the new cluster's points are shared
-            // by the old cluster
-            run.coverNewByOld[n][m] = index_p.occupation_ratio(c, p);
+#if WITH_OPENMP
+#pragma omp parallel if (!logDetails)
+#endif
+        {
+            int localMaxSizeDifference = maxSizeDifference;
+            ::units::values::m localMaxMidDisplacement = maxMidDisplacement;
+            vector<int> pair(2);
 
-            // Calculate this for merge/splits
-            vector<T> oldCenter, newCenter;
-            vector<T> dx = c->geometrical_center() - p->geometrical_center();
-            run.midDisplacement[n][m] = ::units::values::m(vector_norm(run.cs->to_meters(dx)));
+#if WITH_OPENMP
+#pragma omp for schedule(dynamic, 64) nowait
+#endif
+            for (size_t k = 0; k < candidatePairs.size(); k++) {
+                run.mapping.linear_to_grid(candidatePairs[k], pair);
 
-            //
-            // Overlap constraint
-            //
-            // if the object is so big, that overlap is required at the given advection velocity
-            // then check if that is the case. If no overlap exists, prohibit the match by setting
-            // the constraint to false. If no overlap is required, the constraint is simply set to
-            // true, thus allowing a match.
+                int n = pair[0];
+                int m = pair[1];
 
-            if (m_params.useOverlapConstraint) {
-                ::units::values::m radius = p->radius(run.cs);
-                bool requires_overlap = (radius >= run.overlap_constraint_radius);
-                if (requires_overlap && run.coverOldByNew[n][m] == 0.0) {
+                typename Cluster<T>::ptr c = run.current->clusters[n];
+                typename Cluster<T>::ptr p = run.previous->clusters[m];
+                if (logDetails) {
+                    cout << "\tmatch uuid:" << p->uuid
+                         << " id:" << p->id
+                         << " with uuid:" << c->uuid << " ";
+                }
+
+                // Calculate this for merge/splits
+                vector<T> dx = c->geometrical_center() - p->geometrical_center();
+                run.midDisplacement[n][m] = ::units::values::m(vector_norm(run.cs->to_meters(dx)));
+
+                //
+                // Overlap constraint
+                //
+                // if the object is so big, that overlap is required at the given advection velocity
+                // then check if that is the case. If no overlap exists, prohibit the match by setting
+                // the constraint to false. If no overlap is required, the constraint is simply set to
+                // true, thus allowing a match.
+
+                if (m_params.useOverlapConstraint) {
+                    if (requiresOverlap[m] && run.coverOldByNew[n][m] == 0.0) {
+                        if (logDetails) {
+                            cout << "precluded: violation of overlap constraint." << endl;
+                        }
+                        continue;
+                    }
+                }
+
+                //
+                // Growth/shrink rate constraint
+                //
+                // Processes in nature develop within certain bounds. It is
+                // not possible that a cloud covers 10 pixels in one scan
+                // and 10.000 in the next. The size deviation constraint is
+                // created to prohibit matches between objects, which vary
+                // too much in size
+                T maxSize = (T) max(p->size(), c->size());
+                T minSize = (T) min(p->size(), c->size());
+                T sizeDiff = (maxSize == 0) ? 1.0 : (maxSize - minSize);
+                run.sizeDifference[n][m] = sizeDiff;
+                if (m_params.size_weight != 0.0) {
+                    if (run.sizeDifference[n][m] > localMaxSizeDifference) {
+                        localMaxSizeDifference = run.sizeDifference[n][m];
+                    }
+                }
+                T sizeDeviation = (maxSize - minSize) / minSize;
+                if (sizeDeviation > m_params.max_size_deviation) {
                     if (logDetails) {
-                        cout << "precluded: violation of overlap constraint." << endl;
+                        cout << "precluded: violation of size constraint"
+                             << " (dH:" << sizeDeviation << " values"
+                             << " ,dH_max:" << m_params.max_size_deviation << " values)."
+                             << endl;
                     }
                     continue;
                 }
-            }
 
-            //
-            // Growth/shrink rate constraint
-            //
-            // Processes in nature develop within certain bounds. It is
-            // not possible that a cloud covers 10 pixels in one scan
-            // and 10.000 in the next. The size deviation constraint is
-            // created to prohibit matches between objects, which vary
-            // too much in size
-            T maxSize = (T) max(p->size(), c->size());
-            T minSize = (T) min(p->size(), c->size());
-            T sizeDiff = (maxSize == 0) ? 1.0 : (maxSize - minSize);
-            run.sizeDifference[n][m] = sizeDiff;
-            if (m_params.size_weight != 0.0) {
-                if (run.sizeDifference[n][m] > run.maxSizeDifference) {
-                    run.maxSizeDifference = run.sizeDifference[n][m];
+                //
+                // Maximum velocity constraint
+                //
+
+                if (run.midDisplacement[n][m] > run.maxDisplacement) {
+                    if (logDetails) {
+                        cout << "precluded: violation of max displacement"
+                             << " (dR:" << run.midDisplacement[n][m]
+                             << " dR_max:" << run.maxDisplacement
+                             << ")." << endl;
+                    }
+                    continue;
                 }
-            }
-            T sizeDeviation = (maxSize - minSize) / minSize;
-            if (sizeDeviation > m_params.max_size_deviation) {
-                if (logDetails) {
-                    cout << "precluded: violation of size constraint"
-                         << " (dH:" << sizeDeviation << " values"
-                         << " ,dH_max:" << m_params.max_size_deviation << " values)."
-                         << endl;
+
+                //
+                // Histogram correlation values
+                //
+
+                // Just as the number of values will have some continuity,
+                // so will the distribution of values for a cluster. This
+                // fact is checked by creating a correlation between the
+                // histograms of the two clusters. Perfect match means
+                // a value of 1. No correlation at all means a value of 0.
+
+                if (useHistograms) {
+                    typename Histogram<T>::ptr hist_p
+                            = p->histogram(run.tracking_var_index, run.valid_min, run.valid_max);
+                    typename Histogram<T>::ptr hist_c
+                            = c->histogram(run.tracking_var_index, run.valid_min, run.valid_max);
+                    run.rankCorrelation[n][m] = hist_c->correlate_kendall(hist_p);
                 }
-                continue;
-            }
 
-            //
-            // Maximum velocity constraint
-            //
+                //
+                // only if all constraints are passed, the flag is set to true
+                //
+                run.matchPossible[n][m] = true;
 
-            if (run.midDisplacement[n][m] > run.maxDisplacement) {
-                if (logDetails) {
-                    cout << "precluded: violation of max displacement"
-                         << " (dR:" << run.midDisplacement[n][m]
-                         << " dR_max:" << run.maxDisplacement
-                         << ")." << endl;
+                // Keep track of the largest distance in all possible
+                // matches for making values relative later.
+                if (run.midDisplacement[n][m] > localMaxMidDisplacement) {
+                    localMaxMidDisplacement = run.midDisplacement[n][m];
                 }
-                continue;
-            }
-
-            //
-            // Histogram correlation values
-            //
-
-            // Just as the number of values will have some continuity,
-            // so will the distribution of values for a cluster. This
-            // fact is checked by creating a correlation between the
-            // histograms of the two clusters. Perfect match means
-            // a value of 1. No correlation at all means a value of 0.
-
-            if (run.haveHistogramInfo && m_params.correlation_weight != 0.0) {
-                typename Histogram<T>::ptr hist_p
-                        = p->histogram(run.tracking_var_index, run.valid_min, run.valid_max);
-                typename Histogram<T>::ptr hist_c
-                        = c->histogram(run.tracking_var_index, run.valid_min, run.valid_max);
-                run.rankCorrelation[n][m] = hist_c->correlate_kendall(hist_p);
-            }
 
-            //
-            // only if all constraints are passed, the flag is set to true
-            //
-            run.matchPossible[n][m] = true;
+                if (logDetails) {
+                    cout << "possible." << endl;
+                }
 
-            // Keep track of the largest distance in all possible
-            // matches for making values relative later.
-            if (run.midDisplacement[n][m] > run.maxMidDisplacement) {
-                run.maxMidDisplacement = run.midDisplacement[n][m];
-            }
+            } // done finishing correlation table
 
-            if (logDetails) {
-                cout << "possible." << endl;
+#if WITH_OPENMP
+#pragma omp critical
+#endif
+            {
+                if (localMaxSizeDifference > run.maxSizeDifference) {
+                    run.maxSizeDifference = localMaxSizeDifference;
+                }
+                if (localMaxMidDisplacement > run.maxMidDisplacement) {
+                    run.maxMidDisplacement = localMaxMidDisplacement;
+                }
             }
-
-        } // done finishing correlation table
+        }
 
         // Now re-tag new clusters with no id
         run.current->erase_identifiers();
@@ -450,45 +690,51 @@ namespace m3D {
             cout << endl;
         }
 
-        for (size_t idx = 0; idx < run.mapping.size(); idx++) {
-            vector<int> index_pair = run.mapping.linear_to_grid(idx);
-
-            int n = index_pair[0];
-            int m = index_pair[1];
-
-            typename Cluster<T>::ptr c = run.current->clusters[n];
-            typename Cluster<T>::ptr p = run.previous->clusters[m];
-
-            // Only calculate values for pairs, that satisfy the
-            // overlap constraint
-
-            if (run.matchPossible[n][m]) {
-                // The probability of the distance based matching estimate
-                // is the 
-                float prob_r = erfc(run.midDisplacement[n][m].get() / run.maxMidDisplacement.get());
-
-                float prob_h = 0;
-                float prob_t = 0;
-
-                if (run.tracking_var_index >= 0) {
-                    // The probability for the histogram match is 
-                    // the complementary error function of the relative
-                    // histogram difference. The larger it is, the smaller
-                    // the value will be
-                    prob_h = erfc(run.sizeDifference[n][m] / run.maxSizeDifference);
+#if WITH_OPENMP
+#pragma omp parallel
+#endif
+        {
+            vector<int> index_pair(2);
+#if WITH_OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif
+            for (size_t idx = 0; idx < run.mapping.size(); idx++) {
+                run.mapping.linear_to_grid(idx, index_pair);
+
+                int n = index_pair[0];
+                int m = index_pair[1];
+
+                // Only calculate values for pairs, that satisfy the
+                // overlap constraint
+
+                if (run.matchPossible[n][m]) {
+                    // The probability of the distance based matching estimate
+                    // is the 
+                    float prob_r = erfc(run.midDisplacement[n][m].get() / run.maxMidDisplacement.get());
+
+                    float prob_h = 0;
+                    float prob_t = 0;
+
+                    if (run.tracking_var_index >= 0) {
+                        // The probability for the histogram match is 
+                        // the complementary error function of the relative
+                        // histogram difference. The larger it is, the smaller
+                        // the value will be
+                        prob_h = erfc(run.sizeDifference[n][m] / run.maxSizeDifference);
+
+                        // The probability of the 'signature' match is the
+                        // raw output of the kendall's tau correlation of 
+                        // the cluster histograms
+                        prob_t = run.rankCorrelation[n][m];
+                    }
 
-                    // The probability of the 'signature' match is the
-                    // raw output of the kendall's tau correlation of 
-                    // the cluster histograms
-                    prob_t = run.rankCorrelation[n][m];
+                    // The final matching probability is a 
+                    // weighed sum of all three factors. 
+                    run.likelihood[n][m]
+                            = m_params.range_weight * prob_r
+                              + m_params.size_weight * prob_h
+                              + m_params.correlation_weight * prob_t;
                 }
-
-                // The final matching probability is a 
-                // weighed sum of all three factors. 
-                run.likelihood[n][m]
-                        = m_params.range_weight * prob_r
-                          + m_params.size_weight * prob_h
-                          + m_params.correlation_weight * prob_t;
             }
         }
 
@@ -543,8 +789,9 @@ namespace m3D {
         int iterations = 0;
 
         // put the matches in a special data structure
+        vector<int> index_pair(2);
         for (size_t idx = 0; idx < run.mapping.size(); idx++) {
-            vector<int> index_pair = run.mapping.linear_to_grid(idx);
+            run.mapping.linear_to_grid(idx, index_pair);
             int n = index_pair[0];
             int m = index_pair[1];
             if (!run.matchPossible[n][m]) continue;
@@ -571,9 +818,9 @@ namespace m3D {
             match_t match = run.matches.at(mi);
 
             // back to n/m indexes
-            vector<int> pairing = run.mapping.linear_to_grid(match.first);
-            int n = pairing[0];
-            int m = pairing[1];
+            run.mapping.linear_to_grid(match.first, index_pair);
+            int n = index_pair[0];
+            int m = index_pair[1];
 
             typename Cluster<T>::ptr c = run.current->clusters[n];
             typename Cluster<T>::ptr p = run.previous->clusters[m];
@@ -968,7 +1215,8 @@ namespace m3D {
     template<typename T>
     void
     Tracking<T>::track(typename ClusterList<T>::ptr previous,
-                       typename ClusterList<T>::ptr current) {
+                       typename ClusterList<T>::ptr current,
+                       const CoordinateSystem<T> *cs) {
         bool logNormal = m_params.verbosity >= VerbosityNormal;
 
         if (logNormal) cout << "Tracking:" << endl;
@@ -976,10 +1224,15 @@ namespace m3D {
         tracking_run_t run;
         run.previous = previous;
         run.current = current;
+        run.cs = cs;
+        run.owns_cs = false;
         if (logNormal) start_timer("-- Calculating preliminaries ... ");
         bool skip_tracking = initialise(run);
         if (logNormal) stop_timer("done");
         if (skip_tracking) {
+            if (run.owns_cs) {
+                delete run.cs;
+            }
             return;
         }
 
@@ -1029,7 +1282,7 @@ namespace m3D {
         current->highest_uuid = run.highestUuid;
 
         // Clean up
-        if (run.cs != NULL) {
+        if (run.owns_cs) {
             delete run.cs;
             run.cs = NULL;
         }
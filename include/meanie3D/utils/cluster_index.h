@@ -27,14 +27,17 @@
 #include <meanie3D/defines.h>
 #include <meanie3D/namespaces.h>
 #include <meanie3D/array/multiarray.h>
+#include <meanie3D/array/multiarray_blitz.h>
 #include <meanie3D/clustering/cluster.h>
 #include <meanie3D/clustering/id.h>
 
+#include <map>
 #include <vector>
 
 namespace m3D {
     namespace utils {
 
+        using std::map;
         using std::vector;
 
         template<typename T>
@@ -44,9 +47,18 @@ namespace m3D {
 
             typedef MultiArray< ::m3D::id_t > index_t;
 
+            /** Sparse table of intersection counts. Maps the id
+             * of a cluster in one index to the ids of the clusters
+             * it shares gridpoints with in the other index, and the
+             * number of shared gridpoints. Pairs without common
+             * gridpoints have no entry.
+             */
+            typedef map< ::m3D::id_t, size_t> id_count_t;
+            typedef map< ::m3D::id_t, id_count_t> intersection_table_t;
+
         private:
 
-            index_t *m_index;
+            MultiArrayBlitz< ::m3D::id_t > *m_index;
 
         public:
 
@@ -79,6 +91,23 @@ namespace m3D {
             double occupation_ratio(const Cluster <T> *cluster_a,
                                     const Cluster <T> *cluster_b) const;
 
+            /** Walks the label grids of both indexes once and counts
+             * the gridpoints shared by each pair of clusters. The
+             * result is table[id_a][id_b], where id_a is the label in
+             * index a and id_b the label in index b. The cost is linear
+             * in the number of gridpoints, independent of the number
+             * of cluster pairs.
+             *
+             * Important: both indexes must have the same dimensions.
+             *
+             * @param index a
+             * @param index b
+             * @param table (cleared before use)
+             */
+            static void intersection_counts(const ClusterIndex<T> &a,
+                                            const ClusterIndex<T> &b,
+                                            intersection_table_t &table);
+
         };
     }
 }
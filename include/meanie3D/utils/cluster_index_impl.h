@@ -107,6 +107,28 @@ namespace m3D {
             double ratio = ((double) common_points) / ((double) cluster_a->size());
             return ratio;
         }
+
+        template<typename T>
+        void
+        ClusterIndex<T>::intersection_counts(const ClusterIndex <T> &a,
+                                             const ClusterIndex <T> &b,
+                                             intersection_table_t &table) {
+            assert(a.m_index->get_dimensions() == b.m_index->get_dimensions());
+            table.clear();
+
+            // Both label grids are laid out identically, which
+            // allows walking the raw storage in lockstep
+            const m3D::id_t *labels_a = a.m_index->data();
+            const m3D::id_t *labels_b = b.m_index->data();
+            size_t N = a.m_index->size();
+            for (size_t i = 0; i < N; i++) {
+                m3D::id_t id_a = labels_a[i];
+                if (id_a == m3D::NO_ID) continue;
+                m3D::id_t id_b = labels_b[i];
+                if (id_b == m3D::NO_ID) continue;
+                table[id_a][id_b]++;
+            }
+        }
     }
 }
 
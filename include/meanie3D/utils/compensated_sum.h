@@ -0,0 +1,132 @@
+/* The MIT License (MIT)
+ * 
+ * (c) Jürgen Simon 2014 (juergen.simon@uni-bonn.de)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef M3D_UTILS_COMPENSATED_SUM_H
+#define M3D_UTILS_COMPENSATED_SUM_H
+
+#include <meanie3D/defines.h>
+#include <meanie3D/namespaces.h>
+
+namespace m3D {
+    namespace utils {
+
+        /** Tells if sums of the given type are compensated. Only
+         * single precision needs it. Double precision sums stay plain
+         * sums, so that their results do not change.
+         */
+        template<typename T>
+        struct compensates_sums
+        {
+            enum { value = false };
+        };
+
+        template<>
+        struct compensates_sums<float>
+        {
+            enum { value = true };
+        };
+
+        /** Compensated (Kahan) summation. Keeps track of the low
+         * order bits lost in each addition, which makes long sums in
+         * single precision about as accurate as plain sums in double
+         * precision. The order of the additions
+         * is kept, so the result is deterministic.
+         *
+         * Types for which compensates_sums is false are summed
+         * plainly, bit for bit as a plain loop would.
+         *
+         * Note: this relies on strict floating point semantics and
+         * must not be compiled with -ffast-math.
+         */
+        template<typename T, bool Compensated = (bool) compensates_sums<T>::value>
+        class CompensatedSum
+        {
+        private:
+
+            T m_sum;
+            T m_compensation;
+
+        public:
+
+            CompensatedSum() : m_sum(0), m_compensation(0) {
+            };
+
+            /** Adds the given value to the sum
+             * @param value
+             */
+            inline void add(const T &value) {
+                T y = value - m_compensation;
+                T t = m_sum + y;
+                m_compensation = (t - m_sum) - y;
+                m_sum = t;
+            };
+
+            inline CompensatedSum &operator+=(const T &value) {
+                add(value);
+                return *this;
+            };
+
+            /** @return compensated sum
+             */
+            inline T value() const {
+                return m_sum;
+            };
+        };
+
+        /** Plain summation for types that are not compensated
+         */
+        template<typename T>
+        class CompensatedSum<T, false>
+        {
+        private:
+
+            T m_sum;
+
+        public:
+
+            CompensatedSum() : m_sum(0) {
+            };
+
+            /** Adds the given value to the sum
+             * @param value
+             */
+            inline void add(const T &value) {
+                m_sum += value;
+            };
+
+            inline CompensatedSum &operator+=(const T &value) {
+                add(value);
+                return *this;
+            };
+
+            /** @return sum
+             */
+            inline T value() const {
+                return m_sum;
+            };
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,193 @@
+/* The MIT License (MIT)
+ * 
+ * (c) Jürgen Simon 2014 (juergen.simon@uni-bonn.de)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef M3D_DISJOINT_SETS_H
+#define M3D_DISJOINT_SETS_H
+
+#include <meanie3D/defines.h>
+#include <meanie3D/namespaces.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace m3D {
+    namespace utils {
+
+        /** Union-find structure over the elements 0..n-1. Sets are always
+         * linked to the smaller root, so the representative of a set is its
+         * smallest element regardless of the order of the unions.
+         *
+         * unite(), compress() and the compressing find() modify the
+         * structure and are not thread-safe. unite_concurrent() can be
+         * called from any number of threads at the same time, but not
+         * together with the others. Once all unions are done, root() can
+         * be called from any number of threads at the same time. After
+         * compress(), it takes a single step.
+         */
+        class DisjointSets
+        {
+        private:
+
+            std::vector<int> m_parent;
+
+            /** Reads the parent of x. The parent may be changed by
+             * another thread in unite_concurrent() at the same time.
+             */
+            inline int parent(int x) const {
+                return __atomic_load_n(&m_parent[x], __ATOMIC_ACQUIRE);
+            };
+
+            /** Finds the representative of the set containing x while
+             * other threads unite sets, and halves the path on the way.
+             * Each element on the path is linked to its grandparent with
+             * a compare-and-swap. If another thread has changed the link
+             * in the meantime, it is left alone. Either way it points to
+             * an element of the same set, which is smaller.
+             * @param element
+             * @return representative at the time
+             */
+            inline int find_concurrent(int x) {
+                while (true) {
+                    int p = parent(x);
+                    if (p == x) {
+                        return x;
+                    }
+                    int gp = parent(p);
+                    if (gp != p) {
+                        int expected = p;
+                        __atomic_compare_exchange_n(&m_parent[x], &expected, gp, false,
+                                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+                    }
+                    x = gp;
+                }
+            };
+
+        public:
+
+            /** Creates n singleton sets
+             * @param number of elements
+             */
+            DisjointSets(size_t n) : m_parent(n) {
+                for (size_t i = 0; i < n; i++) {
+                    m_parent[i] = (int) i;
+                }
+            };
+
+            /** @return number of elements
+             */
+            size_t size() const {
+                return m_parent.size();
+            };
+
+            /** Finds the representative of the set containing x and
+             * shortens the path on the way (path halving).
+             * @param element
+             * @return representative
+             */
+            int find(int x) {
+                while (m_parent[x] != x) {
+                    m_parent[x] = m_parent[m_parent[x]];
+                    x = m_parent[x];
+                }
+                return x;
+            };
+
+            /** Links every element straight to its representative, so
+             * that root() takes a single step afterwards. Since links
+             * point to smaller elements, one pass in ascending order
+             * does it: the parent of each element has been linked to
+             * its representative already.
+             */
+            void compress() {
+                for (size_t i = 0; i < m_parent.size(); i++) {
+                    m_parent[i] = m_parent[m_parent[i]];
+                }
+            };
+
+            /** Finds the representative of the set containing x
+             * without modifying the structure.
+             * @param element
+             * @return representative
+             */
+            int root(int x) const {
+                while (m_parent[x] != x) {
+                    x = m_parent[x];
+                }
+                return x;
+            };
+
+            /** Merges the sets containing a and b.
+             * @param element
+             * @param element
+             * @return representative of the merged set
+             */
+            int unite(int a, int b) {
+                a = find(a);
+                b = find(b);
+                if (a == b) {
+                    return a;
+                }
+                if (b < a) {
+                    std::swap(a, b);
+                }
+                m_parent[b] = a;
+                return a;
+            };
+
+            /** Merges the sets containing a and b. Lock-free version of
+             * unite(), which can be called from several threads at the same
+             * time. The larger root is linked to the smaller one with a
+             * compare-and-swap, which only succeeds while it still is a root.
+             * Otherwise another thread has linked it in the meantime, and
+             * the roots are looked up again. Since links always point to a
+             * smaller element, the result is the same as with unite(),
+             * whatever the order of the calls. Paths are halved on the
+             * way to the roots (see find_concurrent), which keeps the
+             * trees shallow when chains are united in reverse order.
+             * @param element
+             * @param element
+             * @return representative of the merged set at the time
+             */
+            int unite_concurrent(int a, int b) {
+                while (true) {
+                    a = find_concurrent(a);
+                    b = find_concurrent(b);
+                    if (a == b) {
+                        return a;
+                    }
+                    if (b < a) {
+                        std::swap(a, b);
+                    }
+                    int expected = b;
+                    if (__atomic_compare_exchange_n(&m_parent[b], &expected, a, false,
+                                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                        return a;
+                    }
+                }
+            };
+        };
+    }
+}
+
+#endif
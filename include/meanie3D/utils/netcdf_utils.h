@@ -33,6 +33,8 @@
 #include <netcdf>
 #include <iostream>
 #include <exception>
+#include <sstream>
+#include <stdexcept>
 #include <string.h>
 
 namespace m3D {
@@ -707,8 +709,9 @@ namespace m3D {
                 try {
                     source = new NcFile(source_path.c_str(), NcFile::read);
                 } catch (const netCDF::exceptions::NcException &e) {
-                    cerr << "FATAL:exception opening file " << source_path << " for reading : " << e.what() << endl;
-                    exit(EXIT_FAILURE);
+                    std::ostringstream message;
+                    message << "exception opening file " << source_path << " for reading : " << e.what();
+                    throw std::runtime_error(message.str());
                 }
 
                 // get source file dimensions, using coordinate system
@@ -721,8 +724,9 @@ namespace m3D {
                 try {
                     dest = new NcFile(dest_path, NcFile::write);
                 } catch (const netCDF::exceptions::NcException &e) {
-                    cerr << "FATAL:Exception opening file " << dest_path << " for writing : " << e.what() << endl;
-                    exit(EXIT_FAILURE);
+                    std::ostringstream message;
+                    message << "Exception opening file " << dest_path << " for writing : " << e.what();
+                    throw std::runtime_error(message.str());
                 }
 
                 // copy dimensions and dimension data
@@ -27,6 +27,8 @@
 #include <meanie3D/defines.h>
 #include <meanie3D/namespaces.h>
 
+#include <stdexcept>
+
 #if WITH_OPENCV
 #include <opencv2/opencv.hpp>
 
@@ -45,8 +47,7 @@ namespace m3D {
             vector<size_t> dimension_sizes = array->get_dimensions();
 
             if (dimension_sizes.size() != 2) {
-                cerr << "FATAL:this method is only supported for 2D data" << endl;
-                exit(EXIT_FAILURE);
+                throw std::runtime_error("this method is only supported for 2D data");
             }
 
             using namespace cv;
@@ -93,8 +94,7 @@ namespace m3D {
             vector<size_t> dimension_sizes = dataStore->get_dimension_sizes();
 
             if (dimension_sizes.size() != 2) {
-                cerr << "FATAL:this method is only supported for 2D data" << endl;
-                exit(EXIT_FAILURE);
+                throw std::runtime_error("this method is only supported for 2D data");
             }
 
             using namespace cv;
@@ -192,8 +192,7 @@ namespace m3D {
             using namespace cv;
 
             if (coord_system->rank() != 2) {
-                cerr << "FATAL:'shifted_store_from_flow_of_variable' is only supported for 2D" << endl;
-                exit(EXIT_FAILURE);
+                throw std::runtime_error("'shifted_store_from_flow_of_variable' is only supported for 2D");
             }
 
             Mat previous_image_raw, previous_image, current_image_raw, current_image, flow, cflow;
@@ -69,6 +69,20 @@ namespace m3D {
             cout << message << " (" << time << "s)" << endl;
         }
 
+        /** Returns the seconds since the given time. Other than
+         * the timer above, this can be used for nested measurements.
+         *
+         * @param start time (obtained by gettimeofday)
+         * @return seconds
+         */
+        double seconds_since(const timeval &start_time) {
+            timeval end_time;
+            gettimeofday(&end_time, NULL);
+
+            return double(end_time.tv_sec - start_time.tv_sec)
+                   + double(end_time.tv_usec - start_time.tv_usec) / 1000000.0;
+        }
+
     }
 }
 
@@ -291,10 +291,10 @@ namespace m3D {
                 return acos((v1 * v2) / (vector_norm(v1) * vector_norm(v2)));
             }
 
-            template<typename T>
+            template<typename T, class Y>
             inline
             T
-            mahalabonis_distance_sqr(const vector<T> &x, const vector<T> &y, const vector<T> &H) {
+            mahalabonis_distance_sqr(const vector<T> &x, const Y &y, const vector<T> &H) {
 #if ASSERT_VECTOR_SIZES
                 assert(x.size() == y.size());
                 assert(x.size() == H.size());
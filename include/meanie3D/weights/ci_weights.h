@@ -38,6 +38,8 @@
 #include <netcdf>
 #include <vector>
 #include <map>
+#include <sstream>
+#include <stdexcept>
 
 #include "weight_function.h"
 
@@ -132,8 +134,10 @@ namespace m3D {
 
         // Members for range based weight calculations
         PointIndex <T> *m_index; // index for range search
+        bool m_owns_index; // false if m_index is the context's spatial index
         vector <T> m_bandwidth;  // search radius for numerous operations
-        SearchParameters *m_search_params; // search params for search
+        PreparedRangeSearch <T> *m_range_search; // prepared search on m_index
+        typename Point<T>::list m_neighbors; // re-used search result
 
 #if DEBUG_CI_SCORE
         MultiArray<T> *m_score_108;
@@ -162,9 +166,9 @@ namespace m3D {
                     m_variable_names.push_back(std::string(CI_WEIGHT_VARS[i]));
                     NcVar var = file.getVar(CI_WEIGHT_VARS[i]);
                     if (var.isNull()) {
-                        cerr << "FATAL: file requires variable " << CI_WEIGHT_VARS[i] << " for CI interest weight" <<
-                             endl;
-                        exit(EXIT_FAILURE);
+                        std::ostringstream message;
+                        message << "file requires variable " << CI_WEIGHT_VARS[i] << " for CI interest weight";
+                        throw std::runtime_error(message.str());
                     }
 
                     // Obtain the constants for transforming radiances
@@ -183,8 +187,9 @@ namespace m3D {
                     }
                 }
             } catch (netCDF::exceptions::NcException &e) {
-                cerr << "FATAL: can not read from netcdf file " << params.filename << endl;
-                exit(EXIT_FAILURE);
+                std::ostringstream message;
+                message << "can not read from netcdf file " << params.filename;
+                throw std::runtime_error(message.str());
             }
 
             // Create the data store
@@ -196,8 +201,11 @@ namespace m3D {
 
             // index for effective range search ops
             m_bandwidth = ctx.fs->spatial_component(ctx.bandwidth);
-            m_index = PointIndex<T>::create(&ctx.fs->points, ctx.coord_system->rank());
-            m_search_params = new RangeSearchParams<T>(m_bandwidth);
+            m_owns_index = (ctx.spatial_index == NULL);
+            m_index = m_owns_index
+                      ? PointIndex<T>::create(&ctx.fs->points, ctx.coord_system->rank())
+                      : ctx.spatial_index;
+            m_range_search = m_index->prepare_range_search(m_bandwidth);
 
             this->obtain_protoclusters();
 
@@ -272,14 +280,16 @@ namespace m3D {
                 this->m_data_store = NULL;
             }
 
-            if (this->m_index != NULL) {
-                delete this->m_index;
-                this->m_index = NULL;
+            if (this->m_range_search != NULL) {
+                delete this->m_range_search;
+                this->m_range_search = NULL;
             }
 
-            if (this->m_search_params != NULL) {
-                delete this->m_search_params;
-                this->m_search_params = NULL;
+            if (this->m_index != NULL) {
+                if (this->m_owns_index) {
+                    delete this->m_index;
+                }
+                this->m_index = NULL;
             }
 
             if (this->m_ci_comparison_data_store != NULL) {
@@ -335,8 +345,9 @@ namespace m3D {
                     m_params.variables.push_back(name);
                 }
             } catch (netCDF::exceptions::NcException &e) {
-                cerr << "FATAL: can not read from netcdf file " << m_ci_comparison_data_store->filename() << endl;
-                exit(EXIT_FAILURE);
+                std::ostringstream message;
+                message << "can not read from netcdf file " << m_ci_comparison_data_store->filename();
+                throw std::runtime_error(message.str());
             }
 
             // cut msevi_l15_ir_108 at max 0 centigrade
@@ -345,6 +356,7 @@ namespace m3D {
             // Set other parameters
             m_params.filename = m_super_params.filename;
             m_params.scale = m_super_params.ci_protocluster_scale;
+            m_params.scale_space_method = m_super_params.scale_space_method;
             m_params.min_cluster_size = m_super_params.ci_protocluster_min_size;
             m_params.verbosity = m_super_params.verbosity;
 
@@ -662,11 +674,13 @@ namespace m3D {
             delete this->m_data_store;
             this->m_data_store = NULL;
 
-            delete this->m_index;
-            this->m_index = NULL;
+            delete this->m_range_search;
+            this->m_range_search = NULL;
 
-            delete this->m_search_params;
-            this->m_search_params = NULL;
+            if (this->m_owns_index) {
+                delete this->m_index;
+            }
+            this->m_index = NULL;
         };
 
     public:
@@ -817,12 +831,12 @@ namespace m3D {
                 bool has_lightning = false;
                 bool has_radar = false;
 
-                typename Point<T>::list *neighbors = m_index->search(p->coordinate, m_search_params);
+                m_range_search->search(p->coordinate, m_neighbors);
 
                 T cband_rx, linet_count;
 
-                for (size_t pi = 0; pi < neighbors->size() && !(has_lightning || has_radar); pi++) {
-                    typename Point<T>::ptr n = neighbors->at(pi);
+                for (size_t pi = 0; pi < m_neighbors.size() && !(has_lightning || has_radar); pi++) {
+                    typename Point<T>::ptr n = m_neighbors[pi];
 
                     bool neighbour_is_in_range = false;
                     bool neighbour_is_valid = false;
@@ -850,8 +864,6 @@ namespace m3D {
                     }
                 }
 
-                delete neighbors;
-
                 // If any lightning is present in 5km radius:
                 // increase score
 
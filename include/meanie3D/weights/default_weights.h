@@ -107,7 +107,7 @@ namespace m3D {
          */
 
         T compute_weight(const FeatureSpace <T> *fs,
-                         const vector <T> &values) const {
+                         const ColumnView <T> &values) const {
             T sum = 0.0;
 
             for (size_t var_index = 0; var_index < fs->value_rank(); var_index++) {
@@ -59,25 +59,32 @@ namespace m3D {
 
         PointIndex <T> *m_index; // index for range search
         vector<T> m_bandwidth; // bandwidth for range weight
-        SearchParameters *m_search_params; // search params for search
         Kernel <T> *m_kernel; // kernel for weighing
 
         void
-        calculate_weight_function(FeatureSpace <T> *fs) {
-            size_t spatial_dim = fs->coordinate_system->rank();
-            vector<size_t> indexes(spatial_dim);
-            for (size_t i = 0; i < spatial_dim; i++) indexes[i] = i;
-            m_index = PointIndex<T>::create(&fs->points, indexes);
+        calculate_weight_function(FeatureSpace <T> *fs, PointIndex <T> *spatial_index) {
+            m_index = spatial_index;
+            if (m_index == NULL) {
+                size_t spatial_dim = fs->coordinate_system->rank();
+                vector<size_t> indexes(spatial_dim);
+                for (size_t i = 0; i < spatial_dim; i++) indexes[i] = i;
+                m_index = PointIndex<T>::create(&fs->points, indexes);
+            }
             m_kernel = new GaussianNormalKernel<T>(vector_norm(m_bandwidth));
-            m_search_params = new RangeSearchParams<T>(m_bandwidth);
+            PreparedRangeSearch<T> *search = m_index->prepare_range_search(fs->spatial_component(m_bandwidth));
+            typename Point<T>::list neighbors;
+            vector<T> x;
             for (size_t i = 0; i < fs->points.size(); i++) {
                 Point<T> *p = fs->points[i];
-                T saliency = this->compute_weight(p);
+                T saliency = this->compute_weight(p, search, x, neighbors);
                 m_weight->set(p->gridpoint, saliency);
             }
-            delete m_index;
+            delete search;
+            if (m_index != spatial_index) {
+                delete m_index;
+            }
+            m_index = NULL;
             delete m_kernel;
-            delete m_search_params;
         };
 
     public:
@@ -103,7 +110,7 @@ namespace m3D {
                 m_max = ctx.sf->get_filtered_max();
             }
 
-            calculate_weight_function(ctx.fs);
+            calculate_weight_function(ctx.fs, ctx.spatial_index);
         }
 
         ~OASEWeightFunction() {
@@ -230,16 +237,23 @@ namespace m3D {
         }
 
         /** Actual weight computation happens here
+         * @param point
+         * @param prepared range search
+         * @param buffer for the query
+         * @param buffer for the neighbours
          */
-        T compute_weight(Point <T> *p) {
+        T compute_weight(Point <T> *p,
+                         PreparedRangeSearch<T> *search,
+                         vector<T> &x,
+                         typename Point<T>::list &neighbors) {
 
-
-            typename Point<T>::list *neighbors = m_index->search(p->coordinate, m_search_params);
+            x.assign(p->coordinate.begin(), p->coordinate.end());
+            search->search(x, neighbors);
 
             T weight = 0;
 
-            for (size_t pi = 0; pi < neighbors->size(); pi++) {
-                typename Point<T>::ptr n = neighbors->at(pi);
+            for (size_t pi = 0; pi < neighbors.size(); pi++) {
+                typename Point<T>::ptr n = neighbors[pi];
 
                 // calculate weight at that point
 
@@ -254,8 +268,6 @@ namespace m3D {
                 weight += m_kernel->apply(dist) * point_weight;
             }
 
-            delete neighbors;
-
             return weight;
         }
 
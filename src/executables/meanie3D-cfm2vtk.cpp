@@ -31,7 +31,11 @@ using namespace netCDF;
 using namespace std;
 
 /** Feature-space data type */
+#if WITH_SINGLE_PRECISION
+typedef float FS_TYPE;
+#else
 typedef double FS_TYPE;
+#endif
 
 /** Verbosity */
 typedef enum {
@@ -52,7 +52,11 @@ using namespace m3D;
 
 /** This defines the numerical type for the all variables 
  */
+#if WITH_SINGLE_PRECISION
+typedef float FS_TYPE;
+#else
 typedef double FS_TYPE;
+#endif
 
 #pragma mark -
 #pragma mark Other command line
@@ -82,6 +86,12 @@ void print_compile_time_options() {
 #else
     cout << "\tWRITE_ZEROSHIFT_CLUSTERS=0" << endl;
 #endif
+
+#if WITH_SINGLE_PRECISION
+    cout << "\tWITH_SINGLE_PRECISION=1" << endl;
+#else
+    cout << "\tWITH_SINGLE_PRECISION=0" << endl;
+#endif
     cout << endl;
 }
 
@@ -138,7 +148,12 @@ int main(int argc, char **argv) {
     // Initialize the context beforehand to allow giving the user
     // some feedback before the run.
     detection_context_t<FS_TYPE> detection_context;
-    Detection<FS_TYPE>::initialiseContext(detection_params, detection_context);
+    try {
+        Detection<FS_TYPE>::initialiseContext(detection_params, detection_context);
+    } catch (const std::exception &e) {
+        cerr << "FATAL:" << e.what() << endl;
+        exit(EXIT_FAILURE);
+    }
     
     // Give some user feedback on the choices
     if (detection_params.verbosity > VerbositySilent) {
@@ -157,57 +172,64 @@ int main(int argc, char **argv) {
         }
     }
 
-    // Off we go
-    Detection<FS_TYPE>::run(detection_params, detection_context);
-
-    if (detection_params.inline_tracking) {
-        
-        if (verbosity >= VerbosityNormal) {
-            start_timer("Performing tracking step ...");
-        }
-
-        Tracking<FS_TYPE> tracking(tracking_params);
-        tracking.track(detection_context.previous_clusters, 
-                detection_context.clusters);
-
-        if (verbosity > VerbosityNormal) {
-            stop_timer("done");
-            cout << "Results after tracking:" << endl;
-            detection_context.clusters->print();
-        }
+    // Library code reports failures by exceptions. Here they end
+    // the program.
+    try {
+        // Off we go
+        Detection<FS_TYPE>::run(detection_params, detection_context);
 
-        #if WITH_VTK
-        if (tracking_params.write_vtk) {
-            
-            m3D::utils::VisitUtils<FS_TYPE>::write_clusters_vtu(
-                    detection_context.clusters, 
-                    detection_context.coord_system, 
-                    detection_context.clusters->source_file);
-            
-            boost::filesystem::path path(detection_params.output_filename);
-            string modes_path = path.filename().stem().string() + "_modes.vtk";
-            ::m3D::utils::VisitUtils<FS_TYPE>::write_cluster_modes_vtk(
-                    modes_path, 
-                    detection_context.clusters->clusters, 
-                    true);
-            
-            string centers_path = path.filename().stem().string() + "_centers.vtk";
-            ::m3D::utils::VisitUtils<FS_TYPE>::write_geometrical_cluster_centers_vtk(
-                    centers_path, 
-                    detection_context.clusters->clusters);
-        }
-        #endif
+        if (detection_params.inline_tracking) {
 
-        // Write results 
-        if (verbosity >= VerbosityNormal) {
-            start_timer("-- Writing " + detection_params.output_filename + " ... ");
-        }
-        detection_context.clusters->write(detection_params.output_filename);
-        if (verbosity >= VerbosityNormal) {
-            stop_timer("done");
+            if (verbosity >= VerbosityNormal) {
+                start_timer("Performing tracking step ...");
+            }
+
+            Tracking<FS_TYPE> tracking(tracking_params);
+            tracking.track(detection_context.previous_clusters, 
+                    detection_context.clusters);
+
+            if (verbosity > VerbosityNormal) {
+                stop_timer("done");
+                cout << "Results after tracking:" << endl;
+                detection_context.clusters->print();
+            }
+
+            #if WITH_VTK
+            if (tracking_params.write_vtk) {
+
+                m3D::utils::VisitUtils<FS_TYPE>::write_clusters_vtu(
+                        detection_context.clusters, 
+                        detection_context.coord_system, 
+                        detection_context.clusters->source_file);
+
+                boost::filesystem::path path(detection_params.output_filename);
+                string modes_path = path.filename().stem().string() + "_modes.vtk";
+                ::m3D::utils::VisitUtils<FS_TYPE>::write_cluster_modes_vtk(
+                        modes_path, 
+                        detection_context.clusters->clusters, 
+                        true);
+
+                string centers_path = path.filename().stem().string() + "_centers.vtk";
+                ::m3D::utils::VisitUtils<FS_TYPE>::write_geometrical_cluster_centers_vtk(
+                        centers_path, 
+                        detection_context.clusters->clusters);
+            }
+            #endif
+
+            // Write results 
+            if (verbosity >= VerbosityNormal) {
+                start_timer("-- Writing " + detection_params.output_filename + " ... ");
+            }
+            detection_context.clusters->write(detection_params.output_filename);
+            if (verbosity >= VerbosityNormal) {
+                stop_timer("done");
+            }
         }
+    } catch (const std::exception &e) {
+        cerr << "FATAL:" << e.what() << endl;
+        exit(EXIT_FAILURE);
     }
-        
+
     Detection<FS_TYPE>::cleanup(detection_params, detection_context);
     return EXIT_SUCCESS;
 }
\ No newline at end of file
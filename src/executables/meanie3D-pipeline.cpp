@@ -0,0 +1,396 @@
+/* The MIT License (MIT)
+ * 
+ * (c) Jürgen Simon 2014 (juergen.simon@uni-bonn.de)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/any.hpp>
+
+#include <ctime>
+#include <exception>
+#include <map>
+#include <netcdf>
+#include <set>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <meanie3D/meanie3D.h>
+#include <meanie3D/utils/time_utils.h>
+
+using namespace std;
+using namespace boost;
+using namespace netCDF;
+using namespace m3D;
+
+namespace fs = boost::filesystem;
+
+#pragma mark -
+#pragma mark Constants & Types
+
+/** This defines the numerical type for the all variables 
+ */
+#if WITH_SINGLE_PRECISION
+typedef float FS_TYPE;
+#else
+typedef double FS_TYPE;
+#endif
+
+typedef std::set<fs::path> fset_t;
+
+/** Size and modification time of a file
+ */
+typedef std::pair<uintmax_t, std::time_t> fstate_t;
+typedef std::map<fs::path, fstate_t> fstates_t;
+
+#pragma mark -
+#pragma mark Helpers
+
+/**
+ * Collects the NetCDF files in the given directory, which have not
+ * been processed yet. The set is ordered by path, so files named by
+ * their timestamp come out in chronological order.
+ *
+ * Files may still be written to when they are found. If a map of
+ * observed files is given, a file is only collected once its size
+ * and modification time are the same as on the previous call. New
+ * or changed files are recorded in the map and held back.
+ *
+ * @param directory
+ * @param processed files
+ * @param observed files (may be NULL)
+ * @param result
+ * @throws fs::filesystem_error if the directory can not be read
+ */
+void find_new_files(const fs::path &directory,
+                    const fset_t &processed,
+                    fstates_t *observed,
+                    fset_t &files) {
+    files.clear();
+    fstates_t current;
+    fs::directory_iterator dir_iter(directory);
+    fs::directory_iterator end;
+    while (dir_iter != end) {
+        fs::path f = dir_iter->path();
+        dir_iter++;
+
+        boost::system::error_code ec;
+        if (!fs::is_regular_file(f, ec)
+            || fs::extension(f) != ".nc"
+            || processed.find(f) != processed.end()) {
+            continue;
+        }
+        if (observed == NULL) {
+            files.insert(f);
+            continue;
+        }
+
+        // The file may vanish between listing and looking at it
+        fstate_t state(fs::file_size(f, ec), 0);
+        if (!ec) {
+            state.second = fs::last_write_time(f, ec);
+        }
+        if (ec) {
+            continue;
+        }
+        fstates_t::const_iterator oi = observed->find(f);
+        if (oi != observed->end() && oi->second == state) {
+            files.insert(f);
+        } else {
+            current[f] = state;
+        }
+    }
+    if (observed != NULL) {
+        observed->swap(current);
+    }
+}
+
+/**
+ * Each time step works on a copy of the parameters. Those share
+ * a few pointers with the original, which must not be freed when
+ * the time step is cleaned up.
+ *
+ * @param params
+ */
+void release_shared_params(detection_params_t<FS_TYPE> &params) {
+    params.previous_clusters_filename = NULL;
+    params.ci_comparison_file = NULL;
+    params.ci_comparison_protocluster_file = NULL;
+}
+
+/**
+ * Frees everything a time step allocated.
+ *
+ * @param params the step was run with
+ * @param context
+ */
+void cleanup_step(const detection_params_t<FS_TYPE> &params,
+                  detection_context_t<FS_TYPE> *ctx) {
+    detection_params_t<FS_TYPE> p = params;
+    release_shared_params(p);
+    Detection<FS_TYPE>::cleanup(p, *ctx);
+    delete ctx;
+}
+
+#pragma mark -
+#pragma mark Main
+
+int main(int argc, char **argv) {
+    using namespace m3D;
+
+    detection_params_t<FS_TYPE> detection_params
+            = Detection<FS_TYPE>::defaultParams();
+
+    tracking_param_t tracking_params
+            = Tracking<FS_TYPE>::defaultParams();
+
+    // Declare the supported options.
+    program_options::options_description desc("Options");
+    utils::add_standard_options(desc);
+
+    desc.add_options()
+            ("watch,w", program_options::value<string>(),
+             "Directory containing the scans. Files (*.nc) are processed in the order of their names.")
+            ("output-dir", program_options::value<string>()->default_value("."),
+             "Directory the cluster files are written to. The cluster file for <scan>.nc is called <scan>-clusters.nc")
+            ("poll-interval", program_options::value<unsigned int>()->default_value(10u),
+             "Number of seconds to wait before looking for new scans")
+            ("once",
+             "If present, the scans present in the directory are processed and the program exits. Otherwise it keeps watching the directory for new scans.");
+
+    add_detection_options<FS_TYPE>(desc, detection_params);
+    add_tracking_options<FS_TYPE>(desc, tracking_params);
+
+    // Parse the command line
+    program_options::variables_map vm;
+    try {
+        program_options::store(program_options::parse_command_line(argc, argv, desc), vm);
+        program_options::notify(vm);
+    } catch (std::exception &e) {
+        cerr << "Error parsing command line: " << e.what() << endl;
+        cerr << "Check meanie3D-pipeline --help for command line options" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    Verbosity verbosity;
+    utils::get_standard_options(argc, vm, desc, verbosity);
+
+    if (vm.count("watch") == 0) {
+        cerr << "FATAL:missing parameter --watch" << endl;
+        exit(EXIT_FAILURE);
+    }
+    fs::path watch_dir(vm["watch"].as<string>());
+    if (!fs::is_directory(watch_dir)) {
+        cerr << "FATAL:" << watch_dir.generic_string() << " is not a directory" << endl;
+        exit(EXIT_FAILURE);
+    }
+    fs::path output_dir(vm["output-dir"].as<string>());
+    unsigned int poll_interval = vm["poll-interval"].as<unsigned int>();
+    bool once = vm.count("once") > 0;
+
+    // When watching, scans are only picked up once they have not
+    // changed between two polls. With --once, the scans are taken
+    // to be complete.
+    fstates_t observed;
+    fstates_t *observed_files = once ? NULL : &observed;
+
+    // The detection parameters are evaluated against a template
+    // scan. Unless one is given with --file, the first one found
+    // in the watched directory is used.
+    fset_t processed;
+    fset_t files;
+    if (vm.count("file") == 0) {
+        try {
+            find_new_files(watch_dir, processed, observed_files, files);
+            while (files.empty()) {
+                if (once) {
+                    if (verbosity > VerbositySilent) {
+                        cout << "No scans in " << watch_dir.generic_string() << endl;
+                    }
+                    return EXIT_SUCCESS;
+                }
+                sleep(poll_interval);
+                find_new_files(watch_dir, processed, observed_files, files);
+            }
+        } catch (const fs::filesystem_error &e) {
+            cerr << "FATAL:could not read " << watch_dir.generic_string() << ": " << e.what() << endl;
+            exit(EXIT_FAILURE);
+        }
+        vm.insert(std::make_pair(std::string("file"),
+                                 program_options::variable_value(boost::any(files.begin()->string()), false)));
+    }
+    if (vm.count("output") == 0) {
+        vm.insert(std::make_pair(std::string("output"),
+                                 program_options::variable_value(boost::any(std::string()), false)));
+    }
+
+    try {
+        get_detection_parameters(vm, detection_params);
+#if WITH_VTK
+        utils::set_vtk_dimensions_from_args<FS_TYPE>(vm, detection_params.dimensions);
+#endif
+        detection_params.verbosity = verbosity;
+        get_tracking_parameters<FS_TYPE>(vm, tracking_params, true);
+        tracking_params.verbosity = verbosity;
+    } catch (const std::exception &e) {
+        cerr << e.what() << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    // All scans are expected on the same grid. The coordinate
+    // system is constructed once and shared by all time steps.
+    // Note that it refers to the file, which must stay open.
+    NcFile *template_file = NULL;
+    try {
+        template_file = new NcFile(detection_params.filename, NcFile::read);
+    } catch (const netCDF::exceptions::NcException &e) {
+        cerr << "FATAL:could not open file '" << detection_params.filename
+             << "' for reading: " << e.what() << endl;
+        exit(EXIT_FAILURE);
+    }
+    CoordinateSystem<FS_TYPE> *coord_system = NULL;
+    try {
+        coord_system = new CoordinateSystem<FS_TYPE>(
+                template_file,
+                detection_params.dimensions,
+                detection_params.dimension_variables);
+    } catch (const std::exception &e) {
+        cerr << "FATAL:" << e.what() << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    if (verbosity > VerbositySilent) {
+        cout << "----------------------------------------------------" << endl;
+        cout << "meanie3D pipeline" << endl;
+        cout << "----------------------------------------------------" << endl;
+        cout << endl;
+        cout << "\twatching:" << watch_dir.generic_string() << endl;
+        cout << "\toutput directory:" << output_dir.generic_string() << endl;
+        cout << "\tpoll interval:" << poll_interval << "s" << endl;
+        if (verbosity > VerbosityNormal) {
+            print_tracking_params(tracking_params, vm);
+        }
+    }
+
+    // The tracking object is kept over the whole run, so that
+    // settings it derives on the first run stick.
+    Tracking<FS_TYPE> tracking(tracking_params);
+
+    // The context of the previous time step is kept alive until
+    // the next step has been tracked against it. Its clusters refer
+    // to the points of its feature-space.
+    detection_context_t<FS_TYPE> *previous_ctx = NULL;
+    detection_params_t<FS_TYPE> previous_params;
+
+    while (true) {
+        try {
+            find_new_files(watch_dir, processed, observed_files, files);
+        } catch (const fs::filesystem_error &e) {
+            cerr << "ERROR:could not read " << watch_dir.generic_string() << ": " << e.what() << endl;
+            files.clear();
+        }
+
+        fset_t::iterator fi;
+        for (fi = files.begin(); fi != files.end(); ++fi) {
+            fs::path f = *fi;
+
+            detection_params_t<FS_TYPE> params = detection_params;
+            params.filename = f.string();
+            params.output_filename = (output_dir / (f.stem().string() + "-clusters.nc")).string();
+
+            // Previous output from file (--previous-output) only
+            // applies to the first time step
+            if (previous_ctx != NULL) {
+                params.previous_clusters_filename = NULL;
+            }
+
+            ClusterList<FS_TYPE>::ptr previous = (previous_ctx == NULL) ? NULL : previous_ctx->clusters;
+            bool have_previous = previous != NULL || params.previous_clusters_filename != NULL;
+            params.inline_tracking = have_previous;
+            params.postprocess_with_previous_output = params.postprocess_with_previous_output && have_previous;
+
+            if (verbosity > VerbositySilent) {
+                cout << endl << "Processing " << f.generic_string() << endl;
+            }
+
+            // A scan that can not be processed is skipped. The next
+            // one is tracked against the last good time step.
+            detection_context_t<FS_TYPE> *ctx = new detection_context_t<FS_TYPE>();
+            try {
+                Detection<FS_TYPE>::initialiseContext(params, *ctx, coord_system, previous);
+                Detection<FS_TYPE>::run(params, *ctx);
+
+                // Without previous clusters, the detection has already
+                // written the result
+                if (params.inline_tracking) {
+                    if (verbosity >= VerbosityNormal) {
+                        start_timer("Performing tracking step ...");
+                    }
+                    tracking.track(ctx->previous_clusters, ctx->clusters, coord_system);
+                    if (verbosity >= VerbosityNormal) {
+                        stop_timer("done");
+                    }
+                    if (verbosity >= VerbosityNormal) {
+                        start_timer("-- Writing " + params.output_filename + " ... ");
+                    }
+                    ctx->clusters->write(params.output_filename);
+                    if (verbosity >= VerbosityNormal) {
+                        stop_timer("done");
+                    }
+                }
+            } catch (const std::exception &e) {
+                cerr << "ERROR:could not process " << f.generic_string() << ": " << e.what() << endl;
+                cleanup_step(params, ctx);
+                processed.insert(f);
+                continue;
+            }
+
+            if (previous_ctx != NULL) {
+                cleanup_step(previous_params, previous_ctx);
+            }
+            previous_ctx = ctx;
+            previous_params = params;
+            processed.insert(f);
+        }
+
+        if (once) {
+            break;
+        }
+        sleep(poll_interval);
+    }
+
+    if (previous_ctx != NULL) {
+        cleanup_step(previous_params, previous_ctx);
+    }
+
+    // Free what parameter parsing allocated
+    detection_context_t<FS_TYPE> empty_ctx;
+    Detection<FS_TYPE>::initialiseContext(empty_ctx);
+    Detection<FS_TYPE>::cleanup(detection_params, empty_ctx);
+
+    delete coord_system;
+    delete template_file;
+
+    return EXIT_SUCCESS;
+}
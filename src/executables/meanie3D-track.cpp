@@ -36,7 +36,11 @@ using namespace m3D;
 using namespace m3D::utils;
 
 /** Feature-space data type */
+#if WITH_SINGLE_PRECISION
+typedef float FS_TYPE;
+#else
 typedef double FS_TYPE;
+#endif
 
 int main(int argc, char **argv) {
     // Declare the supported options.
@@ -45,7 +45,11 @@ namespace fs = boost::filesystem;
 #pragma mark type definitions
 
 /** Feature-space data type */
+#if WITH_SINGLE_PRECISION
+typedef float FS_TYPE;
+#else
 typedef double FS_TYPE;
+#endif
 
 typedef vector<float> fvec_t;
 typedef vector<size_t> bin_t;
@@ -16,7 +16,11 @@
 #include "tests_map.h"
 #include "tests_set.h"
 #include "tests_arrayindex.h"
+#include "tests_compensated_sum.h"
+#include "tests_disjoint_sets.h"
 #include "tests_multiarray.h"
+#include "tests_cluster_index.h"
+#include "tests_point_columns.h"
 
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
@@ -5,6 +5,8 @@
 #include <meanie3D/featurespace.h>
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
 #include <vector>
 
 using namespace m3D;
@@ -199,5 +201,462 @@ TYPED_TEST(ArrayIndexTest3D, VectorDataTypes) {
 
 }
 
+// NEIGHBOURHOODS
+
+template<typename T>
+class ArrayIndexNeighbourhoodTest : public testing::Test
+{
+};
+
+TYPED_TEST_CASE(ArrayIndexNeighbourhoodTest, VectorDataTypes);
+
+TYPED_TEST(ArrayIndexNeighbourhoodTest, VectorDataTypes) {
+    PointFactory<TypeParam>::set_instance(new PointDefaultFactory<TypeParam>());
+
+    typename Point<TypeParam>::list points;
+
+    vector<size_t> dimensions(3);
+    dimensions[0] = 5;
+    dimensions[1] = 6;
+    dimensions[2] = 7;
+
+    // construct point list
+
+    vector<int> g(dimensions.size(), 0);
+    vector<TypeParam> c(dimensions.size(), 0);
+
+    for (int iz = 0; iz < dimensions[0]; iz++) {
+        g[0] = iz;
+        for (int iy = 0; iy < dimensions[1]; iy++) {
+            g[1] = iy;
+            for (int ix = 0; ix < dimensions[2]; ix++) {
+                g[2] = ix;
+                typename Point<TypeParam>::ptr p = PointFactory<TypeParam>::get_instance()->create(g, c, c);
+                points.push_back(p);
+            }
+        }
+    }
+
+    ArrayIndex<TypeParam> index(dimensions, points, false);
+
+    // Compare with the grid points in the clipped neighbourhood,
+    // which must come in row-major order
+
+    typename Point<TypeParam>::list neighbours;
+    for (int reach = 1; reach <= 2; reach++) {
+        for (size_t pi = 0; pi < points.size(); pi++) {
+            const vector<int> &gp = points[pi]->gridpoint;
+            index.find_neighbours(gp, neighbours, reach);
+
+            vector<vector<int> > expected;
+            for (int z = gp[0] - reach; z <= gp[0] + reach; z++) {
+                for (int y = gp[1] - reach; y <= gp[1] + reach; y++) {
+                    for (int x = gp[2] - reach; x <= gp[2] + reach; x++) {
+                        if (z < 0 || z >= (int) dimensions[0]
+                            || y < 0 || y >= (int) dimensions[1]
+                            || x < 0 || x >= (int) dimensions[2]) {
+                            continue;
+                        }
+                        vector<int> e(3);
+                        e[0] = z;
+                        e[1] = y;
+                        e[2] = x;
+                        expected.push_back(e);
+                    }
+                }
+            }
+
+            ASSERT_EQ(expected.size(), neighbours.size());
+            for (size_t ni = 0; ni < neighbours.size(); ni++) {
+                EXPECT_EQ(expected[ni], neighbours[ni]->gridpoint);
+            }
+        }
+    }
+
+    // clean up
+
+    while (!points.empty()) {
+        typename Point<TypeParam>::ptr a = points.back();
+        points.pop_back();
+        delete a;
+    }
+}
+
+// ROWS
+
+template<typename T>
+class ArrayIndexRowsTest : public testing::Test
+{
+};
+
+TYPED_TEST_CASE(ArrayIndexRowsTest, VectorDataTypes);
+
+TYPED_TEST(ArrayIndexRowsTest, VectorDataTypes) {
+    PointFactory<TypeParam>::set_instance(new PointDefaultFactory<TypeParam>());
+
+    typename Point<TypeParam>::list points;
+
+    vector<size_t> dimensions(2);
+    dimensions[0] = 6;
+    dimensions[1] = 8;
+
+    // every other grid point, in reverse order
+
+    vector<int> g(dimensions.size(), 0);
+    vector<TypeParam> c(dimensions.size(), 0);
+
+    for (int iy = dimensions[0] - 1; iy >= 0; iy--) {
+        g[0] = iy;
+        for (int ix = dimensions[1] - 1; ix >= 0; ix -= 2) {
+            g[1] = ix;
+            typename Point<TypeParam>::ptr p = PointFactory<TypeParam>::get_instance()->create(g, c, c);
+            points.push_back(p);
+        }
+    }
+
+    // Referencing index: rows are positions in the list
+
+    ArrayIndex<TypeParam> index(dimensions, points, false);
+
+    for (size_t pi = 0; pi < points.size(); pi++) {
+        const vector<int> &gp = points[pi]->gridpoint;
+        EXPECT_EQ((int) pi, index.row(gp));
+        EXPECT_EQ((int) pi, index.row(index.linear_index(gp)));
+        EXPECT_EQ(points[pi], index.get(gp));
+    }
+    EXPECT_EQ(points.size(), index.count());
+
+    // Grid points without points and outside of the grid
+
+    g[0] = 0;
+    g[1] = 0;
+    EXPECT_EQ(ArrayIndex<TypeParam>::NO_ROW, index.row(g));
+    EXPECT_TRUE(index.get(g) == NULL);
+    g[0] = -1;
+    EXPECT_EQ(ArrayIndex<TypeParam>::NO_ROW, index.row(g));
+    g[0] = dimensions[0];
+    EXPECT_EQ(ArrayIndex<TypeParam>::NO_ROW, index.row(g));
+
+    // Copying index: points are appended or take over the row of
+    // the point they replace. Removing a point empties the grid point.
+
+    ArrayIndex<TypeParam> copies(dimensions, true);
+    copies.set(points[3]->gridpoint, points[3]);
+    copies.set(points[1]->gridpoint, points[1]);
+    EXPECT_EQ(0, copies.row(points[3]->gridpoint));
+    EXPECT_EQ(1, copies.row(points[1]->gridpoint));
+    EXPECT_NE(points[3], copies.get(points[3]->gridpoint));
+    EXPECT_EQ(points[3]->gridpoint, copies.get(points[3]->gridpoint)->gridpoint);
+
+    copies.set(points[3]->gridpoint, points[3]);
+    EXPECT_EQ(0, copies.row(points[3]->gridpoint));
+    EXPECT_EQ(2, copies.count());
+
+    copies.set(points[3]->gridpoint, NULL);
+    EXPECT_EQ(ArrayIndex<TypeParam>::NO_ROW, copies.row(points[3]->gridpoint));
+    EXPECT_TRUE(copies.get(points[3]->gridpoint) == NULL);
+    EXPECT_EQ(1, copies.count());
+
+    // clean up
+
+    while (!points.empty()) {
+        typename Point<TypeParam>::ptr a = points.back();
+        points.pop_back();
+        delete a;
+    }
+}
+
+template<class T>
+class ArrayIndexBoxTest : public testing::Test
+{
+};
+
+TYPED_TEST_CASE(ArrayIndexBoxTest, VectorDataTypes);
+
+TYPED_TEST(ArrayIndexBoxTest, VectorDataTypes) {
+    PointFactory<TypeParam>::set_instance(new PointDefaultFactory<TypeParam>());
+
+    typename Point<TypeParam>::list points;
+
+    // The points fill the box [3..6]x[10..14] of a much larger
+    // grid, except for the box's corner at [3,10]
+
+    vector<int> g(2, 0);
+    vector<TypeParam> c(2, 0);
+
+    for (int iy = 3; iy <= 6; iy++) {
+        g[0] = iy;
+        for (int ix = 10; ix <= 14; ix++) {
+            g[1] = ix;
+            if (iy == 3 && ix == 10) continue;
+            points.push_back(PointFactory<TypeParam>::get_instance()->create(g, c, c));
+        }
+    }
+
+    ArrayIndex<TypeParam> index(2, points, false);
+
+    // Only the box is covered
+
+    EXPECT_EQ(3, index.origin()[0]);
+    EXPECT_EQ(10, index.origin()[1]);
+    EXPECT_EQ(4, index.dimensions()[0]);
+    EXPECT_EQ(5, index.dimensions()[1]);
+    EXPECT_EQ(points.size(), index.count());
+
+    // Lookups with grid points of the whole grid
+
+    for (size_t pi = 0; pi < points.size(); pi++) {
+        const vector<int> &gp = points[pi]->gridpoint;
+        EXPECT_EQ((int) pi, index.row(gp));
+        EXPECT_EQ((int) pi, index.row(index.linear_index(gp)));
+        EXPECT_EQ(points[pi], index.get(gp));
+    }
+
+    // Outside of the box there are no points, and no exceptions
+    // for leading dimensions either
+
+    g[0] = 3;
+    g[1] = 10;
+    EXPECT_EQ(ArrayIndex<TypeParam>::NO_ROW, index.row(g));
+    EXPECT_TRUE(index.get(g) == NULL);
+    g[0] = 0;
+    g[1] = 0;
+    EXPECT_EQ(ArrayIndex<TypeParam>::NO_ROW, index.row(g));
+    EXPECT_TRUE(index.get(g) == NULL);
+    g[0] = 20;
+    g[1] = 12;
+    EXPECT_TRUE(index.get(g) == NULL);
+
+    // Neighbourhoods are clipped to the box: [6,14] is a corner
+    // of the box and has 3 neighbours plus itself
+
+    g[0] = 6;
+    g[1] = 14;
+    EXPECT_EQ(4, index.find_neighbours(g, 1).size());
+    g[0] = 4;
+    g[1] = 11;
+    EXPECT_EQ(8, index.find_neighbours(g, 1).size());
+
+    // An empty list gives an empty index
+
+    typename Point<TypeParam>::list none;
+    ArrayIndex<TypeParam> empty(2, none, false);
+    EXPECT_EQ(0, empty.count());
+    EXPECT_TRUE(empty.get(g) == NULL);
+
+    // clean up
+
+    while (!points.empty()) {
+        typename Point<TypeParam>::ptr a = points.back();
+        points.pop_back();
+        delete a;
+    }
+}
+
+// SPARSE NEIGHBOURHOODS
+
+/** Collects visited points until it has seen a given number
+ */
+template<typename T>
+class ArrayIndexStoppingVisitor
+{
+public:
+
+    typename Point<T>::list visited;
+    size_t limit;
+
+    ArrayIndexStoppingVisitor(size_t max_points) : limit(max_points) {
+    };
+
+    bool operator()(typename Point<T>::ptr p) {
+        visited.push_back(p);
+        return visited.size() < limit;
+    };
+};
+
+/** @return points of the list within the given reach of the grid
+ * point, in row-major order
+ */
+template<typename T>
+static vector<vector<int> >
+array_index_brute_force_neighbours(const typename Point<T>::list &points,
+                                   const vector<int> &gp,
+                                   int reach) {
+    vector<vector<int> > result;
+    for (size_t pi = 0; pi < points.size(); pi++) {
+        if (points[pi] == NULL) continue;
+        const vector<int> &g = points[pi]->gridpoint;
+        bool within = true;
+        for (size_t d = 0; d < g.size() && within; d++) {
+            within = (abs(g[d] - gp[d]) <= reach);
+        }
+        if (within) {
+            result.push_back(g);
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+template<typename T>
+class ArrayIndexSparseNeighbourhoodTest : public testing::Test
+{
+};
+
+TYPED_TEST_CASE(ArrayIndexSparseNeighbourhoodTest, VectorDataTypes);
+
+TYPED_TEST(ArrayIndexSparseNeighbourhoodTest, VectorDataTypes) {
+    PointFactory<TypeParam>::set_instance(new PointDefaultFactory<TypeParam>());
+
+    typename Point<TypeParam>::list points;
+
+    vector<size_t> dimensions(3);
+    dimensions[0] = 9;
+    dimensions[1] = 8;
+    dimensions[2] = 7;
+
+    // Points with gaps, in the box [1..7]x[2..7]x[0..6] only
+
+    vector<int> g(dimensions.size(), 0);
+    vector<TypeParam> c(dimensions.size(), 0);
+
+    for (int iz = 1; iz <= 7; iz++) {
+        g[0] = iz;
+        for (int iy = 2; iy <= 7; iy++) {
+            g[1] = iy;
+            for (int ix = 0; ix <= 6; ix++) {
+                g[2] = ix;
+                if ((5 * iz + 3 * iy + ix) % 4 == 0) continue;
+                points.push_back(PointFactory<TypeParam>::get_instance()->create(g, c, c));
+            }
+        }
+    }
+
+    // One index covers the whole grid and references the points,
+    // one covers the box and holds copies
+
+    ArrayIndex<TypeParam> grid_index(dimensions, points, false);
+    ArrayIndex<TypeParam> box_index(dimensions.size(), points, true);
+    ArrayIndex<TypeParam> *indexes[2] = {&grid_index, &box_index};
+
+    // Check all grid points of the grid, with and without
+    // points. Then remove some of the points and check again.
+
+    typename Point<TypeParam>::list neighbours;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int iz = 0; iz < (int) dimensions[0]; iz++) {
+            g[0] = iz;
+            for (int iy = 0; iy < (int) dimensions[1]; iy++) {
+                g[1] = iy;
+                for (int ix = 0; ix < (int) dimensions[2]; ix++) {
+                    g[2] = ix;
+                    for (int reach = 1; reach <= 3; reach++) {
+                        vector<vector<int> > expected
+                                = array_index_brute_force_neighbours<TypeParam>(points, g, reach);
+
+                        for (size_t ii = 0; ii < 2; ii++) {
+                            indexes[ii]->find_neighbours(g, neighbours, reach);
+                            ASSERT_EQ(expected.size(), neighbours.size());
+                            for (size_t ni = 0; ni < neighbours.size(); ni++) {
+                                EXPECT_EQ(expected[ni], neighbours[ni]->gridpoint);
+                            }
+
+                            // A visit that is stopped early sees the
+                            // first points of the neighbourhood only
+                            ArrayIndexStoppingVisitor<TypeParam> visitor(3);
+                            bool completed = indexes[ii]->visit_neighbours(g, visitor, reach);
+                            EXPECT_EQ(expected.size() < 3, completed);
+                            ASSERT_EQ(std::min(expected.size(), (size_t) 3), visitor.visited.size());
+                            for (size_t ni = 0; ni < visitor.visited.size(); ni++) {
+                                EXPECT_EQ(neighbours[ni], visitor.visited[ni]);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // Remove every fifth point from both indexes. Removing
+        // releases the point, also from the referencing index.
+        for (size_t pi = 0; pass == 0 && pi < points.size(); pi += 5) {
+            box_index.set(points[pi]->gridpoint, NULL);
+            grid_index.set(points[pi]->gridpoint, NULL);
+            points[pi] = NULL;
+        }
+    }
+
+    // clean up
+
+    while (!points.empty()) {
+        typename Point<TypeParam>::ptr a = points.back();
+        points.pop_back();
+        delete a;
+    }
+}
+
+// RESERVED ROOM
+
+template<typename T>
+class ArrayIndexReserveTest : public testing::Test
+{
+};
+
+TYPED_TEST_CASE(ArrayIndexReserveTest, VectorDataTypes);
+
+TYPED_TEST(ArrayIndexReserveTest, VectorDataTypes) {
+    PointFactory<TypeParam>::set_instance(new PointDefaultFactory<TypeParam>());
+
+    vector<size_t> dimensions(2);
+    dimensions[0] = 23;
+    dimensions[1] = 17;
+
+    // Room for a point at every grid point
+
+    ArrayIndex<TypeParam> index(dimensions, false);
+    index.reserve(dimensions[0] * dimensions[1]);
+
+    vector<int> g(dimensions.size(), 0);
+    vector<TypeParam> c(dimensions.size(), 0);
+    index.set(g, PointFactory<TypeParam>::get_instance()->create(g, c, c), false);
+    const typename Point<TypeParam>::ptr *first = &index.points()[0];
+
+    // Fill the grid line by line in parallel, the way the scale-space
+    // filter does. Each thread reads its grid points while the others
+    // set theirs.
+
+#if WITH_OPENMP
+#pragma omp parallel for schedule(dynamic)
 #endif
+    for (int ix = 0; ix < (int) dimensions[0]; ix++) {
+        vector<int> gp(2);
+        vector<TypeParam> coordinate(2, 0);
+        gp[0] = ix;
+        for (int iy = 0; iy < (int) dimensions[1]; iy++) {
+            gp[1] = iy;
+            if (index.get(gp) != NULL) continue;
+            typename Point<TypeParam>::ptr p = PointFactory<TypeParam>::get_instance()->create(gp, coordinate, coordinate);
+#if WITH_OPENMP
+#pragma omp critical
+#endif
+            index.set(gp, p, false);
+        }
+    }
+
+    // The list of points has not been reallocated
+
+    EXPECT_EQ(first, &index.points()[0]);
+    EXPECT_EQ(dimensions[0] * dimensions[1], index.points().size());
+
+    for (int ix = 0; ix < (int) dimensions[0]; ix++) {
+        g[0] = ix;
+        for (int iy = 0; iy < (int) dimensions[1]; iy++) {
+            g[1] = iy;
+            ASSERT_TRUE(index.get(g) != NULL);
+            EXPECT_EQ(g, index.get(g)->gridpoint);
+        }
+    }
 
+    index.clear(true);
+}
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef M3D_TEST_CLUSTER_INDEX_H
+#define M3D_TEST_CLUSTER_INDEX_H
+
+#include <meanie3D/utils/cluster_index.h>
+#include <meanie3D/featurespace.h>
+#include <meanie3D/clustering.h>
+
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace m3D;
+using namespace m3D::utils;
+using namespace testing;
+
+#pragma mark -
+#pragma mark Cluster index
+
+typedef testing::Types<float, double> VectorDataTypes;
+
+template<typename T>
+class ClusterIndexTest : public testing::Test
+{
+protected:
+
+    vector<size_t> m_dimensions;
+    typename Point<T>::list m_points;
+
+    /** Tiles the grid with clusters of the given size, starting at
+     * the given offset. Clusters are numbered from first_id on. Some
+     * grid points are left out, so that the clusters have ragged
+     * edges and differ in size.
+     */
+    typename Cluster<T>::list
+    create_clusters(int offset, int width, int height, m3D::id_t first_id) {
+        typename Cluster<T>::list clusters;
+        m3D::id_t id = first_id;
+        for (int x0 = offset; x0 < (int) m_dimensions[0]; x0 += width) {
+            for (int y0 = offset; y0 < (int) m_dimensions[1]; y0 += height) {
+                vector<T> mode(3, 0.0);
+                typename Cluster<T>::ptr c = new Cluster<T>(mode, 2);
+                c->id = id++;
+                for (int x = x0; x < std::min(x0 + width, (int) m_dimensions[0]); x++) {
+                    for (int y = y0; y < std::min(y0 + height, (int) m_dimensions[1]); y++) {
+                        if ((x * 3 + y * 5 + offset) % 7 == 0) {
+                            continue;
+                        }
+                        vector<int> g(2);
+                        g[0] = x;
+                        g[1] = y;
+                        vector<T> values(3);
+                        values[0] = 0.1 * x;
+                        values[1] = 0.1 * y;
+                        values[2] = 1.0;
+                        vector<T> coordinate(values.begin(), values.begin() + 2);
+                        typename Point<T>::ptr p = PointFactory<T>::get_instance()->create(g, coordinate, values);
+                        m_points.push_back(p);
+                        c->add_point(p);
+                    }
+                }
+                clusters.push_back(c);
+            }
+        }
+        return clusters;
+    }
+
+public:
+
+    ClusterIndexTest() : m_dimensions(2) {
+        m_dimensions[0] = 40;
+        m_dimensions[1] = 35;
+    }
+
+    virtual void TearDown() {
+        for (size_t i = 0; i < m_points.size(); i++) {
+            delete m_points[i];
+        }
+        m_points.clear();
+    }
+};
+
+TYPED_TEST_CASE(ClusterIndexTest, VectorDataTypes);
+
+TYPED_TEST(ClusterIndexTest, IntersectionCountsMatchOccupationRatios) {
+    PointFactory<TypeParam>::set_instance(new PointDefaultFactory<TypeParam>());
+
+    // Two differently tiled sets of clusters. The second set
+    // leaves the first few rows and columns uncovered.
+    typename Cluster<TypeParam>::list current = this->create_clusters(0, 10, 10, 0);
+    typename Cluster<TypeParam>::list previous = this->create_clusters(3, 8, 13, 100);
+
+    ClusterIndex<TypeParam> index_c(current, this->m_dimensions);
+    ClusterIndex<TypeParam> index_p(previous, this->m_dimensions);
+
+    typename ClusterIndex<TypeParam>::intersection_table_t table;
+    ClusterIndex<TypeParam>::intersection_counts(index_c, index_p, table);
+
+    // Each pair's count gives the ratios that occupation_ratio
+    // calculates from the points of either cluster
+    size_t overlapping = 0;
+    for (size_t n = 0; n < current.size(); n++) {
+        Cluster<TypeParam> *c = current[n];
+        for (size_t m = 0; m < previous.size(); m++) {
+            Cluster<TypeParam> *p = previous[m];
+
+            size_t common = 0;
+            if (table.find(c->id) != table.end() && table[c->id].find(p->id) != table[c->id].end()) {
+                common = table[c->id][p->id];
+                EXPECT_GT(common, 0);
+                overlapping++;
+            }
+
+            EXPECT_EQ(index_c.occupation_ratio(p, c), ((double) common) / ((double) p->size()));
+            EXPECT_EQ(index_p.occupation_ratio(c, p), ((double) common) / ((double) c->size()));
+        }
+    }
+
+    // No entries for clusters that do not exist
+    size_t entries = 0;
+    typename ClusterIndex<TypeParam>::intersection_table_t::const_iterator ti;
+    for (ti = table.begin(); ti != table.end(); ++ti) {
+        entries += ti->second.size();
+    }
+    EXPECT_EQ(overlapping, entries);
+    EXPECT_GT(overlapping, current.size());
+
+    for (size_t n = 0; n < current.size(); n++) {
+        delete current[n];
+    }
+    for (size_t m = 0; m < previous.size(); m++) {
+        delete previous[m];
+    }
+}
+
+#endif
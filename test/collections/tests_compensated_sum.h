@@ -0,0 +1,51 @@
+#ifndef M3D_TEST_COMPENSATED_SUM_H
+#define M3D_TEST_COMPENSATED_SUM_H
+
+#include <meanie3D/utils/compensated_sum.h>
+
+#include <gtest/gtest.h>
+#include <cmath>
+
+using namespace testing;
+using namespace m3D;
+
+class CompensatedSumTest : public testing::Test
+{
+};
+
+TEST(CompensatedSumTest, DoubleIsPlainSum) {
+    EXPECT_FALSE(utils::compensates_sums<double>::value);
+
+    // Values of widely varying magnitude, where compensation
+    // would change the result
+    unsigned int seed = 17;
+    double plain = 0.0;
+    utils::CompensatedSum<double> sum;
+    for (int i = 0; i < 100000; i++) {
+        seed = seed * 1103515245 + 12345;
+        double value = ((seed >> 8) % 1000) * ((i % 3 == 0) ? 1e8 : 1e-8);
+        plain += value;
+        sum += value;
+    }
+
+    // bit for bit
+    EXPECT_EQ(plain, sum.value());
+}
+
+TEST(CompensatedSumTest, FloatIsCompensated) {
+    EXPECT_TRUE(utils::compensates_sums<float>::value);
+
+    float plain = 0.0f;
+    double reference = 0.0;
+    utils::CompensatedSum<float> sum;
+    for (int i = 0; i < 1000000; i++) {
+        plain += 0.1f;
+        reference += (double) 0.1f;
+        sum += 0.1f;
+    }
+
+    EXPECT_NEAR(reference, sum.value(), 1e-7 * reference);
+    EXPECT_LT(fabs(sum.value() - reference), fabs(plain - reference));
+}
+
+#endif
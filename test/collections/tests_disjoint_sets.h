@@ -0,0 +1,153 @@
+#ifndef M3D_TEST_DISJOINT_SETS_H
+#define M3D_TEST_DISJOINT_SETS_H
+
+#include <meanie3D/utils/disjoint_sets.h>
+
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace testing;
+using namespace m3D;
+
+class DisjointSetsTest : public testing::Test
+{
+public:
+};
+
+TEST(DisjointSetsTest, Singletons) {
+    utils::DisjointSets sets(5);
+    EXPECT_EQ(5, sets.size());
+    for (int i = 0; i < 5; i++) {
+        EXPECT_EQ(i, sets.root(i));
+        EXPECT_EQ(i, sets.find(i));
+    }
+}
+
+TEST(DisjointSetsTest, RepresentativeIsSmallestElement) {
+    // The same partition {0,3,7} {1,2} {4} {5,6,8,9}
+    // built in two different orders
+    utils::DisjointSets a(10);
+    a.unite(7, 3);
+    a.unite(3, 0);
+    a.unite(2, 1);
+    a.unite(9, 8);
+    a.unite(8, 6);
+    a.unite(6, 5);
+
+    utils::DisjointSets b(10);
+    b.unite(5, 9);
+    b.unite(1, 2);
+    b.unite(0, 7);
+    b.unite(6, 8);
+    b.unite(9, 6);
+    b.unite(7, 3);
+
+    int expected[10] = {0, 1, 1, 0, 4, 5, 5, 0, 5, 5};
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(expected[i], a.root(i));
+        EXPECT_EQ(expected[i], b.root(i));
+        EXPECT_EQ(expected[i], b.find(i));
+    }
+
+    // uniting elements of the same set changes nothing
+    EXPECT_EQ(0, a.unite(3, 7));
+    EXPECT_EQ(0, a.root(7));
+}
+
+TEST(DisjointSetsTest, LongChain) {
+    const int n = 10000;
+    utils::DisjointSets sets(n);
+    for (int i = n - 1; i > 0; i--) {
+        sets.unite(i, i - 1);
+    }
+    for (int i = 0; i < n; i++) {
+        EXPECT_EQ(0, sets.root(i));
+    }
+}
+
+TEST(DisjointSetsTest, ConcurrentUnionsMatchSerialUnions) {
+    // Random edges from a fixed linear congruential sequence,
+    // with many elements in few sets
+    const int n = 100000;
+    const int num_edges = 80000;
+    std::vector<int> from(num_edges), to(num_edges);
+    unsigned long r = 12345;
+    for (int i = 0; i < num_edges; i++) {
+        r = (r * 1103515245 + 12345) % 2147483648UL;
+        from[i] = (int) (r % n);
+        r = (r * 1103515245 + 12345) % 2147483648UL;
+        to[i] = (int) (r % n);
+    }
+
+    utils::DisjointSets serial(n);
+    for (int i = 0; i < num_edges; i++) {
+        serial.unite(from[i], to[i]);
+    }
+
+    utils::DisjointSets concurrent(n);
+#if WITH_OPENMP
+#pragma omp parallel for schedule(dynamic,100)
+#endif
+    for (int i = 0; i < num_edges; i++) {
+        concurrent.unite_concurrent(from[i], to[i]);
+    }
+
+    for (int i = 0; i < n; i++) {
+        EXPECT_EQ(serial.root(i), concurrent.root(i));
+    }
+}
+
+TEST(DisjointSetsTest, ConcurrentReverseChainsCompressed) {
+    // Chains united from their far end, in chunks run in reverse
+    // order, as happens along the shift chains of the meanshift graph
+    const int n = 200000;
+    const int chain_length = 5000;
+    const int chunk_size = 1000;
+    const int num_chunks = n / chunk_size;
+
+    utils::DisjointSets sets(n);
+#if WITH_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int chunk = 0; chunk < num_chunks; chunk++) {
+        int begin = (num_chunks - 1 - chunk) * chunk_size;
+        for (int i = begin + chunk_size - 1; i >= begin; i--) {
+            if (i % chain_length != 0) {
+                sets.unite_concurrent(i, i - 1);
+            }
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        EXPECT_EQ(i - i % chain_length, sets.root(i));
+    }
+
+    sets.compress();
+    for (int i = 0; i < n; i++) {
+        EXPECT_EQ(i - i % chain_length, sets.root(i));
+        EXPECT_EQ(i - i % chain_length, sets.find(i));
+    }
+}
+
+TEST(DisjointSetsTest, CompressMatchesRoots) {
+    const int n = 50000;
+    utils::DisjointSets sets(n);
+    unsigned long r = 54321;
+    for (int i = 0; i < n / 2; i++) {
+        r = (r * 1103515245 + 12345) % 2147483648UL;
+        int a = (int) (r % n);
+        r = (r * 1103515245 + 12345) % 2147483648UL;
+        sets.unite(a, (int) (r % n));
+    }
+
+    std::vector<int> roots(n);
+    for (int i = 0; i < n; i++) {
+        roots[i] = sets.root(i);
+    }
+    sets.compress();
+    for (int i = 0; i < n; i++) {
+        EXPECT_EQ(roots[i], sets.root(i));
+    }
+}
+
+#endif
@@ -425,5 +425,129 @@ TYPED_TEST(MultiArrayBoostTest, VectorDataTypes) {
     TEST_A5(dims, a52, index, 550);
 };
 
+#pragma mark -
+#pragma mark Fixed rank Multi-Array
+
+template<typename T>
+class MultiArrayFixedTest : public testing::Test
+{
+};
+
+TYPED_TEST_CASE(MultiArrayFixedTest, VectorDataTypes);
+
+TYPED_TEST(MultiArrayFixedTest, VectorDataTypes) {
+    vector<size_t> dims;
+    vector<int> index;
+
+    // 2D
+
+    dims.resize(2);
+    dims[0] = 10;
+    dims[1] = 20;
+
+    MultiArrayFixed<TypeParam, 2> a21(dims);
+    SET_A2(dims, a21, index, 200);
+    TEST_A2(dims, a21, index, 200);
+
+    MultiArrayFixed<TypeParam, 2> a22(dims, 250);
+    TEST_A2(dims, a22, index, 250);
+
+    // 3D
+
+    dims.resize(3);
+    dims[0] = 10;
+    dims[1] = 10;
+    dims[2] = 100;
+
+    MultiArrayFixed<TypeParam, 3> a31(dims);
+    SET_A3(dims, a31, index, 300);
+    TEST_A3(dims, a31, index, 300);
+
+    MultiArrayFixed<TypeParam, 3> a32(dims, 350);
+    TEST_A3(dims, a32, index, 350);
+
+    // Fixed size grid points and linear indexes must
+    // address the same element as the vector version
+
+    FixedLinearIndexMapping<3> mapping(dims);
+    typename MultiArrayFixed<TypeParam, 3>::GridPoint gp;
+    for (size_t i = 0; i < mapping.size(); i++) {
+        mapping.linear_to_grid(i, gp);
+        EXPECT_EQ(i, a31.linear_index(gp));
+        a31.set(gp, (TypeParam) (i % 1000));
+    }
+    index.resize(3);
+    for (size_t i = 0; i < mapping.size(); i++) {
+        mapping.linear_to_grid(i, gp);
+        for (size_t d = 0; d < 3; d++) index[d] = gp[d];
+        EXPECT_EQ((TypeParam) (i % 1000), a31.get(index));
+    }
+
+    // Copying from another implementation
+
+    MultiArrayBlitz<TypeParam> b31(dims, 375);
+    a32.copy_from(&b31);
+    TEST_A3(dims, a32, index, 375);
+
+    // Assignment makes a deep copy, also between
+    // different dimensions
+
+    MultiArrayFixed<TypeParam, 2> a23(a22.get_dimensions(), 275);
+    a23 = a21;
+    dims = a21.get_dimensions();
+    TEST_A2(dims, a23, index, 200);
+    a21.populate_array(225);
+    TEST_A2(dims, a23, index, 200);
+
+    vector<size_t> small_dims(2, 3);
+    MultiArrayFixed<TypeParam, 2> a24(small_dims, 1);
+    a24 = a23;
+    EXPECT_EQ(a23.get_dimensions(), a24.get_dimensions());
+    TEST_A2(dims, a24, index, 200);
+
+    a24 = a24;
+    TEST_A2(dims, a24, index, 200);
+
+    // An array storing a box only: grid points outside of
+    // the box read the default value
+
+    vector<size_t> box_origin(2), box_extent(2);
+    box_origin[0] = 2;
+    box_origin[1] = 5;
+    box_extent[0] = 3;
+    box_extent[1] = 4;
+    MultiArrayFixed<TypeParam, 2> a25(dims, box_origin, box_extent, 7);
+    EXPECT_EQ(dims, a25.get_dimensions());
+    EXPECT_EQ(dims[0] * dims[1], a25.size());
+    EXPECT_EQ(12, a25.stored_size());
+
+    index.resize(2);
+    index[0] = 3;
+    index[1] = 6;
+    a25.set(index, 9);
+    EXPECT_EQ((TypeParam) 9, a25.get(index));
+    EXPECT_EQ(1, a25.count_value(9));
+    EXPECT_EQ(dims[0] * dims[1] - 1, a25.count_value(7));
+
+    index[0] = 0;
+    index[1] = 0;
+    EXPECT_EQ((TypeParam) 7, a25.get(index));
+    EXPECT_THROW(a25.set(index, 9), std::out_of_range);
+
+    typename MultiArrayFixed<TypeParam, 2>::GridPoint gp2;
+    gp2[0] = 4;
+    gp2[1] = 8;
+    a25.set(gp2, 8);
+    EXPECT_EQ((TypeParam) 8, a25.get(gp2));
+    gp2[1] = 9;
+    EXPECT_EQ((TypeParam) 7, a25.get(gp2));
+
+    MultiArrayFixed<TypeParam, 2> a26(a25);
+    EXPECT_EQ(12, a26.stored_size());
+    index[0] = 3;
+    index[1] = 6;
+    EXPECT_EQ((TypeParam) 9, a26.get(index));
+}
+
 #endif
 
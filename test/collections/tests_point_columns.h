@@ -0,0 +1,125 @@
+#ifndef M3D_TEST_POINT_COLUMNS_H
+#define M3D_TEST_POINT_COLUMNS_H
+
+#include <meanie3D/featurespace.h>
+
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace testing;
+using namespace m3D;
+
+typedef testing::Types<float, double> PointColumnsDataTypes;
+
+template<typename T>
+class PointColumnsTest : public testing::Test
+{
+};
+
+TYPED_TEST_CASE(PointColumnsTest, PointColumnsDataTypes);
+
+/** Points made from one storage lie in the same block, one row
+ * after another, with every component in its own column.
+ */
+TYPED_TEST(PointColumnsTest, RowsAreContiguous) {
+    PointStorage<TypeParam> storage(4);
+
+    vector<int> gp(2);
+    vector<TypeParam> coord(2);
+    vector<TypeParam> values(3);
+
+    typename Point<TypeParam>::list points;
+    for (int i = 0; i < 6; i++) {
+        gp[0] = i;
+        gp[1] = 10 + i;
+        coord[0] = (TypeParam) i;
+        coord[1] = (TypeParam) (10 + i);
+        values[0] = coord[0];
+        values[1] = coord[1];
+        values[2] = (TypeParam) (100 + i);
+        points.push_back(new Point<TypeParam>(storage, gp, coord, values));
+    }
+
+    // four rows per block
+    EXPECT_EQ(points[0]->columns(), points[3]->columns());
+    EXPECT_NE(points[3]->columns(), points[4]->columns());
+    EXPECT_EQ(points[4]->columns(), points[5]->columns());
+
+    PointColumns<TypeParam> *block = points[0]->columns();
+    EXPECT_EQ((size_t) 4, block->size());
+    for (size_t i = 0; i < 4; i++) {
+        EXPECT_EQ(i, points[i]->row());
+        EXPECT_EQ((int) i, block->gridpoint(0)[i]);
+        EXPECT_EQ((int) (10 + i), block->gridpoint(1)[i]);
+        EXPECT_EQ((TypeParam) (100 + i), block->values(2)[i]);
+    }
+
+    // writing through the view writes the column
+    points[1]->shift[2] = 5.0;
+    EXPECT_EQ((TypeParam) 5.0, block->shift(2)[1]);
+
+    EXPECT_EQ(values, (vector<TypeParam>) points[5]->values);
+    EXPECT_EQ(gp, (vector<int>) points[5]->gridpoint);
+
+    for (size_t i = 0; i < points.size(); i++) {
+        delete points[i];
+    }
+}
+
+/** Copies get rows of their own. The block stays alive as long
+ * as any of its points does.
+ */
+TYPED_TEST(PointColumnsTest, CopiesAreIndependent) {
+    vector<int> gp(1, 3);
+    vector<TypeParam> coord(1, 0.5);
+    vector<TypeParam> values(2, 0.5);
+    values[1] = 2.0;
+
+    typename Point<TypeParam>::ptr copy = NULL;
+    {
+        PointStorage<TypeParam> storage;
+        Point<TypeParam> p(storage, gp, coord, values);
+        copy = new Point<TypeParam>(p);
+        EXPECT_NE(p.columns(), copy->columns());
+
+        p.values[1] = 4.0;
+        EXPECT_EQ((TypeParam) 2.0, copy->values[1]);
+    }
+
+    EXPECT_EQ(gp, (vector<int>) copy->gridpoint);
+    EXPECT_EQ(coord, (vector<TypeParam>) copy->coordinate);
+    EXPECT_EQ(values, (vector<TypeParam>) copy->values);
+    delete copy;
+}
+
+/** Assigning to a view copies the elements and never re-binds.
+ */
+TEST(ColumnViewTest, AssignmentCopiesElements) {
+    // two points in columns of capacity 3
+    int columns[6] = {1, 2, 3, 4, 5, 6};
+    ColumnView<int> a;
+    ColumnView<int> b;
+    a.rebind(&columns[0], 3, 2);
+    b.rebind(&columns[1], 3, 2);
+
+    EXPECT_EQ(1, a[0]);
+    EXPECT_EQ(4, a[1]);
+    EXPECT_EQ(2, b[0]);
+    EXPECT_EQ(5, b[1]);
+
+    a = b;
+    EXPECT_EQ(2, columns[0]);
+    EXPECT_EQ(5, columns[3]);
+    EXPECT_EQ(&columns[0], &a[0]);
+    EXPECT_TRUE(a == b);
+
+    vector<int> v(2, 7);
+    b = v;
+    EXPECT_EQ(7, columns[1]);
+    EXPECT_EQ(7, columns[4]);
+    EXPECT_TRUE(b == v);
+    EXPECT_TRUE(a != b);
+    EXPECT_THROW(b.at(2), std::out_of_range);
+}
+
+#endif
@@ -191,6 +191,222 @@ TYPED_TEST(FSClusteringTest2D, FS_Clustering_2D_Range_Test)
         ClusterList<TypeParam>::reset_clustering(this->m_featureSpace);
     }
 }
+
+#pragma mark -
+#pragma mark Single vs. double precision
+
+/** Runs the detection on the same data in single and double
+ * precision and checks that the clusters match.
+ */
+class FSClusteringPrecisionTest2D : public FSClusteringTest2D<double>
+{
+protected:
+
+    template<typename T>
+    detection_params_t<T> params() {
+        detection_params_t<T> params = Detection<T>::defaultParams();
+        params.ranges = vector<T>(this->m_bandwidths.at(0).begin(), this->m_bandwidths.at(0).end());
+        params.kernel_name = "gauss";
+        params.variables = this->m_variables;
+        params.dimensions = this->m_dimensions;
+        params.dimension_variables = this->m_dimension_variables;
+        params.min_cluster_size = 25;
+        params.filename = this->m_filename;
+        return params;
+    }
+
+    /** @return number of points in the clusters of the list
+     */
+    template<typename A>
+    size_t total_points(ClusterList<A> *a) {
+        size_t total = 0;
+        for (size_t ci = 0; ci < a->clusters.size(); ci++) {
+            total += a->clusters.at(ci)->size();
+        }
+        return total;
+    }
+
+    /** @return number of points of a, which lie in the cluster of b
+     * that their cluster has most points in common with. Each cluster
+     * of b may only be matched once.
+     */
+    template<typename A, typename B>
+    size_t matched_points(ClusterList<A> *a, ClusterList<B> *b) {
+        // Label each grid point with its cluster in b
+        map<vector<int>, size_t> labels;
+        for (size_t ci = 0; ci < b->clusters.size(); ci++) {
+            typename Cluster<B>::ptr c = b->clusters.at(ci);
+            for (size_t pi = 0; pi < c->size(); pi++) {
+                labels[c->at(pi)->gridpoint] = ci;
+            }
+        }
+        size_t matched = 0;
+        set<size_t> used;
+        for (size_t ci = 0; ci < a->clusters.size(); ci++) {
+            typename Cluster<A>::ptr c = a->clusters.at(ci);
+            map<size_t, size_t> votes;
+            for (size_t pi = 0; pi < c->size(); pi++) {
+                map<vector<int>, size_t>::iterator fi = labels.find(c->at(pi)->gridpoint);
+                if (fi != labels.end()) {
+                    votes[fi->second]++;
+                }
+            }
+            size_t best = 0, best_votes = 0;
+            for (map<size_t, size_t>::iterator vi = votes.begin(); vi != votes.end(); vi++) {
+                if (vi->second > best_votes) {
+                    best = vi->first;
+                    best_votes = vi->second;
+                }
+            }
+            EXPECT_TRUE(used.insert(best).second);
+            matched += best_votes;
+        }
+        return matched;
+    }
+};
+
+TEST_F(FSClusteringPrecisionTest2D, FS_Clustering_2D_Precision_Test)
+{
+    using namespace m3D;
+
+    // The double precision run is the reference. Its mean-shift sums
+    // are not compensated, so it is the same as before single
+    // precision support was added.
+    ASSERT_FALSE(utils::compensates_sums<double>::value);
+
+    detection_params_t<double> double_params = this->params<double>();
+    detection_context_t<double> double_ctx;
+    Detection<double>::initialiseContext(double_ctx);
+    Detection<double>::run(double_params, double_ctx);
+
+    detection_params_t<float> float_params = this->params<float>();
+    detection_context_t<float> float_ctx;
+    Detection<float>::initialiseContext(float_ctx);
+    Detection<float>::run(float_params, float_ctx);
+
+    ASSERT_EQ(double_ctx.clusters->clusters.size(), float_ctx.clusters->clusters.size());
+
+    // Each double precision cluster must correspond to one single
+    // precision cluster. Allow for a few points on the boundaries
+    // between clusters to fall either way.
+    size_t total = this->total_points(double_ctx.clusters);
+    EXPECT_GE(this->matched_points(double_ctx.clusters, float_ctx.clusters), (size_t) (0.99 * total));
+
+    Detection<double>::cleanup(double_params, double_ctx);
+    Detection<float>::cleanup(float_params, float_ctx);
+}
+
+#pragma mark -
+#pragma mark Tiled detection
+
+/** Runs the detection on the whole domain and in tiles
+ * and checks that the clusters match.
+ */
+class FSClusteringTiledTest2D : public FSClusteringPrecisionTest2D
+{
+};
+
+TEST_F(FSClusteringTiledTest2D, FS_Clustering_2D_Tiled_Test)
+{
+    using namespace m3D;
+
+    detection_params_t<double> params = this->params<double>();
+    detection_context_t<double> ctx;
+    Detection<double>::initialiseContext(ctx);
+    Detection<double>::run(params, ctx);
+
+    // Four tiles, the seams run through the middle of the domain
+    vector<size_t> dims = ctx.coord_system->get_dimension_sizes();
+    detection_params_t<double> tiled_params = this->params<double>();
+    for (size_t d = 0; d < dims.size(); d++) {
+        tiled_params.tile_size.push_back(dims[d] / 2 + 1);
+    }
+    detection_context_t<double> tiled_ctx;
+    Detection<double>::initialiseContext(tiled_ctx);
+    Detection<double>::run(tiled_params, tiled_ctx);
+
+    ASSERT_EQ(ctx.clusters->clusters.size(), tiled_ctx.clusters->clusters.size());
+
+    size_t total = this->total_points(ctx.clusters);
+    EXPECT_GE(this->matched_points(ctx.clusters, tiled_ctx.clusters), (size_t) (0.99 * total));
+
+    // Processing the tiles in parallel must not change the result
+    detection_params_t<double> parallel_params = tiled_params;
+    parallel_params.parallel_tiles = true;
+    detection_context_t<double> parallel_ctx;
+    Detection<double>::initialiseContext(parallel_ctx);
+    Detection<double>::run(parallel_params, parallel_ctx);
+
+    ASSERT_EQ(tiled_ctx.clusters->clusters.size(), parallel_ctx.clusters->clusters.size());
+    for (size_t ci = 0; ci < tiled_ctx.clusters->clusters.size(); ci++) {
+        Cluster<double>::ptr a = tiled_ctx.clusters->clusters.at(ci);
+        Cluster<double>::ptr b = parallel_ctx.clusters->clusters.at(ci);
+        ASSERT_EQ(a->size(), b->size());
+        for (size_t pi = 0; pi < a->size(); pi++) {
+            EXPECT_EQ(a->at(pi)->gridpoint, b->at(pi)->gridpoint);
+        }
+    }
+
+    Detection<double>::cleanup(params, ctx);
+    Detection<double>::cleanup(tiled_params, tiled_ctx);
+    Detection<double>::cleanup(parallel_params, parallel_ctx);
+}
+
+/** Checks that the grid-shaped structures of a tile only
+ * cover the tile, not the whole grid.
+ */
+TEST_F(FSClusteringTiledTest2D, FS_Clustering_2D_Tile_Allocation_Test)
+{
+    using namespace m3D;
+
+    detection_params_t<double> params = this->params<double>();
+    detection_context_t<double> ctx;
+    Detection<double>::initialiseContext(ctx);
+    Detection<double>::run(params, ctx);
+
+    vector<size_t> dims = ctx.coord_system->get_dimension_sizes();
+    for (size_t d = 0; d < dims.size(); d++) {
+        params.tile_size.push_back(dims[d] / 2 + 1);
+    }
+    vector<detection_tile_t<double> > tiles = Detection<double>::create_tiles(params, ctx);
+    ASSERT_GT(tiles.size(), (size_t) 1);
+
+    size_t grid_points = 1;
+    for (size_t d = 0; d < dims.size(); d++) {
+        grid_points *= dims[d];
+    }
+
+    for (size_t ti = 0; ti < tiles.size(); ti++) {
+        const detection_tile_t<double> &tile = tiles[ti];
+        size_t tile_points = 1;
+        for (size_t d = 0; d < dims.size(); d++) {
+            tile_points *= tile.size[d];
+        }
+        ASSERT_LT(tile_points, grid_points);
+
+        FeatureSpace<double> fs(ctx.coord_system, ctx.data_store,
+                                params.lower_thresholds, params.upper_thresholds,
+                                params.replacement_values, tile.origin, tile.size, false);
+
+        // The off-limits mask stores the tile only
+        const MultiArrayFixed<bool, 2> *off_limits
+                = dynamic_cast<const MultiArrayFixed<bool, 2> *>(fs.off_limits());
+        ASSERT_TRUE(off_limits != NULL);
+        EXPECT_EQ(dims, off_limits->get_dimensions());
+        EXPECT_EQ(tile_points, off_limits->stored_size());
+
+        // The grid lookup used by grid mean-shift and graph
+        // aggregation stays within the tile
+        ArrayIndex<double> index(fs.spatial_rank(), fs.points, false);
+        EXPECT_EQ(fs.size(), index.count());
+        for (size_t d = 0; d < dims.size(); d++) {
+            EXPECT_GE(index.origin()[d], (int) tile.origin[d]);
+            EXPECT_LE(index.origin()[d] + index.dimensions()[d], tile.origin[d] + tile.size[d]);
+        }
+    }
+
+    Detection<double>::cleanup(params, ctx);
+}
 #endif
 
 // 3D
@@ -25,6 +25,7 @@
 #define RUN_WEIGHED_SAMPLE 1
 #define RUN_ITERATION 1
 #define RUN_CLUSTERING 1
+#define RUN_TRACKING 1
 
 #pragma mark -
 #pragma mark Data Types 
@@ -43,4 +44,13 @@ typedef Types<float, double> DataTypes;
 
 #endif
 
+#pragma mark -
+#pragma mark Tracking
+
+#if RUN_TRACKING
+
+#include "tracking.h"
+
+#endif
+
 #endif
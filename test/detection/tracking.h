@@ -0,0 +1,80 @@
+#ifndef M3D_TEST_DETECTION_TRACKING_H
+#define M3D_TEST_DETECTION_TRACKING_H
+
+#include "../testcase_base.h"
+
+#pragma mark -
+#pragma mark Exhaustive tracking
+
+/** Tracking, which scores every pair of clusters instead of
+ * the pairs found by the spatial pruning.
+ */
+template<typename T>
+class ExhaustiveTracking : public Tracking<T>
+{
+public:
+
+    ExhaustiveTracking(tracking_param_t params) : Tracking<T>(params) {};
+
+protected:
+
+    void findCandidates(typename Tracking<T>::tracking_run_t &run,
+                        typename SimpleMatrix<T>::flag_matrix_t &candidates) {
+        candidates = SimpleMatrix<T>::create_flag_matrix(run.N, run.M, 1);
+    };
+};
+
+#pragma mark -
+#pragma mark Test Fixture
+
+/** Tracks a scene of rectangular clusters on a 2D grid, which
+ * contains simple moves, a pair exactly at the maximum displacement,
+ * a cluster moving out of reach, a split and a merge. Some of the
+ * split and merge pairs only overlap, with their centers out of reach.
+ */
+template<class T>
+class FSTrackingTest2D : public FSTestBase<T>
+{
+protected:
+
+    /** Creates a cluster covering the grid points from (x0,y0) to
+     * (x1,y1), including both. The values of the points vary with
+     * their position, so that the histograms differ.
+     * @param x0
+     * @param x1
+     * @param y0
+     * @param y1
+     * @return cluster (owns its points)
+     */
+    typename Cluster<T>::ptr create_cluster(int x0, int x1, int y0, int y1);
+
+    /** Creates the clusters of either time step. The previous clusters
+     * are numbered from 1 on.
+     * @param previous (true) or current (false) time step
+     * @return cluster list
+     */
+    typename ClusterList<T>::ptr create_scene(bool previous);
+
+    /** Tracks a fresh copy of the scene.
+     * @param tracking
+     * @return tracked current cluster list
+     */
+    typename ClusterList<T>::ptr track_scene(Tracking<T> &tracking);
+
+    /** @return parameters, whose maximum displacement equals the distance
+     * of the pair set up for it
+     */
+    tracking_param_t tracking_params();
+
+public:
+
+    FSTrackingTest2D();
+
+    virtual void SetUp();
+
+    virtual void TearDown();
+};
+
+#include "tracking_impl.h"
+
+#endif
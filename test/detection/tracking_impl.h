@@ -0,0 +1,226 @@
+#ifndef M3D_TEST_DETECTION_TRACKING_IMPL_H
+#define M3D_TEST_DETECTION_TRACKING_IMPL_H
+
+#include <meanie3D/meanie3D.h>
+
+#include <algorithm>
+
+#pragma mark -
+#pragma mark Scene
+
+// Boxes (x0,x1,y0,y1) in grid points. With 100 grid points from -1m
+// to 1m, 15 grid points are the maximum displacement (0.3m in 1s).
+
+static const int TRACKING_PREVIOUS_BOXES[][4] = {
+        {5,  9,  88, 92},   // 1: moves by 5
+        {30, 34, 88, 92},   // 2: moves by 10
+        {60, 64, 88, 92},   // 3: moves by 14
+        {88, 92, 60, 64},   // 4: moves by 16, out of reach
+        {8,  12, 70, 74},   // 5: moves by exactly 15
+        {50, 95, 20, 40},   // 6: large, requires overlap, splits
+        {20, 24, 50, 56},   // 7: merges, center out of reach
+        {35, 45, 50, 56}    // 8: merges, center in reach
+};
+
+static const int TRACKING_CURRENT_BOXES[][4] = {
+        {10, 14, 88, 92},   // from 1
+        {40, 44, 88, 92},   // from 2
+        {74, 78, 88, 92},   // from 3
+        {88, 92, 76, 80},   // from 4
+        {23, 27, 70, 74},   // from 5
+        {50, 60, 20, 40},   // split of 6, center out of reach
+        {82, 95, 20, 40},   // split of 6, center out of reach
+        {20, 60, 50, 56}    // merge of 7 and 8
+};
+
+static const size_t TRACKING_NUM_BOXES = 8;
+
+template<class T>
+typename Cluster<T>::ptr
+FSTrackingTest2D<T>::create_cluster(int x0, int x1, int y0, int y1) {
+    using namespace m3D::utils::vectors;
+
+    CoordinateSystem<T> *cs = this->coordinate_system();
+    vector<T> mode(3, 0.0);
+    typename Cluster<T>::ptr c = new Cluster<T>(mode, 2);
+    typename CoordinateSystem<T>::GridPoint gridpoint = cs->newGridPoint();
+    typename CoordinateSystem<T>::Coordinate coordinate = cs->newCoordinate();
+    for (int x = x0; x <= x1; x++) {
+        for (int y = y0; y <= y1; y++) {
+            gridpoint[0] = x;
+            gridpoint[1] = y;
+            cs->lookup(gridpoint, coordinate);
+            vector<T> values(3);
+            values[0] = coordinate[0];
+            values[1] = coordinate[1];
+            values[2] = FS_VALUE_MAX * ((3 * x + 5 * y) % 11 + 1) / 12.0;
+            typename Point<T>::ptr p = PointFactory<T>::get_instance()->create(gridpoint, coordinate, values);
+            c->add_point(p);
+            mode += values;
+        }
+    }
+    c->mode = mode / ((T) c->size());
+    return c;
+}
+
+template<class T>
+typename ClusterList<T>::ptr
+FSTrackingTest2D<T>::create_scene(bool previous) {
+    typename Cluster<T>::list clusters;
+    for (size_t i = 0; i < TRACKING_NUM_BOXES; i++) {
+        const int *box = previous ? TRACKING_PREVIOUS_BOXES[i] : TRACKING_CURRENT_BOXES[i];
+        clusters.push_back(create_cluster(box[0], box[1], box[2], box[3]));
+    }
+
+    // The values are made up of the dimensions and the variable
+    vector<string> variables = this->m_dimension_variables;
+    variables.insert(variables.end(), this->m_variables.begin(), this->m_variables.end());
+
+    typename ClusterList<T>::ptr list = new ClusterList<T>(clusters,
+                                                           this->m_filename,
+                                                           variables,
+                                                           this->m_dimensions,
+                                                           this->m_dimension_variables,
+                                                           previous ? 1000 : 1001);
+    if (previous) {
+        for (size_t i = 0; i < clusters.size(); i++) {
+            clusters[i]->id = i + 1;
+            clusters[i]->uuid = i + 1;
+        }
+        list->highest_id = clusters.size();
+        list->highest_uuid = clusters.size();
+    }
+    return list;
+}
+
+template<class T>
+typename ClusterList<T>::ptr
+FSTrackingTest2D<T>::track_scene(Tracking<T> &tracking) {
+    typename ClusterList<T>::ptr previous = create_scene(true);
+    typename ClusterList<T>::ptr current = create_scene(false);
+
+    // The valid range of the tracking variable is read from the file
+    current->file = new NcFile(this->m_filename, NcFile::read);
+
+    tracking.track(previous, current, this->coordinate_system());
+
+    previous->clear(true);
+    delete previous;
+    return current;
+}
+
+template<class T>
+tracking_param_t
+FSTrackingTest2D<T>::tracking_params() {
+    using namespace m3D::utils::vectors;
+
+    // Same calculation of the displacement as in the tracking,
+    // so that the pair is neither in nor out of reach by rounding
+    typename Cluster<T>::ptr p = create_cluster(TRACKING_PREVIOUS_BOXES[4][0], TRACKING_PREVIOUS_BOXES[4][1],
+                                                TRACKING_PREVIOUS_BOXES[4][2], TRACKING_PREVIOUS_BOXES[4][3]);
+    typename Cluster<T>::ptr c = create_cluster(TRACKING_CURRENT_BOXES[4][0], TRACKING_CURRENT_BOXES[4][1],
+                                                TRACKING_CURRENT_BOXES[4][2], TRACKING_CURRENT_BOXES[4][3]);
+    vector<T> dx = c->geometrical_center() - p->geometrical_center();
+    T distance = vector_norm(this->coordinate_system()->to_meters(dx));
+    p->clear(true);
+    c->clear(true);
+    delete p;
+    delete c;
+
+    tracking_param_t params = Tracking<T>::defaultParams();
+    params.maxVelocity = ::units::values::meters_per_second(distance);
+    params.correlation_weight = 1.0;
+    params.tracking_variable = this->m_variables[0];
+    params.verbosity = VerbositySilent;
+    return params;
+}
+
+template<class T>
+void FSTrackingTest2D<T>::SetUp() {
+    FSTestBase<T>::SetUp();
+    this->generate_dimensions();
+    this->add_variable("tracking_test", 0.0, FS_VALUE_MAX);
+    this->reopen_file_for_reading();
+}
+
+template<class T>
+void FSTrackingTest2D<T>::TearDown() {
+    FSTestBase<T>::TearDown();
+}
+
+template<class T>
+FSTrackingTest2D<T>::FSTrackingTest2D() : FSTestBase<T>() {
+    this->m_settings = new FSTestSettings(2, 1, NUMBER_OF_GRIDPOINTS, FSTestBase<T>::filename_from_current_testcase());
+}
+
+#pragma mark -
+#pragma mark Pruned vs. exhaustive scoring
+
+#if RUN_2D
+
+TYPED_TEST_CASE(FSTrackingTest2D, DataTypes);
+
+/** Tracks the scene with the spatial pruning and parallel scoring,
+ * and with all pairs scored by one thread. The results must be
+ * the same.
+ */
+TYPED_TEST(FSTrackingTest2D, FS_Tracking_Pruned_2D_Test)
+{
+    tracking_param_t params = this->tracking_params();
+
+#if WITH_OPENMP
+    int max_threads = omp_get_max_threads();
+    omp_set_num_threads(1);
+#endif
+    ExhaustiveTracking<TypeParam> exhaustive(params);
+    typename ClusterList<TypeParam>::ptr expected = this->track_scene(exhaustive);
+#if WITH_OPENMP
+    omp_set_num_threads(std::max(max_threads, 4));
+#endif
+    Tracking<TypeParam> pruned(params);
+    typename ClusterList<TypeParam>::ptr result = this->track_scene(pruned);
+#if WITH_OPENMP
+    omp_set_num_threads(max_threads);
+#endif
+
+    ASSERT_EQ(expected->size(), result->size());
+    for (size_t n = 0; n < result->size(); n++) {
+        EXPECT_EQ(expected->clusters[n]->id, result->clusters[n]->id);
+        EXPECT_EQ(expected->clusters[n]->uuid, result->clusters[n]->uuid);
+    }
+    EXPECT_EQ(expected->tracked_ids, result->tracked_ids);
+    EXPECT_EQ(expected->new_ids, result->new_ids);
+    EXPECT_EQ(expected->dropped_ids, result->dropped_ids);
+    EXPECT_EQ(expected->splits, result->splits);
+    EXPECT_EQ(expected->merges, result->merges);
+    EXPECT_EQ(expected->highest_id, result->highest_id);
+    EXPECT_EQ(expected->highest_uuid, result->highest_uuid);
+
+    // The scene came out as set up
+    EXPECT_EQ((m3D::id_t) 1, result->clusters[0]->id);
+    EXPECT_EQ((m3D::id_t) 2, result->clusters[1]->id);
+    EXPECT_EQ((m3D::id_t) 3, result->clusters[2]->id);
+    EXPECT_NE((m3D::id_t) 4, result->clusters[3]->id);
+    EXPECT_EQ((m3D::id_t) 5, result->clusters[4]->id);
+
+    ASSERT_EQ((size_t) 1, result->splits.count(6));
+    id_set_t split_ids;
+    split_ids.insert(result->clusters[5]->id);
+    split_ids.insert(result->clusters[6]->id);
+    EXPECT_EQ(split_ids, result->splits[6]);
+
+    id_set_t merged_ids;
+    merged_ids.insert(7);
+    merged_ids.insert(8);
+    ASSERT_EQ((size_t) 1, result->merges.count(result->clusters[7]->id));
+    EXPECT_EQ(merged_ids, result->merges[result->clusters[7]->id]);
+
+    expected->clear(true);
+    delete expected;
+    result->clear(true);
+    delete result;
+}
+
+#endif
+
+#endif
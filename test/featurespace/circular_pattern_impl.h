@@ -165,6 +165,49 @@ TYPED_TEST(FSCircularPatternTest2D, FS_CicrularPattern_2D_Test)
         EXPECT_NEAR(vector_norm(m), 0.0, this->coordinate_system()->resolution_norm());
     }
 }
+
+TYPED_TEST(FSCircularPatternTest2D, FS_CicrularPattern_2D_KNN_Test)
+{
+    // origin
+    vector<TypeParam> x(this->m_settings->fs_dim(), 0);
+    x[ x.size() - 1 ] = FS_VALUE_MAX;
+
+    GaussianNormalKernel<TypeParam> kernel(1.0f);
+
+    // The pattern is symmetric around the origin, so the adaptive
+    // bandwidth must not produce a shift either
+    vector<TypeParam> h = this->m_bandwidths.at(0);
+    h.push_back(FS_VALUE_MAX);
+    for (size_t i = 0; i < this->m_nearest_neighbours.size(); i++) {
+        MeanshiftOperation<TypeParam> op(this->m_featureSpace, this->m_featureSpaceIndex);
+        KNNSearchParams<TypeParam> params(this->m_nearest_neighbours.at(i), h, h);
+        vector<TypeParam> m = op.meanshift(x, &params, &kernel);
+        EXPECT_NEAR(vector_norm(m), 0.0, this->coordinate_system()->resolution_norm());
+    }
+}
+
+TYPED_TEST(FSCircularPatternTest2D, FS_CicrularPattern_2D_KNN_Zero_Bandwidth_Test)
+{
+    // origin
+    vector<TypeParam> x(this->m_settings->fs_dim(), 0);
+    x[ x.size() - 1 ] = FS_VALUE_MAX;
+
+    GaussianNormalKernel<TypeParam> kernel(1.0f);
+
+    // A zero bandwidth component is left out of the ranking and
+    // of the adaptive bandwidth, rather than dividing by zero
+    vector<TypeParam> h = this->m_bandwidths.at(0);
+    h.push_back(0.0);
+    for (size_t i = 0; i < this->m_nearest_neighbours.size(); i++) {
+        MeanshiftOperation<TypeParam> op(this->m_featureSpace, this->m_featureSpaceIndex);
+        KNNSearchParams<TypeParam> params(this->m_nearest_neighbours.at(i), h, h);
+        vector<TypeParam> m = op.meanshift(x, &params, &kernel);
+        for (size_t k = 0; k < m.size(); k++) {
+            EXPECT_FALSE(std::isnan(m[k]) || std::isinf(m[k]));
+        }
+        EXPECT_NEAR(vector_norm(m), 0.0, this->coordinate_system()->resolution_norm());
+    }
+}
 #endif
 
 // 3D
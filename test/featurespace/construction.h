@@ -0,0 +1,62 @@
+#ifndef M3D_TEST_FS_CONSTRUCTION_H
+#define M3D_TEST_FS_CONSTRUCTION_H
+
+//
+//  construction.h
+//  cf-algorithms
+//
+//  Compares the values of the data store with values read
+//  one by one from the file, and the construction of the
+//  feature-space with a serial evaluation of each grid point
+//  in linear order.
+//
+
+#include "../testcase_base.h"
+#include "filters.h"
+
+#pragma mark -
+#pragma mark Test Fixture
+
+/** Runs on the same reflectivity-like pattern as the filter tests.
+ */
+template<class T>
+class FSConstructionTest2D : public FSFilterTest2D<T>
+{
+protected:
+
+    /** Compares the values of the data store, by grid point and by
+     * linear index, with the values read one by one from the file.
+     */
+    void compare_data_store();
+
+    /** Builds a feature-space with the given thresholds and checks
+     * points (including their order), off-limits mask and value
+     * ranges against a serial evaluation of the grid points in
+     * linear order.
+     * @param lower thresholds
+     * @param upper thresholds
+     */
+    void compare_construction(const map<int, double> &lower_thresholds,
+                              const map<int, double> &upper_thresholds);
+
+    /** Compares the construction without thresholds, with a lower
+     * threshold and with lower and upper thresholds. Without
+     * thresholds it is done with one thread as well.
+     */
+    void test_construction();
+
+public:
+
+    FSConstructionTest2D();
+};
+
+template<class T>
+class FSConstructionTest3D : public FSConstructionTest2D<T>
+{
+public:
+    FSConstructionTest3D();
+};
+
+#include "construction_impl.h"
+
+#endif
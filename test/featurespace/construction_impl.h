@@ -0,0 +1,220 @@
+#ifndef M3D_TEST_FS_CONSTRUCTION_IMPL_H
+#define M3D_TEST_FS_CONSTRUCTION_IMPL_H
+
+using namespace m3D;
+using namespace m3D::utils::vectors;
+
+#include "../testcase_base.h"
+
+#include <limits>
+
+#pragma mark -
+#pragma mark Test parameterization
+
+template<class T>
+FSConstructionTest2D<T>::FSConstructionTest2D() : FSFilterTest2D<T>() {
+}
+
+template<class T>
+FSConstructionTest3D<T>::FSConstructionTest3D() : FSConstructionTest2D<T>() {
+    delete this->m_settings;
+    this->m_settings = new FSTestSettings(3, 1, 30, FSTestBase<T>::filename_from_current_testcase());
+}
+
+#pragma mark -
+#pragma mark Data store
+
+template<class T>
+void FSConstructionTest2D<T>::compare_data_store() {
+    const CoordinateSystem<T> *cs = this->coordinate_system();
+    const DataStore<T> *ds = this->m_data_store;
+    ASSERT_EQ(this->m_variables.size(), ds->rank());
+
+    LinearIndexMapping mapping(cs->get_dimension_sizes());
+    size_t mismatches = 0, invalid = 0;
+    for (size_t var_index = 0; var_index < ds->rank(); var_index++) {
+        NcVar var = this->file()->getVar(this->m_variables[var_index]);
+        for (size_t linear_index = 0; linear_index < ds->size(); linear_index++) {
+            vector<int> gridpoint = mapping.linear_to_grid(linear_index);
+
+            // Read the value on its own. The test data has a fill
+            // value, which makes the value valid and in range or
+            // neither, and no scale factor or offset.
+            T expected;
+            vector<size_t> index(gridpoint.begin(), gridpoint.end());
+            var.getVar(index, &expected);
+            bool expected_valid = (expected != FSTestBase<T>::FILL_VALUE);
+
+            bool is_in_range = false, is_valid = false;
+            T value = ds->get(var_index, gridpoint, is_in_range, is_valid);
+            if (is_valid != expected_valid || is_in_range != expected_valid
+                || (expected_valid && value != expected)) {
+                mismatches++;
+            }
+
+            is_in_range = is_valid = false;
+            value = ds->get(var_index, linear_index, is_in_range, is_valid);
+            if (is_valid != expected_valid || is_in_range != expected_valid
+                || (expected_valid && value != expected)) {
+                mismatches++;
+            }
+
+            if (!expected_valid) {
+                invalid++;
+            }
+        }
+    }
+    EXPECT_EQ((size_t) 0, mismatches);
+    EXPECT_GT(invalid, 0);
+}
+
+#pragma mark -
+#pragma mark Construction
+
+template<class T>
+void FSConstructionTest2D<T>::compare_construction(const map<int, double> &lower_thresholds,
+                                                   const map<int, double> &upper_thresholds) {
+    const CoordinateSystem<T> *cs = this->coordinate_system();
+    const DataStore<T> *ds = this->m_data_store;
+    const map<int, double> replacement_values;
+
+    FeatureSpace<T> *fs = new FeatureSpace<T>(cs, ds,
+                                              lower_thresholds,
+                                              upper_thresholds,
+                                              replacement_values,
+                                              false);
+
+    map<size_t, T> min, max;
+    for (size_t vi = 0; vi < ds->rank(); vi++) {
+        min[vi] = std::numeric_limits<T>::max();
+        max[vi] = std::numeric_limits<T>::min();
+    }
+
+    // Evaluate one grid point after the other, the
+    // way the feature-space used to be built
+    LinearIndexMapping mapping(cs->get_dimension_sizes());
+    size_t num_points = 0, mismatches = 0, off_limits = 0;
+    for (size_t linear_index = 0; linear_index < ds->size(); linear_index++) {
+        vector<int> gridpoint = mapping.linear_to_grid(linear_index);
+        typename CoordinateSystem<T>::Coordinate coordinate(gridpoint.size());
+        cs->lookup(gridpoint, coordinate);
+
+        bool isPointValid = true;
+        bool isPointInRange = true;
+        bool isOffLimits = false;
+        vector<T> values = coordinate;
+
+        for (size_t var_index = 0; var_index < ds->rank() && isPointValid; var_index++) {
+            T value = ds->get(var_index, gridpoint, isPointInRange, isPointValid);
+            isOffLimits |= !isPointValid;
+
+            if (isPointValid && isPointInRange) {
+                values.push_back(value);
+                map<int, double>::const_iterator fi = lower_thresholds.find(var_index);
+                if (fi != lower_thresholds.end() && value < fi->second) {
+                    isPointValid = false;
+                }
+                fi = upper_thresholds.find(var_index);
+                if (fi != upper_thresholds.end() && value > fi->second) {
+                    isPointValid = false;
+                }
+            }
+        }
+
+        if (fs->off_limits()->get(gridpoint) != isOffLimits) {
+            mismatches++;
+        }
+        if (isOffLimits) {
+            off_limits++;
+        }
+
+        if (!isPointValid) {
+            continue;
+        }
+
+        // Same point at the same position in the list
+        if (num_points >= fs->size()
+            || fs->points[num_points]->gridpoint != gridpoint
+            || fs->points[num_points]->values != values) {
+            mismatches++;
+        }
+        num_points++;
+
+        for (size_t vi = 0; vi < ds->rank(); vi++) {
+            T v = values[coordinate.size() + vi];
+            if (v < min[vi]) {
+                min[vi] = v;
+            }
+            if (v > max[vi]) {
+                max[vi] = v;
+            }
+        }
+    }
+
+    EXPECT_EQ((size_t) 0, mismatches);
+    EXPECT_EQ(num_points, fs->size());
+    EXPECT_EQ(min, fs->min());
+    EXPECT_EQ(max, fs->max());
+
+    // The comparison is void if the thresholds
+    // took out all or none of the points
+    EXPECT_GT(num_points, 0);
+    EXPECT_LT(num_points, ds->size());
+    EXPECT_GT(off_limits, 0);
+
+    delete fs;
+}
+
+template<class T>
+void FSConstructionTest2D<T>::test_construction() {
+    map<int, double> none, lower, upper;
+    lower[0] = 20.0;
+    upper[0] = 50.0;
+
+#if WITH_OPENMP
+    // The point order must not depend on the number of threads
+    int max_threads = omp_get_max_threads();
+    omp_set_num_threads(1);
+    compare_construction(none, none);
+    omp_set_num_threads(max_threads);
+#endif
+    compare_construction(none, none);
+    compare_construction(lower, none);
+    compare_construction(lower, upper);
+}
+
+// 2D
+#if RUN_2D
+
+TYPED_TEST_CASE(FSConstructionTest2D, DataTypes);
+
+TYPED_TEST(FSConstructionTest2D, FS_DataStore_2D_Test)
+{
+    this->compare_data_store();
+}
+
+TYPED_TEST(FSConstructionTest2D, FS_Construction_2D_Test)
+{
+    this->test_construction();
+}
+
+#endif
+
+// 3D
+#if RUN_3D
+
+TYPED_TEST_CASE(FSConstructionTest3D, DataTypes);
+
+TYPED_TEST(FSConstructionTest3D, FS_DataStore_3D_Test)
+{
+    this->compare_data_store();
+}
+
+TYPED_TEST(FSConstructionTest3D, FS_Construction_3D_Test)
+{
+    this->test_construction();
+}
+
+#endif
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef M3D_TEST_FS_FILTERS_H
+#define M3D_TEST_FS_FILTERS_H
+
+//
+//  filters.h
+//  cf-algorithms
+//
+//  Compares the grid versions of the feature-space filters
+//  with their original versions based on range searches, the
+//  dense scale-space filter with the point based one, and the
+//  scale-space pyramid with direct filtering.
+//
+
+#include "../testcase_base.h"
+
+#pragma mark -
+#pragma mark Test Fixture
+
+template<class T>
+class FSFilterTest2D : public FSTestBase<T>
+{
+protected:
+
+    //
+    // Protected member variables
+    //
+
+    /** Bandwidth of the filters (spatial components
+     * plus one for the variable)
+     */
+    vector<T> m_bandwidth;
+
+    /** Index of the variable in the points' values
+     */
+    size_t m_value_index;
+
+    /** Writes a reflectivity-like pattern with values between
+     * 0 and 60, with gaps where the variable is not set
+     * @param variable
+     * @param current dimension
+     * @param current gridpoint
+     */
+    void create_pattern_recursive(NcVar &var,
+                                  size_t dimensionIndex,
+                                  vector<int> &gridpoint);
+
+    /** @return a new feature-space from the test data
+     */
+    FeatureSpace<T> *create_featurespace();
+
+    /** @return sorted grid points of the feature-space's points
+     */
+    static vector<vector<int> > gridpoints(FeatureSpace<T> *fs);
+
+    /** Runs the convection filter on two copies of the feature-space,
+     * once on the grid and once with range searches, and compares the
+     * points that remain and the points that were erased.
+     * @param if <code>true</code>, each filter is given a spatial index
+     *        to remove the erased points from
+     */
+    void compare_convection_filter(bool share_index);
+
+    /** Runs the replacement filter on two copies of the feature-space,
+     * once on the grid and once with range searches, and compares the
+     * filtered values at the given percentages
+     * @param replacement mode
+     * @param percentages
+     */
+    void compare_replacement_filter(typename ReplacementFilter<T>::ReplacementMode mode,
+                                    const vector<float> &percentages);
+
+    /** Runs the scale-space filter on two copies of the feature-space,
+     * once on dense arrays and once point by point, and compares the
+     * filtered points (including the new ones), their values and the
+     * filtered value ranges
+     * @param scale
+     */
+    void compare_scale_space_filter(T scale);
+
+    /** Smoothes the feature-space to scale t in two steps, from 0
+     * to t0 and from t0 to t, the way the multi-scale detection does,
+     * and compares the result with a single filter at scale t
+     * @param first scale
+     * @param second scale
+     */
+    void compare_scale_space_pyramid(T t0, T t);
+
+public:
+
+    FSFilterTest2D();
+
+    virtual void SetUp();
+
+    virtual void TearDown();
+};
+
+template<class T>
+class FSFilterTest3D : public FSFilterTest2D<T>
+{
+public:
+    FSFilterTest3D();
+};
+
+#include "filters_impl.h"
+
+#endif
@@ -0,0 +1,494 @@
+#ifndef M3D_TEST_FS_FILTERS_IMPL_H
+#define M3D_TEST_FS_FILTERS_IMPL_H
+
+using namespace m3D;
+using namespace m3D::utils::vectors;
+
+#include "../testcase_base.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+#pragma mark -
+#pragma mark Data generation
+
+template<class T>
+void FSFilterTest2D<T>::create_pattern_recursive(NcVar &var,
+                                                 size_t dimensionIndex,
+                                                 vector<int> &gridpoint) {
+    NcDim dim = var.getDim(dimensionIndex);
+    for (int index = 0; index < dim.getSize(); index++) {
+        gridpoint[dimensionIndex] = index;
+        if (dimensionIndex < (gridpoint.size() - 1)) {
+            create_pattern_recursive(var, dimensionIndex + 1, gridpoint);
+            continue;
+        }
+
+        // leave some gaps
+        int hash = 0, noise = 0;
+        double wave = 1.0;
+        for (size_t d = 0; d < gridpoint.size(); d++) {
+            hash += (int) (31 - 14 * d) * gridpoint[d];
+            noise += (int) (7 + 6 * d) * gridpoint[d];
+            wave *= cos((0.35 - 0.1 * d) * gridpoint[d]);
+        }
+        if (hash % 9 == 0) {
+            continue;
+        }
+
+        // smooth peaks and troughs with some noise on top
+        T value = (T) std::max(0.0, std::min(60.0, 30.0 + 28.0 * wave + (noise % 11) - 5));
+        vector<size_t> gp(gridpoint.begin(), gridpoint.end());
+        var.putVar(gp, value);
+        this->m_pointCount++;
+    }
+}
+
+template<class T>
+FeatureSpace<T> *
+FSFilterTest2D<T>::create_featurespace() {
+    const map<int, double> lower_thresholds, upper_thresholds, fill_values;
+    return new FeatureSpace<T>(this->coordinate_system(),
+                               this->m_data_store,
+                               lower_thresholds,
+                               upper_thresholds,
+                               fill_values,
+                               false);
+}
+
+template<class T>
+vector<vector<int> >
+FSFilterTest2D<T>::gridpoints(FeatureSpace<T> *fs) {
+    vector<vector<int> > result;
+    for (size_t i = 0; i < fs->points.size(); i++) {
+        result.push_back(fs->points[i]->gridpoint);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+template<class T>
+void FSFilterTest2D<T>::SetUp() {
+    FSTestBase<T>::SetUp();
+
+    // Grid spacing 0.2 in all dimensions
+    size_t rank = this->m_settings->num_dimensions();
+    vector<float> bounds(rank, 0.1f * this->m_settings->num_gridpoints());
+    this->m_settings->set_axis_bound_values(bounds);
+    this->generate_dimensions();
+
+    // Radius of 5.5 grid points. Neither this nor the convective
+    // radius (0.2 times as much) falls on a grid point.
+    this->m_bandwidth = vector<T>(rank, 1.1);
+    this->m_bandwidth.push_back(60.0);
+    this->m_value_index = rank;
+
+    NcVar var = this->add_variable("reflectivity", 0.0, 60.0);
+    vector<int> gridpoint(rank, 0);
+    this->m_pointCount = 0;
+    create_pattern_recursive(var, 0, gridpoint);
+    this->m_totalPointCount = this->m_pointCount;
+
+    this->generate_featurespace();
+}
+
+template<class T>
+void FSFilterTest2D<T>::TearDown() {
+    FSTestBase<T>::TearDown();
+}
+
+#pragma mark -
+#pragma mark Test parameterization
+
+template<class T>
+FSFilterTest2D<T>::FSFilterTest2D() : FSTestBase<T>() {
+    this->m_settings = new FSTestSettings(2, 1, NUMBER_OF_GRIDPOINTS, FSTestBase<T>::filename_from_current_testcase());
+}
+
+template<class T>
+FSFilterTest3D<T>::FSFilterTest3D() : FSFilterTest2D<T>() {
+    delete this->m_settings;
+    this->m_settings = new FSTestSettings(3, 1, 30, FSTestBase<T>::filename_from_current_testcase());
+}
+
+#pragma mark -
+#pragma mark Convection filter
+
+template<class T>
+void FSFilterTest2D<T>::compare_convection_filter(bool share_index) {
+    ASSERT_TRUE(GridStencil<T>::matches_grid(this->coordinate_system()));
+
+    FeatureSpace<T> *fs_index = this->create_featurespace();
+    FeatureSpace<T> *fs_grid = this->create_featurespace();
+    PointIndex<T> *index = NULL, *grid_index = NULL;
+
+    // With the default critical deltaZ (4.5) almost all points of the
+    // pattern are convective. 7.0 erases about half of them.
+    ConvectionFilter<T> with_index(m_bandwidth, m_value_index, false, 40.0, 7.0, 0.2, true);
+    ConvectionFilter<T> on_grid(m_bandwidth, m_value_index, false, 40.0, 7.0, 0.2, true);
+    if (share_index) {
+        // Erased points are removed through the shared index
+        index = PointIndex<T>::create(fs_index->get_points(), fs_index->spatial_rank());
+        grid_index = PointIndex<T>::create(fs_grid->get_points(), fs_grid->spatial_rank());
+        with_index.set_spatial_index(index);
+        on_grid.set_spatial_index(grid_index);
+    }
+
+    with_index.apply_with_index(fs_index);
+    on_grid.apply_on_grid(fs_grid);
+
+    // Both the convective mask and the rest must be non-trivial
+    EXPECT_GT(fs_grid->size(), 0);
+    EXPECT_LT(fs_grid->size(), this->m_featureSpace->size());
+
+    vector<vector<int> > all = gridpoints(this->m_featureSpace);
+    vector<vector<int> > kept_index = gridpoints(fs_index);
+    vector<vector<int> > kept_grid = gridpoints(fs_grid);
+    EXPECT_EQ(kept_index, kept_grid);
+
+    vector<vector<int> > erased_index, erased_grid;
+    std::set_difference(all.begin(), all.end(), kept_index.begin(), kept_index.end(),
+                        std::back_inserter(erased_index));
+    std::set_difference(all.begin(), all.end(), kept_grid.begin(), kept_grid.end(),
+                        std::back_inserter(erased_grid));
+    EXPECT_EQ(erased_index, erased_grid);
+    EXPECT_EQ(all.size(), kept_grid.size() + erased_grid.size());
+
+    delete index;
+    delete grid_index;
+    delete fs_index;
+    delete fs_grid;
+}
+
+#pragma mark -
+#pragma mark Replacement filter
+
+template<class T>
+void FSFilterTest2D<T>::compare_replacement_filter(typename ReplacementFilter<T>::ReplacementMode mode,
+                                                   const vector<float> &percentages) {
+    ASSERT_TRUE(GridStencil<T>::matches_grid(this->coordinate_system()));
+
+    // The median is exact. The averages are summed in a different
+    // order, and on the grid they pick up rounding errors from the
+    // running sums along each line.
+    const T tolerance = (mode == ReplacementFilter<T>::ReplaceWithMedian)
+                        ? 0.0 : 100 * 60.0 * std::numeric_limits<T>::epsilon();
+
+    for (size_t pi = 0; pi < percentages.size(); pi++) {
+        FeatureSpace<T> *fs_index = this->create_featurespace();
+        FeatureSpace<T> *fs_grid = this->create_featurespace();
+
+        ReplacementFilter<T> filter(mode, 0, m_bandwidth, percentages[pi]);
+        filter.apply_with_index(fs_index);
+        filter.apply_on_grid(fs_grid);
+
+        ASSERT_EQ(fs_index->size(), fs_grid->size());
+
+        size_t mismatches = 0;
+        for (size_t k = 0; k < fs_grid->size(); k++) {
+            ASSERT_EQ(fs_index->points[k]->gridpoint, fs_grid->points[k]->gridpoint);
+            T a = fs_index->points[k]->values[m_value_index];
+            T b = fs_grid->points[k]->values[m_value_index];
+            if (!(fabs(a - b) <= tolerance)) {
+                mismatches++;
+            }
+        }
+        EXPECT_EQ((size_t) 0, mismatches) << "mode " << mode << " percentage " << percentages[pi];
+
+        delete fs_index;
+        delete fs_grid;
+    }
+}
+
+#pragma mark -
+#pragma mark Scale-space filter
+
+template<class T>
+void FSFilterTest2D<T>::compare_scale_space_filter(T scale) {
+    FeatureSpace<T> *fs_points = this->create_featurespace();
+    FeatureSpace<T> *fs_dense = this->create_featurespace();
+    const size_t spatial_rank = fs_dense->spatial_rank();
+
+    const vector<T> resolution = this->coordinate_system()->resolution();
+    const vector<string> excluded;
+    ScaleSpaceFilter<T> point_filter(scale, resolution, excluded);
+    ScaleSpaceFilter<T> dense_filter(scale, resolution, excluded);
+    point_filter.apply_parallellized(fs_points);
+    dense_filter.apply_dense(fs_dense);
+
+    // The weights are summed in the same order, but
+    // the compiler may contract the sums differently
+    const T tolerance = 100 * std::numeric_limits<T>::epsilon();
+
+    // The point based version returns the points in
+    // the order of its array index
+    ASSERT_EQ(fs_points->size(), fs_dense->size());
+    map<vector<int>, typename Point<T>::ptr> filtered;
+    for (size_t k = 0; k < fs_points->size(); k++) {
+        filtered[fs_points->points[k]->gridpoint] = fs_points->points[k];
+    }
+
+    size_t mismatches = 0, new_points = 0;
+    for (size_t k = 0; k < fs_dense->size(); k++) {
+        typename Point<T>::ptr p = fs_dense->points[k];
+        typename map<vector<int>, typename Point<T>::ptr>::iterator fi = filtered.find(p->gridpoint);
+        ASSERT_TRUE(fi != filtered.end());
+        typename Point<T>::ptr q = fi->second;
+
+        bool match = (p->isOriginalPoint == q->isOriginalPoint) && (p->coordinate == q->coordinate);
+        for (size_t d = spatial_rank; d < p->values.size(); d++) {
+            match &= (fabs(p->values[d] - q->values[d]) <= tolerance * std::max((T) 1.0, fabs(q->values[d])));
+        }
+        if (!match) {
+            mismatches++;
+        }
+        if (!p->isOriginalPoint) {
+            new_points++;
+        }
+    }
+    EXPECT_EQ((size_t) 0, mismatches);
+
+    // The filter fills the gaps in the pattern
+    EXPECT_GT(new_points, 0);
+
+    const map<size_t, T> &point_min = point_filter.get_filtered_min();
+    const map<size_t, T> &point_max = point_filter.get_filtered_max();
+    const map<size_t, T> &dense_min = dense_filter.get_filtered_min();
+    const map<size_t, T> &dense_max = dense_filter.get_filtered_max();
+    ASSERT_EQ(point_min.size(), dense_min.size());
+    typename map<size_t, T>::const_iterator mi;
+    for (mi = point_min.begin(); mi != point_min.end(); ++mi) {
+        T a = mi->second, b = dense_min.find(mi->first)->second;
+        EXPECT_LE(fabs(a - b), tolerance * std::max((T) 1.0, fabs(a)));
+        a = point_max.find(mi->first)->second;
+        b = dense_max.find(mi->first)->second;
+        EXPECT_LE(fabs(a - b), tolerance * std::max((T) 1.0, fabs(a)));
+    }
+
+    delete fs_points;
+    delete fs_dense;
+}
+
+/** Smoothes the feature-space from scale 0 to t0 and from t0 to t,
+ * and brings the values to the gain of a single filter at scale t
+ * (see Detection::run_multiscale).
+ */
+template<class T>
+static void apply_scale_space_pyramid(FeatureSpace<T> *fs, T t0, T t) {
+    const vector<T> resolution = fs->coordinate_system->resolution();
+    const vector<string> excluded;
+    ScaleSpaceFilter<T> first(t0, resolution, excluded);
+    ScaleSpaceFilter<T> second(t - t0, resolution, excluded);
+    ScaleSpaceFilter<T> direct(t, resolution, excluded);
+    first.apply(fs);
+    second.apply(fs);
+    second.scale_values(fs, direct.gain() / (first.gain() * second.gain()));
+}
+
+/** @return mean absolute difference of the variable between the
+ * points of the two feature-spaces, which must have the same points
+ */
+template<class T>
+static T mean_difference(FeatureSpace<T> *a, FeatureSpace<T> *b, size_t value_index) {
+    map<vector<int>, typename Point<T>::ptr> points;
+    for (size_t k = 0; k < b->size(); k++) {
+        points[b->points[k]->gridpoint] = b->points[k];
+    }
+    T sum = 0.0;
+    for (size_t k = 0; k < a->size(); k++) {
+        typename Point<T>::ptr q = points[a->points[k]->gridpoint];
+        sum += fabs(a->points[k]->values[value_index] - q->values[value_index]);
+    }
+    return sum / a->size();
+}
+
+template<class T>
+void FSFilterTest2D<T>::compare_scale_space_pyramid(T t0, T t) {
+    const CoordinateSystem<T> *cs = this->coordinate_system();
+    const vector<T> resolution = cs->resolution();
+    const vector<string> excluded;
+    ScaleSpaceFilter<T> previous(t0, resolution, excluded);
+    ScaleSpaceFilter<T> direct(t, resolution, excluded);
+
+    // The kernels are truncated, so that the pyramid only comes
+    // close to the direct filter. It must come much closer than
+    // the field at the previous scale.
+    FeatureSpace<T> *fs_pyramid = this->create_featurespace();
+    FeatureSpace<T> *fs_direct = this->create_featurespace();
+    FeatureSpace<T> *fs_previous = this->create_featurespace();
+    apply_scale_space_pyramid(fs_pyramid, t0, t);
+    direct.apply(fs_direct);
+    previous.apply(fs_previous);
+    previous.scale_values(fs_previous, direct.gain() / previous.gain());
+
+    EXPECT_EQ(gridpoints(fs_direct), gridpoints(fs_pyramid));
+    EXPECT_EQ(fs_direct->count_original_points(), fs_pyramid->count_original_points());
+    EXPECT_LT(mean_difference(fs_pyramid, fs_direct, m_value_index),
+              0.5 * mean_difference(fs_previous, fs_direct, m_value_index));
+
+    delete fs_pyramid;
+    delete fs_direct;
+    delete fs_previous;
+
+    // On a constant field, the gains of the filters are exact away
+    // from the boundaries. Fill the gaps of the pattern and set all
+    // points to the same value.
+    const T value = 30.0;
+    FeatureSpace<T> *fs_constant[2];
+    for (size_t i = 0; i < 2; i++) {
+        FeatureSpace<T> *fs = this->create_featurespace();
+        for (size_t k = 0; k < fs->size(); k++) {
+            fs->points[k]->values[m_value_index] = value;
+        }
+        vector<vector<int> > existing = gridpoints(fs);
+        LinearIndexMapping mapping(cs->get_dimension_sizes());
+        for (size_t linear_index = 0; linear_index < mapping.size(); linear_index++) {
+            vector<int> gridpoint = mapping.linear_to_grid(linear_index);
+            if (std::binary_search(existing.begin(), existing.end(), gridpoint)) {
+                continue;
+            }
+            typename CoordinateSystem<T>::Coordinate coordinate = cs->newCoordinate();
+            cs->lookup(gridpoint, coordinate);
+            vector<T> values = coordinate;
+            values.push_back(value);
+            fs->points.push_back(PointFactory<T>::get_instance()->create(gridpoint, coordinate, values));
+        }
+        fs_constant[i] = fs;
+    }
+    apply_scale_space_pyramid(fs_constant[0], t0, t);
+    direct.apply(fs_constant[1]);
+
+    // Both filters of the pyramid reach in from the boundaries
+    vector<int> margin(resolution.size());
+    for (size_t d = 0; d < resolution.size(); d++) {
+        margin[d] = (int) ceil(ScaleSpaceFilter<T>::scale_to_filter_width(t0) / resolution[d])
+                    + (int) ceil(ScaleSpaceFilter<T>::scale_to_filter_width(t - t0) / resolution[d]);
+    }
+
+    const T expected = value * direct.gain();
+    const T tolerance = 100 * std::numeric_limits<T>::epsilon() * expected;
+    size_t mismatches = 0, interior = 0;
+    for (size_t i = 0; i < 2; i++) {
+        for (size_t k = 0; k < fs_constant[i]->size(); k++) {
+            typename Point<T>::ptr p = fs_constant[i]->points[k];
+            bool is_interior = true;
+            for (size_t d = 0; d < margin.size(); d++) {
+                is_interior &= (p->gridpoint[d] >= margin[d])
+                               && (p->gridpoint[d] < (int) cs->get_dimension_sizes()[d] - margin[d]);
+            }
+            if (!is_interior) {
+                continue;
+            }
+            interior++;
+            if (!(fabs(p->values[m_value_index] - expected) <= tolerance)) {
+                mismatches++;
+            }
+        }
+    }
+    EXPECT_EQ((size_t) 0, mismatches);
+    EXPECT_GT(interior, 0);
+
+    delete fs_constant[0];
+    delete fs_constant[1];
+}
+
+/** A few percentages, including 1.0 (all neighbours, which averages
+ * with prefix sums on the grid) and two invalid ones (which use all
+ * neighbours as well).
+ */
+static vector<float> replacement_filter_percentages() {
+    vector<float> percentages;
+    percentages.push_back(0.1);
+    percentages.push_back(0.25);
+    percentages.push_back(0.5);
+    percentages.push_back(1.0);
+    percentages.push_back(1.5);
+    percentages.push_back(0.0);
+    return percentages;
+}
+
+// 2D
+#if RUN_2D
+
+TYPED_TEST_CASE(FSFilterTest2D, DataTypes);
+
+TYPED_TEST(FSFilterTest2D, FS_ConvectionFilter_2D_Test)
+{
+    this->compare_convection_filter(false);
+}
+
+TYPED_TEST(FSFilterTest2D, FS_ConvectionFilter_2D_Shared_Index_Test)
+{
+    this->compare_convection_filter(true);
+}
+
+TYPED_TEST(FSFilterTest2D, FS_ReplacementFilter_2D_Lowest_Test)
+{
+    this->compare_replacement_filter(ReplacementFilter<TypeParam>::ReplaceWithLowest,
+                                     replacement_filter_percentages());
+}
+
+TYPED_TEST(FSFilterTest2D, FS_ReplacementFilter_2D_Highest_Test)
+{
+    this->compare_replacement_filter(ReplacementFilter<TypeParam>::ReplaceWithHighest,
+                                     replacement_filter_percentages());
+}
+
+TYPED_TEST(FSFilterTest2D, FS_ReplacementFilter_2D_Median_Test)
+{
+    this->compare_replacement_filter(ReplacementFilter<TypeParam>::ReplaceWithMedian,
+                                     replacement_filter_percentages());
+}
+
+TYPED_TEST(FSFilterTest2D, FS_ScaleSpaceFilter_2D_Test)
+{
+    // Filter widths of one, four and eight grid points
+    this->compare_scale_space_filter(0.1);
+    this->compare_scale_space_filter(0.5);
+    this->compare_scale_space_filter(1.5);
+}
+
+TYPED_TEST(FSFilterTest2D, FS_ScaleSpacePyramid_2D_Test)
+{
+    this->compare_scale_space_pyramid(0.5, 1.5);
+    this->compare_scale_space_pyramid(0.5, 3.0);
+}
+
+#endif
+
+// 3D
+#if RUN_3D
+
+TYPED_TEST_CASE(FSFilterTest3D, DataTypes);
+
+TYPED_TEST(FSFilterTest3D, FS_ConvectionFilter_3D_Test)
+{
+    this->compare_convection_filter(false);
+}
+
+TYPED_TEST(FSFilterTest3D, FS_ReplacementFilter_3D_Test)
+{
+    this->compare_replacement_filter(ReplacementFilter<TypeParam>::ReplaceWithLowest,
+                                     replacement_filter_percentages());
+    this->compare_replacement_filter(ReplacementFilter<TypeParam>::ReplaceWithHighest,
+                                     replacement_filter_percentages());
+    this->compare_replacement_filter(ReplacementFilter<TypeParam>::ReplaceWithMedian,
+                                     replacement_filter_percentages());
+}
+
+TYPED_TEST(FSFilterTest3D, FS_ScaleSpaceFilter_3D_Test)
+{
+    this->compare_scale_space_filter(0.5);
+}
+
+TYPED_TEST(FSFilterTest3D, FS_ScaleSpacePyramid_3D_Test)
+{
+    // Small enough to leave an interior for the constant field
+    this->compare_scale_space_pyramid(0.2, 1.0);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef M3D_TEST_FS_INDEX_H
+#define M3D_TEST_FS_INDEX_H
+
+//
+//  index.h
+//  cf-algorithms
+//
+//  Checks the search results of point indexes against a
+//  brute-force search, also after points were added and
+//  removed in place.
+//
+
+#include "../testcase_base.h"
+
+#pragma mark -
+#pragma mark Test Fixture
+
+template<class T>
+class FSIndexTest2D : public Test
+{
+protected:
+
+    //
+    // Protected member variables
+    //
+
+    /** Number of dimensions
+     */
+    size_t m_rank;
+
+    /** Number of grid points along each dimension
+     */
+    size_t m_size;
+
+    /** Points in the index
+     */
+    typename Point<T>::list m_points;
+
+    /** Points added to the index later on
+     */
+    typename Point<T>::list m_spare_points;
+
+    /** Points removed from the index, deleted in TearDown
+     */
+    typename Point<T>::list m_removed_points;
+
+    /** Search range. Chosen such that no grid point lies on
+     * the boundary of the search ellipsoid.
+     */
+    vector<T> m_bandwidth;
+
+    /** @return points of the list within the search ellipsoid
+     * around x, sorted by address
+     */
+    static typename Point<T>::list
+    brute_force_search(const typename Point<T>::list &points,
+                       const vector<T> &x,
+                       const vector<T> &bandwidth);
+
+    /** Compares range searches around a sample of grid points,
+     * and half-way between grid points, with brute-force searches
+     * on the current point list. Searches through the index and
+     * through the prepared search.
+     * @param index
+     * @param prepared search on the index
+     */
+    void compare_searches(PointIndex<T> *index, PreparedRangeSearch<T> *search);
+
+    /** Counts the differences between a prepared search and brute-force
+     * searches around a sample of grid points, and half-way between
+     * grid points. Checks the found points, with plain and with whitened
+     * queries, and the distances returned.
+     * @param prepared search
+     * @param number of queries with other points (incremented)
+     * @param number of wrong distances (incremented)
+     */
+    void count_prepared_search_mismatches(PreparedRangeSearch<T> *search,
+                                          size_t &mismatches,
+                                          size_t &distance_mismatches);
+
+    /** Compares two prepared searches, used side by side, with
+     * brute-force searches on the point list: one with the bandwidth
+     * and one with half of it. Checks the found points, with plain
+     * and with whitened queries, and the distances returned.
+     * @param index type
+     * @param index settings
+     */
+    void compare_prepared_searches(typename PointIndex<T>::IndexType type,
+                                   const index_params_t &params);
+
+    /** Checks that a prepared search on a FLANN index keeps finding
+     * the brute-force results after the index was rebuilt for another
+     * bandwidth: by a search, by a batch search and by preparing
+     * another search. Includes a query whitened before the rebuilds.
+     * @param index settings
+     */
+    void compare_prepared_searches_after_rebuild(const index_params_t &params);
+
+    /** Checks the searches of an approximate FLANN index: each result
+     * must be part of the brute-force result, and batched searches must
+     * find the same points as single ones. If the number of checks is
+     * at least the number of points, the results must be exact.
+     * @param index settings (approximate)
+     */
+    void compare_approximate_searches(const index_params_t &params);
+
+    /** Compares range searches of an index over some of the points'
+     * values, in an order other than their own, with brute-force
+     * searches. The points get a value after their spatial components.
+     * The index covers the value first and then the spatial components
+     * in reverse order.
+     * @param index type
+     * @param index settings
+     */
+    void compare_index_variables(typename PointIndex<T>::IndexType type,
+                                 const index_params_t &params);
+
+    /** Compares the points a search hands to a visitor with the list
+     * returned by the search, including their order, and with a brute
+     * force search. K nearest neighbour searches are checked against
+     * the distance of the k-th nearest point.
+     * @param index type
+     * @param if <code>true</code>, k nearest neighbour searches
+     *        are compared as well
+     */
+    void compare_visitor_searches(typename PointIndex<T>::IndexType type, bool knn);
+
+    /** Removes every third point from the index, adds the spare
+     * points, removes single points (some of them added ones),
+     * and compares searches after each step
+     * @param index settings
+     */
+    void test_add_and_remove(const index_params_t &params);
+
+public:
+
+    FSIndexTest2D();
+
+    virtual void SetUp();
+
+    virtual void TearDown();
+};
+
+template<class T>
+class FSIndexTest3D : public FSIndexTest2D<T>
+{
+public:
+    FSIndexTest3D();
+};
+
+#include "index_impl.h"
+
+#endif
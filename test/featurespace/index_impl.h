@@ -0,0 +1,588 @@
+#ifndef M3D_TEST_FS_INDEX_IMPL_H
+#define M3D_TEST_FS_INDEX_IMPL_H
+
+using namespace m3D;
+using namespace m3D::utils::vectors;
+
+#include <algorithm>
+#include <iterator>
+
+#pragma mark -
+#pragma mark Helpers
+
+template<class T>
+typename Point<T>::list
+FSIndexTest2D<T>::brute_force_search(const typename Point<T>::list &points,
+                                     const vector<T> &x,
+                                     const vector<T> &bandwidth) {
+    typename Point<T>::list result;
+    for (size_t i = 0; i < points.size(); i++) {
+        T r = 0.0;
+        for (size_t d = 0; d < x.size(); d++) {
+            T dist = (points[i]->coordinate[d] - x[d]) / bandwidth[d];
+            r += dist * dist;
+        }
+        if (r <= 1.0) {
+            result.push_back(points[i]);
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+template<class T>
+void FSIndexTest2D<T>::compare_searches(PointIndex<T> *index, PreparedRangeSearch<T> *search) {
+    RangeSearchParams<T> params(m_bandwidth);
+    typename Point<T>::list prepared_result;
+
+    size_t num_grid_points = 1;
+    for (size_t d = 0; d < m_rank; d++) {
+        num_grid_points *= m_size;
+    }
+
+    size_t mismatches = 0;
+    for (size_t l = 0; l < num_grid_points; l += 7) {
+        // every other query lies half-way between grid points
+        vector<T> x(m_rank);
+        for (size_t d = 0, r = l; d < m_rank; d++, r /= m_size) {
+            x[d] = 0.2 * (r % m_size) + ((l % 2) ? 0.1 : 0.0);
+        }
+
+        typename Point<T>::list expected = brute_force_search(m_points, x, m_bandwidth);
+
+        typename Point<T>::list *result = index->search(x, &params);
+        std::sort(result->begin(), result->end());
+        if (*result != expected) {
+            mismatches++;
+        }
+        delete result;
+
+        search->search(x, prepared_result);
+        std::sort(prepared_result.begin(), prepared_result.end());
+        if (prepared_result != expected) {
+            mismatches++;
+        }
+    }
+    EXPECT_EQ((size_t) 0, mismatches);
+}
+
+template<class T>
+void FSIndexTest2D<T>::count_prepared_search_mismatches(PreparedRangeSearch<T> *search,
+                                                        size_t &mismatches,
+                                                        size_t &distance_mismatches) {
+    size_t num_grid_points = 1;
+    for (size_t d = 0; d < m_rank; d++) {
+        num_grid_points *= m_size;
+    }
+
+    const vector<T> &h = search->bandwidth();
+    typename Point<T>::list result;
+    vector<T> distances, white_x;
+    for (size_t l = 0; l < num_grid_points; l += 7) {
+        vector<T> x(m_rank);
+        for (size_t d = 0, r = l; d < m_rank; d++, r /= m_size) {
+            x[d] = 0.2 * (r % m_size) + ((l % 2) ? 0.1 : 0.0);
+        }
+        typename Point<T>::list expected = brute_force_search(m_points, x, h);
+
+        // plain query, with distances in units of the bandwidth
+        search->search(x, result, &distances);
+        if (distances.size() != result.size()) {
+            distance_mismatches++;
+        } else {
+            for (size_t n = 0; n < result.size(); n++) {
+                T dist = 0.0;
+                for (size_t d = 0; d < m_rank; d++) {
+                    T r = (x[d] - result[n]->coordinate[d]) / h[d];
+                    dist += r * r;
+                }
+                if (fabs(dist - distances[n]) > 1e-4) {
+                    distance_mismatches++;
+                }
+            }
+        }
+        std::sort(result.begin(), result.end());
+        if (result != expected) {
+            mismatches++;
+        }
+
+        // whitened query
+        search->whiten(x, white_x);
+        search->search(white_x, result, NULL, true);
+        std::sort(result.begin(), result.end());
+        if (result != expected) {
+            mismatches++;
+        }
+    }
+}
+
+template<class T>
+void FSIndexTest2D<T>::compare_prepared_searches(typename PointIndex<T>::IndexType type,
+                                                 const index_params_t &index_params) {
+    PointIndex<T> *index = PointIndex<T>::create(&m_points, m_rank, type, index_params);
+
+    // The narrow search has half the bandwidth. Again no grid point,
+    // nor any point half-way between grid points, lies on its boundary.
+    PreparedRangeSearch<T> *searches[2];
+    searches[0] = index->prepare_range_search(m_bandwidth);
+    searches[1] = index->prepare_range_search(((T) 0.5) * m_bandwidth);
+
+    size_t mismatches = 0, distance_mismatches = 0;
+    for (size_t si = 0; si < 2; si++) {
+        count_prepared_search_mismatches(searches[si], mismatches, distance_mismatches);
+    }
+    EXPECT_EQ((size_t) 0, mismatches);
+    EXPECT_EQ((size_t) 0, distance_mismatches);
+
+    delete searches[0];
+    delete searches[1];
+    delete index;
+}
+
+template<class T>
+void FSIndexTest2D<T>::compare_prepared_searches_after_rebuild(const index_params_t &index_params) {
+    PointIndex<T> *index = PointIndex<T>::create(&m_points, m_rank, PointIndex<T>::IndexTypeFLANN, index_params);
+
+    PreparedRangeSearch<T> *search = index->prepare_range_search(m_bandwidth);
+
+    // A bandwidth that is no multiple of the prepared one, so that
+    // using it rebuilds the index
+    vector<T> skewed = m_bandwidth;
+    skewed[0] *= 1.5;
+    RangeSearchParams<T> skewed_params(skewed);
+
+    // Whiten a query before any rebuild, it must stay valid
+    vector<T> x(m_rank, 0.5), white_x;
+    search->whiten(x, white_x);
+    typename Point<T>::list expected = brute_force_search(m_points, x, m_bandwidth);
+    typename Point<T>::list result;
+
+    size_t mismatches = 0, distance_mismatches = 0;
+
+    // rebuilt by a search with another bandwidth
+    delete index->search(x, &skewed_params);
+    search->search(white_x, result, NULL, true);
+    std::sort(result.begin(), result.end());
+    EXPECT_EQ(expected, result);
+    count_prepared_search_mismatches(search, mismatches, distance_mismatches);
+
+    // rebuilt by a batch search
+    vector<vector<T> > queries(1, x);
+    vector<typename Point<T>::list> batch_results;
+    index->batch_search(queries, &skewed_params, batch_results);
+    count_prepared_search_mismatches(search, mismatches, distance_mismatches);
+
+    // rebuilt by another prepared search, both used in turns
+    PreparedRangeSearch<T> *other = index->prepare_range_search(skewed);
+    count_prepared_search_mismatches(search, mismatches, distance_mismatches);
+    search->search(white_x, result, NULL, true);
+    other->search(x, result);
+    search->search(white_x, result, NULL, true);
+    std::sort(result.begin(), result.end());
+    EXPECT_EQ(expected, result);
+
+    EXPECT_EQ((size_t) 0, mismatches);
+    EXPECT_EQ((size_t) 0, distance_mismatches);
+
+    delete other;
+    delete search;
+    delete index;
+}
+
+template<class T>
+void FSIndexTest2D<T>::compare_approximate_searches(const index_params_t &index_params) {
+    PointIndex<T> *index = PointIndex<T>::create(&m_points, m_rank, PointIndex<T>::IndexTypeFLANN, index_params);
+    RangeSearchParams<T> params(m_bandwidth);
+
+    size_t num_grid_points = 1;
+    for (size_t d = 0; d < m_rank; d++) {
+        num_grid_points *= m_size;
+    }
+
+    vector<vector<T> > queries;
+    for (size_t l = 0; l < num_grid_points; l += 7) {
+        vector<T> x(m_rank);
+        for (size_t d = 0, r = l; d < m_rank; d++, r /= m_size) {
+            x[d] = 0.2 * (r % m_size) + ((l % 2) ? 0.1 : 0.0);
+        }
+        queries.push_back(x);
+    }
+
+    vector<typename Point<T>::list> batch_results;
+    index->batch_search(queries, &params, batch_results);
+    ASSERT_EQ(queries.size(), batch_results.size());
+
+    size_t found = 0, expected_total = 0, not_in_range = 0, batch_mismatches = 0;
+    for (size_t qi = 0; qi < queries.size(); qi++) {
+        typename Point<T>::list expected = brute_force_search(m_points, queries[qi], m_bandwidth);
+        typename Point<T>::list *result = index->search(queries[qi], &params);
+        std::sort(result->begin(), result->end());
+
+        // whatever is found lies within range
+        typename Point<T>::list missing;
+        std::set_difference(result->begin(), result->end(),
+                            expected.begin(), expected.end(),
+                            std::back_inserter(missing));
+        not_in_range += missing.size();
+
+        std::sort(batch_results[qi].begin(), batch_results[qi].end());
+        if (batch_results[qi] != *result) {
+            batch_mismatches++;
+        }
+
+        found += result->size();
+        expected_total += expected.size();
+        delete result;
+    }
+
+    EXPECT_EQ((size_t) 0, not_in_range);
+    EXPECT_EQ((size_t) 0, batch_mismatches);
+    EXPECT_GT(found, 0);
+    if (index_params.checks >= (int) m_points.size()) {
+        EXPECT_EQ(expected_total, found);
+    }
+
+    delete index;
+}
+
+template<class T>
+void FSIndexTest2D<T>::compare_index_variables(typename PointIndex<T>::IndexType type,
+                                               const index_params_t &index_params) {
+    typename Point<T>::list points;
+    for (size_t i = 0; i < m_points.size(); i++) {
+        vector<int> gridpoint = m_points[i]->gridpoint;
+        vector<T> coordinate = m_points[i]->coordinate;
+        vector<T> values = coordinate;
+        values.push_back(0.2 * ((i * 7) % 5));
+        points.push_back(PointFactory<T>::get_instance()->create(gridpoint, coordinate, values));
+    }
+
+    vector<size_t> indexes(1, m_rank);
+    for (size_t d = m_rank; d > 0; d--) {
+        indexes.push_back(d - 1);
+    }
+
+    // Queries half-way between the values. With a bandwidth of
+    // 0.41 for the value no point lies on the boundary.
+    vector<T> bandwidth(1, 0.41);
+    for (size_t d = 0; d < m_rank; d++) {
+        bandwidth.push_back(m_bandwidth[d]);
+    }
+
+    PointIndex<T> *index = PointIndex<T>::create(&points, indexes, type, index_params);
+    RangeSearchParams<T> params(bandwidth);
+
+    size_t num_grid_points = 1;
+    for (size_t d = 0; d < m_rank; d++) {
+        num_grid_points *= m_size;
+    }
+
+    size_t mismatches = 0, found = 0;
+    for (size_t l = 0; l < num_grid_points; l += 7) {
+        vector<T> x(1, 0.2 * (l % 4) + 0.1);
+        for (size_t d = m_rank; d > 0; d--) {
+            size_t r = l;
+            for (size_t k = 0; k < d - 1; k++) {
+                r /= m_size;
+            }
+            x.push_back(0.2 * (r % m_size) + ((l % 2) ? 0.1 : 0.0));
+        }
+
+        typename Point<T>::list expected;
+        for (size_t i = 0; i < points.size(); i++) {
+            T dist = 0.0;
+            for (size_t k = 0; k < indexes.size(); k++) {
+                T r = (x[k] - points[i]->values[indexes[k]]) / bandwidth[k];
+                dist += r * r;
+            }
+            if (dist <= 1.0) {
+                expected.push_back(points[i]);
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+
+        typename Point<T>::list *result = index->search(x, &params);
+        std::sort(result->begin(), result->end());
+        if (*result != expected) {
+            mismatches++;
+        }
+        found += result->size();
+        delete result;
+    }
+    EXPECT_EQ((size_t) 0, mismatches);
+    EXPECT_GT(found, 0);
+
+    delete index;
+    for (size_t i = 0; i < points.size(); i++) {
+        delete points[i];
+    }
+}
+
+template<class T>
+void FSIndexTest2D<T>::compare_visitor_searches(typename PointIndex<T>::IndexType type, bool knn) {
+    PointIndex<T> *index = PointIndex<T>::create(&m_points, m_rank, type);
+    RangeSearchParams<T> range(m_bandwidth);
+    KNNSearchParams<T> nearest(10, vector<T>(m_rank, 0.2), m_bandwidth);
+
+    size_t num_grid_points = 1;
+    for (size_t d = 0; d < m_rank; d++) {
+        num_grid_points *= m_size;
+    }
+
+    typename Point<T>::list visited;
+    PointListCollector<T> collector(visited);
+    size_t order_mismatches = 0, mismatches = 0;
+    for (size_t l = 0; l < num_grid_points; l += 7) {
+        vector<T> x(m_rank);
+        for (size_t d = 0, r = l; d < m_rank; d++, r /= m_size) {
+            x[d] = 0.2 * (r % m_size) + ((l % 2) ? 0.1 : 0.0);
+        }
+
+        // range search
+        visited.clear();
+        index->search(x, &range, collector);
+        typename Point<T>::list *result = index->search(x, &range);
+        if (*result != visited) {
+            order_mismatches++;
+        }
+        std::sort(result->begin(), result->end());
+        if (*result != brute_force_search(m_points, x, m_bandwidth)) {
+            mismatches++;
+        }
+        delete result;
+
+        if (!knn) {
+            continue;
+        }
+
+        // k nearest neighbours: none of the points found may be
+        // farther away than the k-th nearest point
+        visited.clear();
+        index->search(x, &nearest, collector);
+        result = index->search(x, &nearest);
+        if (*result != visited) {
+            order_mismatches++;
+        }
+        vector<T> distances;
+        for (size_t i = 0; i < m_points.size(); i++) {
+            distances.push_back(mahalabonis_distance_sqr(x, m_points[i]->coordinate, m_bandwidth));
+        }
+        std::nth_element(distances.begin(), distances.begin() + (nearest.k - 1), distances.end());
+        T kth = distances[nearest.k - 1];
+        if (result->size() != nearest.k) {
+            mismatches++;
+        }
+        for (size_t i = 0; i < result->size(); i++) {
+            if (mahalabonis_distance_sqr(x, result->at(i)->coordinate, m_bandwidth) > kth * (1 + 1e-4)) {
+                mismatches++;
+            }
+        }
+        delete result;
+    }
+    EXPECT_EQ((size_t) 0, order_mismatches);
+    EXPECT_EQ((size_t) 0, mismatches);
+
+    delete index;
+}
+
+template<class T>
+void FSIndexTest2D<T>::test_add_and_remove(const index_params_t &index_params) {
+    const size_t initial_size = m_points.size();
+
+    PointIndex<T> *index = PointIndex<T>::create(&m_points, m_rank, PointIndex<T>::IndexTypeFLANN, index_params);
+    PreparedRangeSearch<T> *search = index->prepare_range_search(m_bandwidth);
+    compare_searches(index, search);
+
+    // Remove every third point in one go
+    typename Point<T>::list removed;
+    for (size_t i = 0; i < m_points.size(); i += 3) {
+        removed.push_back(m_points[i]);
+    }
+    index->remove_points(removed);
+    m_removed_points.insert(m_removed_points.end(), removed.begin(), removed.end());
+    ASSERT_EQ(initial_size - removed.size(), m_points.size());
+    compare_searches(index, search);
+
+    // Add the spare points one by one
+    for (size_t i = 0; i < m_spare_points.size(); i++) {
+        index->add_point(m_spare_points[i]);
+    }
+    ASSERT_EQ(initial_size - removed.size() + m_spare_points.size(), m_points.size());
+    m_spare_points.clear();
+    compare_searches(index, search);
+
+    // Remove single points, among them some of the added ones (at
+    // the end of the list), until more than half of the points are
+    // gone. With the default rebuild threshold, this rebuilds the
+    // trees without the removed points.
+    for (size_t step = 0; m_points.size() > initial_size / 3; step++) {
+        typename Point<T>::ptr p = m_points[(step * 37) % m_points.size()];
+        index->remove_point(p);
+        m_removed_points.push_back(p);
+        if (step == 100) {
+            compare_searches(index, search);
+        }
+    }
+    compare_searches(index, search);
+
+    delete search;
+    delete index;
+}
+
+#pragma mark -
+#pragma mark Setup
+
+template<class T>
+void FSIndexTest2D<T>::SetUp() {
+    if (PointFactory<T>::get_instance() == NULL) {
+        PointFactory<T>::set_instance(new PointDefaultFactory<T>());
+    }
+
+    // Grid points 0.2 apart. The bandwidth is 2.75 times that, and
+    // neither grid points nor points half-way between them lie on
+    // the boundary of the search ellipsoid.
+    m_bandwidth = vector<T>(m_rank, 0.55);
+
+    size_t num_grid_points = 1;
+    for (size_t d = 0; d < m_rank; d++) {
+        num_grid_points *= m_size;
+    }
+
+    vector<int> gridpoint(m_rank);
+    vector<T> coordinate(m_rank);
+    for (size_t l = 0; l < num_grid_points; l++) {
+        int hash = 0;
+        for (size_t d = 0, r = l; d < m_rank; d++, r /= m_size) {
+            gridpoint[d] = r % m_size;
+            coordinate[d] = 0.2 * gridpoint[d];
+            hash += (int) (31 - 14 * d) * gridpoint[d];
+        }
+        typename Point<T>::ptr p = PointFactory<T>::get_instance()->create(gridpoint, coordinate, coordinate);
+        if (hash % 5 == 0) {
+            m_spare_points.push_back(p);
+        } else {
+            m_points.push_back(p);
+        }
+    }
+}
+
+template<class T>
+void FSIndexTest2D<T>::TearDown() {
+    typename Point<T>::list *lists[3] = {&m_points, &m_spare_points, &m_removed_points};
+    for (size_t li = 0; li < 3; li++) {
+        for (size_t i = 0; i < lists[li]->size(); i++) {
+            delete lists[li]->at(i);
+        }
+        lists[li]->clear();
+    }
+}
+
+#pragma mark -
+#pragma mark Test parameterization
+
+template<class T>
+FSIndexTest2D<T>::FSIndexTest2D() : m_rank(2), m_size(40) {
+}
+
+template<class T>
+FSIndexTest3D<T>::FSIndexTest3D() : FSIndexTest2D<T>() {
+    this->m_rank = 3;
+    this->m_size = 14;
+}
+
+// 2D
+#if RUN_2D
+
+TYPED_TEST_CASE(FSIndexTest2D, DataTypes);
+
+TYPED_TEST(FSIndexTest2D, FS_FLANNIndex_2D_Incremental_Test)
+{
+    index_params_t params;
+    params.incremental = true;
+    this->test_add_and_remove(params);
+}
+
+TYPED_TEST(FSIndexTest2D, FS_FLANNIndex_2D_Test)
+{
+    this->test_add_and_remove(index_params_t());
+}
+
+TYPED_TEST(FSIndexTest2D, FS_FLANNIndex_2D_Approximate_Test)
+{
+    index_params_t params;
+    params.approximate = true;
+    params.threads = 2;
+    this->compare_approximate_searches(params);
+
+    // enough checks to visit every leaf
+    params.checks = 2 * this->m_points.size();
+    this->compare_approximate_searches(params);
+}
+
+TYPED_TEST(FSIndexTest2D, FS_IndexVariables_2D_Test)
+{
+    index_params_t single_precision;
+    single_precision.single_precision = true;
+    this->compare_index_variables(PointIndex<TypeParam>::IndexTypeFLANN, index_params_t());
+    this->compare_index_variables(PointIndex<TypeParam>::IndexTypeFLANN, single_precision);
+    this->compare_index_variables(PointIndex<TypeParam>::IndexTypeKDTree, index_params_t());
+    this->compare_index_variables(PointIndex<TypeParam>::IndexTypeLinear, index_params_t());
+}
+
+TYPED_TEST(FSIndexTest2D, FS_SearchVisitor_2D_Test)
+{
+    this->compare_visitor_searches(PointIndex<TypeParam>::IndexTypeFLANN, true);
+    this->compare_visitor_searches(PointIndex<TypeParam>::IndexTypeKDTree, false);
+    this->compare_visitor_searches(PointIndex<TypeParam>::IndexTypeLinear, false);
+}
+
+TYPED_TEST(FSIndexTest2D, FS_PreparedSearch_2D_Test)
+{
+    index_params_t single_precision;
+    single_precision.single_precision = true;
+    this->compare_prepared_searches(PointIndex<TypeParam>::IndexTypeFLANN, index_params_t());
+    this->compare_prepared_searches(PointIndex<TypeParam>::IndexTypeFLANN, single_precision);
+    this->compare_prepared_searches(PointIndex<TypeParam>::IndexTypeLinear, index_params_t());
+}
+
+TYPED_TEST(FSIndexTest2D, FS_PreparedSearch_Rebuild_2D_Test)
+{
+    this->compare_prepared_searches_after_rebuild(index_params_t());
+}
+
+#endif
+
+// 3D
+#if RUN_3D
+
+TYPED_TEST_CASE(FSIndexTest3D, DataTypes);
+
+TYPED_TEST(FSIndexTest3D, FS_FLANNIndex_3D_Incremental_Test)
+{
+    index_params_t params;
+    params.incremental = true;
+    this->test_add_and_remove(params);
+}
+
+TYPED_TEST(FSIndexTest3D, FS_IndexVariables_3D_Test)
+{
+    this->compare_index_variables(PointIndex<TypeParam>::IndexTypeFLANN, index_params_t());
+    this->compare_index_variables(PointIndex<TypeParam>::IndexTypeKDTree, index_params_t());
+}
+
+TYPED_TEST(FSIndexTest3D, FS_SearchVisitor_3D_Test)
+{
+    this->compare_visitor_searches(PointIndex<TypeParam>::IndexTypeFLANN, true);
+    this->compare_visitor_searches(PointIndex<TypeParam>::IndexTypeKDTree, false);
+    this->compare_visitor_searches(PointIndex<TypeParam>::IndexTypeLinear, false);
+}
+
+TYPED_TEST(FSIndexTest3D, FS_PreparedSearch_3D_Test)
+{
+    this->compare_prepared_searches(PointIndex<TypeParam>::IndexTypeFLANN, index_params_t());
+    this->compare_prepared_searches(PointIndex<TypeParam>::IndexTypeLinear, index_params_t());
+}
+
+#endif
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef M3D_TEST_FS_MEANSHIFT_H
+#define M3D_TEST_FS_MEANSHIFT_H
+
+//
+//  meanshift.h
+//  cf-algorithms
+//
+//  Compares the batched and the grid mean-shift calculations
+//  with the mean-shift of single points.
+//
+
+#include "../testcase_base.h"
+#include "filters.h"
+
+#pragma mark -
+#pragma mark Weight function
+
+/** Weighs points with the value of the variable
+ */
+template<class T>
+class FSValueWeightFunction : public WeightFunction<T>
+{
+private:
+
+    size_t m_value_index;
+
+public:
+
+    FSValueWeightFunction(size_t value_index) : m_value_index(value_index) {
+    };
+
+    T operator()(const typename Point<T>::ptr p) const {
+        return p->values[m_value_index];
+    };
+};
+
+#pragma mark -
+#pragma mark Test Fixture
+
+/** Runs on the same reflectivity-like pattern as the filter tests.
+ */
+template<class T>
+class FSMeanshiftTest2D : public FSFilterTest2D<T>
+{
+protected:
+
+    /** Compares the batched search of the feature-space index
+     * with single searches for each point's values.
+     * @param search parameters
+     */
+    void compare_batch_search(const SearchParameters *params);
+
+    /** Compares the batched meanshift, in blocks of MEANSHIFT_BATCH_SIZE
+     * points, with the meanshift of each point on its own. The shifts
+     * are not rounded to the grid.
+     * @param search parameters
+     * @param kernel
+     * @param weight function (may be <code>NULL</code>)
+     */
+    void compare_batched_meanshift(const SearchParameters *params,
+                                   const Kernel<T> *kernel,
+                                   const WeightFunction<T> *w);
+
+    /** Compares the meanshift on the grid (without the index) with
+     * the meanshift of each point on its own, using range searches
+     * with the same bandwidth. The shifts are not rounded to the grid.
+     * @param kernel
+     * @param weight function (may be <code>NULL</code>)
+     */
+    void compare_grid_meanshift(const Kernel<T> *kernel,
+                                const WeightFunction<T> *w);
+
+public:
+
+    FSMeanshiftTest2D();
+};
+
+template<class T>
+class FSMeanshiftTest3D : public FSMeanshiftTest2D<T>
+{
+public:
+    FSMeanshiftTest3D();
+};
+
+#include "meanshift_impl.h"
+
+#endif
@@ -0,0 +1,199 @@
+#ifndef M3D_TEST_FS_MEANSHIFT_IMPL_H
+#define M3D_TEST_FS_MEANSHIFT_IMPL_H
+
+using namespace m3D;
+using namespace m3D::utils::vectors;
+
+#include "../testcase_base.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#pragma mark -
+#pragma mark Test parameterization
+
+template<class T>
+FSMeanshiftTest2D<T>::FSMeanshiftTest2D() : FSFilterTest2D<T>() {
+}
+
+template<class T>
+FSMeanshiftTest3D<T>::FSMeanshiftTest3D() : FSMeanshiftTest2D<T>() {
+    delete this->m_settings;
+    this->m_settings = new FSTestSettings(3, 1, 30, FSTestBase<T>::filename_from_current_testcase());
+}
+
+#pragma mark -
+#pragma mark Batched search and meanshift
+
+template<class T>
+void FSMeanshiftTest2D<T>::compare_batch_search(const SearchParameters *params) {
+    const typename Point<T>::list &points = this->m_featureSpace->points;
+
+    vector<vector<T> > queries;
+    for (size_t i = 0; i < points.size(); i++) {
+        queries.push_back(points[i]->values);
+    }
+
+    vector<typename Point<T>::list> results;
+    this->m_featureSpaceIndex->batch_search(queries, params, results);
+    ASSERT_EQ(queries.size(), results.size());
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < queries.size(); i++) {
+        typename Point<T>::list *expected = this->m_featureSpaceIndex->search(queries[i], params);
+        std::sort(expected->begin(), expected->end());
+        std::sort(results[i].begin(), results[i].end());
+        if (*expected != results[i]) {
+            mismatches++;
+        }
+        delete expected;
+    }
+    EXPECT_EQ((size_t) 0, mismatches);
+}
+
+template<class T>
+void FSMeanshiftTest2D<T>::compare_batched_meanshift(const SearchParameters *params,
+                                                     const Kernel<T> *kernel,
+                                                     const WeightFunction<T> *w) {
+    const typename Point<T>::list &points = this->m_featureSpace->points;
+    MeanshiftOperation<T> op(this->m_featureSpace, this->m_featureSpaceIndex);
+    typename MeanshiftOperation<T>::batch_buffer_t buffer;
+
+    // The samples are the same, but the batched version sums
+    // in a different way (see MeanshiftOperation::accumulate)
+    const T tolerance = 100 * 60.0 * std::numeric_limits<T>::epsilon();
+
+    size_t mismatches = 0, non_zero = 0;
+    for (size_t begin = 0; begin < points.size(); begin += MEANSHIFT_BATCH_SIZE) {
+        size_t end = std::min(begin + MEANSHIFT_BATCH_SIZE, points.size());
+        op.meanshift(points, begin, end, params, kernel, w, buffer, false);
+        ASSERT_EQ(end - begin, buffer.shifts.size());
+
+        for (size_t i = begin; i < end; i++) {
+            vector<T> expected = op.meanshift(points[i]->values, params, kernel, w, false);
+            const vector<T> &shift = buffer.shifts[i - begin];
+            ASSERT_EQ(expected.size(), shift.size());
+            bool match = true;
+            for (size_t d = 0; d < shift.size(); d++) {
+                match &= (fabs(expected[d] - shift[d]) <= tolerance);
+            }
+            if (!match) {
+                mismatches++;
+            }
+            if (vector_norm(expected) > tolerance) {
+                non_zero++;
+            }
+        }
+    }
+    EXPECT_EQ((size_t) 0, mismatches);
+
+    // The comparison is void if there is nothing to shift
+    EXPECT_GT(non_zero, points.size() / 2);
+}
+
+#pragma mark -
+#pragma mark Grid meanshift
+
+template<class T>
+void FSMeanshiftTest2D<T>::compare_grid_meanshift(const Kernel<T> *kernel,
+                                                  const WeightFunction<T> *w) {
+    ASSERT_TRUE(GridStencil<T>::matches_grid(this->coordinate_system()));
+
+    const typename Point<T>::list &points = this->m_featureSpace->points;
+    RangeSearchParams<T> params(this->m_bandwidth);
+    MeanshiftOperation<T> op(this->m_featureSpace, this->m_featureSpaceIndex);
+
+    // Same sample, summed in stencil order
+    GridMeanshiftOperation<T> grid_op(this->m_featureSpace, this->m_bandwidth);
+    grid_op.meanshift(0, points.size(), kernel, w, false);
+
+    const T tolerance = 100 * 60.0 * std::numeric_limits<T>::epsilon();
+
+    size_t mismatches = 0, non_zero = 0;
+    for (size_t i = 0; i < points.size(); i++) {
+        vector<T> expected = op.meanshift(points[i]->values, &params, kernel, w, false);
+        const vector<T> &shift = points[i]->shift;
+        ASSERT_EQ(expected.size(), shift.size());
+        bool match = true;
+        for (size_t d = 0; d < shift.size(); d++) {
+            match &= (fabs(expected[d] - shift[d]) <= tolerance);
+        }
+        if (!match) {
+            mismatches++;
+        }
+        if (vector_norm(expected) > tolerance) {
+            non_zero++;
+        }
+    }
+    EXPECT_EQ((size_t) 0, mismatches);
+    EXPECT_GT(non_zero, points.size() / 2);
+}
+
+// 2D
+#if RUN_2D
+
+TYPED_TEST_CASE(FSMeanshiftTest2D, DataTypes);
+
+TYPED_TEST(FSMeanshiftTest2D, FS_BatchSearch_2D_Test)
+{
+    RangeSearchParams<TypeParam> range(this->m_bandwidth);
+    this->compare_batch_search(&range);
+
+    KNNSearchParams<TypeParam> knn(20, this->coordinate_system()->resolution(), this->m_bandwidth);
+    this->compare_batch_search(&knn);
+}
+
+TYPED_TEST(FSMeanshiftTest2D, FS_BatchedMeanshift_2D_Test)
+{
+    RangeSearchParams<TypeParam> range(this->m_bandwidth);
+    KNNSearchParams<TypeParam> knn(20, this->coordinate_system()->resolution(), this->m_bandwidth);
+    GaussianNormalKernel<TypeParam> gauss(1.0);
+    EpanechnikovKernel<TypeParam> epanechnikov(1.0);
+    FSValueWeightFunction<TypeParam> w(this->m_value_index);
+
+    this->compare_batched_meanshift(&range, &gauss, NULL);
+    this->compare_batched_meanshift(&range, &epanechnikov, &w);
+    this->compare_batched_meanshift(&range, NULL, &w);
+    this->compare_batched_meanshift(&knn, &gauss, &w);
+}
+
+TYPED_TEST(FSMeanshiftTest2D, FS_GridMeanshift_2D_Test)
+{
+    GaussianNormalKernel<TypeParam> gauss(1.0);
+    EpanechnikovKernel<TypeParam> epanechnikov(1.0);
+    FSValueWeightFunction<TypeParam> w(this->m_value_index);
+
+    this->compare_grid_meanshift(&gauss, NULL);
+    this->compare_grid_meanshift(&epanechnikov, &w);
+    this->compare_grid_meanshift(NULL, &w);
+}
+
+#endif
+
+// 3D
+#if RUN_3D
+
+TYPED_TEST_CASE(FSMeanshiftTest3D, DataTypes);
+
+TYPED_TEST(FSMeanshiftTest3D, FS_BatchedMeanshift_3D_Test)
+{
+    RangeSearchParams<TypeParam> range(this->m_bandwidth);
+    GaussianNormalKernel<TypeParam> gauss(1.0);
+    FSValueWeightFunction<TypeParam> w(this->m_value_index);
+
+    this->compare_batch_search(&range);
+    this->compare_batched_meanshift(&range, &gauss, &w);
+}
+
+TYPED_TEST(FSMeanshiftTest3D, FS_GridMeanshift_3D_Test)
+{
+    GaussianNormalKernel<TypeParam> gauss(1.0);
+    FSValueWeightFunction<TypeParam> w(this->m_value_index);
+
+    this->compare_grid_meanshift(&gauss, &w);
+}
+
+#endif
+
+#endif
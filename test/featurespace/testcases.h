@@ -22,6 +22,10 @@
 #define RUN_UNWEIGHED_SAMPLE 1
 #define RUN_WEIGHED_SAMPLE 1
 #define RUN_ITERATION 1
+#define RUN_FILTERS 1
+#define RUN_INDEX 1
+#define RUN_MEANSHIFT 1
+#define RUN_CONSTRUCTION 1
 
 #pragma mark -
 #pragma mark Data Types 
@@ -67,4 +71,40 @@ typedef Types<float, double> DataTypes;
 
 #endif
 
+#pragma mark -
+#pragma mark Filters on the grid and with range searches
+
+#if RUN_FILTERS
+
+#include "filters.h"
+
+#endif
+
+#pragma mark -
+#pragma mark Point index searches
+
+#if RUN_INDEX
+
+#include "index.h"
+
+#endif
+
+#pragma mark -
+#pragma mark Batched mean-shift
+
+#if RUN_MEANSHIFT
+
+#include "meanshift.h"
+
+#endif
+
+#pragma mark -
+#pragma mark Feature-space construction
+
+#if RUN_CONSTRUCTION
+
+#include "construction.h"
+
+#endif
+
 #endif
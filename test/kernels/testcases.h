@@ -157,4 +157,59 @@ TYPED_TEST(FloatKernelTest, TestFloat) {
 }
 
 
+// Compares the impulse response of the recursive Gaussian with the
+// sampled scale-space kernel (normalized, not truncated) at a range
+// of scales. Resolution is 1, so sigma = sqrt(scale) grid points.
+
+template<class T>
+class RecursiveGaussianTest : public Test
+{
+};
+
+typedef Types<double, float> RecursiveGaussianTypes;
+
+TYPED_TEST_CASE(RecursiveGaussianTest, RecursiveGaussianTypes);
+
+TYPED_TEST(RecursiveGaussianTest, CompareWithSampledKernel) {
+    const TypeParam scales[] = {0.25, 1.0, 4.0, 25.0, 100.0, 400.0};
+    const size_t lines = 3;
+
+    for (size_t si = 0; si < sizeof(scales) / sizeof(scales[0]); si++) {
+        TypeParam t = scales[si];
+        TypeParam sigma = sqrt(t);
+        size_t n = (size_t) (20 * sigma) + 41;
+        size_t centre = n / 2;
+
+        vector<TypeParam> in(n * lines, 0.0), out(n * lines), scratch(n * lines);
+        for (size_t j = 0; j < lines; j++) {
+            in[centre * lines + j] = 1.0;
+        }
+
+        RecursiveGaussian<TypeParam> recursive(sigma);
+        ASSERT_TRUE(recursive.is_valid());
+        recursive.apply(&in[0], &out[0], &scratch[0], n, lines, lines);
+
+        ScaleSpaceKernel<TypeParam> kernel(t);
+        vector<TypeParam> sampled(n);
+        TypeParam sum = 0.0;
+        for (size_t k = 0; k < n; k++) {
+            TypeParam r = (k < centre) ? (centre - k) : (k - centre);
+            sampled[k] = kernel.value(r);
+            sum += sampled[k];
+        }
+
+        TypeParam max_error = 0.0;
+        for (size_t k = 0; k < n; k++) {
+            for (size_t j = 0; j < lines; j++) {
+                TypeParam error = fabs(out[k * lines + j] - sampled[k] / sum);
+                max_error = std::max(max_error, error);
+            }
+        }
+
+        // relative to the peak value
+        max_error /= (sampled[centre] / sum);
+        EXPECT_LT(max_error, 0.001);
+    }
+}
+
 #endif